@@ -55,6 +55,7 @@
 #include "gromacs/analysisdata/paralleloptions.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/mutex.h"
 
 namespace gmx
 {
@@ -245,7 +246,7 @@ class AnalysisDataStorageImpl
          * There is always one unused frame in the buffer, which is initialized
          * such that when \a firstFrameLocation_ is incremented, it becomes
          * valid.  This makes it easier to rotate the buffer in concurrent
-         * access scenarions (which are not yet otherwise implemented).
+         * access scenarions.
          */
         FrameList               frames_;
         //! Location of oldest frame in \a frames_.
@@ -270,6 +271,15 @@ class AnalysisDataStorageImpl
          * frame (see \a frames_).
          */
         int                     nextIndex_;
+        /*! \brief
+         * Protects the frame buffer and the notifications against concurrent
+         * frame starts and finishes.
+         *
+         * Only the operations that touch state shared between frames are
+         * serialized; adding points into a frame that is in progress does not
+         * lock, as the data is frame-local.
+         */
+        Mutex                   mutex_;
 };
 
 /********************************************************************
@@ -758,7 +768,9 @@ void
 AnalysisDataStorageFrame::finishFrame()
 {
     GMX_RELEASE_ASSERT(data_ != nullptr, "Invalid frame accessed");
-    data_->storageImpl().finishFrame(data_->frameIndex());
+    internal::AnalysisDataStorageImpl &storageImpl = data_->storageImpl();
+    lock_guard<Mutex>                  lock(storageImpl.mutex_);
+    storageImpl.finishFrame(data_->frameIndex());
 }
 
 
@@ -860,6 +872,7 @@ AnalysisDataStorageFrame &
 AnalysisDataStorage::startFrame(const AnalysisDataFrameHeader &header)
 {
     GMX_ASSERT(header.isValid(), "Invalid header");
+    lock_guard<Mutex> lock(impl_->mutex_);
     internal::AnalysisDataStorageFrameData *storedFrame;
     if (impl_->storeAll())
     {
@@ -903,6 +916,7 @@ AnalysisDataStorage::startFrame(int index, real x, real dx)
 AnalysisDataStorageFrame &
 AnalysisDataStorage::currentFrame(int index)
 {
+    lock_guard<Mutex> lock(impl_->mutex_);
     const int storageIndex = impl_->computeStorageLocation(index);
     GMX_RELEASE_ASSERT(storageIndex >= 0, "Out of bounds frame index");
 
@@ -920,6 +934,7 @@ AnalysisDataStorage::currentFrame(int index)
 void
 AnalysisDataStorage::finishFrame(int index)
 {
+    lock_guard<Mutex> lock(impl_->mutex_);
     impl_->finishFrame(index);
 }
 
@@ -928,6 +943,7 @@ AnalysisDataStorage::finishFrameSerial(int index)
 {
     if (impl_->pendingLimit_ > 1)
     {
+        lock_guard<Mutex> lock(impl_->mutex_);
         impl_->finishFrameSerial(index);
     }
 }
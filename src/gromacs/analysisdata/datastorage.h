@@ -257,8 +257,10 @@ class AnalysisDataStorageFrame
  * AnalysisDataStorageFrame::finishPointSet()) take the responsibility of
  * calling all the notification methods in AnalysisDataModuleManager,
  *
- * \todo
- * Proper multi-threaded implementation.
+ * If startParallelDataStorage() is used, frames may be started, filled, and
+ * finished concurrently from different threads, as long as each frame is only
+ * accessed from one thread at a time.  finishFrameSerial() still needs to be
+ * called in frame order.
  *
  * \inlibraryapi
  * \ingroup module_analysisdata
@@ -305,73 +305,126 @@ void dd_get_constraint_range(const gmx_domdec_t *dd, int *at_start, int *at_end)
     *at_end   = dd->comm->atomRanges.end(DDAtomRanges::Type::Constraints);
 }
 
-void dd_move_x(gmx_domdec_t             *dd,
-               matrix                    box,
-               gmx::ArrayRef<gmx::RVec>  x,
-               gmx_wallcycle            *wcycle)
+/*! \brief Packs the coordinates to send for pulse \p ind along DD dimension index \p d
+ *
+ * Applies the PBC shift and, with screw PBC, the rotation.
+ */
+static void packHaloCoordinates(const gmx_domdec_t             *dd,
+                                int                             d,
+                                const gmx_domdec_ind_t         &ind,
+                                const matrix                    box,
+                                gmx::ArrayRef<const gmx::RVec>  x,
+                                gmx::ArrayRef<gmx::RVec>        sendBuffer)
 {
-    wallcycle_start(wcycle, ewcMOVEX);
+    const bool bPBC   = (dd->ci[dd->dim[d]] == 0);
+    const bool bScrew = (bPBC && dd->bScrewPBC && dd->dim[d] == XX);
 
-    int                    nzone, nat_tot;
-    gmx_domdec_comm_t     *comm;
-    gmx_domdec_comm_dim_t *cd;
-    rvec                   shift = {0, 0, 0};
-    gmx_bool               bPBC, bScrew;
+    int        n      = 0;
+    if (!bPBC)
+    {
+        for (int j : ind.index)
+        {
+            sendBuffer[n] = x[j];
+            n++;
+        }
+    }
+    else if (!bScrew)
+    {
+        const rvec &shift = box[dd->dim[d]];
+        for (int j : ind.index)
+        {
+            /* We need to shift the coordinates */
+            for (int d = 0; d < DIM; d++)
+            {
+                sendBuffer[n][d] = x[j][d] + shift[d];
+            }
+            n++;
+        }
+    }
+    else
+    {
+        const rvec &shift = box[dd->dim[d]];
+        for (int j : ind.index)
+        {
+            /* Shift x */
+            sendBuffer[n][XX] = x[j][XX] + shift[XX];
+            /* Rotate y and z.
+             * This operation requires a special shift force
+             * treatment, which is performed in calc_vir.
+             */
+            sendBuffer[n][YY] = box[YY][YY] - x[j][YY];
+            sendBuffer[n][ZZ] = box[ZZ][ZZ] - x[j][ZZ];
+            n++;
+        }
+    }
+}
 
-    comm = dd->comm;
+//! Copies the coordinates received for pulse \p ind into the zones of \p x
+static void unpackHaloCoordinates(const gmx_domdec_ind_t         &ind,
+                                  int                             nzone,
+                                  gmx::ArrayRef<const gmx::RVec>  receiveBuffer,
+                                  gmx::ArrayRef<gmx::RVec>        x)
+{
+    int j = 0;
+    for (int zone = 0; zone < nzone; zone++)
+    {
+        for (int i = ind.cell2at0[zone]; i < ind.cell2at1[zone]; i++)
+        {
+            x[i] = receiveBuffer[j++];
+        }
+    }
+}
 
-    nzone   = 1;
-    nat_tot = comm->atomRanges.numHomeAtoms();
+/*! \brief Communicates the halo coordinates for all pulses and dimensions
+ *
+ * When the first pulse along the first dimension has been started
+ * by dd_move_x_start(), this pulse is completed instead of communicated.
+ */
+static void moveHaloCoordinates(gmx_domdec_t             *dd,
+                                const matrix              box,
+                                gmx::ArrayRef<gmx::RVec>  x,
+                                gmx_wallcycle            *wcycle)
+{
+    gmx_domdec_comm_t *comm = dd->comm;
+    DDHaloExchangeX   &halo = comm->haloExchangeX;
+
+    int                nzone   = 1;
+    int                nat_tot = comm->atomRanges.numHomeAtoms();
     for (int d = 0; d < dd->ndim; d++)
     {
-        bPBC   = (dd->ci[dd->dim[d]] == 0);
-        bScrew = (bPBC && dd->bScrewPBC && dd->dim[d] == XX);
-        if (bPBC)
+        const bool firstPulseIsInFlight = (d == 0 && halo.isInFlight);
+        if (firstPulseIsInFlight)
         {
-            copy_rvec(box[dd->dim[d]], shift);
+            wallcycle_sub_start_nocount(wcycle, ewcsMOVEX_DIM0);
         }
-        cd = &comm->cd[d];
-        for (const gmx_domdec_ind_t &ind : cd->ind)
+        else
         {
-            DDBufferAccess<gmx::RVec>  sendBufferAccess(comm->rvecBuffer, ind.nsend[nzone + 1]);
-            gmx::ArrayRef<gmx::RVec>  &sendBuffer = sendBufferAccess.buffer;
-            int                        n          = 0;
-            if (!bPBC)
-            {
-                for (int j : ind.index)
-                {
-                    sendBuffer[n] = x[j];
-                    n++;
-                }
-            }
-            else if (!bScrew)
-            {
-                for (int j : ind.index)
-                {
-                    /* We need to shift the coordinates */
-                    for (int d = 0; d < DIM; d++)
-                    {
-                        sendBuffer[n][d] = x[j][d] + shift[d];
-                    }
-                    n++;
-                }
-            }
-            else
+            wallcycle_sub_start(wcycle, ewcsMOVEX_DIM0 + d);
+        }
+
+        const gmx_domdec_comm_dim_t *cd = &comm->cd[d];
+        for (int p = 0; p < cd->numPulses(); p++)
+        {
+            const gmx_domdec_ind_t &ind = cd->ind[p];
+
+            if (p == 0 && firstPulseIsInFlight)
             {
-                for (int j : ind.index)
+                ddWaitSendrecv(&halo.requests);
+                halo.isInFlight = false;
+
+                if (!cd->receiveInPlace)
                 {
-                    /* Shift x */
-                    sendBuffer[n][XX] = x[j][XX] + shift[XX];
-                    /* Rotate y and z.
-                     * This operation requires a special shift force
-                     * treatment, which is performed in calc_vir.
-                     */
-                    sendBuffer[n][YY] = box[YY][YY] - x[j][YY];
-                    sendBuffer[n][ZZ] = box[ZZ][ZZ] - x[j][ZZ];
-                    n++;
+                    unpackHaloCoordinates(ind, nzone, halo.receiveBuffer, x);
                 }
+                nat_tot += ind.nrecv[nzone+1];
+
+                continue;
             }
 
+            DDBufferAccess<gmx::RVec>  sendBufferAccess(comm->rvecBuffer, ind.nsend[nzone + 1]);
+            gmx::ArrayRef<gmx::RVec>  &sendBuffer = sendBufferAccess.buffer;
+            packHaloCoordinates(dd, d, ind, box, x, sendBuffer);
+
             DDBufferAccess<gmx::RVec>  receiveBufferAccess(comm->rvecBuffer2, cd->receiveInPlace ? 0 : ind.nrecv[nzone + 1]);
 
             gmx::ArrayRef<gmx::RVec>   receiveBuffer;
@@ -389,19 +442,85 @@ void dd_move_x(gmx_domdec_t             *dd,
 
             if (!cd->receiveInPlace)
             {
-                int j = 0;
-                for (int zone = 0; zone < nzone; zone++)
-                {
-                    for (int i = ind.cell2at0[zone]; i < ind.cell2at1[zone]; i++)
-                    {
-                        x[i] = receiveBuffer[j++];
-                    }
-                }
+                unpackHaloCoordinates(ind, nzone, receiveBuffer, x);
             }
             nat_tot += ind.nrecv[nzone+1];
         }
         nzone += nzone;
+
+        wallcycle_sub_stop(wcycle, ewcsMOVEX_DIM0 + d);
     }
+}
+
+void dd_move_x(gmx_domdec_t             *dd,
+               matrix                    box,
+               gmx::ArrayRef<gmx::RVec>  x,
+               gmx_wallcycle            *wcycle)
+{
+    GMX_ASSERT(!dd->comm->haloExchangeX.isInFlight, "dd_move_x can not be called between dd_move_x_start and dd_move_x_finish");
+
+    wallcycle_start(wcycle, ewcMOVEX);
+
+    moveHaloCoordinates(dd, box, x, wcycle);
+
+    wallcycle_stop(wcycle, ewcMOVEX);
+}
+
+void dd_move_x_start(gmx_domdec_t             *dd,
+                     const matrix              box,
+                     gmx::ArrayRef<gmx::RVec>  x,
+                     gmx_wallcycle            *wcycle)
+{
+    gmx_domdec_comm_t *comm = dd->comm;
+    DDHaloExchangeX   &halo = comm->haloExchangeX;
+
+    GMX_ASSERT(!halo.isInFlight, "dd_move_x_start can only be called once before dd_move_x_finish");
+
+    wallcycle_start(wcycle, ewcMOVEX);
+
+    /* Only the first pulse along the first dimension involves only
+     * home atoms, all later pulses also send received atoms.
+     */
+    if (dd->ndim > 0 && comm->cd[0].numPulses() > 0)
+    {
+        wallcycle_sub_start(wcycle, ewcsMOVEX_DIM0);
+
+        const int                    nzone = 1;
+        const gmx_domdec_comm_dim_t &cd    = comm->cd[0];
+        const gmx_domdec_ind_t      &ind   = cd.ind[0];
+
+        halo.sendBuffer.resize(ind.nsend[nzone + 1]);
+        packHaloCoordinates(dd, 0, ind, box, x, halo.sendBuffer);
+
+        gmx::ArrayRef<gmx::RVec> receiveBuffer;
+        if (cd.receiveInPlace)
+        {
+            receiveBuffer = gmx::arrayRefFromArray(x.data() + comm->atomRanges.numHomeAtoms(), ind.nrecv[nzone + 1]);
+        }
+        else
+        {
+            halo.receiveBuffer.resize(ind.nrecv[nzone + 1]);
+            receiveBuffer = halo.receiveBuffer;
+        }
+        ddIsendrecv<gmx::RVec>(dd, 0, dddirBackward,
+                               halo.sendBuffer, receiveBuffer,
+                               &halo.requests);
+        halo.isInFlight = true;
+
+        wallcycle_sub_stop(wcycle, ewcsMOVEX_DIM0);
+    }
+
+    wallcycle_stop(wcycle, ewcMOVEX);
+}
+
+void dd_move_x_finish(gmx_domdec_t             *dd,
+                      const matrix              box,
+                      gmx::ArrayRef<gmx::RVec>  x,
+                      gmx_wallcycle            *wcycle)
+{
+    wallcycle_start_nocount(wcycle, ewcMOVEX);
+
+    moveHaloCoordinates(dd, box, x, wcycle);
 
     wallcycle_stop(wcycle, ewcMOVEX);
 }
@@ -439,6 +558,8 @@ void dd_move_f(gmx_domdec_t             *dd,
         vis[dd->dim[d]] = 1;
         is              = IVEC2IS(vis);
 
+        wallcycle_sub_start(wcycle, ewcsMOVEF_DIM0 + d);
+
         cd = &comm->cd[d];
         for (int p = cd->numPulses() - 1; p >= 0; p--)
         {
@@ -523,6 +644,8 @@ void dd_move_f(gmx_domdec_t             *dd,
             }
         }
         nzone /= 2;
+
+        wallcycle_sub_stop(wcycle, ewcsMOVEF_DIM0 + d);
     }
     wallcycle_stop(wcycle, ewcMOVEF);
 }
@@ -2891,7 +3014,8 @@ static void set_dd_envvar_options(const gmx::MDLogger &mdlog,
 {
     gmx_domdec_comm_t *comm = dd->comm;
 
-    dd->bSendRecv2      = (dd_getenv(mdlog, "GMX_DD_USE_SENDRECV2", 0) != 0);
+    dd->bSendRecv2           = (dd_getenv(mdlog, "GMX_DD_USE_SENDRECV2", 0) != 0);
+    dd->useMoleculeTemplates = (dd_getenv(mdlog, "GMX_DD_NO_MOLECULE_TEMPLATES", 0) == 0);
     comm->dlb_scale_lim = dd_getenv(mdlog, "GMX_DLB_MAX_BOX_SCALING", 10);
     comm->eFlop         = dd_getenv(mdlog, "GMX_DLB_BASED_ON_FLOPS", 0);
     int recload         = dd_getenv(mdlog, "GMX_DD_RECORD_LOAD", 1);
@@ -2904,6 +3028,11 @@ static void set_dd_envvar_options(const gmx::MDLogger &mdlog,
         GMX_LOG(mdlog.info).appendText("Will use two sequential MPI_Sendrecv calls instead of two simultaneous non-blocking MPI_Irecv and MPI_Isend pairs for constraint and vsite communication");
     }
 
+    if (!dd->useMoleculeTemplates)
+    {
+        GMX_LOG(mdlog.info).appendText("Will assign the bonded interactions of all molecules atom by atom");
+    }
+
     if (comm->eFlop)
     {
         GMX_LOG(mdlog.info).appendText("Will load balance based on FLOP count");
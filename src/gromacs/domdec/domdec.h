@@ -212,6 +212,29 @@ void dd_move_x(struct gmx_domdec_t      *dd,
                gmx::ArrayRef<gmx::RVec>  x,
                gmx_wallcycle            *wcycle);
 
+/*! \brief Starts the communication of the coordinates to the neighboring cells
+ *
+ * Packs and starts non-blocking communication of the coordinates
+ * of the first pulse along the first decomposition dimension, which
+ * only involves home atoms. This allows overlapping this communication
+ * with computation on the home atoms. Must be followed by a call
+ * to dd_move_x_finish() before the non-local coordinates are used.
+ */
+void dd_move_x_start(struct gmx_domdec_t      *dd,
+                     const matrix              box,
+                     gmx::ArrayRef<gmx::RVec>  x,
+                     gmx_wallcycle            *wcycle);
+
+/*! \brief Completes the communication of the coordinates started by dd_move_x_start()
+ *
+ * Waits for the first pulse and communicates all remaining pulses.
+ * The result is identical to that of dd_move_x().
+ */
+void dd_move_x_finish(struct gmx_domdec_t      *dd,
+                      const matrix              box,
+                      gmx::ArrayRef<gmx::RVec>  x,
+                      gmx_wallcycle            *wcycle);
+
 /*! \brief Sum the forces over the neighboring cells.
  *
  * When fshift!=NULL the shift forces are updated to obtain
@@ -477,6 +477,8 @@ int dd_make_local_constraints(gmx_domdec_t *dd, int at_start,
          */
         t0_set = ((!at2con_mt.empty() && dc->nthread > 1) ? 1 : 0);
 
+        /* The threads only read dd->ga2la */
+        dd->ga2la->setConcurrentReadMode(true);
 #pragma omp parallel for num_threads(dc->nthread) schedule(static)
         for (thread = 0; thread < dc->nthread; thread++)
         {
@@ -522,6 +524,7 @@ int dd_make_local_constraints(gmx_domdec_t *dd, int at_start,
             }
             GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
         }
+        dd->ga2la->setConcurrentReadMode(false);
 
         /* Combine the generate settles and requested indices */
         for (thread = 1; thread < dc->nthread; thread++)
@@ -46,11 +46,13 @@
 #include "config.h"
 
 #include "gromacs/domdec/domdec.h"
+#include "gromacs/domdec/domdec_network.h"
 #include "gromacs/domdec/domdec_struct.h"
 #include "gromacs/mdlib/updategroupscog.h"
 #include "gromacs/timing/cyclecounter.h"
 #include "gromacs/topology/block.h"
 
+struct gmx_ga2la_t;
 struct t_commrec;
 
 /*! \cond INTERNAL */
@@ -375,6 +377,22 @@ struct dd_comm_setup_work_t
     int                    nsend_zone;           /**< The number of atom groups to send for the last zone */
 };
 
+/*! \brief Persistent state of a coordinate halo exchange in flight
+ *
+ * Used by dd_move_x_start() and dd_move_x_finish() to communicate
+ * the first pulse along the first decomposition dimension while
+ * the local non-bonded work is done. The buffers are only resized
+ * when the communication volume grows, so no allocation is needed
+ * on steps without search.
+ */
+struct DDHaloExchangeX
+{
+    std::vector<gmx::RVec> sendBuffer;         /**< The packed coordinates to send */
+    std::vector<gmx::RVec> receiveBuffer;      /**< Receive buffer, unused when receiving in place */
+    DDSendrecvRequests     requests;           /**< The requests of the communication in flight */
+    bool                   isInFlight = false; /**< Whether the communication has been started but not finished */
+};
+
 /*! \brief Struct for domain decomposition communication
  *
  * This struct contains most information about domain decomposition
@@ -501,6 +519,9 @@ struct gmx_domdec_comm_t // NOLINT (clang-analyzer-optin.performance.Padding)
     /* Communication buffer only used with multiple grid pulses */
     DDBuffer<gmx::RVec> rvecBuffer2; /**< Another rvec comm. buffer */
 
+    /** State of the non-blocking coordinate halo exchange */
+    DDHaloExchangeX haloExchangeX;
+
     /* Communication buffers for local redistribution */
     std::array<std::vector<int>, DIM*2>       cggl_flag;  /**< Charge group flag comm. buffers */
     std::array<std::vector<gmx::RVec>, DIM*2> cgcm_state; /**< Charge group center comm. buffers */
@@ -582,6 +603,30 @@ static const int zone_reorder_cartesian[DD_MAXZONE] = { 0, 1, 3, 2, 5, 4, 6, 7 }
  * components see only j zones with that component 0.
  */
 
+/*! \brief Updates the global and local indices of the home atoms after sorting
+ *
+ * Uses the sorting order \p sort, which gives for each new home atom the local
+ * index before sorting. The first \p numAtomsKept atoms before sorting were
+ * home atoms before redistribution, the others were received. This assumes
+ * that \p ga2la only contains entries for the atoms that stayed home, i.e.
+ * the entries of atoms that moved to other ranks and of the non-home zones
+ * have been removed, and that \p globalAtomIndices is unchanged since the last
+ * partitioning. Atoms that kept their local index are skipped, the entries of
+ * the other atoms that stayed home are updated in place and those of received
+ * atoms are added, which avoids clearing and refilling the whole list.
+ *
+ * \param[in]     sort                    The sorting order of the home atoms
+ * \param[in]     numAtomsKept            The number of home atoms before redistribution
+ * \param[in]     globalAtomGroupIndices  The global atom indices of the sorted home atoms
+ * \param[in,out] globalAtomIndices       The global atom indices of the local atoms, resized to the home atoms
+ * \param[in,out] ga2la                   The global to local atom index
+ */
+void updateHomeAtomIndices(gmx::ArrayRef<const gmx_cgsort_t> sort,
+                           int                               numAtomsKept,
+                           gmx::ArrayRef<const int>          globalAtomGroupIndices,
+                           std::vector<int>                 *globalAtomIndices,
+                           gmx_ga2la_t                      *ga2la);
+
 /*! \brief Returns the DD cut-off distance for multi-body interactions */
 real dd_cutoff_multibody(const gmx_domdec_t *dd);
 
@@ -146,6 +146,59 @@ template void ddSendrecv(const gmx_domdec_t *, int, int,
 template void ddSendrecv(const gmx_domdec_t *, int, int,
                          gmx::ArrayRef<gmx::RVec>, gmx::ArrayRef<gmx::RVec>);
 
+template <typename T>
+void
+ddIsendrecv(const gmx_domdec_t *dd,
+            int                 ddDimensionIndex,
+            int                 direction,
+            gmx::ArrayRef<T>    sendBuffer,
+            gmx::ArrayRef<T>    receiveBuffer,
+            DDSendrecvRequests *requests)
+{
+    GMX_ASSERT(requests->numRequests == 0, "Only one non-blocking communication can be in flight per request set");
+
+#if GMX_MPI
+    int           sendRank    = dd->neighbor[ddDimensionIndex][direction == dddirForward ? 0 : 1];
+    int           receiveRank = dd->neighbor[ddDimensionIndex][direction == dddirForward ? 1 : 0];
+
+    constexpr int mpiTag      = 2;
+    if (!receiveBuffer.empty())
+    {
+        MPI_Irecv(receiveBuffer.data(), receiveBuffer.size()*sizeof(T), MPI_BYTE,
+                  receiveRank, mpiTag, dd->mpi_comm_all,
+                  &requests->requests[requests->numRequests++]);
+    }
+    if (!sendBuffer.empty())
+    {
+        MPI_Isend(sendBuffer.data(), sendBuffer.size()*sizeof(T), MPI_BYTE,
+                  sendRank, mpiTag, dd->mpi_comm_all,
+                  &requests->requests[requests->numRequests++]);
+    }
+#else // GMX_MPI
+    GMX_UNUSED_VALUE(dd);
+    GMX_UNUSED_VALUE(ddDimensionIndex);
+    GMX_UNUSED_VALUE(direction);
+    GMX_UNUSED_VALUE(sendBuffer);
+    GMX_UNUSED_VALUE(receiveBuffer);
+#endif // GMX_MPI
+}
+
+//! Specialization of extern template for gmx::RVec
+template void ddIsendrecv(const gmx_domdec_t *, int, int,
+                          gmx::ArrayRef<gmx::RVec>, gmx::ArrayRef<gmx::RVec>,
+                          DDSendrecvRequests *);
+
+void ddWaitSendrecv(DDSendrecvRequests *requests)
+{
+#if GMX_MPI
+    if (requests->numRequests > 0)
+    {
+        MPI_Waitall(requests->numRequests, requests->requests, MPI_STATUSES_IGNORE); //NOLINT(clang-analyzer-optin.mpi.MPI-Checker)
+    }
+#endif
+    requests->numRequests = 0;
+}
+
 void dd_sendrecv2_rvec(const struct gmx_domdec_t gmx_unused *dd,
                        int gmx_unused ddimind,
                        rvec gmx_unused *buf_s_fw, int gmx_unused n_s_fw,
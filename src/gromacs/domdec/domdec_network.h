@@ -50,6 +50,7 @@
 
 #include "gromacs/math/vectypes.h"
 #include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/gmxmpi.h"
 
 struct gmx_domdec_t;
 
@@ -143,6 +144,47 @@ ddSendrecv<gmx::RVec>(const gmx_domdec_t      *dd,
                       gmx::ArrayRef<gmx::RVec> sendBuffer,
                       gmx::ArrayRef<gmx::RVec> receiveBuffer);
 
+/*! \brief Requests for a non-blocking send and receive along the domain decomposition
+ *
+ * Set up by ddIsendrecv() and completed by ddWaitSendrecv().
+ */
+struct DDSendrecvRequests
+{
+    int         numRequests = 0; //!< The number of requests in flight
+    MPI_Request requests[2];     //!< The send and/or receive requests
+};
+
+/*! \brief Starts moving a view of T values in the communication region
+ * one cell along the domain decomposition, without waiting for completion
+ *
+ * Does the same communication as ddSendrecv(), but returns directly.
+ * The buffers should not be accessed before ddWaitSendrecv() has been
+ * called with \p requests. A different tag is used than for ddSendrecv(),
+ * so blocking communication can be done while this is in flight.
+ */
+template <typename T>
+void
+ddIsendrecv(const gmx_domdec_t *dd,
+            int                 ddDimensionIndex,
+            int                 direction,
+            gmx::ArrayRef<T>    sendBuffer,
+            gmx::ArrayRef<T>    receiveBuffer,
+            DDSendrecvRequests *requests);
+
+//! Extern declaration for gmx::RVec specialization
+extern template
+void
+ddIsendrecv<gmx::RVec>(const gmx_domdec_t       *dd,
+                       int                       ddDimensionIndex,
+                       int                       direction,
+                       gmx::ArrayRef<gmx::RVec>  sendBuffer,
+                       gmx::ArrayRef<gmx::RVec>  receiveBuffer,
+                       DDSendrecvRequests       *requests);
+
+//! Waits for the completion of the communication started by ddIsendrecv()
+void
+ddWaitSendrecv(DDSendrecvRequests *requests);
+
 /*! \brief Move revc's in the comm. region one cell along the domain decomposition
  *
  * Moves in dimension indexed by ddimind, simultaneously in the forward
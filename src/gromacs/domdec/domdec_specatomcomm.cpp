@@ -58,11 +58,47 @@
 #include "gromacs/domdec/hashedmap.h"
 #include "gromacs/domdec/partition.h"
 #include "gromacs/math/vec.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
 #include "gromacs/mdtypes/commrec.h"
 #include "gromacs/pbcutil/ishift.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/gmxassert.h"
 
+/*! \brief The minimum number of requested atoms per thread for looking up home atoms
+ *
+ * Below this threshold the OpenMP overhead is larger than the gain.
+ */
+static constexpr int c_minNumRequestedAtomsPerThread = 1024;
+
+/*! \brief Sets \p homeIndex to the local index of the home atoms in \p globalIndices, -1 otherwise
+ *
+ * The lookup is done in parallel using OpenMP, ga2la is only read.
+ */
+static void findRequestedHomeAtoms(gmx_ga2la_t              *ga2la,
+                                   gmx::ArrayRef<const int>  globalIndices,
+                                   gmx::ArrayRef<int>        homeIndex)
+{
+    const int numIndices = globalIndices.size();
+    const int numThreads = std::max(1, std::min(gmx_omp_nthreads_get(emntDomdec),
+                                                numIndices/c_minNumRequestedAtomsPerThread));
+
+    ga2la->setConcurrentReadMode(true);
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+    for (int thread = 0; thread < numThreads; thread++)
+    {
+        try
+        {
+            const int start = (numIndices*thread)/numThreads;
+            const int end   = (numIndices*(thread + 1))/numThreads;
+            ga2la->findHomeLocalIndices(globalIndices.subArray(start, end - start),
+                                        homeIndex.subArray(start, end - start));
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+    ga2la->setConcurrentReadMode(false);
+}
+
 void dd_move_f_specat(gmx_domdec_t *dd, gmx_domdec_specat_comm_t *spac,
                       rvec *f, rvec *fshift)
 {
@@ -468,14 +504,19 @@ int setup_specat_communication(gmx_domdec_t               *dd,
             spas->a.clear();
             spac->ibuf.clear();
             nsend[0]    = 0;
+            /* Look up which requested atoms are home atoms in one bulk call */
+            spac->homeIndex.resize(nr);
+            findRequestedHomeAtoms(dd->ga2la,
+                                   gmx::constArrayRefFromArray(ireq->data() + start, nr),
+                                   spac->homeIndex);
             for (int i = 0; i < nr; i++)
             {
                 const int indr = (*ireq)[start + i];
                 int       ind;
                 /* Check if this is a home atom and if so ind will be set */
-                if (const int *homeIndex = dd->ga2la->findHome(indr))
+                if (spac->homeIndex[i] >= 0)
                 {
-                    ind = *homeIndex;
+                    ind = spac->homeIndex[i];
                 }
                 else
                 {
@@ -72,6 +72,7 @@ struct gmx_domdec_specat_comm_t
     /* The atoms to send */
     gmx_specatsend_t  spas[DIM][2];              /**< The communication setup per DIM, direction */
     std::vector<bool> sendAtom;                  /**< Work buffer that tells if spec.atoms should be sent */
+    std::vector<int>  homeIndex;                 /**< Work buffer with the local index of requested home atoms, -1 otherwise */
 
     /* Send buffers */
     std::vector<int>       ibuf;       /**< Integer send buffer */
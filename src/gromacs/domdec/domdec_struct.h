@@ -173,6 +173,8 @@ struct gmx_domdec_t { //NOLINT(clang-analyzer-optin.performance.Padding)
     bool splitConstraints;
     /* Can atoms connected by settles be assigned to different domains? */
     bool splitSettles;
+    /* Can complete home molecules be assigned as a whole in the local topology? */
+    bool useMoleculeTemplates = true;
 
     /* Global atom number to interaction list */
     gmx_reverse_top_t  *reverse_top;
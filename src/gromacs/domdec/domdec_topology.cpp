@@ -93,9 +93,10 @@
 
 struct reverse_ilist_t
 {
-    std::vector<int> index;              /* Index for each atom into il          */
-    std::vector<int> il;                 /* ftype|type|a0|...|an|ftype|...       */
-    int              numAtomsInMolecule; /* The number of atoms in this molecule */
+    std::vector<int> index;               /* Index for each atom into il          */
+    std::vector<int> il;                  /* ftype|type|a0|...|an|ftype|...       */
+    int              numAtomsInMolecule;  /* The number of atoms in this molecule */
+    bool             useTemplate = false; /* Can complete home molecules be assigned as a whole? */
 };
 
 struct MolblockIndices
@@ -109,11 +110,12 @@ struct MolblockIndices
 /*! \brief Struct for thread local work data for local topology generation */
 struct thread_work_t
 {
-    t_idef                    idef;       /**< Partial local topology */
-    std::unique_ptr<VsitePbc> vsitePbc;   /**< vsite PBC structure */
-    int                       nbonded;    /**< The number of bondeds in this struct */
-    t_blocka                  excl;       /**< List of exclusions */
-    int                       excl_count; /**< The total exclusion count for \p excl */
+    t_idef                    idef;               /**< Partial local topology */
+    std::unique_ptr<VsitePbc> vsitePbc;           /**< vsite PBC structure */
+    int                       nbonded;            /**< The number of bondeds in this struct */
+    t_blocka                  excl;               /**< List of exclusions */
+    int                       excl_count;         /**< The total exclusion count for \p excl */
+    std::vector<int>          moleculeLocalAtoms; /**< Buffer for the local atom indices of a molecule */
 };
 
 /*! \brief Struct for the reverse topology: links bonded interactions to atomsx */
@@ -146,6 +148,11 @@ struct gmx_reverse_top_t
     //! \brief Intermolecular reverse ilist
     reverse_ilist_t  ril_intermol;
 
+    //! \brief Can molecules of some molecule types be assigned as a whole?
+    bool              haveMoleculeTemplates = false;
+    //! \brief Tells for each home atom whether its molecule was assigned as a whole
+    std::vector<char> homeAtomInMoleculeTemplate;
+
     /* Work data structures for multi-threading */
     //! \brief Thread work array for local topology generation
     std::vector<thread_work_t> th_work;
@@ -635,10 +642,36 @@ static int make_reverse_ilist(const InteractionLists &ilist,
     return nint_mt;
 }
 
+/*! \brief Returns whether the interactions of complete molecules with reverse ilist \p ril can be assigned as a whole
+ *
+ * Virtual sites and position restraints need special treatment on
+ * assignment, so molecules with those are always assigned atom by atom.
+ */
+static bool canUseMoleculeTemplate(const reverse_ilist_t &ril)
+{
+    if (ril.numAtomsInMolecule <= 1 || ril.il.empty())
+    {
+        return false;
+    }
+
+    for (gmx::index j = 0; j < gmx::ssize(ril.il); j += 2 + nral_rt(ril.il[j]))
+    {
+        const int ftype = ril.il[j];
+        if ((interaction_function[ftype].flags & IF_VSITE) ||
+            ftype == F_POSRES || ftype == F_FBPOSRES)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 /*! \brief Generate the reverse topology */
 static gmx_reverse_top_t make_reverse_top(const gmx_mtop_t *mtop, gmx_bool bFE,
                                           gmx_bool bConstr, gmx_bool bSettle,
-                                          gmx_bool bBCheck, int *nint)
+                                          gmx_bool bBCheck,
+                                          bool useMoleculeTemplates, int *nint)
 {
     gmx_reverse_top_t  rt;
 
@@ -667,6 +700,10 @@ static gmx_reverse_top_t make_reverse_top(const gmx_mtop_t *mtop, gmx_bool bFE,
         nint_mt.push_back(numberOfInteractions);
 
         rt.ril_mt_tot_size += rt.ril_mt[mt].index[molt.atoms.nr];
+
+        rt.ril_mt[mt].useTemplate = (useMoleculeTemplates &&
+                                     canUseMoleculeTemplate(rt.ril_mt[mt]));
+        rt.haveMoleculeTemplates  = (rt.haveMoleculeTemplates || rt.ril_mt[mt].useTemplate);
     }
     if (debug)
     {
@@ -746,7 +783,8 @@ void dd_make_reverse_top(FILE *fplog,
     *dd->reverse_top =
         make_reverse_top(mtop, ir->efep != efepNO,
                          !dd->splitConstraints, !dd->splitSettles,
-                         bBCheck, &dd->nbonded_global);
+                         bBCheck, dd->useMoleculeTemplates,
+                         &dd->nbonded_global);
 
     gmx_reverse_top_t *rt = dd->reverse_top;
 
@@ -1365,6 +1403,109 @@ check_assign_interactions_atom(int i, int i_gl,
     }
 }
 
+/*! \brief Assigns the bonded interactions of molecules that are completely in the home zone
+ *
+ * For molecule types without virtual sites and position restraints, the
+ * interactions of a molecule of which all atoms are home atoms can be
+ * copied as a whole from the reverse topology of the molecule type,
+ * with only the atom indices translated. This avoids the global to local
+ * lookups and zone checks for every atom of every interaction.
+ * The molecules are assigned by their first atom, which needs to be in
+ * \p atomRange. All home atoms of assigned molecules are marked in
+ * \p homeAtomInMoleculeTemplate, so the atom by atom assignment can skip
+ * their intramolecular interactions.
+ */
+static int make_bondeds_molecule_templates(const gmx_domdec_t            *dd,
+                                           gmx_bool                       bRCheck2B,
+                                           real                           rc2,
+                                           t_pbc                         *pbc_null,
+                                           rvec                          *cg_cm,
+                                           t_idef                        *idef,
+                                           gmx::RangePartitioning::Block  atomRange,
+                                           std::vector<int>              *localAtoms,
+                                           gmx::ArrayRef<char>            homeAtomInMoleculeTemplate)
+{
+    const gmx_reverse_top_t *rt            = dd->reverse_top;
+    const gmx_ga2la_t       &ga2la         = *dd->ga2la;
+    const bool               bBCheck       = rt->bBCheck;
+
+    int                      nbonded_local = 0;
+
+    for (int i : atomRange)
+    {
+        int       mb, mt, mol, i_mol;
+
+        const int i_gl = dd->globalAtomIndices[i];
+        global_atomnr_to_moltype_ind(rt, i_gl, &mb, &mt, &mol, &i_mol);
+
+        const reverse_ilist_t &ril = rt->ril_mt[mt];
+        if (i_mol != 0 || !ril.useTemplate)
+        {
+            continue;
+        }
+
+        /* Check whether all atoms of this molecule are home atoms */
+        localAtoms->resize(ril.numAtomsInMolecule);
+        (*localAtoms)[0]    = i;
+        bool moleculeIsHome = true;
+        for (int a_mol = 1; a_mol < ril.numAtomsInMolecule && moleculeIsHome; a_mol++)
+        {
+            if (const int *a_loc = ga2la.findHome(i_gl + a_mol))
+            {
+                (*localAtoms)[a_mol] = *a_loc;
+            }
+            else
+            {
+                moleculeIsHome = false;
+            }
+        }
+        if (!moleculeIsHome)
+        {
+            continue;
+        }
+
+        for (int a_loc : *localAtoms)
+        {
+            homeAtomInMoleculeTemplate[a_loc] = TRUE;
+        }
+
+        /* Copy all interactions of the molecule, translating the atom indices */
+        gmx::ArrayRef<const int> rtil = ril.il;
+        int                      j    = 0;
+        while (j < rtil.ssize())
+        {
+            t_iatom   tiatoms[1 + MAXATOMLIST];
+
+            const int ftype = rtil[j];
+            const int nral  = NRAL(ftype);
+            tiatoms[0]      = rtil[j + 1];
+            for (int k = 1; k <= nral; k++)
+            {
+                tiatoms[k] = (*localAtoms)[rtil[j + 1 + k]];
+            }
+            j += 2 + nral;
+
+            /* Apply the same distance check as for home atom pairs
+             * in check_assign_interactions_atom.
+             */
+            if (nral == 2 && bRCheck2B &&
+                dd_dist2(pbc_null, cg_cm, tiatoms[1], tiatoms[2]) >= rc2)
+            {
+                continue;
+            }
+
+            add_ifunc(nral, tiatoms, &idef->il[ftype]);
+            if (bBCheck ||
+                !(interaction_function[ftype].flags & IF_LIMZERO))
+            {
+                nbonded_local++;
+            }
+        }
+    }
+
+    return nbonded_local;
+}
+
 /*! \brief This function looks up and assigns bonded interactions for zone iz.
  *
  * With thread parallelizing each thread acts on a different atom range:
@@ -1401,20 +1542,25 @@ static int make_bondeds_zone(gmx_domdec_t *dd,
         gmx::ArrayRef<const int>       index = rt->ril_mt[mt].index;
         gmx::ArrayRef<const t_iatom>   rtil  = rt->ril_mt[mt].il;
 
-        check_assign_interactions_atom(i, i_gl, mol, i_mol,
-                                       rt->ril_mt[mt].numAtomsInMolecule,
-                                       index, rtil, FALSE,
-                                       index[i_mol], index[i_mol+1],
-                                       dd, zones,
-                                       &molb[mb],
-                                       bRCheckMB, rcheck, bRCheck2B, rc2,
-                                       pbc_null,
-                                       cg_cm,
-                                       ip_in,
-                                       idef,
-                                       izone,
-                                       bBCheck,
-                                       &nbonded_local);
+        /* Molecules assigned as a whole have been handled already */
+        if (izone != 0 || rt->homeAtomInMoleculeTemplate.empty() ||
+            !rt->homeAtomInMoleculeTemplate[i])
+        {
+            check_assign_interactions_atom(i, i_gl, mol, i_mol,
+                                           rt->ril_mt[mt].numAtomsInMolecule,
+                                           index, rtil, FALSE,
+                                           index[i_mol], index[i_mol+1],
+                                           dd, zones,
+                                           &molb[mb],
+                                           bRCheckMB, rcheck, bRCheck2B, rc2,
+                                           pbc_null,
+                                           cg_cm,
+                                           ip_in,
+                                           idef,
+                                           izone,
+                                           bBCheck,
+                                           &nbonded_local);
+        }
 
 
         if (rt->bIntermolecularInteractions)
@@ -1775,19 +1921,111 @@ static int make_local_bondeds_excls(gmx_domdec_t *dd,
     lexcls->nra   = 0;
     *excl_count   = 0;
 
-    for (izone = 0; izone < nzone_bondeds; izone++)
+    const int numThreads = rt->th_work.size();
+
+    if (rt->haveMoleculeTemplates)
+    {
+        /* Home molecules are marked concurrently by the thread that
+         * owns their first atom, so we need to clear all marks first.
+         */
+        rt->homeAtomInMoleculeTemplate.assign(zones->cg_range[1], FALSE);
+    }
+
+    /* First assign the molecules that can be assigned as a whole, this
+     * needs to finish before the atom by atom assignment can start.
+     */
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+    for (thread = 0; thread < numThreads; thread++)
+    {
+        try
+        {
+            t_idef *idef_t;
+
+            if (thread == 0)
+            {
+                idef_t = idef;
+            }
+            else
+            {
+                idef_t = &rt->th_work[thread].idef;
+                clear_idef(idef_t);
+            }
+
+            rt->th_work[thread].nbonded = 0;
+
+            if (rt->haveMoleculeTemplates)
+            {
+                const int numHomeAtoms = zones->cg_range[1];
+
+                rt->th_work[thread].nbonded =
+                    make_bondeds_molecule_templates(dd,
+                                                    bRCheck2B, rc2,
+                                                    pbc_null, cg_cm,
+                                                    idef_t,
+                                                    gmx::RangePartitioning::Block((numHomeAtoms* thread   )/numThreads,
+                                                                                  (numHomeAtoms*(thread+1))/numThreads),
+                                                    &rt->th_work[thread].moleculeLocalAtoms,
+                                                    rt->homeAtomInMoleculeTemplate);
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+
+    /* Assign the remaining bondeds of all zones in a single pass,
+     * so the atoms of all zones are divided evenly over the threads.
+     */
+    const int numAtomsBondeds = zones->cg_range[nzone_bondeds];
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+    for (thread = 0; thread < numThreads; thread++)
+    {
+        try
+        {
+            t_idef   *idef_t = (thread == 0 ? idef : &rt->th_work[thread].idef);
+
+            const int at0t   = (numAtomsBondeds* thread   )/numThreads;
+            const int at1t   = (numAtomsBondeds*(thread+1))/numThreads;
+
+            for (int iz = 0; iz < nzone_bondeds; iz++)
+            {
+                const int at0 = std::max(at0t, zones->cg_range[iz]);
+                const int at1 = std::min(at1t, zones->cg_range[iz + 1]);
+                if (at0 < at1)
+                {
+                    rt->th_work[thread].nbonded +=
+                        make_bondeds_zone(dd, zones,
+                                          mtop->molblock,
+                                          bRCheckMB, rcheck, bRCheck2B, rc2,
+                                          pbc_null, cg_cm, idef->iparams,
+                                          idef_t,
+                                          iz,
+                                          gmx::RangePartitioning::Block(at0, at1));
+                }
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+
+    if (rt->th_work.size() > 1)
+    {
+        combine_idef(idef, rt->th_work);
+    }
+
+    for (const thread_work_t &th_work : rt->th_work)
+    {
+        nbonded_local += th_work.nbonded;
+    }
+
+    for (izone = 0; izone < nzone_excl; izone++)
     {
         cg0 = zones->cg_range[izone];
         cg1 = zones->cg_range[izone + 1];
 
-        const int numThreads = rt->th_work.size();
 #pragma omp parallel for num_threads(numThreads) schedule(static)
         for (thread = 0; thread < numThreads; thread++)
         {
             try
             {
                 int       cg0t, cg1t;
-                t_idef   *idef_t;
                 t_blocka *excl_t;
 
                 cg0t = cg0 + ((cg1 - cg0)* thread   )/numThreads;
@@ -1795,54 +2033,32 @@ static int make_local_bondeds_excls(gmx_domdec_t *dd,
 
                 if (thread == 0)
                 {
-                    idef_t = idef;
+                    excl_t = lexcls;
                 }
                 else
                 {
-                    idef_t = &rt->th_work[thread].idef;
-                    clear_idef(idef_t);
+                    excl_t      = &rt->th_work[thread].excl;
+                    excl_t->nr  = 0;
+                    excl_t->nra = 0;
                 }
 
-                rt->th_work[thread].nbonded =
-                    make_bondeds_zone(dd, zones,
-                                      mtop->molblock,
-                                      bRCheckMB, rcheck, bRCheck2B, rc2,
-                                      pbc_null, cg_cm, idef->iparams,
-                                      idef_t,
-                                      izone,
-                                      gmx::RangePartitioning::Block(cg0t, cg1t));
-
-                if (izone < nzone_excl)
+                if (!rt->bExclRequired)
                 {
-                    if (thread == 0)
-                    {
-                        excl_t = lexcls;
-                    }
-                    else
-                    {
-                        excl_t      = &rt->th_work[thread].excl;
-                        excl_t->nr  = 0;
-                        excl_t->nra = 0;
-                    }
-
-                    if (!rt->bExclRequired)
-                    {
-                        /* No charge groups and no distance check required */
-                        make_exclusions_zone(dd, zones, mtop->moltype, cginfo,
-                                             excl_t, izone, cg0t,
-                                             cg1t,
-                                             mtop->intermolecularExclusionGroup);
-                    }
-                    else
-                    {
-                        rt->th_work[thread].excl_count =
-                            make_exclusions_zone_cg(dd, zones,
-                                                    mtop->moltype, bRCheck2B, rc2,
-                                                    pbc_null, cg_cm, cginfo,
-                                                    excl_t,
-                                                    izone,
-                                                    cg0t, cg1t);
-                    }
+                    /* No charge groups and no distance check required */
+                    make_exclusions_zone(dd, zones, mtop->moltype, cginfo,
+                                         excl_t, izone, cg0t,
+                                         cg1t,
+                                         mtop->intermolecularExclusionGroup);
+                }
+                else
+                {
+                    rt->th_work[thread].excl_count =
+                        make_exclusions_zone_cg(dd, zones,
+                                                mtop->moltype, bRCheck2B, rc2,
+                                                pbc_null, cg_cm, cginfo,
+                                                excl_t,
+                                                izone,
+                                                cg0t, cg1t);
                 }
             }
             GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
@@ -1850,25 +2066,12 @@ static int make_local_bondeds_excls(gmx_domdec_t *dd,
 
         if (rt->th_work.size() > 1)
         {
-            combine_idef(idef, rt->th_work);
+            combine_blocka(lexcls, rt->th_work);
         }
 
         for (const thread_work_t &th_work : rt->th_work)
         {
-            nbonded_local += th_work.nbonded;
-        }
-
-        if (izone < nzone_excl)
-        {
-            if (rt->th_work.size() > 1)
-            {
-                combine_blocka(lexcls, rt->th_work);
-            }
-
-            for (const thread_work_t &th_work : rt->th_work)
-            {
-                *excl_count += th_work.excl_count;
-            }
+            *excl_count += th_work.excl_count;
         }
     }
 
@@ -1961,12 +2164,15 @@ void dd_make_local_top(gmx_domdec_t *dd, gmx_domdec_zones_t *zones,
         }
     }
 
+    /* The threads in make_local_bondeds_excls only read ga2la */
+    dd->ga2la->setConcurrentReadMode(true);
     dd->nbonded_local =
         make_local_bondeds_excls(dd, zones, &mtop, fr->cginfo.data(),
                                  bRCheckMB, rcheck, bRCheck2B, rc,
                                  pbc_null, cgcm_or_x,
                                  &ltop->idef,
                                  &ltop->excls, &nexcl);
+    dd->ga2la->setConcurrentReadMode(false);
 
     /* The ilist is not sorted yet,
      * we can only do this when we have the charge arrays.
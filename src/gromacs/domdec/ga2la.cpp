@@ -45,6 +45,8 @@
 
 #include "ga2la.h"
 
+#include <algorithm>
+
 /*! \brief Returns whether to use a direct list only
  *
  * There are two methods implemented for finding the local atom number
@@ -82,3 +84,48 @@ gmx_ga2la_t::gmx_ga2la_t(int numAtomsTotal,
         new(&(data_.hashed)) gmx::HashedMap<Entry>(numAtomsLocal);
     }
 }
+
+template <bool homeOnly>
+void gmx_ga2la_t::findLocalIndicesImpl(gmx::ArrayRef<const int> globalIndices,
+                                       gmx::ArrayRef<int>       localIndices) const
+{
+    GMX_ASSERT(globalIndices.size() == localIndices.size(), "The index lists should have the same size");
+
+    const int numIndices = globalIndices.size();
+    if (usingDirect_)
+    {
+        /* Branch-free loop, so the compiler can vectorize with gathers */
+        for (int i = 0; i < numIndices; i++)
+        {
+            const Entry &entry = data_.direct[globalIndices[i]];
+            const bool   found = (homeOnly ? entry.cell == 0 : entry.cell >= 0);
+            localIndices[i]    = (found ? entry.la : -1);
+        }
+    }
+    else
+    {
+        /* Process in blocks, so the entry pointers stay on the stack
+         * and the table entries searched in the first pass of the hashed
+         * lookup are likely still in cache in its second pass.
+         */
+        constexpr int c_blockSize = 64;
+        const Entry  *entries[c_blockSize];
+        for (int blockStart = 0; blockStart < numIndices; blockStart += c_blockSize)
+        {
+            const int blockSize = std::min(c_blockSize, numIndices - blockStart);
+            data_.hashed.find(globalIndices.subArray(blockStart, blockSize),
+                              gmx::arrayRefFromArray(entries, blockSize));
+            for (int i = 0; i < blockSize; i++)
+            {
+                const Entry *entry = entries[i];
+                const bool   found = (entry && (homeOnly ? entry->cell == 0 : true));
+                localIndices[blockStart + i] = (found ? entry->la : -1);
+            }
+        }
+    }
+}
+
+template void gmx_ga2la_t::findLocalIndicesImpl<false>(gmx::ArrayRef<const int>,
+                                                       gmx::ArrayRef<int>) const;
+template void gmx_ga2la_t::findLocalIndicesImpl<true>(gmx::ArrayRef<const int>,
+                                                      gmx::ArrayRef<int>) const;
@@ -51,12 +51,18 @@
 #include <vector>
 
 #include "gromacs/domdec/hashedmap.h"
+#include "gromacs/utility/arrayref.h"
 #include "gromacs/utility/gmxassert.h"
 
 /*! \libinternal \brief Global to local atom mapping
  *
  * Used for efficient mapping from global atom indices to local atom indices
  * in the domain decomposition.
+ *
+ * All const methods only read the list, so they can be called concurrently
+ * by multiple threads without locking. To catch modifications while threads
+ * might be reading, the list can be put in concurrent-read mode, in which
+ * all modifying calls trigger an assertion in debug builds.
  */
 class gmx_ga2la_t
 {
@@ -89,6 +95,7 @@ class gmx_ga2la_t
                     const Entry &value)
         {
             GMX_ASSERT(a_gl >= 0, "Only global atom indices >= 0 are supported");
+            GMX_ASSERT(!concurrentReadMode_, "Can not modify the list in concurrent-read mode");
             if (usingDirect_)
             {
                 GMX_ASSERT(data_.direct[a_gl].cell == -1, "The key to be inserted should not be present");
@@ -100,9 +107,30 @@ class gmx_ga2la_t
             }
         }
 
+        /*! \brief Inserts an entry when \p a_gl is not present, otherwise sets the value
+         *
+         * \param[in]  a_gl   The global atom index
+         * \param[in]  value  The value to set for this index
+         */
+        void insert_or_assign(int          a_gl,
+                              const Entry &value)
+        {
+            GMX_ASSERT(a_gl >= 0, "Only global atom indices >= 0 are supported");
+            GMX_ASSERT(!concurrentReadMode_, "Can not modify the list in concurrent-read mode");
+            if (usingDirect_)
+            {
+                data_.direct[a_gl] = value;
+            }
+            else
+            {
+                data_.hashed.insert_or_assign(a_gl, value);
+            }
+        }
+
         //! Delete the entry for global atom a_gl
         void erase(int a_gl)
         {
+            GMX_ASSERT(!concurrentReadMode_, "Can not modify the list in concurrent-read mode");
             if (usingDirect_)
             {
                 data_.direct[a_gl].cell = -1;
@@ -139,6 +167,7 @@ class gmx_ga2la_t
          */
         Entry &at(int a_gl)
         {
+            GMX_ASSERT(!concurrentReadMode_, "Can not modify the list in concurrent-read mode");
             if (usingDirect_)
             {
                 GMX_ASSERT(data_.direct[a_gl].cell >= 0, "a_gl should be present");
@@ -152,9 +181,39 @@ class gmx_ga2la_t
             }
         }
 
+        /*! \brief Sets the local indices for a list of global atom indices
+         *
+         * \p localIndices[i] is set to the local index of global atom
+         * \p globalIndices[i] when present, to -1 otherwise.
+         * This is faster than calling find() for each atom, since
+         * the lookups are done in blocks with independent memory accesses.
+         *
+         * \param[in]  globalIndices  The global atom indices
+         * \param[out] localIndices   The local atom indices, should have the same size as \p globalIndices
+         */
+        void findLocalIndices(gmx::ArrayRef<const int> globalIndices,
+                              gmx::ArrayRef<int>       localIndices) const
+        {
+            findLocalIndicesImpl<false>(globalIndices, localIndices);
+        }
+
+        /*! \brief Sets the local indices for a list of global atom indices, -1 for non-home atoms
+         *
+         * As findLocalIndices(), but only home atoms are considered present.
+         *
+         * \param[in]  globalIndices  The global atom indices
+         * \param[out] localIndices   The local atom indices, should have the same size as \p globalIndices
+         */
+        void findHomeLocalIndices(gmx::ArrayRef<const int> globalIndices,
+                                  gmx::ArrayRef<int>       localIndices) const
+        {
+            findLocalIndicesImpl<true>(globalIndices, localIndices);
+        }
+
         //! Clear all the entries in the list.
         void clear()
         {
+            GMX_ASSERT(!concurrentReadMode_, "Can not modify the list in concurrent-read mode");
             if (usingDirect_)
             {
                 for (Entry &entry : data_.direct) {entry.cell = -1; }
@@ -165,7 +224,22 @@ class gmx_ga2la_t
             }
         }
 
+        /*! \brief Sets whether the list is being read concurrently by multiple threads
+         *
+         * While in concurrent-read mode, the list should not be modified.
+         * This is checked in debug builds.
+         */
+        void setConcurrentReadMode(bool concurrentReadMode)
+        {
+            concurrentReadMode_ = concurrentReadMode;
+        }
+
     private:
+        //! Implementation of findLocalIndices() and, with \p homeOnly=true, findHomeLocalIndices()
+        template <bool homeOnly>
+        void findLocalIndicesImpl(gmx::ArrayRef<const int> globalIndices,
+                                  gmx::ArrayRef<int>       localIndices) const;
+
         union Data
         {
             std::vector<Entry>    direct;
@@ -175,6 +249,8 @@ class gmx_ga2la_t
             ~Data() {}
         } data_;
         const bool usingDirect_;
+        //! Whether the list is being read concurrently, only used for checking
+        bool       concurrentReadMode_ = false;
 };
 
 #endif
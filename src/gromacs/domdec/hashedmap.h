@@ -53,8 +53,10 @@
 #include <vector>
 
 #include "gromacs/compat/utility.h"
+#include "gromacs/utility/arrayref.h"
 #include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/gmxassert.h"
 
 namespace gmx
 {
@@ -301,6 +303,46 @@ class HashedMap
             return nullptr;
         }
 
+        /*! \brief Sets pointers to the values for a list of keys
+         *
+         * \p values[i] is set to a pointer to the value for \p keys[i]
+         * or nullptr when not present. The keys are first all compared
+         * with the entry at their hash index, which requires only
+         * independent loads that can be overlapped by the hardware.
+         * Only for the, usually few, keys not found there the linked
+         * lists are searched in a second pass.
+         *
+         * \param[in]  keys    The keys
+         * \param[out] values  The pointers to the values, should have the same size as \p keys
+         */
+        void find(ArrayRef<const int> keys,
+                  ArrayRef<const T *> values) const
+        {
+            GMX_ASSERT(keys.size() == values.size(), "keys and values should have the same size");
+
+            const int numKeys = keys.size();
+            for (int i = 0; i < numKeys; i++)
+            {
+                const hashEntry &entry = table_[keys[i] & bitMask_];
+                values[i]              = (entry.key == keys[i] ? &entry.value : nullptr);
+            }
+            for (int i = 0; i < numKeys; i++)
+            {
+                if (values[i] == nullptr)
+                {
+                    int ind = table_[keys[i] & bitMask_].next;
+                    while (ind >= 0 && table_[ind].key != keys[i])
+                    {
+                        ind = table_[ind].next;
+                    }
+                    if (ind >= 0)
+                    {
+                        values[i] = &table_[ind].value;
+                    }
+                }
+            }
+        }
+
         /*! \brief Clear all the entries in the list
          *
          * Also optimizes the size of the table based on the current
@@ -73,18 +73,23 @@ LocalAtomSetData::setLocalAndCollectiveIndices(const gmx_ga2la_t &ga2la)
      */
     int  numAtomsGlobal   = globalIndex_.size();
 
+    /* Look up all indices in one bulk call, then compact in place */
+    localIndex_.resize(numAtomsGlobal);
+    ga2la.findHomeLocalIndices(globalIndex_, localIndex_);
+
     /* Clear vector without changing capacity,
      * because we expect the size of the vectors to vary little. */
-    localIndex_.resize(0);
     collectiveIndex_.resize(0);
 
+    int numAtomsLocal = 0;
     for (int iCollective = 0; iCollective < numAtomsGlobal; iCollective++)
     {
-        if (const int *iLocal = ga2la.findHome(globalIndex_[iCollective]))
+        const int iLocal = localIndex_[iCollective];
+        if (iLocal >= 0)
         {
             /* Save the atoms index in the local atom numbers array */
             /* The atom with this index is a home atom. */
-            localIndex_.push_back(*iLocal);
+            localIndex_[numAtomsLocal++] = iLocal;
 
             /* Keep track of where this local atom belongs in the collective index array.
              * This is needed when reducing the local arrays to a collective/global array
@@ -92,6 +97,7 @@ LocalAtomSetData::setLocalAndCollectiveIndices(const gmx_ga2la_t &ga2la)
             collectiveIndex_.push_back(iCollective);
         }
     }
+    localIndex_.resize(numAtomsLocal);
 }
 
 } // namespace internal
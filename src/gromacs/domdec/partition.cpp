@@ -538,6 +538,50 @@ static void make_dd_indices(gmx_domdec_t *dd,
     }
 }
 
+/*! \brief Maximum fraction of home atoms migrating between ranks for updating the global to local index incrementally
+ *
+ * With many migrated atoms the hashed global to local list can get far
+ * from optimal occupation, which is only corrected by clearing it.
+ */
+static constexpr real c_maxMigratedFractionForIncrementalIndices = 0.25;
+
+void updateHomeAtomIndices(gmx::ArrayRef<const gmx_cgsort_t> sort,
+                           int                               numAtomsKept,
+                           gmx::ArrayRef<const int>          globalAtomGroupIndices,
+                           std::vector<int>                 *globalAtomIndices,
+                           gmx_ga2la_t                      *ga2la)
+{
+    const int numHomeAtoms = sort.ssize();
+
+    globalAtomIndices->resize(numHomeAtoms);
+    for (int a = 0; a < numHomeAtoms; a++)
+    {
+        const int aOld = sort[a].ind;
+        if (aOld == a && aOld < numAtomsKept)
+        {
+            /* This atom stayed home at the same local index, so both its
+             * global index and its global to local entry are still correct.
+             */
+            continue;
+        }
+
+        const int a_gl = globalAtomGroupIndices[a];
+        (*globalAtomIndices)[a] = a_gl;
+        if (aOld < numAtomsKept)
+        {
+            /* This atom stayed home, but got a new local index */
+            ga2la->at(a_gl).la = a;
+        }
+        else
+        {
+            /* This atom was received, the entries of received atoms
+             * that used to be in the halo have been removed already.
+             */
+            ga2la->insert(a_gl, { a, 0 });
+        }
+    }
+}
+
 //! Checks the charge-group assignements.
 static int check_bLocalCG(gmx_domdec_t *dd, int ncg_sys, const char *bLocalCG,
                           const char *where)
@@ -663,8 +707,11 @@ static void clearDDStateIndices(gmx_domdec_t *dd,
     }
     else
     {
+        /* Keep the entries for the home atoms, those are updated
+         * incrementally after redistribution or cleared after sorting.
+         */
         const int numAtomsInZones = dd->comm->atomRanges.end(DDAtomRanges::Type::Zones);
-        for (int i = 0; i < numAtomsInZones; i++)
+        for (int i = atomStart; i < numAtomsInZones; i++)
         {
             ga2la.erase(dd->globalAtomIndices[i]);
         }
@@ -3054,6 +3101,12 @@ void dd_partition_system(FILE                    *fplog,
      * obtaining correct local charge group / atom counts.
      */
     ncg_moved = 0;
+    /* When only few atoms migrated, we keep the global to local entries
+     * of the atoms that stayed home and only update those after sorting.
+     * Large shifts of the cell boundaries by DLB cause many atoms to
+     * migrate, in that case we fall back to rebuilding all indices.
+     */
+    bool updateHomeIndicesIncrementally = false;
     if (bRedist)
     {
         wallcycle_sub_start(wcycle, ewcsDD_REDIST);
@@ -3065,6 +3118,12 @@ void dd_partition_system(FILE                    *fplog,
 
         GMX_RELEASE_ASSERT(bSortCG, "Sorting is required after redistribution");
 
+        /* The moved atoms are still present, received atoms are appended */
+        const int numAtomsReceived = dd->ncg_home - ncgindex_set;
+        const int numAtomsMigrated = ncg_moved + numAtomsReceived;
+        updateHomeIndicesIncrementally =
+            (numAtomsMigrated <= c_maxMigratedFractionForIncrementalIndices*(dd->ncg_home - ncg_moved));
+
         if (comm->useUpdateGroups)
         {
             comm->updateGroupsCog->addCogs(gmx::arrayRefFromArray(dd->globalAtomGroupIndices.data(), dd->ncg_home),
@@ -3127,9 +3186,27 @@ void dd_partition_system(FILE                    *fplog,
         /* After sorting and compacting we set the correct size */
         dd_resize_state(state_local, f, comm->atomRanges.numHomeAtoms());
 
-        /* Rebuild all the indices */
-        dd->ga2la->clear();
-        ncgindex_set = 0;
+        if (updateHomeIndicesIncrementally)
+        {
+            /* Only update the home atom indices, the rest is set below */
+            updateHomeAtomIndices(comm->sort->sorted, ncgindex_set,
+                                  dd->globalAtomGroupIndices,
+                                  &dd->globalAtomIndices, dd->ga2la);
+            ncgindex_set = dd->ncg_home;
+        }
+        else
+        {
+            /* Rebuild all the indices */
+            dd->ga2la->clear();
+            ncgindex_set = 0;
+        }
+
+        if (debug)
+        {
+            fprintf(debug, "Step %s, %s the home atom indices\n",
+                    gmx_step_str(step, sbuf),
+                    updateHomeIndicesIncrementally ? "updating" : "rebuilding");
+        }
 
         wallcycle_sub_stop(wcycle, ewcsDD_GRID);
     }
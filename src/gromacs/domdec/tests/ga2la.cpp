@@ -0,0 +1,153 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the global to local atom index class.
+ *
+ * \ingroup module_domdec
+ */
+#include "gmxpre.h"
+
+#include "gromacs/domdec/ga2la.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "testutils/testasserts.h"
+
+namespace
+{
+
+/*! \brief Checks that the global atom is found and if so also checks the entry */
+void checkFinds(const gmx_ga2la_t &ga2la,
+                int                a_gl,
+                int                la,
+                int                cell)
+{
+    const gmx_ga2la_t::Entry *entry = ga2la.find(a_gl);
+    EXPECT_FALSE(entry == nullptr);
+    if (entry)
+    {
+        EXPECT_EQ(entry->la, la);
+        EXPECT_EQ(entry->cell, cell);
+    }
+}
+
+/*! \brief Checks insertion, in-place updates and erasing */
+void checkInsertsAssignsErases(gmx_ga2la_t *ga2la)
+{
+    ga2la->insert(10, { 0, 0 });
+    ga2la->insert(5,  { 1, 0 });
+    ga2la->insert(7,  { 2, 1 });
+
+    checkFinds(*ga2la, 10, 0, 0);
+    checkFinds(*ga2la, 7,  2, 1);
+    EXPECT_TRUE(ga2la->findHome(7) == nullptr);
+
+    /* Reorder the home atoms in place and add a new one */
+    ga2la->insert_or_assign(10, { 1, 0 });
+    ga2la->insert_or_assign(5,  { 0, 0 });
+    ga2la->insert_or_assign(3,  { 3, 0 });
+    ga2la->erase(7);
+
+    checkFinds(*ga2la, 10, 1, 0);
+    checkFinds(*ga2la, 5,  0, 0);
+    checkFinds(*ga2la, 3,  3, 0);
+    EXPECT_TRUE(ga2la->find(7) == nullptr);
+
+    ga2la->clear();
+    EXPECT_TRUE(ga2la->find(10) == nullptr);
+    EXPECT_TRUE(ga2la->find(3) == nullptr);
+}
+
+/*! \brief Checks the bulk lookup of local indices, also of more atoms than the block size */
+void checkFindsLocalIndices(gmx_ga2la_t *ga2la)
+{
+    const int        numAtoms = 150;
+    std::vector<int> globalIndices;
+    for (int a = 0; a < numAtoms; a++)
+    {
+        /* Every third atom is not local, every other local atom is a home atom */
+        if (a % 3 != 0)
+        {
+            ga2la->insert(a, { numAtoms - a, a % 2 });
+        }
+        globalIndices.push_back(a);
+    }
+
+    std::vector<int> localIndices(numAtoms);
+    ga2la->findLocalIndices(globalIndices, localIndices);
+    for (int a = 0; a < numAtoms; a++)
+    {
+        EXPECT_EQ(localIndices[a], (a % 3 != 0) ? numAtoms - a : -1);
+    }
+
+    ga2la->findHomeLocalIndices(globalIndices, localIndices);
+    for (int a = 0; a < numAtoms; a++)
+    {
+        EXPECT_EQ(localIndices[a], (a % 3 != 0 && a % 2 == 0) ? numAtoms - a : -1);
+    }
+}
+
+TEST(GlobalToLocalAtoms, DirectListInsertsAssignsErases)
+{
+    gmx_ga2la_t ga2la(100, 50);
+
+    checkInsertsAssignsErases(&ga2la);
+}
+
+TEST(GlobalToLocalAtoms, HashedListInsertsAssignsErases)
+{
+    gmx_ga2la_t ga2la(100000, 100);
+
+    checkInsertsAssignsErases(&ga2la);
+}
+
+TEST(GlobalToLocalAtoms, DirectListFindsLocalIndices)
+{
+    gmx_ga2la_t ga2la(1000, 1000);
+
+    checkFindsLocalIndices(&ga2la);
+}
+
+TEST(GlobalToLocalAtoms, HashedListFindsLocalIndices)
+{
+    gmx_ga2la_t ga2la(100000, 100);
+
+    checkFindsLocalIndices(&ga2la);
+}
+
+} // namespace
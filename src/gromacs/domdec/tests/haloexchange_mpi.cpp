@@ -0,0 +1,249 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests the overlapped coordinate halo exchange
+ *
+ * Sets up coordinate halo communication on a 2x2 domain grid by hand
+ * and checks that the halo coordinates after dd_move_x_start() and
+ * dd_move_x_finish() match those after dd_move_x(), with one and two
+ * pulses along the first dimension and with and without receiving
+ * in place.
+ *
+ * \ingroup module_domdec
+ */
+#include "gmxpre.h"
+
+#include <limits>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/domdec/atomdistribution.h"
+#include "gromacs/domdec/domdec.h"
+#include "gromacs/domdec/domdec_internal.h"
+#include "gromacs/domdec/domdec_struct.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/utility/gmxmpi.h"
+#include "gromacs/utility/stringutil.h"
+
+#include "testutils/mpitest.h"
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! The number of domains along each of the two decomposition dimensions
+constexpr int c_numDomainsPerDim = 2;
+
+//! Returns the rank of the domain at Cartesian domain index \p ci
+int domainRank(const ivec ci)
+{
+    return ci[XX]*c_numDomainsPerDim + ci[YY];
+}
+
+//! Returns the number of home atoms of \p rank
+int numHomeAtoms(int rank)
+{
+    return 20 + 3*rank;
+}
+
+//! Returns the number of atoms \p rank sends in pulse \p pulse along dimension index \p d
+int numAtomsToSend(int rank, int d, int pulse)
+{
+    return 2 + (3*rank + 2*d + pulse) % 5;
+}
+
+/*! \brief Sets up \p dd on a 2x2 grid with \p numPulsesX pulses along x and one along y
+ *
+ * Each pulse sends a scattered selection of the home atoms and of the
+ * atoms received in earlier pulses. Without \p receiveInPlace, the
+ * atoms received along y are stored with the zones in reverse order.
+ * Returns the total number of home and halo atoms.
+ */
+int setUpHaloCommunication(gmx_domdec_t *dd, int numPulsesX, bool receiveInPlace)
+{
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    dd->mpi_comm_all = MPI_COMM_WORLD;
+    dd->rank         = rank;
+    dd->nc[XX]       = c_numDomainsPerDim;
+    dd->nc[YY]       = c_numDomainsPerDim;
+    dd->nc[ZZ]       = 1;
+    dd->ci[XX]       = rank/c_numDomainsPerDim;
+    dd->ci[YY]       = rank % c_numDomainsPerDim;
+    dd->ci[ZZ]       = 0;
+    dd->ndim         = 2;
+    dd->dim[0]       = XX;
+    dd->dim[1]       = YY;
+    dd->bScrewPBC    = FALSE;
+    for (int d = 0; d < dd->ndim; d++)
+    {
+        const int dim = dd->dim[d];
+        ivec      ci;
+        copy_ivec(dd->ci, ci);
+        ci[dim]            = (dd->ci[dim] + 1) % dd->nc[dim];
+        dd->neighbor[d][0] = domainRank(ci);
+        ci[dim]            = (dd->ci[dim] - 1 + dd->nc[dim]) % dd->nc[dim];
+        dd->neighbor[d][1] = domainRank(ci);
+    }
+
+    gmx_domdec_comm_t *comm    = dd->comm;
+    const int          numHome = numHomeAtoms(rank);
+    comm->atomRanges.setEnd(DDAtomRanges::Type::Home, numHome);
+
+    int nzone   = 1;
+    int nat_tot = numHome;
+    for (int d = 0; d < dd->ndim; d++)
+    {
+        gmx_domdec_comm_dim_t &cd = comm->cd[d];
+        cd.receiveInPlace = receiveInPlace;
+        cd.ind.resize(d == 0 ? numPulsesX : 1);
+        for (int p = 0; p < cd.numPulses(); p++)
+        {
+            gmx_domdec_ind_t &ind = cd.ind[p];
+
+            const int         numSend = numAtomsToSend(rank, d, p);
+
+            ind.index.clear();
+            for (int k = 0; k < numSend; k++)
+            {
+                ind.index.push_back((7*k + rank + p) % nat_tot);
+            }
+            ind.nsend[nzone + 1] = numSend;
+
+            /* We receive from the forward neighbor */
+            const int numRecv = numAtomsToSend(dd->neighbor[d][0], d, p);
+            ind.nrecv[nzone + 1] = numRecv;
+            if (nzone == 1)
+            {
+                ind.cell2at0[0] = nat_tot;
+                ind.cell2at1[0] = nat_tot + numRecv;
+            }
+            else
+            {
+                const int numRecvZone0 = numRecv/2;
+                ind.cell2at0[1] = nat_tot;
+                ind.cell2at1[1] = nat_tot + numRecv - numRecvZone0;
+                ind.cell2at0[0] = ind.cell2at1[1];
+                ind.cell2at1[0] = nat_tot + numRecv;
+            }
+            nat_tot += numRecv;
+        }
+        nzone += nzone;
+    }
+    comm->atomRanges.setEnd(DDAtomRanges::Type::Zones, nat_tot);
+
+    return nat_tot;
+}
+
+//! Returns coordinates with unique home atom values for \p step and NaN halo values
+std::vector<RVec> makeCoordinates(int rank, int numAtomsTotal, int step)
+{
+    const real        nan = std::numeric_limits<real>::quiet_NaN();
+    std::vector<RVec> x(numAtomsTotal, { nan, nan, nan });
+    for (int a = 0; a < numHomeAtoms(rank); a++)
+    {
+        x[a] = { real(rank), real(a), real(step) };
+    }
+
+    return x;
+}
+
+//! Checks that the overlapped halo exchange gives the same coordinates as dd_move_x
+void checkStartFinishMatchesMoveX(int numPulsesX, bool receiveInPlace)
+{
+    gmx_domdec_comm_t comm;
+    gmx_domdec_t      dd;
+    dd.comm                 = &comm;
+    const int numAtomsTotal = setUpHaloCommunication(&dd, numPulsesX, receiveInPlace);
+
+    matrix    box = { { 5, 0, 0 }, { 0, 6, 0 }, { 0, 0, 7 } };
+
+    /* Two steps, to check that the persistent buffers are reused correctly */
+    for (int step = 0; step < 2; step++)
+    {
+        SCOPED_TRACE(formatString("step %d", step));
+
+        std::vector<RVec> reference = makeCoordinates(dd.rank, numAtomsTotal, step);
+        dd_move_x(&dd, box, reference, nullptr);
+
+        std::vector<RVec> x = makeCoordinates(dd.rank, numAtomsTotal, step);
+        dd_move_x_start(&dd, box, x, nullptr);
+        dd_move_x_finish(&dd, box, x, nullptr);
+
+        for (int a = 0; a < numAtomsTotal; a++)
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                /* The comparison also fails for halo atoms that were not set */
+                EXPECT_EQ(reference[a][d], x[a][d]) << "atom " << a << " dim " << d;
+            }
+        }
+    }
+}
+
+TEST(HaloExchangeTest, StartFinishMatchesMoveX)
+{
+    GMX_MPI_TEST(4);
+    checkStartFinishMatchesMoveX(1, true);
+}
+
+TEST(HaloExchangeTest, StartFinishMatchesMoveXNotInPlace)
+{
+    GMX_MPI_TEST(4);
+    checkStartFinishMatchesMoveX(1, false);
+}
+
+TEST(HaloExchangeTest, StartFinishMatchesMoveXWithTwoPulses)
+{
+    GMX_MPI_TEST(4);
+    checkStartFinishMatchesMoveX(2, true);
+}
+
+TEST(HaloExchangeTest, StartFinishMatchesMoveXWithTwoPulsesNotInPlace)
+{
+    GMX_MPI_TEST(4);
+    checkStartFinishMatchesMoveX(2, false);
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -43,6 +43,8 @@
 
 #include "gromacs/domdec/hashedmap.h"
 
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include "testutils/testasserts.h"
@@ -166,6 +168,31 @@ TEST(HashedMap, LinkedEntries)
     checkFinds(map, 3 + 2*largePowerOf2, 'c');
 }
 
+// Check that bulk lookup finds direct and linked entries and misses
+TEST(HashedMap, FindsMultipleKeys)
+{
+    gmx::HashedMap<char> map(20);
+
+    const int            largePowerOf2 = 2048;
+
+    map.insert(3 + 0*largePowerOf2, 'a');
+    map.insert(3 + 1*largePowerOf2, 'b');
+    map.insert(8, 'c');
+
+    const std::vector<int> keys = { 3 + 1*largePowerOf2, 8, 5, 3 + 0*largePowerOf2, 3 + 2*largePowerOf2 };
+    std::vector<const char *> values(keys.size());
+    map.find(keys, values);
+
+    ASSERT_TRUE(values[0] != nullptr);
+    EXPECT_EQ(*values[0], 'b');
+    ASSERT_TRUE(values[1] != nullptr);
+    EXPECT_EQ(*values[1], 'c');
+    EXPECT_TRUE(values[2] == nullptr);
+    ASSERT_TRUE(values[3] != nullptr);
+    EXPECT_EQ(*values[3], 'a');
+    EXPECT_TRUE(values[4] == nullptr);
+}
+
 // HashedMap only throws in debug mode, so only test in debug mode
 #ifndef NDEBUG
 
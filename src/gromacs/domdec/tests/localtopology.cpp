@@ -0,0 +1,349 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the generation of the local topology.
+ *
+ * \ingroup module_domdec
+ */
+#include "gmxpre.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/domdec/atomdistribution.h"
+#include "gromacs/domdec/domdec.h"
+#include "gromacs/domdec/domdec_internal.h"
+#include "gromacs/domdec/domdec_struct.h"
+#include "gromacs/domdec/ga2la.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/mdlib/dispersioncorrection.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
+#include "gromacs/mdtypes/forcerec.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/nbnxm/nbnxm.h"
+#include "gromacs/pbcutil/pbc.h"
+#include "gromacs/topology/ifunc.h"
+#include "gromacs/topology/mtop_util.h"
+#include "gromacs/topology/topology.h"
+#include "gromacs/utility/smalloc.h"
+
+#include "testutils/testasserts.h"
+
+namespace
+{
+
+//! The number of atoms in a molecule
+constexpr int  c_numAtomsPerMolecule = 5;
+//! The number of molecules in the system
+constexpr int  c_numMolecules        = 40;
+//! The number of atoms in the system
+constexpr int  c_numAtoms            = c_numMolecules*c_numAtomsPerMolecule;
+//! The spacing of the molecules along x
+constexpr real c_moleculeSpacing     = 0.25;
+//! The spacing of the atoms in a molecule along x
+constexpr real c_atomSpacing         = 0.12;
+//! The upper x-boundary of the home zone
+constexpr real c_homeZoneEnd         = 0.5*c_numMolecules*c_moleculeSpacing;
+//! The cut-off distance, also the width of the halo zone
+constexpr real c_cutoff              = 0.4;
+
+//! Returns the position of global atom \p a
+gmx::RVec atomPosition(int a)
+{
+    const int molecule = a/c_numAtomsPerMolecule;
+    const int atom     = a % c_numAtomsPerMolecule;
+
+    return { molecule*c_moleculeSpacing + atom*c_atomSpacing,
+             0.1_real*(atom % 2),
+             0.05_real*(molecule % 3) };
+}
+
+/*! \brief Builds a system of chain molecules with bonds, angles and dihedrals
+ *
+ * The first and last atom of each molecule are also bonded, beyond
+ * the cut-off distance. Some molecules are connected by intermolecular
+ * bonds and angles.
+ */
+void fillTopology(gmx_mtop_t *mtop)
+{
+    mtop->ffparams.atnr     = 1;
+    mtop->ffparams.functype = { F_BONDS, F_ANGLES, F_PDIHS };
+    mtop->ffparams.iparams.resize(mtop->ffparams.functype.size());
+
+    mtop->moltype.resize(1);
+    gmx_moltype_t &moltype = mtop->moltype[0];
+    moltype.atoms.nr       = c_numAtomsPerMolecule;
+    /* Every atom is a charge group, as with the Verlet scheme */
+    moltype.cgs.nr         = c_numAtomsPerMolecule;
+    srenew(moltype.cgs.index, c_numAtomsPerMolecule + 1);
+    /* Each atom excludes itself and its bonded neighbors */
+    moltype.excls.nr       = c_numAtomsPerMolecule;
+    srenew(moltype.excls.index, c_numAtomsPerMolecule + 1);
+    snew(moltype.excls.a, 3*c_numAtomsPerMolecule);
+    moltype.excls.nra      = 0;
+    for (int a = 0; a < c_numAtomsPerMolecule; a++)
+    {
+        moltype.cgs.index[a]   = a;
+        moltype.excls.index[a] = moltype.excls.nra;
+        for (int b = std::max(a - 1, 0); b <= std::min(a + 1, c_numAtomsPerMolecule - 1); b++)
+        {
+            moltype.excls.a[moltype.excls.nra++] = b;
+        }
+    }
+    moltype.cgs.index[c_numAtomsPerMolecule]   = c_numAtomsPerMolecule;
+    moltype.excls.index[c_numAtomsPerMolecule] = moltype.excls.nra;
+
+    InteractionLists &ilist = moltype.ilist;
+    for (int a = 0; a + 1 < c_numAtomsPerMolecule; a++)
+    {
+        ilist[F_BONDS].iatoms.insert(ilist[F_BONDS].iatoms.end(), { 0, a, a + 1 });
+    }
+    ilist[F_BONDS].iatoms.insert(ilist[F_BONDS].iatoms.end(), { 0, 0, c_numAtomsPerMolecule - 1 });
+    for (int a = 0; a + 2 < c_numAtomsPerMolecule; a++)
+    {
+        ilist[F_ANGLES].iatoms.insert(ilist[F_ANGLES].iatoms.end(), { 1, a, a + 1, a + 2 });
+    }
+    for (int a = 0; a + 3 < c_numAtomsPerMolecule; a++)
+    {
+        ilist[F_PDIHS].iatoms.insert(ilist[F_PDIHS].iatoms.end(), { 2, a, a + 1, a + 2, a + 3 });
+    }
+
+    mtop->molblock.resize(1);
+    mtop->molblock[0].type = 0;
+    mtop->molblock[0].nmol = c_numMolecules;
+    mtop->natoms           = c_numAtoms;
+
+    mtop->bIntermolecularInteractions = true;
+    mtop->intermolecular_ilist        = std::make_unique<InteractionLists>();
+    InteractionLists &ilistIntermol   = *mtop->intermolecular_ilist;
+    for (int m = 0; m + 1 < c_numMolecules; m += 3)
+    {
+        const int lastAtom  = m*c_numAtomsPerMolecule + c_numAtomsPerMolecule - 1;
+        const int nextAtom  = (m + 1)*c_numAtomsPerMolecule;
+        ilistIntermol[F_BONDS].iatoms.insert(ilistIntermol[F_BONDS].iatoms.end(),
+                                             { 0, lastAtom, nextAtom });
+        ilistIntermol[F_ANGLES].iatoms.insert(ilistIntermol[F_ANGLES].iatoms.end(),
+                                              { 1, lastAtom - 1, lastAtom, nextAtom });
+    }
+
+    gmx_mtop_finalize(mtop);
+}
+
+//! The bonded interactions of a local topology, with global atom indices, for each function type
+typedef std::vector< std::vector< std::vector<int> > > GlobalInteractions;
+
+/*! \brief Generates the local topology for one domain of a 1D decomposition and returns its bonded interactions
+ *
+ * The home zone holds the atoms below c_homeZoneEnd along x, the halo
+ * zone, shifted by one cell along x, holds the atoms up to the cut-off
+ * distance above it. The molecules at the zone boundary are split over
+ * the zones. The home atoms are not in molecule order and the halo
+ * atoms are in reverse order.
+ */
+GlobalInteractions makeLocalBondeds(const gmx_mtop_t &mtop,
+                                    bool              useMoleculeTemplates,
+                                    int              *numBondedsLocal)
+{
+    std::vector<int> homeAtoms;
+    std::vector<int> haloAtoms;
+    for (int a = 0; a < c_numAtoms; a++)
+    {
+        const real x = atomPosition(a)[XX];
+        if (x < c_homeZoneEnd)
+        {
+            homeAtoms.push_back(a);
+        }
+        else if (x < c_homeZoneEnd + c_cutoff)
+        {
+            haloAtoms.push_back(a);
+        }
+    }
+    std::sort(homeAtoms.begin(), homeAtoms.end(),
+              [](int a, int b) { return (a*37) % c_numAtoms < (b*37) % c_numAtoms; });
+    std::reverse(haloAtoms.begin(), haloAtoms.end());
+
+    gmx_domdec_comm_t comm;
+    comm.haveInterDomainMultiBodyBondeds = false;
+    comm.cutoff_mbody                    = 0;
+    comm.cutoff                          = c_cutoff;
+
+    gmx_domdec_t      dd;
+    dd.comm                 = &comm;
+    dd.nc[XX]               = 2;
+    dd.nc[YY]               = 1;
+    dd.nc[ZZ]               = 1;
+    dd.splitConstraints     = false;
+    dd.splitSettles         = false;
+    dd.useMoleculeTemplates = useMoleculeTemplates;
+    gmx_ga2la_t       ga2la(c_numAtoms, homeAtoms.size() + haloAtoms.size());
+    dd.ga2la                = &ga2la;
+
+    std::vector<gmx::RVec> x;
+    for (int a : homeAtoms)
+    {
+        ga2la.insert(a, { static_cast<int>(dd.globalAtomIndices.size()), 0 });
+        dd.globalAtomIndices.push_back(a);
+        x.push_back(atomPosition(a));
+    }
+    for (int a : haloAtoms)
+    {
+        ga2la.insert(a, { static_cast<int>(dd.globalAtomIndices.size()), 1 });
+        dd.globalAtomIndices.push_back(a);
+        x.push_back(atomPosition(a));
+    }
+
+    gmx_domdec_zones_t zones;
+    zones.n             = 2;
+    clear_ivec(zones.shift[0]);
+    clear_ivec(zones.shift[1]);
+    zones.shift[1][XX]  = 1;
+    zones.cg_range[0]   = 0;
+    zones.cg_range[1]   = homeAtoms.size();
+    zones.cg_range[2]   = homeAtoms.size() + haloAtoms.size();
+    zones.nizone        = 1;
+    zones.izone[0].j0   = 0;
+    zones.izone[0].j1   = 2;
+    zones.izone[0].cg1  = zones.cg_range[1];
+    zones.izone[0].jcg0 = zones.cg_range[0];
+    zones.izone[0].jcg1 = zones.cg_range[2];
+
+    t_inputrec ir;
+    ir.cutoff_scheme = ecutsVERLET;
+    ir.efep          = efepNO;
+    dd_make_reverse_top(nullptr, &dd, &mtop, nullptr, &ir, TRUE);
+
+    t_forcerec fr;
+    fr.ePBC    = epbcXYZ;
+    fr.bMolPBC = FALSE;
+    fr.cginfo.resize(x.size(), 0);
+
+    /* With a cell size below the cut-off, the distance checks are active */
+    matrix box         = { { 2*c_homeZoneEnd, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+    rvec   cellsizeMin = { 0.5*c_cutoff, 1, 1 };
+    ivec   npulse      = { 1, 1, 1 };
+
+    gmx_localtop_t ltop;
+    dd_init_local_top(mtop, &ltop);
+    dd_make_local_top(&dd, &zones, DIM, box, cellsizeMin, npulse, &fr,
+                      as_rvec_array(x.data()), mtop, &ltop);
+    *numBondedsLocal = dd.nbonded_local;
+
+    GlobalInteractions interactions(F_NRE);
+    for (int ftype = 0; ftype < F_NRE; ftype++)
+    {
+        const t_ilist &il   = ltop.idef.il[ftype];
+        const int      nral = NRAL(ftype);
+        for (int i = 0; i < il.nr; i += 1 + nral)
+        {
+            std::vector<int> interaction = { il.iatoms[i] };
+            for (int k = 1; k <= nral; k++)
+            {
+                interaction.push_back(dd.globalAtomIndices[il.iatoms[i + k]]);
+            }
+            interactions[ftype].push_back(interaction);
+        }
+        std::sort(interactions[ftype].begin(), interactions[ftype].end());
+    }
+
+    return interactions;
+}
+
+//! Test fixture, parameterized over the number of OpenMP threads
+class LocalTopologyTest : public ::testing::TestWithParam<int>
+{
+    public:
+        LocalTopologyTest() :
+            numThreadsSaved_(gmx_omp_nthreads_get(emntDomdec))
+        {
+            gmx_omp_nthreads_set(emntDomdec, GetParam());
+            fillTopology(&mtop_);
+        }
+        ~LocalTopologyTest() override
+        {
+            gmx_omp_nthreads_set(emntDomdec, numThreadsSaved_);
+        }
+
+    protected:
+        //! The global topology
+        gmx_mtop_t mtop_;
+
+    private:
+        //! The number of domdec threads to restore after the test
+        int        numThreadsSaved_;
+};
+
+TEST_P(LocalTopologyTest, MoleculeTemplatesMatchAtomByAtomAssignment)
+{
+    int                      numBondedsGeneric  = 0;
+    const GlobalInteractions generic            = makeLocalBondeds(mtop_, false, &numBondedsGeneric);
+    int                      numBondedsTemplate = 0;
+    const GlobalInteractions withTemplates      = makeLocalBondeds(mtop_, true, &numBondedsTemplate);
+
+    /* Check that the setup covers intra- and intermolecular
+     * interactions across zones and the distance check.
+     */
+    int numAcrossZones    = 0;
+    int numIntermolecular = 0;
+    for (const auto &bond : generic[F_BONDS])
+    {
+        const gmx::RVec x0 = atomPosition(bond[1]);
+        const gmx::RVec x1 = atomPosition(bond[2]);
+        if ((x0[XX] < c_homeZoneEnd) != (x1[XX] < c_homeZoneEnd))
+        {
+            numAcrossZones++;
+        }
+        if (bond[1]/c_numAtomsPerMolecule != bond[2]/c_numAtomsPerMolecule)
+        {
+            numIntermolecular++;
+        }
+        EXPECT_LT(distance2(x0, x1), c_cutoff*c_cutoff);
+    }
+    EXPECT_GT(numAcrossZones, 0);
+    EXPECT_GT(numIntermolecular, 0);
+    EXPECT_FALSE(generic[F_PDIHS].empty());
+
+    for (int ftype = 0; ftype < F_NRE; ftype++)
+    {
+        EXPECT_EQ(generic[ftype], withTemplates[ftype]) << "for " << interaction_function[ftype].longname;
+    }
+    EXPECT_EQ(numBondedsGeneric, numBondedsTemplate);
+}
+
+INSTANTIATE_TEST_CASE_P(WithThreads, LocalTopologyTest, ::testing::Values(1, 2, 4));
+
+} // namespace
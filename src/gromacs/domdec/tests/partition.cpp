@@ -0,0 +1,162 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for updating the home atom indices after repartitioning.
+ *
+ * \ingroup module_domdec
+ */
+#include "gmxpre.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/domdec/domdec_internal.h"
+#include "gromacs/domdec/ga2la.h"
+
+#include "testutils/testasserts.h"
+
+namespace
+{
+
+//! The number of atoms in the system
+constexpr int c_numAtomsTotal = 1000;
+
+/*! \brief Mimics redistribution and sorting and checks the incremental index update against a full rebuild
+ *
+ * The home atoms are a scattered selection of the system, followed by
+ * halo atoms. Some home atoms move to other ranks, some atoms are
+ * received, one of which was a halo atom. After sorting, the first part
+ * of the home atoms keeps its local indices, the rest is reordered.
+ */
+void checkIncrementalUpdateMatchesRebuild(gmx_ga2la_t *ga2la)
+{
+    const int        numHomeAtoms = 200;
+    const int        numHaloAtoms = 60;
+
+    std::vector<int> globalAtomIndices;
+    for (int a = 0; a < numHomeAtoms + numHaloAtoms; a++)
+    {
+        /* 7 and c_numAtomsTotal are coprime, so all indices are distinct */
+        globalAtomIndices.push_back((a*7 + 3) % c_numAtomsTotal);
+        ga2la->insert(globalAtomIndices[a], { a, a < numHomeAtoms ? 0 : 1 });
+    }
+
+    /* Redistribution: the entries of atoms that move away are erased
+     * while marking them, received atoms are appended to the home atoms.
+     */
+    std::vector<int>  globalAtomGroupIndices(globalAtomIndices.begin(), globalAtomIndices.begin() + numHomeAtoms);
+    std::vector<bool> moved(numHomeAtoms, false);
+    for (int a = 30; a < numHomeAtoms; a += 17)
+    {
+        moved[a] = true;
+        ga2la->erase(globalAtomIndices[a]);
+    }
+    const std::vector<int> received = { globalAtomIndices[numHomeAtoms + 5], 1, 2, 5, 998 };
+    globalAtomGroupIndices.insert(globalAtomGroupIndices.end(), received.begin(), received.end());
+
+    /* Clearing the halo, as clearDDStateIndices() does */
+    for (int a = numHomeAtoms; a < numHomeAtoms + numHaloAtoms; a++)
+    {
+        ga2la->erase(globalAtomIndices[a]);
+    }
+
+    /* Sorting: keep the first atoms in place, reverse the order of the
+     * others and interleave the received atoms.
+     */
+    std::vector<gmx_cgsort_t> sort;
+    for (int a = 0; a < 20; a++)
+    {
+        sort.push_back({ 0, 0, a });
+    }
+    for (int a = numHomeAtoms - 1; a >= 20; a--)
+    {
+        if (!moved[a])
+        {
+            sort.push_back({ 0, 0, a });
+        }
+        if (a <= 190 && (190 - a) % 40 == 0)
+        {
+            sort.push_back({ 0, 0, numHomeAtoms + (190 - a)/40 });
+        }
+    }
+    ASSERT_EQ(sort.size(), globalAtomGroupIndices.size() - std::count(moved.begin(), moved.end(), true));
+    std::vector<int> sortedGlobalAtomGroupIndices;
+    for (const gmx_cgsort_t &entry : sort)
+    {
+        sortedGlobalAtomGroupIndices.push_back(globalAtomGroupIndices[entry.ind]);
+    }
+
+    updateHomeAtomIndices(sort, numHomeAtoms, sortedGlobalAtomGroupIndices,
+                          &globalAtomIndices, ga2la);
+
+    /* Rebuild the indices of the sorted home atoms from scratch */
+    gmx_ga2la_t referenceGa2la(c_numAtomsTotal, numHomeAtoms);
+    for (size_t a = 0; a < sortedGlobalAtomGroupIndices.size(); a++)
+    {
+        referenceGa2la.insert(sortedGlobalAtomGroupIndices[a], { static_cast<int>(a), 0 });
+    }
+
+    EXPECT_EQ(sortedGlobalAtomGroupIndices, globalAtomIndices);
+    for (int a_gl = 0; a_gl < c_numAtomsTotal; a_gl++)
+    {
+        const gmx_ga2la_t::Entry *entry          = ga2la->find(a_gl);
+        const gmx_ga2la_t::Entry *referenceEntry = referenceGa2la.find(a_gl);
+        ASSERT_EQ(referenceEntry == nullptr, entry == nullptr) << "global atom " << a_gl;
+        if (entry)
+        {
+            EXPECT_EQ(referenceEntry->la, entry->la) << "global atom " << a_gl;
+            EXPECT_EQ(referenceEntry->cell, entry->cell) << "global atom " << a_gl;
+        }
+    }
+}
+
+TEST(HomeAtomIndices, DirectListUpdateMatchesRebuild)
+{
+    gmx_ga2la_t ga2la(c_numAtomsTotal, c_numAtomsTotal);
+
+    checkIncrementalUpdateMatchesRebuild(&ga2la);
+}
+
+TEST(HomeAtomIndices, HashedListUpdateMatchesRebuild)
+{
+    gmx_ga2la_t ga2la(100000, 100);
+
+    checkIncrementalUpdateMatchesRebuild(&ga2la);
+}
+
+} // namespace
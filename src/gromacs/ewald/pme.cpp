@@ -210,6 +210,10 @@ bool pme_gpu_supports_input(const t_inputrec &ir, const gmx_mtop_t &mtop, std::s
     {
         errorReasons.emplace_back("not a dynamical integrator");
     }
+    if (ir.useMts)
+    {
+        errorReasons.emplace_back("multiple time stepping");
+    }
     return addMessageIfNotSupported(errorReasons, error);
 }
 
@@ -642,7 +646,7 @@ gmx_pme_t *gmx_pme_init(const t_commrec         *cr,
                         PmeGpu                  *pmeGpu,
                         const gmx_device_info_t *gpuInfo,
                         PmeGpuProgramHandle      pmeGpuProgram,
-                        const gmx::MDLogger      & /*mdlog*/)
+                        const gmx::MDLogger      &mdlog)
 {
     int               use_threads, sum_use_threads, i;
     ivec              ndata;
@@ -942,7 +946,8 @@ gmx_pme_t *gmx_pme_init(const t_commrec         *cr,
             gmx_parallel_3dfft_init(&pme->pfft_setup[i], ndata,
                                     &pme->fftgrid[i], &pme->cfftgrid[i],
                                     pme->mpi_comm_d,
-                                    bReproducible, pme->nthread, allocateRealGridForGpu);
+                                    bReproducible, pme->nthread, allocateRealGridForGpu,
+                                    &mdlog);
 
         }
     }
@@ -66,13 +66,14 @@ using namespace gmx; // TODO: Remove when this file is moved into gmx namespace
    the function the order argument can be used as regular int because
    integral_constant has a proper conversion.
 
-   SIMD do_fspline() template funtions will be used for PME order 4 and 5
-   when the SIMD module has support for SIMD4 for the architecture used.
+   SIMD do_fspline() template funtions will be used for PME order 4 up to
+   PME_SIMD4_ORDER_MAX when the SIMD module has support for SIMD4 for the
+   architecture used.
    For SIMD4 without unaligned load/store support:
-     order 4 and 5 use the order 4+5 aligned SIMD template
+     orders 4 to PME_SIMD4_ORDER_MAX use the aligned SIMD template
    For SIMD4 with unaligned load/store support:
      order 4 uses the order 4 unaligned SIMD template
-     order 5 uses the order 4+5 aligned SIMD template
+     orders 5 to PME_SIMD4_ORDER_MAX use the aligned SIMD template
  */
 struct do_fspline
 {
@@ -187,35 +188,13 @@ struct do_fspline
     }
 #endif
 
-#ifdef PME_SIMD4_SPREAD_GATHER
-/* Load order elements from unaligned memory into two 4-wide SIMD */
-    template<int order>
-    static inline void loadOrderU(const real* data, std::integral_constant<int, order> /*unused*/,
-                                  int offset, Simd4Real* S0, Simd4Real* S1)
-    {
-#ifdef PME_SIMD4_UNALIGNED
-        *S0 = load4U(data-offset);
-        *S1 = load4U(data-offset+4);
-#else
-        alignas(GMX_SIMD_ALIGNMENT) real  buf_aligned[GMX_SIMD4_WIDTH*2];
-        /* Copy data to an aligned buffer */
-        for (int i = 0; i < order; i++)
-        {
-            buf_aligned[offset+i]  = data[i];
-        }
-        *S0 = load4(buf_aligned);
-        *S1 = load4(buf_aligned+4);
-#endif
-    }
-#endif
-
 #ifdef PME_SIMD4_SPREAD_GATHER
 /* This code assumes that the grid is allocated 4-real aligned
  * and that pme->pmegrid_nz is a multiple of 4.
- * This code supports pme_order <= 5.
+ * This code supports 4 <= pme_order <= PME_SIMD4_ORDER_MAX.
  */
     template <int Order>
-    typename std::enable_if<Order == 4 || Order == 5, RVec>::type
+    typename std::enable_if<Order >= 4 && Order <= PME_SIMD4_ORDER_MAX, RVec>::type
     operator()(std::integral_constant<int, Order>  order) const
     {
         const int                     norder = nn*order;
@@ -236,14 +215,11 @@ struct do_fspline
         Simd4Real                      fy_S = setZero();
         Simd4Real                      fz_S = setZero();
 
-        Simd4Real                      tz_S0, tz_S1, dz_S0, dz_S1;
-        loadOrderU(thz,  order, offset, &tz_S0, &tz_S1);
-        loadOrderU(dthz, order, offset, &dz_S0, &dz_S1);
+        constexpr int                  numRegisters = pmeSimd4NumZRegisters(Order);
 
-        tz_S0 = selectByMask(tz_S0, work->mask_S0[offset]);
-        dz_S0 = selectByMask(dz_S0, work->mask_S0[offset]);
-        tz_S1 = selectByMask(tz_S1, work->mask_S1[offset]);
-        dz_S1 = selectByMask(dz_S1, work->mask_S1[offset]);
+        Simd4Real                      tz_S[numRegisters], dz_S[numRegisters];
+        loadSplineSimd4Aligned<Order>(thz,  offset, work, tz_S);
+        loadSplineSimd4Aligned<Order>(dthz, offset, work, dz_S);
 
         for (int ithx = 0; (ithx < order); ithx++)
         {
@@ -257,16 +233,15 @@ struct do_fspline
                 const Simd4Real ty_S     = Simd4Real(thy[ithy]);
                 const Simd4Real dy_S     = Simd4Real(dthy[ithy]);
 
-                const Simd4Real gval_S0 = load4(grid + index_xy + idxZ - offset);
-                const Simd4Real gval_S1 = load4(grid + index_xy + idxZ - offset + 4);
-
-                const Simd4Real fxy1_S0 = tz_S0 * gval_S0;
-                const Simd4Real fz1_S0  = dz_S0 * gval_S0;
-                const Simd4Real fxy1_S1 = tz_S1 * gval_S1;
-                const Simd4Real fz1_S1  = dz_S1 * gval_S1;
+                Simd4Real       fxy1_S   = setZero();
+                Simd4Real       fz1_S    = setZero();
+                for (int r = 0; r < numRegisters; r++)
+                {
+                    const Simd4Real gval_S = load4(grid + index_xy + idxZ - offset + r*GMX_SIMD4_WIDTH);
 
-                const Simd4Real fxy1_S = fxy1_S0 + fxy1_S1;
-                const Simd4Real fz1_S  = fz1_S0 + fz1_S1;
+                    fxy1_S = fma(tz_S[r], gval_S, fxy1_S);
+                    fz1_S  = fma(dz_S[r], gval_S, fz1_S);
+                }
 
                 fx_S = fma(dx_S * ty_S, fxy1_S, fx_S);
                 fy_S = fma(tx_S * dy_S, fxy1_S, fy_S);
@@ -345,6 +320,17 @@ void gather_f_bsplines(const gmx_pme_t *pme, const real *grid,
                 case 5:
                     f = spline_func(std::integral_constant<int, 5>());
                     break;
+#ifdef PME_SIMD4_SPREAD_GATHER
+                case 6:
+                    f = spline_func(std::integral_constant<int, 6>());
+                    break;
+                case 7:
+                    f = spline_func(std::integral_constant<int, 7>());
+                    break;
+                case 8:
+                    f = spline_func(std::integral_constant<int, 8>());
+                    break;
+#endif
                 default:
                     f = spline_func(order);
                     break;
@@ -508,7 +508,7 @@ void unwrap_periodic_pmegrid(struct gmx_pme_t *pme, real *pmegrid)
 void set_grid_alignment(int gmx_unused *pmegrid_nz, int gmx_unused pme_order)
 {
 #ifdef PME_SIMD4_SPREAD_GATHER
-    if (pme_order == 5
+    if ((pme_order >= 5 && pme_order <= PME_SIMD4_ORDER_MAX)
 #if !PME_4NSIMD_GATHER
         || pme_order == 4
 #endif
@@ -523,8 +523,11 @@ void set_grid_alignment(int gmx_unused *pmegrid_nz, int gmx_unused pme_order)
 static void set_gridsize_alignment(int gmx_unused *gridsize, int gmx_unused pme_order)
 {
 #ifdef PME_SIMD4_SPREAD_GATHER
+    if ((pme_order >= 6 && pme_order <= PME_SIMD4_ORDER_MAX)
 #if !PME_4NSIMD_GATHER
-    if (pme_order == 4)
+        || pme_order == 4
+#endif
+        )
     {
         /* Add extra elements to ensured aligned operations do not go
          * beyond the allocated grid size.
@@ -534,7 +537,6 @@ static void set_gridsize_alignment(int gmx_unused *gridsize, int gmx_unused pme_
         *gridsize += 4;
     }
 #endif
-#endif
 }
 
 void pmegrid_init(pmegrid_t *grid,
@@ -47,8 +47,11 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
 
 #include <algorithm>
+#include <string>
 
 #include "gromacs/domdec/dlb.h"
 #include "gromacs/domdec/domdec.h"
@@ -59,10 +62,12 @@
 #include "gromacs/ewald/pme.h"
 #include "gromacs/fft/calcgrid.h"
 #include "gromacs/gmxlib/network.h"
+#include "gromacs/hardware/cpuinfo.h"
 #include "gromacs/math/functions.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/mdlib/dispersioncorrection.h"
 #include "gromacs/mdlib/forcerec.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
 #include "gromacs/mdtypes/commrec.h"
 #include "gromacs/mdtypes/inputrec.h"
 #include "gromacs/mdtypes/md_enums.h"
@@ -77,6 +82,7 @@
 #include "gromacs/utility/logger.h"
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/strconvert.h"
+#include "gromacs/utility/stringutil.h"
 
 #include "pme_internal.h"
 
@@ -95,6 +101,13 @@ struct pme_setup_t {
     double            cycles;          /**< the fastest time for this setup in cycles    */
 };
 
+/*! \brief The optimal setup of a previous run, as read from the tuning cache */
+struct PmeTuningCacheEntry {
+    bool valid        = false; /**< whether an entry matching this run was read */
+    ivec grid         = { 0 }; /**< the optimal PME grid dimensions             */
+    real rcut_coulomb = 0;     /**< the optimal Coulomb cut-off                 */
+};
+
 /*! \brief After 50 nstlist periods of not observing imbalance: never tune PME */
 const int  PMETunePeriod = 50;
 /*! \brief Trigger PME load balancing at more than 5% PME overload */
@@ -122,6 +135,8 @@ const real maxRelativeSlowdownAccepted = 1.12;
  * choosing a slower setup due to acceleration or fluctuations.
  */
 const real maxFluctuationAccepted = 1.02;
+/*! \brief Use a cached setup only when the box vectors differ by less than 1% */
+const real c_tuningCacheBoxTolerance = 0.01;
 
 /*! \brief Enumeration whose values describe the effect limiting the load balancing */
 enum epmelb {
@@ -161,6 +176,10 @@ struct pme_load_balancing_t {
 
     int                      cycles_n;           /**< step cycle counter cummulative count */
     double                   cycles_c;           /**< step cycle counter cummulative cycles */
+
+    std::string              tuningCacheFilename; /**< file name of the tuning cache, empty when not used */
+    std::string              tuningCacheKey;      /**< the system, hardware and rank layout, only set on the master rank */
+    PmeTuningCacheEntry      cachedSetup;         /**< the setup of a previous run, read from the tuning cache */
 };
 
 /* TODO The code in this file should call this getter, rather than
@@ -170,6 +189,115 @@ bool pme_loadbal_is_active(const pme_load_balancing_t *pme_lb)
     return pme_lb != nullptr && pme_lb->bActive;
 }
 
+/*! \brief Returns a description of the system, hardware and rank layout
+ *
+ * A cached setup is only used when the description matches exactly.
+ * The box is not part of the key, since it fluctuates, it is compared
+ * with a tolerance instead.
+ */
+static std::string pmeTuningCacheKey(const t_commrec  *cr,
+                                     const t_inputrec &ir,
+                                     int               numAtomsGlobal,
+                                     bool              useGpu)
+{
+    std::string key;
+
+    key += gmx::formatString("atoms %d\n", numAtomsGlobal);
+    key += gmx::formatString("cpu %s\n", gmx::stripString(gmx::CpuInfo::detect().brandString()).c_str());
+    key += gmx::formatString("openmp-threads %d\n", gmx_omp_nthreads_get(emntDefault));
+    key += gmx::formatString("gpu %d\n", useGpu ? 1 : 0);
+    key += gmx::formatString("ranks %d pme-ranks %d\n", cr->nnodes, cr->npmenodes);
+    if (DOMAINDECOMP(cr))
+    {
+        key += gmx::formatString("dd-grid %d %d %d\n",
+                                 cr->dd->nc[XX], cr->dd->nc[YY], cr->dd->nc[ZZ]);
+    }
+    key += gmx::formatString("pme-grid %d %d %d pme-order %d\n",
+                             ir.nkx, ir.nky, ir.nkz, ir.pme_order);
+    key += gmx::formatString("rcoulomb %g nstlist %d\n", ir.rcoulomb, ir.nstlist);
+
+    return key;
+}
+
+/*! \brief Reads the tuning cache, returns a valid entry only when it matches \p key and \p box */
+static PmeTuningCacheEntry readPmeTuningCache(const std::string &filename,
+                                              const std::string &key,
+                                              const matrix       box)
+{
+    PmeTuningCacheEntry entry;
+
+    FILE               *fp = std::fopen(filename.c_str(), "r");
+    if (fp == nullptr)
+    {
+        return entry;
+    }
+
+    std::string readKey;
+    dvec        boxNorms     = { -1, -1, -1 };
+    bool        haveGrid     = false;
+    bool        haveCutoff   = false;
+    char        line[STRLEN];
+    while (std::fgets(line, STRLEN, fp) != nullptr)
+    {
+        double rcut;
+
+        if (line[0] == '#')
+        {
+            continue;
+        }
+        if (sscanf(line, "box %lf %lf %lf", &boxNorms[XX], &boxNorms[YY], &boxNorms[ZZ]) == 3)
+        {
+            continue;
+        }
+        if (sscanf(line, "optimal-pme-grid %d %d %d", &entry.grid[XX], &entry.grid[YY], &entry.grid[ZZ]) == 3)
+        {
+            haveGrid = true;
+        }
+        else if (sscanf(line, "optimal-rcoulomb %lf", &rcut) == 1)
+        {
+            entry.rcut_coulomb = rcut;
+            haveCutoff         = true;
+        }
+        else
+        {
+            readKey += line;
+        }
+    }
+    std::fclose(fp);
+
+    bool boxMatches = true;
+    for (int d = 0; d < DIM; d++)
+    {
+        boxMatches = boxMatches &&
+            std::abs(boxNorms[d] - norm(box[d])) <= c_tuningCacheBoxTolerance*norm(box[d]);
+    }
+
+    entry.valid = (readKey == key && boxMatches && haveGrid && haveCutoff);
+
+    return entry;
+}
+
+/*! \brief Writes \p setup as the optimal setup to the tuning cache, returns whether this succeeded */
+static bool writePmeTuningCache(const std::string &filename,
+                                const std::string &key,
+                                const matrix       box,
+                                const pme_setup_t &setup)
+{
+    FILE *fp = std::fopen(filename.c_str(), "w");
+    if (fp == nullptr)
+    {
+        return false;
+    }
+
+    fprintf(fp, "# PME tuning cache written by mdrun, only used with identical settings below\n");
+    fprintf(fp, "%s", key.c_str());
+    fprintf(fp, "box %.6f %.6f %.6f\n", norm(box[XX]), norm(box[YY]), norm(box[ZZ]));
+    fprintf(fp, "optimal-pme-grid %d %d %d\n", setup.grid[XX], setup.grid[YY], setup.grid[ZZ]);
+    fprintf(fp, "optimal-rcoulomb %.6f\n", setup.rcut_coulomb);
+
+    return std::fclose(fp) == 0;
+}
+
 // TODO Return a unique_ptr to pme_load_balancing_t
 void pme_loadbal_init(pme_load_balancing_t     **pme_lb_p,
                       t_commrec                 *cr,
@@ -180,6 +308,8 @@ void pme_loadbal_init(pme_load_balancing_t     **pme_lb_p,
                       const nonbonded_verlet_t  &nbv,
                       gmx_pme_t                 *pmedata,
                       gmx_bool                   bUseGPU,
+                      int                        numAtomsGlobal,
+                      const std::string         &tuningCacheFilename,
                       gmx_bool                  *bPrinting)
 {
     GMX_RELEASE_ASSERT(ir.cutoff_scheme != ecutsGROUP, "PME tuning is not supported with cutoff-scheme=group (because it contains bugs)");
@@ -289,6 +419,33 @@ void pme_loadbal_init(pme_load_balancing_t     **pme_lb_p,
 
     pme_lb->step_rel_stop = PMETunePeriod*ir.nstlist;
 
+    if (pme_lb->bActive && !tuningCacheFilename.empty() &&
+        getenv("GMX_DISABLE_PME_TUNE_CACHE") == nullptr)
+    {
+        pme_lb->tuningCacheFilename = tuningCacheFilename;
+        if (MASTER(cr))
+        {
+            pme_lb->tuningCacheKey = pmeTuningCacheKey(cr, ir, numAtomsGlobal, bUseGPU);
+            pme_lb->cachedSetup    = readPmeTuningCache(tuningCacheFilename,
+                                                        pme_lb->tuningCacheKey,
+                                                        pme_lb->box_start);
+        }
+        if (DOMAINDECOMP(cr))
+        {
+            dd_bcast(cr->dd, sizeof(pme_lb->cachedSetup), &pme_lb->cachedSetup);
+        }
+        if (pme_lb->cachedSetup.valid)
+        {
+            GMX_LOG(mdlog.info).asParagraph().appendTextFormatted(
+                    "Read the optimal PME setup of a previous run from %s:\n"
+                    "  pme grid %d %d %d, coulomb cutoff %.3f\n"
+                    "PME tuning will start at this setup",
+                    tuningCacheFilename.c_str(),
+                    pme_lb->cachedSetup.grid[XX], pme_lb->cachedSetup.grid[YY], pme_lb->cachedSetup.grid[ZZ],
+                    pme_lb->cachedSetup.rcut_coulomb);
+        }
+    }
+
     /* Delay DD load balancing when GPUs are used */
     if (pme_lb->bActive && DOMAINDECOMP(cr) && cr->dd->nnodes > 1 && bUseGPU)
     {
@@ -523,6 +680,164 @@ static void switch_to_stage1(pme_load_balancing_t *pme_lb)
     pme_lb->cur = pme_lb->end;
 }
 
+/*! \brief Set up balancing to continue directly at the setup read from the tuning cache
+ *
+ * Generates the setups up to one beyond the cached one, with the same
+ * restrictions as in stage 0, and sets up the last stage to only time
+ * the cached setup and its two neighbors.
+ * Returns false, leaving the balancing state unchanged, when the cached
+ * setup is not generated or can not be used with DD.
+ */
+static bool pme_loadbal_use_cached_setup(pme_load_balancing_t *pme_lb,
+                                         t_commrec            *cr,
+                                         const t_inputrec     &ir,
+                                         const t_state        &state)
+{
+    GMX_RELEASE_ASSERT(pme_lb->stage == 0 && pme_lb->cur == 0 && pme_lb->setup.size() == 1,
+                       "The cached setup can only be used at the start of balancing");
+
+    const PmeTuningCacheEntry &cached = pme_lb->cachedSetup;
+    const int                  cachedGridPoints = cached.grid[XX]*cached.grid[YY]*cached.grid[ZZ];
+
+    int                        cachedIndex = -1;
+    bool                       haveNext    = true;
+    while (haveNext && (cachedIndex < 0 || pme_lb->cur == cachedIndex))
+    {
+        const pme_setup_t &set = pme_lb->setup[pme_lb->cur];
+        if (cachedIndex < 0)
+        {
+            if (set.grid[XX] == cached.grid[XX] &&
+                set.grid[YY] == cached.grid[YY] &&
+                set.grid[ZZ] == cached.grid[ZZ] &&
+                std::abs(set.rcut_coulomb - cached.rcut_coulomb) <= 1e-3*cached.rcut_coulomb)
+            {
+                cachedIndex = pme_lb->cur;
+            }
+            else if (set.grid[XX]*set.grid[YY]*set.grid[ZZ] < cachedGridPoints)
+            {
+                /* We passed the cached grid, which is thus not generated here */
+                break;
+            }
+        }
+
+        haveNext = pme_loadbal_increase_cutoff(pme_lb, ir.pme_order, cr->dd);
+        if (haveNext)
+        {
+            const pme_setup_t &next = pme_lb->setup.back();
+            if (next.spacing > c_maxSpacingScaling*pme_lb->setup[0].spacing ||
+                (ir.ePBC != epbcNONE &&
+                 gmx::square(next.rlistOuter) > max_cutoff2(ir.ePBC, state.box)))
+            {
+                pme_lb->setup.pop_back();
+                haveNext = false;
+            }
+            else
+            {
+                pme_lb->cur++;
+            }
+        }
+    }
+
+    pme_lb->cur = pme_lb->setup.size() - 1;
+    if (cachedIndex >= 0 && DOMAINDECOMP(cr) &&
+        !change_dd_cutoff(cr, state, pme_lb->setup[pme_lb->cur].rlistOuter))
+    {
+        cachedIndex = -1;
+    }
+    if (cachedIndex < 0)
+    {
+        pme_lb->setup.resize(1);
+        pme_lb->cur = 0;
+
+        return false;
+    }
+
+    /* Time the setups from the one after the cached setup down to the one
+     * before it, then choose the fastest of these.
+     */
+    pme_lb->start   = std::max(pme_lb->lower_limit, cachedIndex - 1);
+    pme_lb->end     = pme_lb->setup.size();
+    pme_lb->stage   = pme_lb->nstage - 1;
+    pme_lb->fastest = pme_lb->cur;
+
+    return true;
+}
+
+/*! \brief Switch the Coulomb cut-off and the PME grid to setup \p pme_lb->cur */
+static void
+pme_loadbal_switch_setup(pme_load_balancing_t      *pme_lb,
+                         t_commrec                 *cr,
+                         const t_inputrec          &ir,
+                         interaction_const_t       *ic,
+                         struct nonbonded_verlet_t *nbv,
+                         struct gmx_pme_t **        pmedata)
+{
+    pme_setup_t *set  = &pme_lb->setup[pme_lb->cur];
+    const real   rtab = ir.rlist + ir.tabext;
+
+    ic->rcoulomb           = set->rcut_coulomb;
+    nbv->changePairlistRadii(set->rlistOuter, set->rlistInner);
+    ic->ewaldcoeff_q       = set->ewaldcoeff_q;
+    /* TODO: centralize the code that sets the potentials shifts */
+    if (ic->coulomb_modifier == eintmodPOTSHIFT)
+    {
+        GMX_RELEASE_ASSERT(ic->rcoulomb != 0, "Cutoff radius cannot be zero");
+        ic->sh_ewald = std::erfc(ic->ewaldcoeff_q*ic->rcoulomb) / ic->rcoulomb;
+    }
+    if (EVDW_PME(ic->vdwtype))
+    {
+        /* We have PME for both Coulomb and VdW, set rvdw equal to rcoulomb */
+        ic->rvdw            = set->rcut_coulomb;
+        ic->ewaldcoeff_lj   = set->ewaldcoeff_lj;
+        if (ic->vdw_modifier == eintmodPOTSHIFT)
+        {
+            real       crc2;
+
+            ic->dispersion_shift.cpot = -1.0/gmx::power6(static_cast<double>(ic->rvdw));
+            ic->repulsion_shift.cpot  = -1.0/gmx::power12(static_cast<double>(ic->rvdw));
+            ic->sh_invrc6             = -ic->dispersion_shift.cpot;
+            crc2                      = gmx::square(ic->ewaldcoeff_lj*ic->rvdw);
+            ic->sh_lj_ewald           = (std::exp(-crc2)*(1 + crc2 + 0.5*crc2*crc2) - 1)/gmx::power6(ic->rvdw);
+        }
+    }
+
+    /* We always re-initialize the tables whether they are used or not */
+    init_interaction_const_tables(nullptr, ic, rtab);
+
+    Nbnxm::gpu_pme_loadbal_update_param(nbv, ic);
+
+    if (!pme_lb->bSepPMERanks)
+    {
+        /* FIXME:
+         * CPU PME keeps a list of allocated pmedata's, that's why pme_lb->setup[pme_lb->cur].pmedata is not always nullptr.
+         * GPU PME, however, currently needs the gmx_pme_reinit always called on load balancing
+         * (pme_gpu_reinit might be not sufficiently decoupled from gmx_pme_init).
+         * This can lead to a lot of reallocations for PME GPU.
+         * Would be nicer if the allocated grid list was hidden within a single pmedata structure.
+         */
+        if ((pme_lb->setup[pme_lb->cur].pmedata == nullptr) || pme_gpu_task_enabled(pme_lb->setup[pme_lb->cur].pmedata))
+        {
+            /* Generate a new PME data structure,
+             * copying part of the old pointers.
+             */
+            gmx_pme_reinit(&set->pmedata,
+                           cr, pme_lb->setup[0].pmedata, &ir,
+                           set->grid, set->ewaldcoeff_q, set->ewaldcoeff_lj);
+        }
+        *pmedata = set->pmedata;
+    }
+    else
+    {
+        /* Tell our PME-only rank to switch grid */
+        gmx_pme_send_switchgrid(cr, set->grid, set->ewaldcoeff_q, set->ewaldcoeff_lj);
+    }
+
+    if (debug)
+    {
+        print_grid(nullptr, debug, "", "switched to", set, -1);
+    }
+}
+
 /*! \brief Process the timings and try to adjust the PME grid and Coulomb cut-off
  *
  * The adjustment is done to generate a different non-bonded PP and PME load.
@@ -553,7 +868,6 @@ pme_load_balance(pme_load_balancing_t      *pme_lb,
     pme_setup_t *set;
     double       cycles_fast;
     char         buf[STRLEN], sbuf[22];
-    real         rtab;
 
     if (PAR(cr))
     {
@@ -561,11 +875,25 @@ pme_load_balance(pme_load_balancing_t      *pme_lb,
         cycles /= cr->nnodes;
     }
 
+    if (pme_lb->cachedSetup.valid)
+    {
+        /* Only try the cached setup once, at the start of balancing */
+        pme_lb->cachedSetup.valid = false;
+
+        if (pme_loadbal_use_cached_setup(pme_lb, cr, ir, state))
+        {
+            sprintf(buf, "step %4s: ", gmx_step_str(step, sbuf));
+            print_grid(fp_err, fp_log, buf, "cached", &pme_lb->setup[pme_lb->cur], -1);
+
+            pme_loadbal_switch_setup(pme_lb, cr, ir, ic, nbv, pmedata);
+
+            return;
+        }
+    }
+
     set = &pme_lb->setup[pme_lb->cur];
     set->count++;
 
-    rtab = ir.rlist + ir.tabext;
-
     if (set->count % 2 == 1)
     {
         /* Skip the first cycle, because the first step after a switch
@@ -790,71 +1118,10 @@ pme_load_balance(pme_load_balancing_t      *pme_lb,
     }
 
     /* Change the Coulomb cut-off and the PME grid */
+    pme_loadbal_switch_setup(pme_lb, cr, ir, ic, nbv, pmedata);
 
     set = &pme_lb->setup[pme_lb->cur];
 
-    ic->rcoulomb           = set->rcut_coulomb;
-    nbv->changePairlistRadii(set->rlistOuter, set->rlistInner);
-    ic->ewaldcoeff_q       = set->ewaldcoeff_q;
-    /* TODO: centralize the code that sets the potentials shifts */
-    if (ic->coulomb_modifier == eintmodPOTSHIFT)
-    {
-        GMX_RELEASE_ASSERT(ic->rcoulomb != 0, "Cutoff radius cannot be zero");
-        ic->sh_ewald = std::erfc(ic->ewaldcoeff_q*ic->rcoulomb) / ic->rcoulomb;
-    }
-    if (EVDW_PME(ic->vdwtype))
-    {
-        /* We have PME for both Coulomb and VdW, set rvdw equal to rcoulomb */
-        ic->rvdw            = set->rcut_coulomb;
-        ic->ewaldcoeff_lj   = set->ewaldcoeff_lj;
-        if (ic->vdw_modifier == eintmodPOTSHIFT)
-        {
-            real       crc2;
-
-            ic->dispersion_shift.cpot = -1.0/gmx::power6(static_cast<double>(ic->rvdw));
-            ic->repulsion_shift.cpot  = -1.0/gmx::power12(static_cast<double>(ic->rvdw));
-            ic->sh_invrc6             = -ic->dispersion_shift.cpot;
-            crc2                      = gmx::square(ic->ewaldcoeff_lj*ic->rvdw);
-            ic->sh_lj_ewald           = (std::exp(-crc2)*(1 + crc2 + 0.5*crc2*crc2) - 1)/gmx::power6(ic->rvdw);
-        }
-    }
-
-    /* We always re-initialize the tables whether they are used or not */
-    init_interaction_const_tables(nullptr, ic, rtab);
-
-    Nbnxm::gpu_pme_loadbal_update_param(nbv, ic);
-
-    if (!pme_lb->bSepPMERanks)
-    {
-        /* FIXME:
-         * CPU PME keeps a list of allocated pmedata's, that's why pme_lb->setup[pme_lb->cur].pmedata is not always nullptr.
-         * GPU PME, however, currently needs the gmx_pme_reinit always called on load balancing
-         * (pme_gpu_reinit might be not sufficiently decoupled from gmx_pme_init).
-         * This can lead to a lot of reallocations for PME GPU.
-         * Would be nicer if the allocated grid list was hidden within a single pmedata structure.
-         */
-        if ((pme_lb->setup[pme_lb->cur].pmedata == nullptr) || pme_gpu_task_enabled(pme_lb->setup[pme_lb->cur].pmedata))
-        {
-            /* Generate a new PME data structure,
-             * copying part of the old pointers.
-             */
-            gmx_pme_reinit(&set->pmedata,
-                           cr, pme_lb->setup[0].pmedata, &ir,
-                           set->grid, set->ewaldcoeff_q, set->ewaldcoeff_lj);
-        }
-        *pmedata = set->pmedata;
-    }
-    else
-    {
-        /* Tell our PME-only rank to switch grid */
-        gmx_pme_send_switchgrid(cr, set->grid, set->ewaldcoeff_q, set->ewaldcoeff_lj);
-    }
-
-    if (debug)
-    {
-        print_grid(nullptr, debug, "", "switched to", set, -1);
-    }
-
     if (pme_lb->stage == pme_lb->nstage)
     {
         print_grid(fp_err, fp_log, "", "optimal", set, -1);
@@ -944,9 +1211,13 @@ void pme_loadbal_do(pme_load_balancing_t *pme_lb,
         {
             if (DDMASTER(cr->dd))
             {
-                /* If PME rank load is too high, start tuning */
+                /* If PME rank load is too high, start tuning.
+                 * With a cached setup we start right away, as the previous
+                 * run has shown that tuning helps.
+                 */
                 pme_lb->bBalance =
-                    (dd_pme_f_ratio(cr->dd) >= loadBalanceTriggerFactor);
+                    (dd_pme_f_ratio(cr->dd) >= loadBalanceTriggerFactor ||
+                     pme_lb->cachedSetup.valid);
             }
             dd_bcast(cr->dd, sizeof(gmx_bool), &pme_lb->bBalance);
         }
@@ -968,6 +1239,15 @@ void pme_loadbal_do(pme_load_balancing_t *pme_lb,
     {
         pme_lb->bBalance = FALSE;
 
+        if (!pme_lb->tuningCacheFilename.empty() && MASTER(cr) &&
+            !writePmeTuningCache(pme_lb->tuningCacheFilename, pme_lb->tuningCacheKey,
+                                 pme_lb->box_start, pme_lb->setup[pme_lb->cur]))
+        {
+            GMX_LOG(mdlog.warning).asParagraph().appendTextFormatted(
+                    "NOTE: Could not write the PME tuning cache %s",
+                    pme_lb->tuningCacheFilename.c_str());
+        }
+
         if (DOMAINDECOMP(cr) && dd_dlb_is_locked(cr->dd))
         {
             /* Unlock the DLB=auto, DLB is allowed to activate */
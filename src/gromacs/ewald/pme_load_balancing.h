@@ -46,6 +46,8 @@
 #ifndef GMX_EWALD_PME_LOAD_BALANCING_H
 #define GMX_EWALD_PME_LOAD_BALANCING_H
 
+#include <string>
+
 #include "gromacs/mdtypes/forcerec.h"
 #include "gromacs/mdtypes/interaction_const.h"
 #include "gromacs/timing/wallcycle.h"
@@ -73,6 +75,11 @@ bool pme_loadbal_is_active(const pme_load_balancing_t *pme_lb);
  * Returns in bPrinting whether the load balancing is printing to fp_err.
  * The PME grid in pmedata is reused for smaller grids to lower the memory
  * usage.
+ * When \p tuningCacheFilename is not empty, the optimal setup found in
+ * a previous run of the same system on the same hardware and rank layout
+ * is read from that file. Balancing then starts at the cached setup and only
+ * re-times it and its neighbors. The optimal setup of this run is written
+ * to the same file.
  */
 void pme_loadbal_init(pme_load_balancing_t     **pme_lb_p,
                       t_commrec                 *cr,
@@ -83,6 +90,8 @@ void pme_loadbal_init(pme_load_balancing_t     **pme_lb_p,
                       const nonbonded_verlet_t  &nbv,
                       gmx_pme_t                 *pmedata,
                       gmx_bool                   bUseGPU,
+                      int                        numAtomsGlobal,
+                      const std::string         &tuningCacheFilename,
                       gmx_bool                  *bPrinting);
 
 /*! \brief Process cycles and PME load balance when necessary
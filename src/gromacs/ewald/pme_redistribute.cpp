@@ -140,7 +140,11 @@ static void pme_calc_pidx_wrapper(int natoms, matrix recipbox, rvec x[],
 
 static void realloc_splinevec(splinevec th, real **ptr_z, int nalloc)
 {
-    const int padding = 4;
+    /* The aligned SIMD4 code reads up to 3 elements before and,
+     * with 3 SIMD4 registers for order 6, up to 6 elements beyond
+     * the spline values of an atom.
+     */
+    const int padding = 8;
     int       i;
 
     srenew(th[XX], nalloc);
@@ -41,9 +41,11 @@
 /* Check if we have 4-wide SIMD macro support */
 #if GMX_SIMD4_HAVE_REAL
 /* Do PME spread and gather with 4-wide SIMD.
- * NOTE: SIMD is only used with PME order 4 and 5 (which are the most common).
+ * NOTE: SIMD is only used with PME order 4 up to PME_SIMD4_ORDER_MAX.
  */
 #    define PME_SIMD4_SPREAD_GATHER
+/* The maximum PME order supported by the 4-wide SIMD spread and gather */
+#    define PME_SIMD4_ORDER_MAX 8
 
 #    if GMX_SIMD_HAVE_LOADU && GMX_SIMD_HAVE_STOREU
 /* With PME-order=4 on x86, unaligned load+store is slightly faster
@@ -55,6 +57,15 @@
 
 #ifdef PME_SIMD4_SPREAD_GATHER
 #    define SIMD4_ALIGNMENT  (GMX_SIMD4_WIDTH*sizeof(real))
+
+/*! \brief Returns the number of 4-wide SIMD registers needed to cover
+ * \p order grid points in z, starting at any offset within an aligned
+ * block of 4 grid points.
+ */
+static constexpr int pmeSimd4NumZRegisters(int order)
+{
+    return (order + 2*GMX_SIMD4_WIDTH - 2)/GMX_SIMD4_WIDTH;
+}
 #else
 /* We can use any alignment, apart from 0, so we use 4 reals */
 #    define SIMD4_ALIGNMENT  (4*sizeof(real))
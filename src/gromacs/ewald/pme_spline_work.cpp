@@ -54,29 +54,29 @@ pme_spline_work *make_pme_spline_work(int gmx_unused order)
     pme_spline_work *work;
 
 #ifdef PME_SIMD4_SPREAD_GATHER
-    alignas(GMX_SIMD_ALIGNMENT) real  tmp[GMX_SIMD4_WIDTH*2];
+    constexpr int    numRegisters = pmeSimd4NumZRegisters(PME_SIMD4_ORDER_MAX);
+    alignas(GMX_SIMD_ALIGNMENT) real  tmp[GMX_SIMD4_WIDTH*numRegisters];
     Simd4Real        zero_S;
-    Simd4Real        real_mask_S0, real_mask_S1;
-    int              of, i;
+    int              of, i, r;
 
     work = new(gmx::AlignedAllocationPolicy::malloc(sizeof(pme_spline_work)))pme_spline_work;
 
     zero_S = setZero();
 
     /* Generate bit masks to mask out the unused grid entries,
-     * as we only operate on order of the 8 grid entries that are
-     * load into 2 SIMD registers.
+     * as we only operate on order of the grid entries that are
+     * loaded into up to numRegisters SIMD registers.
      */
-    for (of = 0; of < 2*GMX_SIMD4_WIDTH-(order-1); of++)
+    for (of = 0; of < GMX_SIMD4_WIDTH; of++)
     {
-        for (i = 0; i < 2*GMX_SIMD4_WIDTH; i++)
+        for (i = 0; i < GMX_SIMD4_WIDTH*numRegisters; i++)
         {
             tmp[i] = (i >= of && i < of+order ? -1.0 : 1.0);
         }
-        real_mask_S0      = load4(tmp);
-        real_mask_S1      = load4(tmp+GMX_SIMD4_WIDTH);
-        work->mask_S0[of] = (real_mask_S0 < zero_S);
-        work->mask_S1[of] = (real_mask_S1 < zero_S);
+        for (r = 0; r < numRegisters; r++)
+        {
+            work->mask_S[r][of] = (load4(tmp + r*GMX_SIMD4_WIDTH) < zero_S);
+        }
     }
 #else
     work = nullptr;
@@ -42,8 +42,10 @@
 struct pme_spline_work
 {
 #ifdef PME_SIMD4_SPREAD_GATHER
-    /* Masks for 4-wide SIMD aligned spreading and gathering */
-    gmx::Simd4Bool        mask_S0[6], mask_S1[6];
+    /* Masks for 4-wide SIMD aligned spreading and gathering,
+     * per SIMD register and per offset of the first grid point
+     */
+    gmx::Simd4Bool        mask_S[pmeSimd4NumZRegisters(PME_SIMD4_ORDER_MAX)][GMX_SIMD4_WIDTH];
 #else
     int                   dummy; /* C89 requires that struct has at least one member */
 #endif
@@ -53,4 +55,46 @@ pme_spline_work *make_pme_spline_work(int order);
 
 void destroy_pme_spline_work(pme_spline_work *work);
 
+#ifdef PME_SIMD4_SPREAD_GATHER
+/*! \brief Loads \p order z-spline values into 4-wide SIMD registers
+ * aligned with the grid
+ *
+ * The first value ends up at position \p offset, the z-index of the first
+ * grid point modulo 4, entries outside the spline are masked out.
+ * Note that \p data is read before and beyond the spline values,
+ * so the spline arrays in z need padding.
+ */
+template<int order>
+static inline void
+loadSplineSimd4Aligned(const real            *data,
+                       int                    offset,
+                       const pme_spline_work *work,
+                       gmx::Simd4Real        *S)
+{
+    constexpr int numRegisters = pmeSimd4NumZRegisters(order);
+
+#ifdef PME_SIMD4_UNALIGNED
+    for (int r = 0; r < numRegisters; r++)
+    {
+        S[r] = gmx::load4U(data - offset + r*GMX_SIMD4_WIDTH);
+    }
+#else
+    alignas(GMX_SIMD_ALIGNMENT) real buf_aligned[numRegisters*GMX_SIMD4_WIDTH];
+    /* Copy data to an aligned buffer (unused buffer parts are masked) */
+    for (int i = 0; i < order; i++)
+    {
+        buf_aligned[offset + i] = data[i];
+    }
+    for (int r = 0; r < numRegisters; r++)
+    {
+        S[r] = gmx::load4(buf_aligned + r*GMX_SIMD4_WIDTH);
+    }
+#endif
+    for (int r = 0; r < numRegisters; r++)
+    {
+        S[r] = gmx::selectByMask(S[r], work->mask_S[r][offset]);
+    }
+}
+#endif
+
 #endif
@@ -311,6 +311,73 @@ static void make_bsplines(splinevec theta, splinevec dtheta, int order,
         }                                                \
     }
 
+#ifdef PME_SIMD4_SPREAD_GATHER
+/*! \brief Spreads one coefficient with aligned SIMD4 loads and stores
+ *
+ * This code assumes that the grid is allocated 4-real aligned
+ * and that pnz is a multiple of 4.
+ * This code supports 4 <= order <= PME_SIMD4_ORDER_MAX.
+ */
+template<int order>
+static inline void
+spreadCoefficientSimd4Aligned(real                  *grid,
+                              int                    pny,
+                              int                    pnz,
+                              int                    i0,
+                              int                    j0,
+                              int                    k0,
+                              real                   coefficient,
+                              const real            *thx,
+                              const real            *thy,
+                              const real            *thz,
+                              const pme_spline_work *work)
+{
+    using namespace gmx;
+
+    static_assert(order >= 4 && order <= PME_SIMD4_ORDER_MAX, "The aligned SIMD4 spread only supports 4 <= order <= PME_SIMD4_ORDER_MAX");
+
+    constexpr int numRegisters = pmeSimd4NumZRegisters(order);
+
+    const int     offset       = k0 & (GMX_SIMD4_WIDTH - 1);
+
+    Simd4Real     ty_S[order];
+    Simd4Real     tz_S[numRegisters];
+    Simd4Real     vx_tz_S[numRegisters];
+
+    for (int ithy = 0; ithy < order; ithy++)
+    {
+        ty_S[ithy] = Simd4Real(thy[ithy]);
+    }
+    loadSplineSimd4Aligned<order>(thz, offset, work, tz_S);
+
+    for (int ithx = 0; ithx < order; ithx++)
+    {
+        const int       index = (i0 + ithx)*pny*pnz + j0*pnz + k0 - offset;
+        const Simd4Real vx_S(coefficient*thx[ithx]);
+
+        for (int r = 0; r < numRegisters; r++)
+        {
+            vx_tz_S[r] = vx_S * tz_S[r];
+        }
+
+        for (int ithy = 0; ithy < order; ithy++)
+        {
+            real *gridPtr = grid + index + ithy*pnz;
+
+            for (int r = 0; r < numRegisters; r++)
+            {
+                Simd4Real gri_S = load4(gridPtr + r*GMX_SIMD4_WIDTH);
+                gri_S = fma(vx_tz_S[r], ty_S[ithy], gri_S);
+                store4(gridPtr + r*GMX_SIMD4_WIDTH, gri_S);
+            }
+        }
+    }
+}
+
+/* Spreads with the aligned SIMD4 kernel for a PME order known at compile time */
+#define PME_SPREAD_SIMD4_ALIGNED(order) \
+    spreadCoefficientSimd4Aligned<order>(grid, pny, pnz, i0, j0, k0, coefficient, thx, thy, thz, work)
+#endif
 
 static void spread_coefficients_bsplines_thread(const pmegrid_t                   *pmegrid,
                                                 const pme_atomcomm_t              *atc,
@@ -328,10 +395,6 @@ static void spread_coefficients_bsplines_thread(const pmegrid_t
     int            pnx, pny, pnz, ndatatot;
     int            offx, offy, offz;
 
-#if defined PME_SIMD4_SPREAD_GATHER && !defined PME_SIMD4_UNALIGNED
-    alignas(GMX_SIMD_ALIGNMENT) real  thz_aligned[GMX_SIMD4_WIDTH*2];
-#endif
-
     pnx = pmegrid->s[XX];
     pny = pmegrid->s[YY];
     pnz = pmegrid->s[ZZ];
@@ -373,24 +436,24 @@ static void spread_coefficients_bsplines_thread(const pmegrid_t
 #ifdef PME_SIMD4_SPREAD_GATHER
 #ifdef PME_SIMD4_UNALIGNED
 #define PME_SPREAD_SIMD4_ORDER4
+#include "pme_simd4.h"
 #else
-#define PME_SPREAD_SIMD4_ALIGNED
-#define PME_ORDER 4
+                    PME_SPREAD_SIMD4_ALIGNED(4);
 #endif
-#include "pme_simd4.h"
 #else
                     DO_BSPLINE(4);
 #endif
                     break;
-                case 5:
 #ifdef PME_SIMD4_SPREAD_GATHER
-#define PME_SPREAD_SIMD4_ALIGNED
-#define PME_ORDER 5
-#include "pme_simd4.h"
+                case 5: PME_SPREAD_SIMD4_ALIGNED(5); break;
+                case 6: PME_SPREAD_SIMD4_ALIGNED(6); break;
+                case 7: PME_SPREAD_SIMD4_ALIGNED(7); break;
+                case 8: PME_SPREAD_SIMD4_ALIGNED(8); break;
 #else
+                case 5:
                     DO_BSPLINE(5);
-#endif
                     break;
+#endif
                 default:
                     DO_BSPLINE(order);
                     break;
@@ -271,6 +271,17 @@ std::vector<IVec> const c_sampleGridSizes
     }
 };
 
+//! Grid sizes large enough for the higher interpolation orders
+std::vector<IVec> const c_sampleGridSizesHigherOrders
+{
+    IVec {
+        16, 16, 16
+    },
+    IVec {
+        19, 17, 15
+    }
+};
+
 //! Random charges
 std::vector<real> const c_sampleChargesFull
 {
@@ -352,6 +363,12 @@ INSTANTIATE_TEST_CASE_P(SaneInput13, PmeSplineAndSpreadTest, ::testing::Combine(
                                                                                     ::testing::Values(c_sampleCoordinates13),
                                                                                     ::testing::Values(c_sampleCharges13)
                                                                                 ));
+/*! \brief Instantiation of the test with valid input, 13 atoms and the higher PME orders */
+INSTANTIATE_TEST_CASE_P(HigherOrders13, PmeSplineAndSpreadTest, ::testing::Combine(c_inputBoxes, ::testing::Range(6, 8 + 1),
+                                                                                       ::testing::ValuesIn(c_sampleGridSizesHigherOrders),
+                                                                                       ::testing::Values(c_sampleCoordinates13),
+                                                                                       ::testing::Values(c_sampleCharges13)
+                                                                                   ));
 }  // namespace
 }  // namespace test
 }  // namespace gmx
@@ -0,0 +1,184 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Microbenchmark for the CPU PME spline, spread and gather kernels.
+ *
+ * Usage: pme-spread-gather-benchmark [-atoms n] [-repeats n]
+ *
+ * Times spline computation plus spreading and force gathering for
+ * all PME interpolation orders from 4 to 8 with \p atoms (default 20000)
+ * randomly placed charges in a cubic box with a grid spacing of 0.12 nm,
+ * averaged over \p repeats (default 20) calls. Single threaded, so the
+ * numbers reflect the cost of the (SIMD) kernels for each order.
+ * Not run by CTest.
+ *
+ * \ingroup module_ewald
+ */
+#include "gmxpre.h"
+
+#include <cmath>
+#include <cstdio>
+
+#include <chrono>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/domdec/domdec.h"
+#include "gromacs/ewald/pme.h"
+#include "gromacs/ewald/pme_gather.h"
+#include "gromacs/ewald/pme_internal.h"
+#include "gromacs/ewald/pme_spread.h"
+#include "gromacs/math/invertmatrix.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/mdtypes/commrec.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/options/basicoptions.h"
+#include "gromacs/options/ioptionscontainer.h"
+#include "gromacs/random/threefry.h"
+#include "gromacs/random/uniformrealdistribution.h"
+#include "gromacs/utility/logger.h"
+
+#include "testutils/testoptions.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! The number of charges
+int g_atomCount = 20000;
+//! The number of calls to average the timings over
+int g_repeats   = 20;
+
+/*! \cond */
+GMX_TEST_OPTIONS(PmeSpreadGatherBenchmarkOptions, options)
+{
+    options->addOption(IntegerOption("atoms")
+                           .store(&g_atomCount)
+                           .description("Number of charges"));
+    options->addOption(IntegerOption("repeats")
+                           .store(&g_repeats)
+                           .description("Number of calls to average the timings over"));
+}
+/*! \endcond */
+
+//! Returns the time in microseconds per call of \p func averaged over \p repeats calls
+template<typename Func>
+double timePerCall(int repeats, Func func)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++)
+    {
+        func();
+    }
+    const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+    return elapsed.count()/repeats;
+}
+
+TEST(PmeSpreadGatherBenchmark, ReportsTimingsPerOrder)
+{
+    const int  atomCount = g_atomCount;
+
+    /* A box with the density of water for three-site water */
+    const real boxSize   = std::cbrt(atomCount/100.0);
+    matrix     box       = {{boxSize, 0, 0}, {0, boxSize, 0}, {0, 0, boxSize}};
+    const int  gridSize  = static_cast<int>(std::ceil(boxSize/0.12));
+
+    DefaultRandomEngine           rng(2019);
+    UniformRealDistribution<real> position(0, boxSize);
+    UniformRealDistribution<real> charge(-1, 1);
+    std::vector<RVec>             x(atomCount);
+    std::vector<real>             q(atomCount);
+    std::vector<RVec>             f(atomCount);
+    for (int i = 0; i < atomCount; i++)
+    {
+        x[i] = { position(rng), position(rng), position(rng) };
+        q[i] = charge(rng);
+    }
+
+    std::printf("%d atoms, box %.2f nm, grid %d^3, %d repeats\n",
+                atomCount, boxSize, gridSize, g_repeats);
+    std::printf("%5s %16s %16s\n", "order", "spread (us)", "gather (us)");
+
+    for (int order = 4; order <= 8; order++)
+    {
+        t_inputrec inputRec;
+        inputRec.nkx         = gridSize;
+        inputRec.nky         = gridSize;
+        inputRec.nkz         = gridSize;
+        inputRec.pme_order   = order;
+        inputRec.coulombtype = eelPME;
+        inputRec.epsilon_r   = 1.0;
+
+        const MDLogger dummyLogger;
+        t_commrec      dummyCommrec  = {0};
+        NumPmeDomains  numPmeDomains = { 1, 1 };
+        gmx_pme_t     *pme           = gmx_pme_init(&dummyCommrec, numPmeDomains, &inputRec, atomCount,
+                                                    false, false, false, 1.0, 1.0, 1,
+                                                    PmeRunMode::CPU, nullptr, nullptr, nullptr, dummyLogger);
+        invertBoxMatrix(box, pme->recipbox);
+
+        pme_atomcomm_t *atc = &pme->atc[0];
+        atc->x           = as_rvec_array(x.data());
+        atc->coefficient = q.data();
+        atc->f           = as_rvec_array(f.data());
+
+        const double    spreadTime = timePerCall(g_repeats, [&]()
+                                                 {
+                                                     spread_on_grid(pme, atc, &pme->pmegrid[0], TRUE, TRUE,
+                                                                    pme->fftgrid[0], TRUE, 0);
+                                                 });
+
+        atc->spline[0].n = atomCount;
+        const double gatherTime = timePerCall(g_repeats, [&]()
+                                              {
+                                                  gather_f_bsplines(pme, pme->pmegrid[0].grid.grid, TRUE,
+                                                                    atc, &atc->spline[0], 1.0);
+                                              });
+
+        std::printf("%5d %16.1f %16.1f\n", order, spreadTime, gatherTime);
+
+        gmx_pme_destroy(pme);
+    }
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
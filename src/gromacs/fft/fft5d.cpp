@@ -54,6 +54,7 @@
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/gmxmpi.h"
+#include "gromacs/utility/logger.h"
 #include "gromacs/utility/smalloc.h"
 
 #ifdef NOGMX
@@ -82,6 +83,9 @@
 FILE* debug = 0;
 #endif
 
+/* The number of blocks the transposes are split into with FFT5D_PIPELINED */
+static const int c_fft5dNumPipelineBlocks = 4;
+
 #if GMX_FFT_FFTW3
 
 #include "gromacs/utility/exceptions.h"
@@ -402,9 +406,11 @@ fft5d_plan fft5d_plan_3d(int NG, int MG, int KG, MPI_Comm comm[2], int flags, t_
             snew_aligned(lin, lsize, 32);
         }
         snew_aligned(lout, lsize, 32);
-        if (nthreads > 1)
+        if (nthreads > 1 || (flags&FFT5D_PIPELINED))
         {
-            /* We need extra transpose buffers to avoid OpenMP barriers */
+            /* We need extra transpose buffers to avoid OpenMP barriers
+             * and, with pipelining, to communicate while computing FFTs.
+             */
             snew_aligned(lout2, lsize, 32);
             snew_aligned(lout3, lsize, 32);
         }
@@ -419,7 +425,7 @@ fft5d_plan fft5d_plan_3d(int NG, int MG, int KG, MPI_Comm comm[2], int flags, t_
     {
         lin  = *rlin;
         lout = *rlout;
-        if (nthreads > 1)
+        if (nthreads > 1 || (flags&FFT5D_PIPELINED))
         {
             lout2 = *rlout2;
             lout3 = *rlout3;
@@ -433,6 +439,12 @@ fft5d_plan fft5d_plan_3d(int NG, int MG, int KG, MPI_Comm comm[2], int flags, t_
 
     plan = static_cast<fft5d_plan>(calloc(1, sizeof(struct fft5d_plan_t)));
 
+    if (GMX_DOUBLE && (flags&FFT5D_SINGLE_PRECISION_COMM))
+    {
+        snew_aligned(plan->commSendBuffer, 2*lsize, 32);
+        snew_aligned(plan->commRecvBuffer, 2*lsize, 32);
+    }
+
 
     if (debug)
     {
@@ -605,6 +617,51 @@ fft5d_plan fft5d_plan_3d(int NG, int MG, int KG, MPI_Comm comm[2], int flags, t_
         }
     }
 
+    if (flags&FFT5D_PIPELINED)
+    {
+        /* With pipelining the 1D FFTs before each of the two transposes
+           are computed per block of planes along the major axis */
+        plan->numPipelineBlocks = c_fft5dNumPipelineBlocks;
+        for (s = 0; s < 2; s++)
+        {
+            plan->p1dBlock[s] = static_cast<gmx_fft_t*>(malloc(sizeof(gmx_fft_t)*plan->numPipelineBlocks*nthreads));
+        }
+
+#pragma omp parallel for num_threads(nthreads) schedule(static) ordered
+        for (t = 0; t < nthreads; t++)
+        {
+#pragma omp ordered
+            {
+                try
+                {
+                    for (int step = 0; step < 2; step++)
+                    {
+                        for (int b = 0; b < plan->numPipelineBlocks; b++)
+                        {
+                            const int zStart   = std::min(( b   *K[step])/plan->numPipelineBlocks, pK[step]);
+                            const int zEnd     = std::min(((b+1)*K[step])/plan->numPipelineBlocks, pK[step]);
+                            const int numLines = (zEnd - zStart)*pM[step];
+                            const int tsize    = ((t+1)*numLines/nthreads)-(t*numLines/nthreads);
+
+                            gmx_fft_t *p1d = &plan->p1dBlock[step][b*nthreads + t];
+                            if ((flags&FFT5D_REALCOMPLEX) && !(flags&FFT5D_BACKWARD) && step == 0)
+                            {
+                                gmx_fft_init_many_1d_real( p1d, rC[step], tsize, (flags&FFT5D_NOMEASURE) ? GMX_FFT_FLAG_CONSERVATIVE : 0 );
+                            }
+                            else
+                            {
+                                gmx_fft_init_many_1d     ( p1d,  C[step], tsize, (flags&FFT5D_NOMEASURE) ? GMX_FFT_FLAG_CONSERVATIVE : 0 );
+                            }
+                        }
+                    }
+                }
+                GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+            }
+        }
+
+        plan->pipelineRequests = static_cast<MPI_Request*>(malloc(sizeof(MPI_Request)*2*std::max(nP[0], nP[1])*plan->numPipelineBlocks));
+    }
+
 #if GMX_FFT_FFTW3
 }
 #endif
@@ -659,6 +716,10 @@ fft5d_plan fft5d_plan_3d(int NG, int MG, int KG, MPI_Comm comm[2], int flags, t_
     plan->flags         = flags;
     plan->nthreads      = nthreads;
     plan->pinningPolicy = realGridAllocationPinningPolicy;
+    if (plan->numPipelineBlocks == 0)
+    {
+        plan->numPipelineBlocks = 1;
+    }
     *rlin               = lin;
     *rlout              = lout;
     *rlout2             = lout2;
@@ -739,7 +800,8 @@ static void splitaxes(t_complex* lout, const t_complex* lin,
    KG global size*/
 static void joinAxesTrans13(t_complex* lout, const t_complex* lin,
                             int maxN, int maxM, int maxK, int pM,
-                            int P, int KG, const int* K, const int* oK, int starty, int startx, int endy, int endx)
+                            int P, int KG, const int* K, const int* oK, int starty, int startx, int endy, int endx,
+                            int startk, int endk)
 {
     int i, x, y, z;
     int out_i, in_i, out_x, in_x, out_z, in_z;
@@ -771,7 +833,7 @@ static void joinAxesTrans13(t_complex* lout, const t_complex* lin,
         {
             out_i  = out_x  + oK[i];
             in_i   = in_x + i*maxM*maxN*maxK;
-            for (z = 0; z < K[i]; z++) /*3.l*/
+            for (z = startk; z < std::min(K[i], endk); z++) /*3.l*/
             {
                 out_z  = out_i  + z;
                 in_z   = in_i + z*maxM*maxN;
@@ -954,6 +1016,213 @@ static void print_localdata(const t_complex* lin, const char* txt, int s, fft5d_
     }
 }
 
+/*! \brief Converts \p count complex numbers to single precision for communication
+ *
+ * When the plan has a log to report to, also accumulates the rounding
+ * error introduced.
+ */
+static void convertToCommPrecision(fft5d_plan plan, float *dest, const t_complex *src, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        dest[2*i    ] = static_cast<float>(src[i].re);
+        dest[2*i + 1] = static_cast<float>(src[i].im);
+    }
+
+    if (plan->logger)
+    {
+        double errorSquared = 0;
+        double normSquared  = 0;
+        for (int i = 0; i < count; i++)
+        {
+            const double errorRe = src[i].re - dest[2*i    ];
+            const double errorIm = src[i].im - dest[2*i + 1];
+            errorSquared        += errorRe*errorRe + errorIm*errorIm;
+            normSquared         += src[i].re*src[i].re + src[i].im*src[i].im;
+        }
+        plan->commRoundingErrorSquared += errorSquared;
+        plan->commNormSquared          += normSquared;
+    }
+}
+
+/*! \brief Converts \p count complex numbers back from single precision after communication */
+static void convertFromCommPrecision(t_complex *dest, const float *src, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        dest[i].re = src[2*i    ];
+        dest[i].im = src[2*i + 1];
+    }
+}
+
+/*! \brief Does the 1D FFTs of step \p s and the following transpose in a pipelined fashion
+ *
+ * The lines are split into blocks of planes along the major axis.
+ * The communication of each block is started as soon as all its lines
+ * have been transformed and split, so it overlaps with the FFTs of the next
+ * blocks. The received blocks are joined while later blocks are still in
+ * flight. The time spent in thread 0 posting and waiting for communication,
+ * i.e. the communication that is not overlapped, is counted as FFT comm.
+ * Thread 0 also accumulates the wall time from posting the first block until
+ * all blocks have arrived and the part of that spent posting and waiting,
+ * from which fft5d_destroy reports the overlap.
+ */
+static void fft5d_execute_pipelined_step(fft5d_plan plan, int s, int thread, fft5d_time times)
+{
+#if GMX_MPI && !defined FFT5D_MPI_TRANSPOSE
+    t_complex   *lin       = plan->lin;
+    t_complex   *lout      = plan->lout;
+    t_complex   *lout2     = plan->lout2;
+    t_complex   *lout3     = plan->lout3;
+    int         *N         = plan->N, *M = plan->M, *K = plan->K, *pN = plan->pN, *pM = plan->pM, *pK = plan->pK,
+    *C                     = plan->C, *P = plan->P, **iNin = plan->iNin, **oNin = plan->oNin, **iNout = plan->iNout, **oNout = plan->oNout;
+    const int    nthreads  = plan->nthreads;
+    const int    numBlocks = plan->numPipelineBlocks;
+    MPI_Request *requests  = plan->pipelineRequests;
+    const bool   bTrans13  = ((s == 0 && !(plan->flags&FFT5D_ORDER_YZ)) || (s == 1 && (plan->flags&FFT5D_ORDER_YZ)));
+    /* The size of the chunk sent to each rank, as for MPI_Alltoall */
+    const int    chunkSize = (bTrans13 ? N[s]*pM[s]*K[s] : N[s]*M[s]*pK[s]);
+    /* A chunk consists of K[s] planes along the major axis */
+    const int    planeSize = (K[s] > 0 ? chunkSize/K[s] : 0);
+    const int    realsPerComplex = sizeof(t_complex)/sizeof(real);
+    double       commStartTime   = 0;
+
+    /* The lines are divided differently over the threads than in the previous join */
+#pragma omp barrier
+
+    for (int b = 0; b < numBlocks; b++)
+    {
+        const int zStart   = ( b   *K[s])/numBlocks;
+        const int zEnd     = ((b+1)*K[s])/numBlocks;
+        const int numLines = (std::min(zEnd, pK[s]) - std::min(zStart, pK[s]))*pM[s];
+        const int tstart   = std::min(zStart, pK[s])*pM[s] + ( thread   *numLines/nthreads);
+        const int tend     = std::min(zStart, pK[s])*pM[s] + ((thread+1)*numLines/nthreads);
+
+        if (tend > tstart)
+        {
+            gmx_fft_t p1d = plan->p1dBlock[s][b*nthreads + thread];
+            if ((plan->flags&FFT5D_REALCOMPLEX) && !(plan->flags&FFT5D_BACKWARD) && s == 0)
+            {
+                gmx_fft_many_1d_real(p1d, GMX_FFT_REAL_TO_COMPLEX, lin+tstart*C[s], lout+tstart*C[s]);
+            }
+            else
+            {
+                gmx_fft_many_1d(     p1d, (plan->flags&FFT5D_BACKWARD) ? GMX_FFT_BACKWARD : GMX_FFT_FORWARD, lin+tstart*C[s], lout+tstart*C[s]);
+            }
+            splitaxes(lout2, lout, N[s], M[s], K[s], pM[s], P[s], C[s], iNout[s], oNout[s], tstart%pM[s], tstart/pM[s], tend%pM[s], tend/pM[s]);
+        }
+#pragma omp barrier /*all lines of this block have to be split before sending*/
+
+        if (thread == 0 && zEnd > zStart)
+        {
+#ifndef NOGMX
+            wallcycle_start(times, ewcPME_FFTCOMM);
+#endif
+            const double postStartTime = MPI_Wtime();
+            if (b == 0)
+            {
+                commStartTime = postStartTime;
+            }
+            const int    count = (zEnd - zStart)*planeSize;
+            for (int i = 0; i < P[s]; i++)
+            {
+                const int offset = i*chunkSize + zStart*planeSize;
+                if (plan->commSendBuffer)
+                {
+                    convertToCommPrecision(plan, plan->commSendBuffer + 2*offset, lout2 + offset, count);
+                    MPI_Irecv(plan->commRecvBuffer + 2*offset, 2*count, MPI_FLOAT, i, b, plan->cart[s], &requests[(2*b    )*P[s] + i]);
+                    MPI_Isend(plan->commSendBuffer + 2*offset, 2*count, MPI_FLOAT, i, b, plan->cart[s], &requests[(2*b + 1)*P[s] + i]);
+                }
+                else
+                {
+                    MPI_Irecv(reinterpret_cast<real *>(lout3 + offset), count*realsPerComplex, GMX_MPI_REAL, i, b, plan->cart[s], &requests[(2*b    )*P[s] + i]);
+                    MPI_Isend(reinterpret_cast<real *>(lout2 + offset), count*realsPerComplex, GMX_MPI_REAL, i, b, plan->cart[s], &requests[(2*b + 1)*P[s] + i]);
+                }
+            }
+            plan->pipelineWaitTime += MPI_Wtime() - postStartTime;
+#ifndef NOGMX
+            wallcycle_stop(times, ewcPME_FFTCOMM);
+#endif
+        }
+    }
+
+    for (int b = 0; b < numBlocks; b++)
+    {
+        const int zStart = ( b   *K[s])/numBlocks;
+        const int zEnd   = ((b+1)*K[s])/numBlocks;
+
+        if (zEnd == zStart)
+        {
+            continue;
+        }
+
+        if (thread == 0)
+        {
+#ifndef NOGMX
+            wallcycle_start(times, ewcPME_FFTCOMM);
+#endif
+            const double waitStartTime = MPI_Wtime();
+            MPI_Waitall(P[s], &requests[2*b*P[s]], MPI_STATUSES_IGNORE);
+            if (plan->commRecvBuffer)
+            {
+                for (int i = 0; i < P[s]; i++)
+                {
+                    const int offset = i*chunkSize + zStart*planeSize;
+                    convertFromCommPrecision(lout3 + offset, plan->commRecvBuffer + 2*offset, (zEnd - zStart)*planeSize);
+                }
+            }
+            plan->pipelineWaitTime += MPI_Wtime() - waitStartTime;
+#ifndef NOGMX
+            wallcycle_stop(times, ewcPME_FFTCOMM);
+#endif
+        }
+#pragma omp barrier /*the data of this block has to be received before joining*/
+
+        if (bTrans13)
+        {
+            if (pM[s] > 0)
+            {
+                const int tstart = ( thread   *pM[s]*pN[s]/nthreads);
+                const int tend   = ((thread+1)*pM[s]*pN[s]/nthreads);
+                joinAxesTrans13(lin, lout3, N[s], pM[s], K[s], pM[s], P[s], C[s+1], iNin[s+1], oNin[s+1], tstart%pM[s], tstart/pM[s], tend%pM[s], tend/pM[s], zStart, zEnd);
+            }
+        }
+        else
+        {
+            const int numLines = (std::min(zEnd, pK[s]) - std::min(zStart, pK[s]))*pN[s];
+            if (pN[s] > 0 && numLines > 0)
+            {
+                const int tstart = std::min(zStart, pK[s])*pN[s] + ( thread   *numLines/nthreads);
+                const int tend   = std::min(zStart, pK[s])*pN[s] + ((thread+1)*numLines/nthreads);
+                joinAxesTrans12(lin, lout3, N[s], M[s], pK[s], pN[s], P[s], C[s+1], iNin[s+1], oNin[s+1], tstart%pN[s], tstart/pN[s], tend%pN[s], tend/pN[s]);
+            }
+        }
+    }
+
+    if (thread == 0)
+    {
+        const double waitStartTime = MPI_Wtime();
+        for (int b = 0; b < numBlocks; b++)
+        {
+            if (((b+1)*K[s])/numBlocks > (b*K[s])/numBlocks)
+            {
+                MPI_Waitall(P[s], &requests[(2*b + 1)*P[s]], MPI_STATUSES_IGNORE);
+            }
+        }
+        const double commEndTime = MPI_Wtime();
+        plan->pipelineWaitTime  += commEndTime - waitStartTime;
+        plan->pipelineCommTime  += commEndTime - commStartTime;
+    }
+#pragma omp barrier /*the join is not divided over threads as the following FFT*/
+#else
+    GMX_UNUSED_VALUE(plan);
+    GMX_UNUSED_VALUE(s);
+    GMX_UNUSED_VALUE(thread);
+    GMX_UNUSED_VALUE(times);
+    gmx_incons("fft5d pipelined transpose without MPI configuration");
+#endif
+}
+
 void fft5d_execute(fft5d_plan plan, int thread, fft5d_time times)
 {
     t_complex  *lin   = plan->lin;
@@ -1022,6 +1291,17 @@ void fft5d_execute(fft5d_plan plan, int thread, fft5d_time times)
             bParallelDim = 0;
         }
 
+        if (bParallelDim && plan->numPipelineBlocks > 1)
+        {
+            fft5d_execute_pipelined_step(plan, s, thread, times);
+
+            if ((plan->flags&FFT5D_DEBUG) && thread == 0)
+            {
+                print_localdata(lin, "%d %d: tranposed %d\n", s+1, plan);
+            }
+            continue;
+        }
+
         /* ---------- START FFT ------------ */
 #ifdef NOGMX
         if (times != 0 && thread == 0)
@@ -1112,13 +1392,24 @@ void fft5d_execute(fft5d_plan plan, int thread, fft5d_time times)
                 FFTW(execute)(mpip[s]);
 #else
 #if GMX_MPI
+                int count;
                 if ((s == 0 && !(plan->flags&FFT5D_ORDER_YZ)) || (s == 1 && (plan->flags&FFT5D_ORDER_YZ)))
                 {
-                    MPI_Alltoall(reinterpret_cast<real *>(lout2), N[s]*pM[s]*K[s]*sizeof(t_complex)/sizeof(real), GMX_MPI_REAL, reinterpret_cast<real *>(lout3), N[s]*pM[s]*K[s]*sizeof(t_complex)/sizeof(real), GMX_MPI_REAL, cart[s]);
+                    count = N[s]*pM[s]*K[s];
+                }
+                else
+                {
+                    count = N[s]*M[s]*pK[s];
+                }
+                if (plan->commSendBuffer)
+                {
+                    convertToCommPrecision(plan, plan->commSendBuffer, lout2, count*P[s]);
+                    MPI_Alltoall(plan->commSendBuffer, 2*count, MPI_FLOAT, plan->commRecvBuffer, 2*count, MPI_FLOAT, cart[s]);
+                    convertFromCommPrecision(lout3, plan->commRecvBuffer, count*P[s]);
                 }
                 else
                 {
-                    MPI_Alltoall(reinterpret_cast<real *>(lout2), N[s]*M[s]*pK[s]*sizeof(t_complex)/sizeof(real), GMX_MPI_REAL, reinterpret_cast<real *>(lout3), N[s]*M[s]*pK[s]*sizeof(t_complex)/sizeof(real), GMX_MPI_REAL, cart[s]);
+                    MPI_Alltoall(reinterpret_cast<real *>(lout2), count*sizeof(t_complex)/sizeof(real), GMX_MPI_REAL, reinterpret_cast<real *>(lout3), count*sizeof(t_complex)/sizeof(real), GMX_MPI_REAL, cart[s]);
                 }
 #else
                 gmx_incons("fft5d MPI call without MPI configuration");
@@ -1165,7 +1456,7 @@ void fft5d_execute(fft5d_plan plan, int thread, fft5d_time times)
             {
                 tstart = ( thread   *pM[s]*pN[s]/plan->nthreads);
                 tend   = ((thread+1)*pM[s]*pN[s]/plan->nthreads);
-                joinAxesTrans13(lin, joinin, N[s], pM[s], K[s], pM[s], P[s], C[s+1], iNin[s+1], oNin[s+1], tstart%pM[s], tstart/pM[s], tend%pM[s], tend/pM[s]);
+                joinAxesTrans13(lin, joinin, N[s], pM[s], K[s], pM[s], P[s], C[s+1], iNin[s+1], oNin[s+1], tstart%pM[s], tstart/pM[s], tend%pM[s], tend/pM[s], 0, K[s]);
             }
         }
         else
@@ -1248,6 +1539,14 @@ void fft5d_destroy(fft5d_plan plan)
             }
             free(plan->p1d[s]);
         }
+        if (s < 2 && plan->p1dBlock[s])
+        {
+            for (t = 0; t < plan->numPipelineBlocks*plan->nthreads; t++)
+            {
+                gmx_many_fft_destroy(plan->p1dBlock[s][t]);
+            }
+            free(plan->p1dBlock[s]);
+        }
         if (plan->iNin[s])
         {
             free(plan->iNin[s]);
@@ -1294,7 +1593,7 @@ void fft5d_destroy(fft5d_plan plan)
         }
         sfree_aligned(plan->lin);
         sfree_aligned(plan->lout);
-        if (plan->nthreads > 1)
+        if (plan->nthreads > 1 || (plan->flags&FFT5D_PIPELINED))
         {
             sfree_aligned(plan->lout2);
             sfree_aligned(plan->lout3);
@@ -1307,9 +1606,58 @@ void fft5d_destroy(fft5d_plan plan)
 #endif
 #endif
 
+    if (plan->commSendBuffer)
+    {
+        if (plan->logger)
+        {
+            GMX_LOG(plan->logger->info).appendTextFormatted(
+                    "The %s 3D FFT transposes were communicated in single precision, rms relative rounding error of the communicated data %.2e",
+                    (plan->flags&FFT5D_BACKWARD) ? "backward" : "forward",
+                    fft5d_comm_relative_rounding_error(plan));
+        }
+        sfree_aligned(plan->commSendBuffer);
+        sfree_aligned(plan->commRecvBuffer);
+    }
+
+    if (plan->logger && (plan->flags&FFT5D_PIPELINED) && plan->pipelineCommTime > 0)
+    {
+        double commTime;
+        double overlap = fft5d_pipelined_comm_overlap(plan, &commTime);
+        GMX_LOG(plan->logger->info).appendTextFormatted(
+                "The %s 3D FFT transposes were pipelined, %.1f%% of the %.3f s of communication was overlapped with computation",
+                (plan->flags&FFT5D_BACKWARD) ? "backward" : "forward",
+                100*overlap, commTime);
+    }
+
+    free(plan->pipelineRequests);
     free(plan);
 }
 
+double fft5d_comm_relative_rounding_error(fft5d_plan plan)
+{
+    if (plan->commNormSquared > 0)
+    {
+        return std::sqrt(plan->commRoundingErrorSquared/plan->commNormSquared);
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+double fft5d_pipelined_comm_overlap(fft5d_plan plan, double *commTime)
+{
+    *commTime = plan->pipelineCommTime;
+    if (plan->pipelineCommTime > 0)
+    {
+        return std::max(plan->pipelineCommTime - plan->pipelineWaitTime, 0.0)/plan->pipelineCommTime;
+    }
+    else
+    {
+        return 0;
+    }
+}
+
 /*Is this better than direct access of plan? enough data?
    here 0,1 reference divided by which processor grid dimension (not FFT step!)*/
 void fft5d_local_size(fft5d_plan plan, int* N1, int* M0, int* K0, int* K1, int** coor)
@@ -76,6 +76,7 @@ typedef gmx_wallcycle_t fft5d_time;
 
 namespace gmx
 {
+class MDLogger;
 enum class PinningPolicy : int;
 } // namespace
 
@@ -86,7 +87,11 @@ typedef enum fft5d_flags_t {
     FFT5D_DEBUG       = 8,
     FFT5D_NOMEASURE   = 16,
     FFT5D_INPLACE     = 32,
-    FFT5D_NOMALLOC    = 64
+    FFT5D_NOMALLOC    = 64,
+    FFT5D_PIPELINED   = 128,
+    /* Communicate the transposes in single precision, only has effect in double precision builds.
+       The grids and the 1D FFTs stay in the precision of real. */
+    FFT5D_SINGLE_PRECISION_COMM = 256
 } fft5d_flags;
 
 struct fft5d_plan_t {
@@ -118,6 +123,23 @@ struct fft5d_plan_t {
     int                coor[2];
     int                nthreads;
     gmx::PinningPolicy pinningPolicy;
+    /* With FFT5D_PIPELINED the transposes are split into blocks along the
+       major axis, which are communicated while the 1D FFTs of the next block
+       are computed. Otherwise the number of blocks is 1. */
+    int                numPipelineBlocks;
+    gmx_fft_t         *p1dBlock[2];      /*1D plans per pipeline block and thread*/
+    MPI_Request       *pipelineRequests; /*requests for all pipeline blocks and peers*/
+    double             pipelineCommTime; /*wall time from posting the first block until all blocks arrived*/
+    double             pipelineWaitTime; /*part of pipelineCommTime spent posting and waiting*/
+    /* With FFT5D_SINGLE_PRECISION_COMM in double precision the transposes are
+       communicated through these single precision buffers */
+    float             *commSendBuffer, *commRecvBuffer;
+    /* When set, the overlap of pipelined transposes and the rounding error
+       of single precision transposes are accumulated and written to this log
+       by fft5d_destroy */
+    const gmx::MDLogger *logger;
+    double             commRoundingErrorSquared; /*sum of squared rounding errors of the sent data*/
+    double             commNormSquared;          /*sum of squares of the sent data*/
 };
 
 typedef struct fft5d_plan_t *fft5d_plan;
@@ -127,6 +149,15 @@ fft5d_plan fft5d_plan_3d(int N, int M, int K, MPI_Comm comm[2], int flags, t_com
 void fft5d_local_size(fft5d_plan plan, int* N1, int* M0, int* K0, int* K1, int** coor);
 void fft5d_destroy(fft5d_plan plan);
 fft5d_plan fft5d_plan_3d_cart(int N, int M, int K, MPI_Comm comm, int P0, int flags, t_complex** lin, t_complex** lin2, t_complex** lout2, t_complex** lout3, int nthreads);
+/*! \brief Returns the rms relative rounding error of the data communicated
+ * in single precision with FFT5D_SINGLE_PRECISION_COMM, 0 when not used
+ * or when logger is not set */
+double fft5d_comm_relative_rounding_error(fft5d_plan plan);
+/*! \brief Returns the fraction of the communication time of pipelined
+ * transposes that was overlapped with computation, 0 without FFT5D_PIPELINED
+ *
+ * \p commTime is set to the total time in seconds with transposes in flight. */
+double fft5d_pipelined_comm_overlap(fft5d_plan plan, double *commTime);
 void fft5d_compare_data(const t_complex* lin, const t_complex* in, fft5d_plan plan, int bothLocal, int normarlize);
 
 #endif
@@ -46,6 +46,7 @@
 #include "gromacs/math/gmxcomplex.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/gmxmpi.h"
+#include "gromacs/utility/logger.h"
 #include "gromacs/utility/smalloc.h"
 
 struct gmx_parallel_3dfft  {
@@ -60,7 +61,8 @@ gmx_parallel_3dfft_init   (gmx_parallel_3dfft_t           *    pfft_setup,
                            MPI_Comm                            comm[2],
                            gmx_bool                            bReproducible,
                            int                                 nthreads,
-                           gmx::PinningPolicy                  realGridAllocation)
+                           gmx::PinningPolicy                  realGridAllocation,
+                           const gmx::MDLogger                *logger)
 {
     int        rN      = ndata[2], M = ndata[1], K = ndata[0];
     int        flags   = FFT5D_REALCOMPLEX | FFT5D_ORDER_YZ; /* FFT5D_DEBUG */
@@ -73,6 +75,14 @@ gmx_parallel_3dfft_init   (gmx_parallel_3dfft_t           *    pfft_setup,
     {
         flags |= FFT5D_NOMEASURE;
     }
+    if (getenv("GMX_PME_FFT_PIPELINE") != nullptr)
+    {
+        flags |= FFT5D_PIPELINED;
+    }
+    if (GMX_DOUBLE && getenv("GMX_PME_FFT_SINGLE_PRECISION_COMM") != nullptr)
+    {
+        flags |= FFT5D_SINGLE_PRECISION_COMM;
+    }
 
     if (!(flags&FFT5D_ORDER_YZ))
     {
@@ -88,6 +98,14 @@ gmx_parallel_3dfft_init   (gmx_parallel_3dfft_t           *    pfft_setup,
     (*pfft_setup)->p2 = fft5d_plan_3d(Nb, Mb, Kb, rcomm,
                                       (flags|FFT5D_BACKWARD|FFT5D_NOMALLOC)^FFT5D_ORDER_YZ, complex_data, reinterpret_cast<t_complex**>(real_data), &buf1, &buf2, nthreads);
 
+    /* Only accumulate statistics on ranks that write them to the log */
+    if (logger != nullptr && logger->info &&
+        (*pfft_setup)->p1 != nullptr && (*pfft_setup)->p2 != nullptr)
+    {
+        (*pfft_setup)->p1->logger = logger;
+        (*pfft_setup)->p2->logger = logger;
+    }
+
     return static_cast<int>((*pfft_setup)->p1 != nullptr && (*pfft_setup)->p2 != nullptr);
 }
 
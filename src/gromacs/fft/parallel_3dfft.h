@@ -45,6 +45,11 @@
 #include "gromacs/utility/gmxmpi.h"
 #include "gromacs/utility/real.h"
 
+namespace gmx
+{
+class MDLogger;
+} // namespace gmx
+
 typedef struct gmx_parallel_3dfft *
     gmx_parallel_3dfft_t;
 
@@ -73,6 +78,11 @@ typedef struct gmx_parallel_3dfft *
  *  \param nthreads       Run in parallel using n threads
  *  \param realGridAllocation  Whether to make real grid use allocation pinned for GPU transfers.
  *                             Only used in PME mixed CPU+GPU mode.
+ *  \param logger         When not nullptr and its info level writes output,
+ *                        the overlap of pipelined transposes and the rounding error
+ *                        of transposes communicated in single precision are
+ *                        accumulated and written to it on destruction.
+ *                        Must outlive the setup.
  *
  *  \return 0 or a standard error code.
  */
@@ -84,7 +94,8 @@ int
                                MPI_Comm                  comm[2],
                                gmx_bool                  bReproducible,
                                int                       nthreads,
-                               gmx::PinningPolicy realGridAllocation = gmx::PinningPolicy::CannotBePinned);
+                               gmx::PinningPolicy realGridAllocation = gmx::PinningPolicy::CannotBePinned,
+                               const gmx::MDLogger *logger = nullptr);
 
 
 
@@ -0,0 +1,242 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests the pipelined and single precision fft5d transposes
+ *
+ * Does 3D real-to-complex FFTs and back over a 2x2 rank grid and
+ * checks that with FFT5D_PIPELINED the forward and backward results
+ * match those with blocking transposes, also with multiple threads,
+ * and that with FFT5D_SINGLE_PRECISION_COMM the result matches that
+ * of the default path within single precision accuracy. The latter flag
+ * only has an effect in double precision, otherwise the results are
+ * identical.
+ *
+ * \ingroup module_fft
+ */
+#include "gmxpre.h"
+
+#include "gromacs/fft/fft5d.h"
+
+#include <cmath>
+
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/math/gmxcomplex.h"
+#include "gromacs/utility/gmxmpi.h"
+#include "gromacs/utility/gmxomp.h"
+#include "gromacs/utility/real.h"
+
+#include "testutils/mpitest.h"
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! The local grids after a forward and a backward 3D FFT
+struct TransformResult
+{
+    //! The local complex grid after the forward transform
+    std::vector<real> complexGrid;
+    //! The local real grid after the backward transform
+    std::vector<real> realGrid;
+    //! The fraction of the pipelined communication overlapped with computation
+    double            overlap;
+    //! The time with pipelined transposes in flight
+    double            commTime;
+};
+
+/*! \brief Executes \p plan with \p numThreads threads */
+void execute(fft5d_plan plan, int numThreads)
+{
+#pragma omp parallel num_threads(numThreads)
+    {
+        fft5d_execute(plan, gmx_omp_get_thread_num(), nullptr);
+    }
+}
+
+/*! \brief Returns the local grids after a forward and a backward 3D FFT
+ *
+ * The plans are set up as in gmx_parallel_3dfft_init, with \p flags
+ * added, on a 2x2 rank grid with \p numThreads threads.
+ */
+TransformResult transformForwardAndBackward(int flags, int numThreads = 1)
+{
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm comm[2];
+    MPI_Comm_split(MPI_COMM_WORLD, rank/2, rank, &comm[0]);
+    MPI_Comm_split(MPI_COMM_WORLD, rank%2, rank, &comm[1]);
+
+    const int  nx = 14, ny = 12, nz = 15;
+    t_complex *realData, *complexData, *buf1, *buf2;
+
+    flags |= FFT5D_REALCOMPLEX | FFT5D_ORDER_YZ | FFT5D_NOMEASURE;
+    fft5d_plan forward  = fft5d_plan_3d(nz, ny, nx, comm, flags,
+                                        &realData, &complexData, &buf1, &buf2, numThreads);
+    fft5d_plan backward = fft5d_plan_3d(nx, nz, ny, comm, (flags|FFT5D_BACKWARD|FFT5D_NOMALLOC)^FFT5D_ORDER_YZ,
+                                        &complexData, &realData, &buf1, &buf2, numThreads);
+
+    /* The local real grid is stored as [x][y][z] with padded z rows */
+    real     *grid      = reinterpret_cast<real *>(realData);
+    const int localNx   = forward->pK[0];
+    const int localNy   = forward->pM[0];
+    const int localNz   = forward->rC[0];
+    const int rowStride = 2*forward->C[0];
+    for (int i = 0; i < localNx; i++)
+    {
+        for (int j = 0; j < localNy; j++)
+        {
+            for (int k = 0; k < localNz; k++)
+            {
+                const int x = forward->oK[0] + i;
+                const int y = forward->oM[0] + j;
+
+                grid[(i*localNy + j)*rowStride + k] = std::cos(0.7*x + 0.3*y*k) + 0.1*(x - y);
+            }
+        }
+    }
+
+    TransformResult result;
+    execute(forward, numThreads);
+    /* The local complex grid is stored as in the real grid of the backward plan */
+    const real *complexGrid = reinterpret_cast<real *>(complexData);
+    result.complexGrid.assign(complexGrid, complexGrid + 2*backward->pK[0]*backward->pM[0]*backward->C[0]);
+    execute(backward, numThreads);
+
+    for (int i = 0; i < localNx; i++)
+    {
+        for (int j = 0; j < localNy; j++)
+        {
+            for (int k = 0; k < localNz; k++)
+            {
+                result.realGrid.push_back(grid[(i*localNy + j)*rowStride + k]);
+            }
+        }
+    }
+    result.overlap = fft5d_pipelined_comm_overlap(forward, &result.commTime);
+
+    fft5d_destroy(backward);
+    fft5d_destroy(forward);
+    MPI_Comm_free(&comm[0]);
+    MPI_Comm_free(&comm[1]);
+
+    return result;
+}
+
+//! Checks that \p result matches \p reference within \p relativeTolerance of its largest value
+void checkGridsMatch(const std::vector<real> &reference, const std::vector<real> &result,
+                     double relativeTolerance)
+{
+    ASSERT_EQ(reference.size(), result.size());
+    ASSERT_FALSE(reference.empty());
+
+    real magnitude = 0;
+    for (real value : reference)
+    {
+        magnitude = std::max(magnitude, std::abs(value));
+    }
+    const FloatingPointTolerance tolerance = relativeToleranceAsFloatingPoint(magnitude, relativeTolerance);
+    for (size_t i = 0; i < reference.size(); i++)
+    {
+        EXPECT_REAL_EQ_TOL(reference[i], result[i], tolerance) << "grid element " << i;
+    }
+}
+
+//! Checks that pipelined transposes with \p numThreads threads match blocking transposes
+void checkPipelinedMatchesBlocking(int numThreads)
+{
+    const TransformResult reference = transformForwardAndBackward(0, numThreads);
+    const TransformResult result    = transformForwardAndBackward(FFT5D_PIPELINED, numThreads);
+
+    /* The 1D FFTs of a block of lines can use a different algorithm than
+       those of all lines, so the results can differ by rounding */
+    {
+        SCOPED_TRACE("Comparing the forward transforms");
+        checkGridsMatch(reference.complexGrid, result.complexGrid, GMX_DOUBLE ? 1e-12 : 1e-6);
+    }
+    {
+        SCOPED_TRACE("Comparing the backward transforms");
+        checkGridsMatch(reference.realGrid, result.realGrid, GMX_DOUBLE ? 1e-12 : 1e-6);
+    }
+    EXPECT_EQ(0, reference.commTime);
+    EXPECT_GT(result.commTime, 0);
+    EXPECT_GE(result.overlap, 0);
+    EXPECT_LE(result.overlap, 1);
+}
+
+//! Checks that single precision communication matches the default with \p flags
+void checkSinglePrecisionCommMatchesDefault(int flags)
+{
+    const TransformResult reference = transformForwardAndBackward(flags);
+    const TransformResult result    = transformForwardAndBackward(flags | FFT5D_SINGLE_PRECISION_COMM);
+
+    checkGridsMatch(reference.realGrid, result.realGrid, 2e-6);
+}
+
+TEST(Fft5dTest, PipelinedTransposesMatchBlocking)
+{
+    GMX_MPI_TEST(4);
+    checkPipelinedMatchesBlocking(1);
+}
+
+TEST(Fft5dTest, PipelinedTransposesMatchBlockingWithTwoThreads)
+{
+    GMX_MPI_TEST(4);
+    checkPipelinedMatchesBlocking(2);
+}
+
+TEST(Fft5dTest, SinglePrecisionCommMatchesDefault)
+{
+    GMX_MPI_TEST(4);
+    checkSinglePrecisionCommMatchesDefault(0);
+}
+
+TEST(Fft5dTest, PipelinedSinglePrecisionCommMatchesDefault)
+{
+    GMX_MPI_TEST(4);
+    checkSinglePrecisionCommMatchesDefault(FFT5D_PIPELINED);
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -40,6 +40,7 @@
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <cstdint>
 #include <cstring>
 
 #include <algorithm>
@@ -164,7 +165,7 @@ static int sizeofint(const int size)
  |
  | given the number of small unsigned integers and the maximum value
  | return the number of bits needed to read or write them with the
- | routines receiveints and sendints. You need this parameter when
+ | routines bitreader_receiveints and sendints. You need this parameter when
  | calling these routines. Note that for many calls I can use
  | the variable 'smallidx' which is exactly the number of bits, and
  | So I don't need to call 'sizeofints for those calls.
@@ -278,81 +279,129 @@ static void sendints(int buf[], const int num_of_ints, const int num_of_bits,
 }
 
 
-/*___________________________________________________________________________
+/*____________________________________________________________________________
  |
- | receivebits - decode number from buf using specified number of bits
+ | t_bitreader - read bits from the compressed coordinate stream
  |
- | extract the number of bits from the array buf and construct an integer
- | from it. Return that value.
+ | This is the inverse of sendbits(). Instead of handling the stream one byte
+ | at a time, up to 64 not yet consumed bits are kept left-aligned in an
+ | accumulator, which is refilled from the stream one 64-bit big-endian word
+ | at a time, so that most reads are a shift and a mask. Bits past the end
+ | of the stream read as zero.
  |
  */
 
-static int receivebits(int buf[], int num_of_bits)
+typedef struct
 {
+    const unsigned char *data;  /* start of the compressed data */
+    size_t               size;  /* number of bytes in data */
+    size_t               pos;   /* next byte of data to load into acc */
+    uint64_t             acc;   /* pending bits, most significant first */
+    int                  nbits; /* number of valid bits in acc */
+} t_bitreader;
+
+static void bitreader_init(t_bitreader *br, const unsigned char *data, size_t size)
+{
+    br->data  = data;
+    br->size  = size;
+    br->pos   = 0;
+    br->acc   = 0;
+    br->nbits = 0;
+}
 
-    int             cnt, num, lastbits;
-    unsigned int    lastbyte;
-    unsigned char * cbuf;
-    int             mask = (1 << num_of_bits) -1;
-
-    cbuf     = reinterpret_cast<unsigned char *>(buf) + 3 * sizeof(*buf);
-    cnt      = buf[0];
-    lastbits = static_cast<unsigned int>(buf[1]);
-    lastbyte = static_cast<unsigned int>(buf[2]);
-
-    num = 0;
-    while (num_of_bits >= 8)
+/* Make sure that at least 56 bits are available in the accumulator */
+static inline void bitreader_refill(t_bitreader *br)
+{
+    if (br->pos + 8 <= br->size)
     {
-        lastbyte     = ( lastbyte << 8 ) | cbuf[cnt++];
-        num         |=  (lastbyte >> lastbits) << (num_of_bits - 8);
-        num_of_bits -= 8;
+        const unsigned char *p    = br->data + br->pos;
+        uint64_t             word =
+            (static_cast<uint64_t>(p[0]) << 56) | (static_cast<uint64_t>(p[1]) << 48) |
+            (static_cast<uint64_t>(p[2]) << 40) | (static_cast<uint64_t>(p[3]) << 32) |
+            (static_cast<uint64_t>(p[4]) << 24) | (static_cast<uint64_t>(p[5]) << 16) |
+            (static_cast<uint64_t>(p[6]) << 8)  |  static_cast<uint64_t>(p[7]);
+        /* Only whole bytes are consumed, so the stream position stays
+         * byte-aligned. */
+        const int            nbytes = (63 - br->nbits) >> 3;
+        br->acc   |= word >> br->nbits;
+        br->pos   += nbytes;
+        br->nbits += nbytes * 8;
     }
-    if (num_of_bits > 0)
+    else
     {
-        if (lastbits < num_of_bits)
+        while (br->nbits <= 56)
         {
-            lastbits += 8;
-            lastbyte  = (lastbyte << 8) | cbuf[cnt++];
+            uint64_t byte = (br->pos < br->size) ? br->data[br->pos] : 0;
+            br->acc   |= byte << (56 - br->nbits);
+            br->pos++;
+            br->nbits += 8;
         }
-        lastbits -= num_of_bits;
-        num      |= (lastbyte >> lastbits) & ((1 << num_of_bits) -1);
     }
-    num   &= mask;
-    buf[0] = cnt;
-    buf[1] = lastbits;
-    buf[2] = lastbyte;
+}
+
+/* Return the next num_of_bits (1 to 56) bits of the stream */
+static inline uint64_t bitreader_read(t_bitreader *br, int num_of_bits)
+{
+    if (br->nbits < num_of_bits)
+    {
+        bitreader_refill(br);
+    }
+    uint64_t num = br->acc >> (64 - num_of_bits);
+    br->acc   <<= num_of_bits;
+    br->nbits  -= num_of_bits;
     return num;
 }
 
 /*____________________________________________________________________________
  |
- | receiveints - decode 'small' integers from the buf array
+ | bitreader_receiveints - decode three 'small' integers from the stream
  |
- | this routine is the inverse from sendints() and decodes the small integers
- | written to buf by calculating the remainder and doing divisions with
- | the given sizes[]. You need to specify the total number of bits to be
- | used from buf in num_of_bits.
+ | This is the inverse of sendints() with num_of_ints == 3. The encoded value
+ | is a little-endian sequence of bytes that holds the integers as a mixed
+ | radix number with the given sizes. When it fits into 64 bits, which is
+ | always the case except for the very largest sizes, the bytes are assembled
+ | into a single integer with one read and a byte swap, and two native
+ | divisions suffice. Otherwise, the division is done byte by byte.
  |
  */
 
-static void receiveints(int buf[], const int num_of_ints, int num_of_bits,
-                        const unsigned int sizes[], int nums[])
+static inline void bitreader_receiveints(t_bitreader *br, int num_of_bits,
+                                         const unsigned int sizes[], int nums[])
 {
+    if (num_of_bits <= 64)
+    {
+        /* All full bytes except the last one, which may be partial */
+        const int nbytes = (num_of_bits - 1) >> 3;
+        uint64_t  num    = 0;
+        if (nbytes > 0)
+        {
+            uint64_t bytes = bitreader_read(br, nbytes * 8);
+            for (int j = 0; j < nbytes; j++)
+            {
+                num   = (num << 8) | (bytes & 0xff);
+                bytes = bytes >> 8;
+            }
+        }
+        num    |= bitreader_read(br, num_of_bits - nbytes * 8) << (nbytes * 8);
+        nums[2] = static_cast<int>(num % sizes[2]);
+        num    /= sizes[2];
+        nums[1] = static_cast<int>(num % sizes[1]);
+        num    /= sizes[1];
+        nums[0] = static_cast<int>(num);
+        return;
+    }
+
     int bytes[32];
     int i, j, num_of_bytes, p, num;
 
-    bytes[0]     = bytes[1] = bytes[2] = bytes[3] = 0;
     num_of_bytes = 0;
     while (num_of_bits > 8)
     {
-        bytes[num_of_bytes++] = receivebits(buf, 8);
+        bytes[num_of_bytes++] = static_cast<int>(bitreader_read(br, 8));
         num_of_bits          -= 8;
     }
-    if (num_of_bits > 0)
-    {
-        bytes[num_of_bytes++] = receivebits(buf, num_of_bits);
-    }
-    for (i = num_of_ints-1; i > 0; i--)
+    bytes[num_of_bytes++] = static_cast<int>(bitreader_read(br, num_of_bits));
+    for (i = 2; i > 0; i--)
     {
         num = 0;
         for (j = num_of_bytes-1; j >= 0; j--)
@@ -419,6 +468,7 @@ int xdr3dfcoord(XDR *xdrs, float *fp, int *size, float *precision)
     int          bufsize, lsize;
     unsigned int bitsize;
     float        inv_precision;
+    t_bitreader  reader;
     int          errval = 1;
     int          rc;
 
@@ -894,10 +944,10 @@ int xdr3dfcoord(XDR *xdrs, float *fp, int *size, float *precision)
 
 
 
-        buf[0] = buf[1] = buf[2] = 0;
+        bitreader_init(&reader, reinterpret_cast<unsigned char *>(&(buf[3])),
+                       static_cast<size_t>(buf[0]));
 
-        lfp           = fp;
-        inv_precision = 1.0 / *precision;
+        /* Decode the integer coordinates into ip, in output order */
         run           = 0;
         i             = 0;
         lip           = ip;
@@ -907,13 +957,13 @@ int xdr3dfcoord(XDR *xdrs, float *fp, int *size, float *precision)
 
             if (bitsize == 0)
             {
-                thiscoord[0] = receivebits(buf, bitsizeint[0]);
-                thiscoord[1] = receivebits(buf, bitsizeint[1]);
-                thiscoord[2] = receivebits(buf, bitsizeint[2]);
+                thiscoord[0] = static_cast<int>(bitreader_read(&reader, bitsizeint[0]));
+                thiscoord[1] = static_cast<int>(bitreader_read(&reader, bitsizeint[1]));
+                thiscoord[2] = static_cast<int>(bitreader_read(&reader, bitsizeint[2]));
             }
             else
             {
-                receiveints(buf, 3, bitsize, sizeint, thiscoord);
+                bitreader_receiveints(&reader, bitsize, sizeint, thiscoord);
             }
 
             i++;
@@ -926,11 +976,11 @@ int xdr3dfcoord(XDR *xdrs, float *fp, int *size, float *precision)
             prevcoord[2] = thiscoord[2];
 
 
-            flag       = receivebits(buf, 1);
+            flag       = static_cast<int>(bitreader_read(&reader, 1));
             is_smaller = 0;
             if (flag == 1)
             {
-                run        = receivebits(buf, 5);
+                run        = static_cast<int>(bitreader_read(&reader, 5));
                 is_smaller = run % 3;
                 run       -= is_smaller;
                 is_smaller--;
@@ -940,7 +990,7 @@ int xdr3dfcoord(XDR *xdrs, float *fp, int *size, float *precision)
                 thiscoord += 3;
                 for (k = 0; k < run; k += 3)
                 {
-                    receiveints(buf, 3, smallidx, sizesmall, thiscoord);
+                    bitreader_receiveints(&reader, smallidx, sizesmall, thiscoord);
                     i++;
                     thiscoord[0] += prevcoord[0] - smallnum;
                     thiscoord[1] += prevcoord[1] - smallnum;
@@ -956,9 +1006,9 @@ int xdr3dfcoord(XDR *xdrs, float *fp, int *size, float *precision)
                         prevcoord[1] = tmp;
                         tmp          = thiscoord[2]; thiscoord[2] = prevcoord[2];
                         prevcoord[2] = tmp;
-                        *lfp++       = prevcoord[0] * inv_precision;
-                        *lfp++       = prevcoord[1] * inv_precision;
-                        *lfp++       = prevcoord[2] * inv_precision;
+                        thiscoord[-3] = prevcoord[0];
+                        thiscoord[-2] = prevcoord[1];
+                        thiscoord[-1] = prevcoord[2];
                     }
                     else
                     {
@@ -966,17 +1016,9 @@ int xdr3dfcoord(XDR *xdrs, float *fp, int *size, float *precision)
                         prevcoord[1] = thiscoord[1];
                         prevcoord[2] = thiscoord[2];
                     }
-                    *lfp++ = thiscoord[0] * inv_precision;
-                    *lfp++ = thiscoord[1] * inv_precision;
-                    *lfp++ = thiscoord[2] * inv_precision;
+                    thiscoord += 3;
                 }
             }
-            else
-            {
-                *lfp++ = thiscoord[0] * inv_precision;
-                *lfp++ = thiscoord[1] * inv_precision;
-                *lfp++ = thiscoord[2] * inv_precision;
-            }
             smallidx += is_smaller;
             if (is_smaller < 0)
             {
@@ -997,6 +1039,13 @@ int xdr3dfcoord(XDR *xdrs, float *fp, int *size, float *precision)
             }
             sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
         }
+
+        /* Convert to floating point in a separate, vectorizable loop */
+        inv_precision = 1.0 / *precision;
+        for (i = 0; i < static_cast<int>(size3); i++)
+        {
+            fp[i] = ip[i] * inv_precision;
+        }
     }
     if (we_should_free)
     {
@@ -0,0 +1,479 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements gmx::MappedTrrReader.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "mappedtrrreader.h"
+
+#include "config.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <utility>
+#include <vector>
+
+#if HAVE_SYS_MMAN_H
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "gromacs/math/vec.h"
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/stringutil.h"
+
+namespace gmx
+{
+
+namespace
+{
+
+//! Magic number at the start of each trr frame.
+const int c_trrMagic = 1993;
+
+//! Reads a big-endian (XDR) 32-bit word.
+inline uint32_t loadBigEndian32(const unsigned char *p)
+{
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16)
+           | (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+//! Reads a big-endian (XDR) 64-bit word.
+inline uint64_t loadBigEndian64(const unsigned char *p)
+{
+    return (static_cast<uint64_t>(loadBigEndian32(p)) << 32) | loadBigEndian32(p + 4);
+}
+
+//! Reads an XDR int.
+inline int loadInt(const unsigned char *p)
+{
+    return static_cast<int32_t>(loadBigEndian32(p));
+}
+
+//! Reads an XDR float or double.
+inline real loadReal(const unsigned char *p, bool bDouble)
+{
+    if (bDouble)
+    {
+        const uint64_t word = loadBigEndian64(p);
+        double         value;
+        std::memcpy(&value, &word, sizeof(value));
+        return value;
+    }
+    const uint32_t word = loadBigEndian32(p);
+    float          value;
+    std::memcpy(&value, &word, sizeof(value));
+    return value;
+}
+
+/*! \brief
+ * Converts \p count XDR floats or doubles at \p src into \p dest.
+ *
+ * The loops are simple enough for the compiler to vectorize the byte
+ * swapping.
+ */
+void convertReals(const unsigned char *src, int64_t count, bool bDouble, real *dest)
+{
+    if (bDouble)
+    {
+        for (int64_t i = 0; i < count; i++)
+        {
+            const uint64_t word = loadBigEndian64(src + i*sizeof(double));
+            double         value;
+            std::memcpy(&value, &word, sizeof(value));
+            dest[i] = value;
+        }
+    }
+    else
+    {
+        for (int64_t i = 0; i < count; i++)
+        {
+            const uint32_t word = loadBigEndian32(src + i*sizeof(float));
+            float          value;
+            std::memcpy(&value, &word, sizeof(value));
+            dest[i] = value;
+        }
+    }
+}
+
+}   // namespace
+
+/********************************************************************
+ * MappedTrrReader::Impl
+ */
+
+/*! \internal \brief
+ * Private implementation class for MappedTrrReader.
+ *
+ * \ingroup module_fileio
+ */
+class MappedTrrReader::Impl
+{
+    public:
+        explicit Impl(const std::string &filename);
+        ~Impl();
+
+        /*! \brief
+         * Makes sure that the first \p size bytes of the file are mapped.
+         *
+         * Returns false if the file is shorter.
+         */
+        bool ensureMapped(int64_t size);
+        //! Maps the current contents of the file.
+        void map();
+        //! Releases the mapping.
+        void unmap();
+
+        //! Returns whether the vectors at \p offset can be used in place.
+        bool canUseInPlace(int64_t offset) const;
+        //! Returns a view of \p offset, converting into \p buffer if needed.
+        ArrayRef<const RVec> view(int64_t offset, std::vector<RVec> *buffer, bool *bConverted);
+
+        //! Name of the mapped file.
+        std::string             filename_;
+        //! File descriptor of the mapped file.
+        int                     fd_;
+        //! Start of the mapping.
+        const unsigned char    *data_;
+        //! Size of the mapping.
+        int64_t                 mappedSize_;
+
+        //! Header of the current frame.
+        gmx_trr_header_t        header_;
+        //! Offsets of the box, x, v, and f in the current frame (-1 if none).
+        int64_t                 boxOffset_, xOffset_, vOffset_, fOffset_;
+        //! Offset of the end of the current frame.
+        int64_t                 frameEnd_;
+        //! Conversion buffers, reused for all frames.
+        std::vector<RVec>       xBuffer_, vBuffer_, fBuffer_;
+        //! Whether the buffers hold the data of the current frame.
+        bool                    bXConverted_, bVConverted_, bFConverted_;
+};
+
+MappedTrrReader::Impl::Impl(const std::string &filename)
+    : filename_(filename), fd_(-1), data_(nullptr), mappedSize_(0),
+      header_(), boxOffset_(-1), xOffset_(-1), vOffset_(-1), fOffset_(-1),
+      frameEnd_(0), bXConverted_(false), bVConverted_(false), bFConverted_(false)
+{
+#if HAVE_SYS_MMAN_H
+    fd_ = open(filename.c_str(), O_RDONLY);
+    if (fd_ < 0)
+    {
+        GMX_THROW(FileIOError(formatString("Could not open '%s' for reading: %s",
+                                           filename.c_str(), std::strerror(errno))));
+    }
+    map();
+#else
+    GMX_THROW(NotImplementedError("Memory-mapped file reading is not supported on this platform"));
+#endif
+}
+
+MappedTrrReader::Impl::~Impl()
+{
+#if HAVE_SYS_MMAN_H
+    unmap();
+    if (fd_ >= 0)
+    {
+        close(fd_);
+    }
+#endif
+}
+
+void MappedTrrReader::Impl::map()
+{
+#if HAVE_SYS_MMAN_H
+    struct stat fileStat;
+    if (fstat(fd_, &fileStat) != 0)
+    {
+        GMX_THROW(FileIOError(formatString("Could not determine the size of '%s'",
+                                           filename_.c_str())));
+    }
+    if (fileStat.st_size <= mappedSize_)
+    {
+        return;
+    }
+    unmap();
+    void *data = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (data == MAP_FAILED)
+    {
+        GMX_THROW(FileIOError(formatString("Could not map '%s' into memory: %s",
+                                           filename_.c_str(), std::strerror(errno))));
+    }
+    // Trajectories are usually read front to back.
+    madvise(data, fileStat.st_size, MADV_SEQUENTIAL);
+    data_       = static_cast<const unsigned char *>(data);
+    mappedSize_ = fileStat.st_size;
+#endif
+}
+
+void MappedTrrReader::Impl::unmap()
+{
+#if HAVE_SYS_MMAN_H
+    if (data_ != nullptr)
+    {
+        munmap(const_cast<unsigned char *>(data_), mappedSize_);
+        data_       = nullptr;
+        mappedSize_ = 0;
+    }
+#endif
+}
+
+bool MappedTrrReader::Impl::ensureMapped(int64_t size)
+{
+    if (size > mappedSize_)
+    {
+        map();
+    }
+    return size <= mappedSize_;
+}
+
+bool MappedTrrReader::Impl::canUseInPlace(int64_t offset) const
+{
+    const bool bRealIsDouble = (sizeof(real) == sizeof(double));
+    return GMX_INTEGER_BIG_ENDIAN && header_.bDouble == bRealIsDouble
+           && reinterpret_cast<uintptr_t>(data_ + offset) % alignof(RVec) == 0;
+}
+
+ArrayRef<const RVec>
+MappedTrrReader::Impl::view(int64_t offset, std::vector<RVec> *buffer, bool *bConverted)
+{
+    if (offset < 0)
+    {
+        return {};
+    }
+    const RVec *begin;
+    if (canUseInPlace(offset))
+    {
+        begin = reinterpret_cast<const RVec *>(data_ + offset);
+    }
+    else
+    {
+        if (!*bConverted)
+        {
+            buffer->resize(header_.natoms);
+            convertReals(data_ + offset, static_cast<int64_t>(header_.natoms)*DIM,
+                         header_.bDouble, as_rvec_array(buffer->data())[0]);
+            *bConverted = true;
+        }
+        begin = buffer->data();
+    }
+    return constArrayRefFromArray(begin, header_.natoms);
+}
+
+/********************************************************************
+ * MappedTrrReader
+ */
+
+bool MappedTrrReader::isSupported()
+{
+    return HAVE_SYS_MMAN_H;
+}
+
+MappedTrrReader::MappedTrrReader(const std::string &filename)
+    : impl_(new Impl(filename))
+{
+}
+
+MappedTrrReader::~MappedTrrReader()
+{
+}
+
+bool MappedTrrReader::readFrame(int64_t offset, bool *bOK)
+{
+    Impl             &impl   = *impl_;
+    gmx_trr_header_t &header = impl.header_;
+    int64_t           pos    = offset;
+
+    impl.bXConverted_ = impl.bVConverted_ = impl.bFConverted_ = false;
+    impl.boxOffset_   = impl.xOffset_ = impl.vOffset_ = impl.fOffset_ = -1;
+
+    *bOK = true;
+    if (!impl.ensureMapped(pos + sizeof(int32_t)))
+    {
+        // Like the XDR reader, treat a failure to read the magic number as
+        // the end of the file.
+        return false;
+    }
+    *bOK = false;
+    if (loadInt(impl.data_ + pos) != c_trrMagic)
+    {
+        return false;
+    }
+    pos += sizeof(int32_t);
+
+    // Version string, stored as its length (including the terminating
+    // null) followed by an XDR string padded to a multiple of four bytes.
+    if (!impl.ensureMapped(pos + 2*sizeof(int32_t)))
+    {
+        return false;
+    }
+    const int64_t stringLength = loadBigEndian32(impl.data_ + pos + sizeof(int32_t));
+    pos += 2*sizeof(int32_t) + ((stringLength + 3) & ~static_cast<int64_t>(3));
+
+    const int c_headerIntCount = 13;
+    if (!impl.ensureMapped(pos + c_headerIntCount*sizeof(int32_t)))
+    {
+        return false;
+    }
+    int *sizes[] = {
+        &header.ir_size, &header.e_size, &header.box_size, &header.vir_size,
+        &header.pres_size, &header.top_size, &header.sym_size,
+        &header.x_size, &header.v_size, &header.f_size, &header.natoms
+    };
+    for (int *size : sizes)
+    {
+        *size = loadInt(impl.data_ + pos);
+        pos  += sizeof(int32_t);
+    }
+
+    // Determine the precision from the size of a block, as in trrio.cpp.
+    int realSize = 0;
+    if (header.box_size)
+    {
+        realSize = header.box_size/(DIM*DIM);
+    }
+    else if (header.natoms > 0)
+    {
+        const int vectorSize = (header.x_size ? header.x_size
+                                : (header.v_size ? header.v_size : header.f_size));
+        realSize = vectorSize/(header.natoms*DIM);
+    }
+    if (realSize != sizeof(float) && realSize != sizeof(double))
+    {
+        return false;
+    }
+    header.bDouble = (realSize == sizeof(double));
+
+    header.step = loadInt(impl.data_ + pos);
+    pos        += sizeof(int32_t);
+    header.nre  = loadInt(impl.data_ + pos);
+    pos        += sizeof(int32_t);
+    if (!impl.ensureMapped(pos + 2*realSize))
+    {
+        return false;
+    }
+    header.t       = loadReal(impl.data_ + pos, header.bDouble);
+    header.lambda  = loadReal(impl.data_ + pos + realSize, header.bDouble);
+    pos           += 2*realSize;
+
+    const int64_t vectorBlockSize = static_cast<int64_t>(header.natoms)*DIM*realSize;
+    if ((header.box_size != 0 && header.box_size != DIM*DIM*realSize)
+        || (header.x_size != 0 && header.x_size != vectorBlockSize)
+        || (header.v_size != 0 && header.v_size != vectorBlockSize)
+        || (header.f_size != 0 && header.f_size != vectorBlockSize))
+    {
+        return false;
+    }
+    const int64_t boxOffset = (header.box_size != 0 ? pos : -1);
+    pos += header.box_size + header.vir_size + header.pres_size;
+    const int64_t xOffset   = (header.x_size != 0 ? pos : -1);
+    pos += header.x_size;
+    const int64_t vOffset   = (header.v_size != 0 ? pos : -1);
+    pos += header.v_size;
+    const int64_t fOffset   = (header.f_size != 0 ? pos : -1);
+    pos += header.f_size;
+    if (!impl.ensureMapped(pos))
+    {
+        return false;
+    }
+    impl.boxOffset_ = boxOffset;
+    impl.xOffset_   = xOffset;
+    impl.vOffset_   = vOffset;
+    impl.fOffset_   = fOffset;
+    impl.frameEnd_  = pos;
+    *bOK            = true;
+    return true;
+}
+
+const gmx_trr_header_t &MappedTrrReader::header() const
+{
+    return impl_->header_;
+}
+
+int64_t MappedTrrReader::frameEnd() const
+{
+    return impl_->frameEnd_;
+}
+
+void MappedTrrReader::getBox(matrix box) const
+{
+    clear_mat(box);
+    if (impl_->boxOffset_ >= 0)
+    {
+        convertReals(impl_->data_ + impl_->boxOffset_, DIM*DIM,
+                     impl_->header_.bDouble, box[0]);
+    }
+}
+
+ArrayRef<const RVec> MappedTrrReader::x()
+{
+    return impl_->view(impl_->xOffset_, &impl_->xBuffer_, &impl_->bXConverted_);
+}
+
+ArrayRef<const RVec> MappedTrrReader::v()
+{
+    return impl_->view(impl_->vOffset_, &impl_->vBuffer_, &impl_->bVConverted_);
+}
+
+ArrayRef<const RVec> MappedTrrReader::f()
+{
+    return impl_->view(impl_->fOffset_, &impl_->fBuffer_, &impl_->bFConverted_);
+}
+
+void MappedTrrReader::copyFrameData(matrix box, rvec *x, rvec *v, rvec *f) const
+{
+    const int64_t valueCount = static_cast<int64_t>(impl_->header_.natoms)*DIM;
+    getBox(box);
+    const std::pair<int64_t, rvec *> blocks[] = {
+        { impl_->xOffset_, x }, { impl_->vOffset_, v }, { impl_->fOffset_, f }
+    };
+    for (const auto &block : blocks)
+    {
+        if (block.first >= 0 && block.second != nullptr)
+        {
+            convertReals(impl_->data_ + block.first, valueCount,
+                         impl_->header_.bDouble, block.second[0]);
+        }
+    }
+}
+
+} // namespace gmx
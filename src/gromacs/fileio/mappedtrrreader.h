@@ -0,0 +1,130 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \libinternal \file
+ * \brief
+ * Declares gmx::MappedTrrReader for reading trr files through a memory map.
+ *
+ * \inlibraryapi
+ * \ingroup module_fileio
+ */
+#ifndef GMX_FILEIO_MAPPEDTRRREADER_H
+#define GMX_FILEIO_MAPPEDTRRREADER_H
+
+#include <cstdint>
+
+#include <string>
+
+#include "gromacs/fileio/trrio.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/classhelpers.h"
+#include "gromacs/utility/real.h"
+
+namespace gmx
+{
+
+/*! \libinternal \brief
+ * Reads trr frames from a memory-mapped file.
+ *
+ * Frame headers and data are decoded directly from the mapped file,
+ * without going through the XDR layer value by value.  Coordinates,
+ * velocities and forces are available as views; these point directly into
+ * the mapping when the file has the byte order and precision of the
+ * build, and otherwise into a buffer that is converted in a single pass and
+ * reused for all frames.
+ *
+ * If the file grows while it is read (e.g., during a simulation), the
+ * mapping is extended when a frame beyond its end is requested.
+ *
+ * \inlibraryapi
+ * \ingroup module_fileio
+ */
+class MappedTrrReader
+{
+    public:
+        //! Returns whether memory-mapped reading is supported on this platform.
+        static bool isSupported();
+
+        /*! \brief
+         * Maps \p filename for reading.
+         *
+         * \throws FileIOError if the file cannot be opened or mapped.
+         */
+        explicit MappedTrrReader(const std::string &filename);
+        ~MappedTrrReader();
+
+        /*! \brief
+         * Reads the frame starting at byte \p offset.
+         *
+         * \param[in]  offset  Offset of the frame in the file.
+         * \param[out] bOK     Set to false if the frame is incomplete or
+         *     corrupted.
+         * \returns    true if a complete frame was read.  At the end of the
+         *     file, returns false with \p bOK true.
+         *
+         * Views returned for a previous frame are invalidated.
+         */
+        bool readFrame(int64_t offset, bool *bOK);
+
+        //! Returns the header of the current frame.
+        const gmx_trr_header_t &header() const;
+        //! Returns the offset of the end of the current frame.
+        int64_t frameEnd() const;
+        //! Copies the box of the current frame into \p box (zero if none).
+        void getBox(matrix box) const;
+        //! Returns the coordinates of the current frame (empty if none).
+        ArrayRef<const RVec> x();
+        //! Returns the velocities of the current frame (empty if none).
+        ArrayRef<const RVec> v();
+        //! Returns the forces of the current frame (empty if none).
+        ArrayRef<const RVec> f();
+        /*! \brief
+         * Copies the data of the current frame into caller-owned arrays.
+         *
+         * Each array (except \p box) may be null, in which case the data is
+         * skipped.  Arrays must hold header().natoms elements.  The data
+         * is converted directly into the arrays without intermediate copies.
+         */
+        void copyFrameData(matrix box, rvec *x, rvec *v, rvec *f) const;
+
+    private:
+        class Impl;
+
+        PrivateImplPointer<Impl> impl_;
+};
+
+} // namespace gmx
+
+#endif
@@ -0,0 +1,312 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for gmx::MappedTrrReader.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "gromacs/fileio/mappedtrrreader.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/oenv.h"
+#include "gromacs/fileio/trrio.h"
+#include "gromacs/fileio/trxio.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/trajectory/trajectoryframe.h"
+#include "gromacs/utility/futil.h"
+
+#include "testutils/testasserts.h"
+#include "testutils/testfilemanager.h"
+
+namespace
+{
+
+using gmx::MappedTrrReader;
+
+class MappedTrrReaderTest : public ::testing::Test
+{
+    public:
+        MappedTrrReaderTest()
+            : filename_(fileManager_.getTemporaryFilePath(".trr"))
+        {
+        }
+
+        //! Returns the value written for \p component of \p atom in \p frame.
+        static real value(int frame, int atom, int component, int vector)
+        {
+            return 100*vector + frame + 0.001*atom - 0.25*component;
+        }
+
+        /*! \brief
+         * Writes frames [firstFrame, firstFrame + frameCount).
+         *
+         * Odd frames only have coordinates, even frames also velocities and
+         * forces.
+         */
+        void writeFrames(int firstFrame, int frameCount, const char *mode)
+        {
+            t_fileio *fio = gmx_trr_open(filename_.c_str(), mode);
+            for (int frame = firstFrame; frame < firstFrame + frameCount; ++frame)
+            {
+                std::vector<gmx::RVec> vectors[3];
+                for (int vector = 0; vector < 3; ++vector)
+                {
+                    vectors[vector].resize(c_atomCount);
+                    for (int i = 0; i < c_atomCount; ++i)
+                    {
+                        for (int d = 0; d < DIM; ++d)
+                        {
+                            vectors[vector][i][d] = value(frame, i, d, vector);
+                        }
+                    }
+                }
+                matrix box = {{1.0f + frame, 0, 0}, {0, 2, 0}, {0.5, 0, 3}};
+                const bool bAll = (frame % 2 == 0);
+                gmx_trr_write_frame(fio, 5*frame, 0.25*frame, 0.1*frame, box, c_atomCount,
+                                    as_rvec_array(vectors[0].data()),
+                                    bAll ? as_rvec_array(vectors[1].data()) : nullptr,
+                                    bAll ? as_rvec_array(vectors[2].data()) : nullptr);
+            }
+            gmx_trr_close(fio);
+        }
+
+        //! Checks that \p values hold \p vector of \p frame.
+        static void checkVectors(int frame, int vector, gmx::ArrayRef<const gmx::RVec> values)
+        {
+            ASSERT_EQ(c_atomCount, values.ssize());
+            for (int i = 0; i < c_atomCount; ++i)
+            {
+                for (int d = 0; d < DIM; ++d)
+                {
+                    ASSERT_EQ(value(frame, i, d, vector), values[i][d])
+                    << "frame " << frame << ", atom " << i;
+                }
+            }
+        }
+
+        //! Number of atoms in each frame.
+        static const int           c_atomCount = 37;
+        gmx::test::TestFileManager fileManager_;
+        std::string                filename_;
+};
+
+const int MappedTrrReaderTest::c_atomCount;
+
+TEST_F(MappedTrrReaderTest, ReadsFrames)
+{
+    if (!MappedTrrReader::isSupported())
+    {
+        return;
+    }
+    writeFrames(0, 3, "w");
+    MappedTrrReader reader(filename_);
+    int64_t         offset = 0;
+    bool            bOK;
+    for (int frame = 0; frame < 3; ++frame)
+    {
+        ASSERT_TRUE(reader.readFrame(offset, &bOK));
+        EXPECT_TRUE(bOK);
+        const gmx_trr_header_t &header = reader.header();
+        EXPECT_EQ(5*frame, header.step);
+        EXPECT_REAL_EQ_TOL(0.25*frame, header.t, gmx::test::defaultRealTolerance());
+        EXPECT_REAL_EQ_TOL(0.1*frame, header.lambda, gmx::test::defaultRealTolerance());
+        EXPECT_EQ(c_atomCount, header.natoms);
+        matrix box;
+        reader.getBox(box);
+        EXPECT_EQ(1.0f + frame, box[XX][XX]);
+        EXPECT_EQ(0.5f, box[ZZ][XX]);
+        checkVectors(frame, 0, reader.x());
+        if (frame % 2 == 0)
+        {
+            checkVectors(frame, 1, reader.v());
+            checkVectors(frame, 2, reader.f());
+        }
+        else
+        {
+            EXPECT_TRUE(reader.v().empty());
+            EXPECT_TRUE(reader.f().empty());
+        }
+        offset = reader.frameEnd();
+    }
+    EXPECT_FALSE(reader.readFrame(offset, &bOK));
+    EXPECT_TRUE(bOK);
+}
+
+TEST_F(MappedTrrReaderTest, MatchesXdrReader)
+{
+    if (!MappedTrrReader::isSupported())
+    {
+        return;
+    }
+    writeFrames(0, 2, "w");
+    MappedTrrReader reader(filename_);
+    t_fileio       *fio = gmx_trr_open(filename_.c_str(), "r");
+    bool            bOK;
+    int64_t         offset = 0;
+    for (int frame = 0; frame < 2; ++frame)
+    {
+        gmx_trr_header_t header;
+        gmx_bool         bXdrOK;
+        ASSERT_TRUE(gmx_trr_read_frame_header(fio, &header, &bXdrOK));
+        std::vector<gmx::RVec> x(header.natoms), v(header.natoms), f(header.natoms);
+        matrix                 box;
+        ASSERT_TRUE(gmx_trr_read_frame_data(fio, &header, box, as_rvec_array(x.data()),
+                                            as_rvec_array(v.data()), as_rvec_array(f.data())));
+
+        ASSERT_TRUE(reader.readFrame(offset, &bOK));
+        EXPECT_EQ(gmx_fio_ftell(fio), reader.frameEnd());
+        std::vector<gmx::RVec> mappedX(header.natoms), mappedV(header.natoms), mappedF(header.natoms);
+        matrix                 mappedBox;
+        reader.copyFrameData(mappedBox, as_rvec_array(mappedX.data()),
+                             as_rvec_array(mappedV.data()), as_rvec_array(mappedF.data()));
+        EXPECT_EQ(header.x_size, reader.header().x_size);
+        EXPECT_EQ(header.v_size, reader.header().v_size);
+        EXPECT_EQ(header.t, reader.header().t);
+        for (int d = 0; d < DIM; ++d)
+        {
+            EXPECT_EQ(box[d][XX], mappedBox[d][XX]);
+        }
+        for (int i = 0; i < header.natoms; ++i)
+        {
+            EXPECT_EQ(x[i][YY], mappedX[i][YY]);
+            if (header.v_size > 0)
+            {
+                EXPECT_EQ(v[i][ZZ], mappedV[i][ZZ]);
+                EXPECT_EQ(f[i][XX], mappedF[i][XX]);
+            }
+        }
+        offset = reader.frameEnd();
+    }
+    gmx_trr_close(fio);
+}
+
+TEST_F(MappedTrrReaderTest, HandlesIncompleteAndAppendedFrames)
+{
+    if (!MappedTrrReader::isSupported())
+    {
+        return;
+    }
+    writeFrames(0, 2, "w");
+    int64_t firstFrameEnd;
+    {
+        MappedTrrReader reader(filename_);
+        bool            bOK;
+        ASSERT_TRUE(reader.readFrame(0, &bOK));
+        firstFrameEnd = reader.frameEnd();
+    }
+    ASSERT_EQ(0, gmx_truncate(filename_, firstFrameEnd + 100));
+
+    MappedTrrReader reader(filename_);
+    bool            bOK;
+    ASSERT_TRUE(reader.readFrame(0, &bOK));
+    EXPECT_FALSE(reader.readFrame(firstFrameEnd, &bOK));
+    EXPECT_FALSE(bOK);
+
+    // Replace the incomplete frame while the file is mapped.
+    ASSERT_EQ(0, gmx_truncate(filename_, firstFrameEnd));
+    writeFrames(1, 2, "a");
+    ASSERT_TRUE(reader.readFrame(firstFrameEnd, &bOK));
+    EXPECT_TRUE(bOK);
+    EXPECT_EQ(5, reader.header().step);
+    checkVectors(1, 0, reader.x());
+    ASSERT_TRUE(reader.readFrame(reader.frameEnd(), &bOK));
+    checkVectors(2, 2, reader.f());
+}
+
+TEST_F(MappedTrrReaderTest, TrxioProvidesViewsWithoutCopying)
+{
+    if (!MappedTrrReader::isSupported())
+    {
+        return;
+    }
+    writeFrames(0, 3, "w");
+    gmx_output_env_t *oenv;
+    output_env_init_default(&oenv);
+    t_trxstatus      *status;
+    t_trxframe        fr;
+    const int         flags = TRX_READ_X | TRX_READ_V | TRX_READ_F;
+    ASSERT_TRUE(read_first_frame(oenv, &status, filename_.c_str(), &fr, flags | TRX_MAPPED_VIEWS));
+    t_trxstatus      *copyStatus;
+    t_trxframe        copyFr;
+    ASSERT_TRUE(read_first_frame(oenv, &copyStatus, filename_.c_str(), &copyFr, flags));
+    for (int frame = 0; frame < 3; ++frame)
+    {
+        EXPECT_EQ(5*frame, fr.step);
+        EXPECT_EQ(copyFr.bX, fr.bX);
+        EXPECT_EQ(copyFr.bV, fr.bV);
+        EXPECT_EQ(copyFr.bF, fr.bF);
+        EXPECT_EQ(copyFr.box[XX][XX], fr.box[XX][XX]);
+        EXPECT_EQ(nullptr, fr.x);
+        EXPECT_EQ(nullptr, fr.v);
+        EXPECT_EQ(nullptr, fr.f);
+
+        gmx::ArrayRef<const gmx::RVec> x, v, f;
+        ASSERT_TRUE(trx_get_mapped_frame_views(status, &x, &v, &f));
+        checkVectors(frame, 0, x);
+        checkVectors(frame, 0, gmx::constArrayRefFromArray(reinterpret_cast<const gmx::RVec *>(copyFr.x),
+                                                           copyFr.natoms));
+        if (frame % 2 == 0)
+        {
+            checkVectors(frame, 1, v);
+            checkVectors(frame, 2, f);
+        }
+        else
+        {
+            EXPECT_TRUE(v.empty());
+            EXPECT_TRUE(f.empty());
+        }
+        const bool bNext = (frame + 1 < 3);
+        ASSERT_EQ(bNext, read_next_frame(oenv, copyStatus, &copyFr));
+        ASSERT_EQ(bNext, read_next_frame(oenv, status, &fr));
+    }
+    gmx::ArrayRef<const gmx::RVec> x, v, f;
+    EXPECT_FALSE(trx_get_mapped_frame_views(status, &x, &v, &f));
+    close_trx(copyStatus);
+    close_trx(status);
+    done_frame(&copyFr);
+    done_frame(&fr);
+    output_env_done(oenv);
+}
+
+} // namespace
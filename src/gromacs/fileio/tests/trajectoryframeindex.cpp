@@ -0,0 +1,278 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for gmx::TrajectoryFrameIndex.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "gromacs/fileio/trajectoryframeindex.h"
+
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/filetypes.h"
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/oenv.h"
+#include "gromacs/fileio/trrio.h"
+#include "gromacs/fileio/trxio.h"
+#include "gromacs/fileio/xtcio.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/trajectory/trajectoryframe.h"
+#include "gromacs/utility/futil.h"
+
+#include "testutils/testfilemanager.h"
+
+namespace
+{
+
+using gmx::TrajectoryFrameIndex;
+
+//! Parameters for generating a test trajectory.
+struct FrameIndexTestParameters
+{
+    //! File extension, selecting the format.
+    const char *extension;
+    //! Number of atoms in each frame.
+    int         atomCount;
+};
+
+//! Formatter for Google Test.
+void PrintTo(const FrameIndexTestParameters &params, std::ostream *os)
+{
+    *os << params.extension << ", " << params.atomCount << " atoms";
+}
+
+class TrajectoryFrameIndexTest : public ::testing::TestWithParam<FrameIndexTestParameters>
+{
+    public:
+        TrajectoryFrameIndexTest()
+            : filename_(fileManager_.getTemporaryFilePath(GetParam().extension))
+        {
+        }
+        ~TrajectoryFrameIndexTest() override
+        {
+            std::remove(TrajectoryFrameIndex::sidecarFileName(filename_).c_str());
+        }
+
+        //! Writes frames [firstFrame, firstFrame + frameCount) to the trajectory.
+        void writeFrames(int firstFrame, int frameCount, const char *mode)
+        {
+            const int             natoms = GetParam().atomCount;
+            std::vector<gmx::RVec> x(natoms);
+            const bool            bXtc   = (fn2ftp(filename_.c_str()) == efXTC);
+            t_fileio             *fio    = bXtc ? open_xtc(filename_.c_str(), mode)
+                : gmx_trr_open(filename_.c_str(), mode);
+            for (int frame = firstFrame; frame < firstFrame + frameCount; ++frame)
+            {
+                matrix box;
+                frameBox(frame, box);
+                for (int i = 0; i < natoms; ++i)
+                {
+                    x[i] = { 0.01f*i, 0.02f*frame, 0.5f };
+                }
+                if (bXtc)
+                {
+                    ASSERT_TRUE(write_xtc(fio, natoms, 10*frame, 0.5*frame, box,
+                                          as_rvec_array(x.data()), 1000));
+                }
+                else
+                {
+                    gmx_trr_write_frame(fio, 10*frame, 0.5*frame, 0, box, natoms,
+                                        as_rvec_array(x.data()), nullptr, nullptr);
+                }
+            }
+            gmx_fio_close(fio);
+        }
+        //! Returns the box written for \p frame.
+        static void frameBox(int frame, matrix box)
+        {
+            clear_mat(box);
+            box[XX][XX] = 3 + 0.25*frame;
+            box[YY][YY] = 4;
+            box[ZZ][ZZ] = 5;
+        }
+        //! Checks that \p index contains frames [0, frameCount).
+        void checkIndex(const TrajectoryFrameIndex &index, int frameCount)
+        {
+            ASSERT_EQ(frameCount, index.frameCount());
+            for (int frame = 0; frame < frameCount; ++frame)
+            {
+                const gmx::TrajectoryFrameIndexEntry &entry = index.frame(frame);
+                EXPECT_EQ(10*frame, entry.step);
+                EXPECT_EQ(0.5*frame, entry.time);
+                EXPECT_EQ(GetParam().atomCount, entry.natoms);
+                matrix box;
+                frameBox(frame, box);
+                EXPECT_FLOAT_EQ(box[XX][XX], entry.box[XX][XX]);
+                EXPECT_FLOAT_EQ(box[ZZ][ZZ], entry.box[ZZ][ZZ]);
+                if (frame > 0)
+                {
+                    EXPECT_LT(index.frame(frame - 1).offset, entry.offset);
+                }
+            }
+        }
+
+        gmx::test::TestFileManager fileManager_;
+        std::string                filename_;
+};
+
+TEST_P(TrajectoryFrameIndexTest, IndexesAllFrames)
+{
+    writeFrames(0, 8, "w");
+    TrajectoryFrameIndex index(filename_);
+    index.update();
+    checkIndex(index, 8);
+    EXPECT_EQ(0, index.frame(0).offset);
+    EXPECT_FALSE(index.isOutOfDate());
+}
+
+TEST_P(TrajectoryFrameIndexTest, SkipsIncompleteLastFrame)
+{
+    writeFrames(0, 4, "w");
+    TrajectoryFrameIndex fullIndex(filename_);
+    fullIndex.update();
+    ASSERT_EQ(4, fullIndex.frameCount());
+    ASSERT_EQ(0, gmx_truncate(filename_, fullIndex.frame(3).offset + 40));
+
+    TrajectoryFrameIndex index(filename_);
+    index.update();
+    checkIndex(index, 3);
+    EXPECT_TRUE(index.isOutOfDate());
+}
+
+TEST_P(TrajectoryFrameIndexTest, ReadsSidecarAndExtendsIt)
+{
+    writeFrames(0, 5, "w");
+    {
+        TrajectoryFrameIndex index(filename_);
+        EXPECT_FALSE(index.readSidecar());
+        index.update();
+        index.writeSidecar();
+    }
+    {
+        TrajectoryFrameIndex index(filename_);
+        ASSERT_TRUE(index.readSidecar());
+        checkIndex(index, 5);
+        EXPECT_FALSE(index.isOutOfDate());
+    }
+    writeFrames(5, 3, "a");
+    TrajectoryFrameIndex index(filename_);
+    ASSERT_TRUE(index.readSidecar());
+    EXPECT_EQ(5, index.frameCount());
+    EXPECT_TRUE(index.isOutOfDate());
+    index.update();
+    checkIndex(index, 8);
+}
+
+TEST_P(TrajectoryFrameIndexTest, RejectsSidecarOfDifferentTrajectory)
+{
+    writeFrames(0, 5, "w");
+    {
+        TrajectoryFrameIndex index(filename_);
+        index.update();
+        index.writeSidecar();
+    }
+    writeFrames(1, 5, "w");
+    TrajectoryFrameIndex index(filename_);
+    EXPECT_FALSE(index.readSidecar());
+    EXPECT_EQ(0, index.frameCount());
+}
+
+TEST_P(TrajectoryFrameIndexTest, FindsFramesByTime)
+{
+    writeFrames(0, 8, "w");
+    TrajectoryFrameIndex index(filename_);
+    index.update();
+    EXPECT_EQ(0, index.findFirstFrameAtTime(-1.0));
+    EXPECT_EQ(3, index.findFirstFrameAtTime(1.5));
+    EXPECT_EQ(4, index.findFirstFrameAtTime(1.6));
+    EXPECT_EQ(8, index.findFirstFrameAtTime(10.0));
+
+    const auto ranges = index.splitIntoRanges(3);
+    ASSERT_EQ(3U, ranges.size());
+    EXPECT_EQ(0, ranges[0].first);
+    EXPECT_EQ(ranges[0].second, ranges[1].first);
+    EXPECT_EQ(ranges[1].second, ranges[2].first);
+    EXPECT_EQ(8, ranges[2].second);
+    EXPECT_EQ(8U, index.splitIntoRanges(10).size());
+}
+
+TEST_P(TrajectoryFrameIndexTest, SeeksToFrameWhenReading)
+{
+    writeFrames(0, 8, "w");
+    {
+        TrajectoryFrameIndex index(filename_);
+        index.update();
+        index.writeSidecar();
+    }
+
+    gmx_output_env_t *oenv;
+    output_env_init_default(&oenv);
+    t_trxstatus      *status;
+    t_trxframe        fr;
+    ASSERT_TRUE(read_first_frame(oenv, &status, filename_.c_str(), &fr, TRX_NEED_X));
+    EXPECT_EQ(0, fr.step);
+    ASSERT_TRUE(trx_seek_frame(status, 6));
+    ASSERT_TRUE(read_next_frame(oenv, status, &fr));
+    EXPECT_EQ(60, fr.step);
+    EXPECT_FLOAT_EQ(0.12, fr.x[0][YY]);
+    ASSERT_TRUE(trx_seek_frame(status, 2));
+    ASSERT_TRUE(read_next_frame(oenv, status, &fr));
+    EXPECT_EQ(20, fr.step);
+    EXPECT_FALSE(trx_seek_frame(status, 8));
+    close_trx(status);
+    done_frame(&fr);
+    output_env_done(oenv);
+}
+
+//! Test cases; xtc files with at most nine atoms are not compressed.
+const FrameIndexTestParameters c_frameIndexTestCases[] = {
+    { ".xtc", 50 },
+    { ".xtc", 5 },
+    { ".trr", 50 }
+};
+
+INSTANTIATE_TEST_CASE_P(Formats, TrajectoryFrameIndexTest,
+                        ::testing::ValuesIn(c_frameIndexTestCases));
+
+} // namespace
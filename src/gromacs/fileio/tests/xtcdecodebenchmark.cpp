@@ -0,0 +1,177 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Microbenchmark for reading compressed xtc coordinates.
+ *
+ * Usage: xtc-decode-benchmark [-xtc file.xtc] [-repeats n]
+ *
+ * Reads all frames of the given trajectory \p repeats times (default 10)
+ * and reports the decoding throughput in frames/s and in MB/s of
+ * compressed data.  Without a file, a synthetic trajectory of water-like
+ * clusters is generated and used.  The file is read through the page
+ * cache, so the numbers mostly reflect the cost of decompression.
+ * Not run by CTest.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include <cstdio>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/xtcio.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/options/basicoptions.h"
+#include "gromacs/options/ioptionscontainer.h"
+#include "gromacs/random/threefry.h"
+#include "gromacs/random/uniformrealdistribution.h"
+#include "gromacs/utility/futil.h"
+#include "gromacs/utility/smalloc.h"
+
+#include "testutils/testfilemanager.h"
+#include "testutils/testoptions.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! The trajectory to read, a synthetic one is generated when empty
+std::string g_xtcFileName;
+//! The number of passes over the trajectory
+int         g_repeats = 10;
+
+/*! \cond */
+GMX_TEST_OPTIONS(XtcDecodeBenchmarkOptions, options)
+{
+    options->addOption(StringOption("xtc")
+                           .store(&g_xtcFileName)
+                           .description("Trajectory to read, a synthetic one is used when not set"));
+    options->addOption(IntegerOption("repeats")
+                           .store(&g_repeats)
+                           .description("Number of passes over the trajectory"));
+}
+/*! \endcond */
+
+//! Writes a trajectory of water-like three-atom clusters to \p filename.
+void writeSyntheticTrajectory(const char *filename, int atomCount, int frameCount)
+{
+    const real                    boxSize = 10.0;
+    matrix                        box     = {{boxSize, 0, 0}, {0, boxSize, 0}, {0, 0, boxSize}};
+    DefaultRandomEngine           rng(1995);
+    UniformRealDistribution<real> position(0, boxSize);
+    UniformRealDistribution<real> offset(-0.1, 0.1);
+    std::vector<RVec>             x(atomCount);
+
+    t_fileio *fio = open_xtc(filename, "w");
+    for (int frame = 0; frame < frameCount; ++frame)
+    {
+        RVec center = { 0, 0, 0 };
+        for (int i = 0; i < atomCount; ++i)
+        {
+            if (i % 3 == 0)
+            {
+                center = { position(rng), position(rng), position(rng) };
+            }
+            for (int d = 0; d < DIM; ++d)
+            {
+                x[i][d] = center[d] + offset(rng);
+            }
+        }
+        write_xtc(fio, atomCount, frame, frame, box, as_rvec_array(x.data()), 1000);
+    }
+    close_xtc(fio);
+}
+
+TEST(XtcDecodeBenchmark, ReportsThroughput)
+{
+    TestFileManager fileManager;
+    std::string     filename = g_xtcFileName;
+    if (filename.empty())
+    {
+        filename = fileManager.getTemporaryFilePath("synthetic.xtc");
+        writeSyntheticTrajectory(filename.c_str(), 30000, 50);
+    }
+
+    FILE           *fp = gmx_ffopen(filename, "rb");
+    gmx_fseek(fp, 0, SEEK_END);
+    const gmx_off_t fileSize = gmx_ftell(fp);
+    gmx_ffclose(fp);
+
+    int        frameCount = 0;
+    const auto start      = std::chrono::steady_clock::now();
+    for (int r = 0; r < g_repeats; ++r)
+    {
+        t_fileio *fio    = open_xtc(filename.c_str(), "r");
+        int       natoms = 0;
+        int64_t   step;
+        real      time, prec;
+        matrix    box;
+        rvec     *x = nullptr;
+        gmx_bool  bOK;
+        if (read_first_xtc(fio, &natoms, &step, &time, box, &x, &prec, &bOK))
+        {
+            do
+            {
+                ++frameCount;
+            }
+            while (read_next_xtc(fio, natoms, &step, &time, box, x, &prec, &bOK));
+        }
+        EXPECT_TRUE(bOK) << "Reading " << filename << " failed";
+        sfree(x);
+        close_xtc(fio);
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const double seconds = elapsed.count();
+    std::printf("Read %d frames (%d passes over %s) in %.3f s\n",
+                frameCount, g_repeats, filename.c_str(), seconds);
+    std::printf("%.1f frames/s, %.1f MB/s of compressed data\n",
+                frameCount/seconds, g_repeats*static_cast<double>(fileSize)/(seconds*1e6));
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -0,0 +1,211 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the compressed coordinate format of xtc files.
+ *
+ * The decoder is checked to reproduce the integer-quantized input
+ * coordinates bit-for-bit, using synthetic frames that exercise the
+ * different code paths of the compression: runs of small differences
+ * (water-like clusters), isolated atoms, large coordinate ranges that do
+ * not fit the combined integer packing, and high precision.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "gromacs/fileio/xtcio.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/random/threefry.h"
+#include "gromacs/random/uniformrealdistribution.h"
+#include "gromacs/utility/smalloc.h"
+
+#include "testutils/testfilemanager.h"
+
+namespace
+{
+
+//! Parameters for generating a synthetic trajectory.
+struct XtcTestParameters
+{
+    //! Number of atoms in each frame.
+    int         atomCount;
+    //! Coordinates are generated within [-boxSize/2, boxSize/2).
+    float       boxSize;
+    //! Maximum distance of an atom from the center of its three-atom group.
+    float       clusterSize;
+    //! Precision to write the coordinates with.
+    float       precision;
+};
+
+//! Formatter for Google Test.
+void PrintTo(const XtcTestParameters &params, std::ostream *os)
+{
+    *os << params.atomCount << " atoms, box " << params.boxSize
+    << ", cluster " << params.clusterSize
+    << ", precision " << params.precision;
+}
+
+/*! \brief
+ * Returns the value the decoder should produce for \p x.
+ *
+ * Mirrors the rounding done in the encoder, and the conversion back to
+ * floating point in the decoder.
+ */
+float quantize(float x, float precision)
+{
+    float lf;
+    if (x >= 0.0)
+    {
+        lf = x * precision + 0.5;
+    }
+    else
+    {
+        lf = x * precision - 0.5;
+    }
+    const int   lint         = static_cast<int>(lf);
+    const float invPrecision = 1.0 / precision;
+    return lint * invPrecision;
+}
+
+class XtcCompressionTest : public ::testing::TestWithParam<XtcTestParameters>
+{
+    public:
+        //! Fills \p x with coordinates for \p frame.
+        void generateFrame(int frame, std::vector<gmx::RVec> *x)
+        {
+            const XtcTestParameters          &params = GetParam();
+            gmx::DefaultRandomEngine          rng(frame);
+            gmx::UniformRealDistribution<real>
+                                              position(-0.5*params.boxSize, 0.5*params.boxSize);
+            gmx::UniformRealDistribution<real>
+                                              offset(-params.clusterSize, params.clusterSize);
+            x->resize(params.atomCount);
+            gmx::RVec center = { 0, 0, 0 };
+            for (int i = 0; i < params.atomCount; ++i)
+            {
+                // Every seventh group is made of isolated atoms, to break
+                // the runs and exercise the adaptive small-integer size.
+                const bool bIsolated = (i / 3) % 7 == 6;
+                if (i % 3 == 0 || bIsolated)
+                {
+                    center = { position(rng), position(rng), position(rng) };
+                }
+                for (int d = 0; d < DIM; ++d)
+                {
+                    (*x)[i][d] = center[d] + (bIsolated ? 0 : offset(rng));
+                }
+            }
+        }
+
+        gmx::test::TestFileManager fileManager_;
+};
+
+TEST_P(XtcCompressionTest, DecodesBitIdentically)
+{
+    const XtcTestParameters &params     = GetParam();
+    const int                frameCount = 3;
+    const std::string        filename   = fileManager_.getTemporaryFilePath(".xtc");
+    matrix                   box        = {{params.boxSize, 0, 0}, {0, params.boxSize, 0}, {0, 0, params.boxSize}};
+
+    std::vector<std::vector<gmx::RVec> > frames(frameCount);
+    t_fileio *fio = open_xtc(filename.c_str(), "w");
+    for (int frame = 0; frame < frameCount; ++frame)
+    {
+        generateFrame(frame, &frames[frame]);
+        ASSERT_TRUE(write_xtc(fio, params.atomCount, frame, frame, box,
+                              as_rvec_array(frames[frame].data()), params.precision));
+    }
+    close_xtc(fio);
+
+    fio = open_xtc(filename.c_str(), "r");
+    int      natoms = 0;
+    int64_t  step;
+    real     time, prec;
+    rvec    *x = nullptr;
+    gmx_bool bOK;
+    ASSERT_TRUE(read_first_xtc(fio, &natoms, &step, &time, box, &x, &prec, &bOK));
+    ASSERT_EQ(params.atomCount, natoms);
+    for (int frame = 0; frame < frameCount; ++frame)
+    {
+        if (frame > 0)
+        {
+            ASSERT_TRUE(read_next_xtc(fio, natoms, &step, &time, box, x, &prec, &bOK));
+        }
+        ASSERT_TRUE(bOK);
+        EXPECT_EQ(frame, step);
+        for (int i = 0; i < natoms; ++i)
+        {
+            for (int d = 0; d < DIM; ++d)
+            {
+                const float expected = quantize(frames[frame][i][d], params.precision);
+                ASSERT_EQ(expected, static_cast<float>(x[i][d]))
+                << "frame " << frame << ", atom " << i << ", dimension " << d;
+            }
+        }
+    }
+    EXPECT_FALSE(read_next_xtc(fio, natoms, &step, &time, box, x, &prec, &bOK));
+    sfree(x);
+    close_xtc(fio);
+}
+
+//! Test cases covering the different paths of the decoder.
+const XtcTestParameters c_xtcTestCases[] = {
+    // Water-like clusters: long runs of small differences.
+    { 999, 5.0, 0.1, 1000 },
+    // Isolated atoms only: few runs.
+    { 501, 5.0, 5.0, 1000 },
+    // Total bit size of the three packed integers exceeds 64 bits.
+    { 300, 10000.0, 0.1, 1000 },
+    // Range too large for packing the three integers together.
+    { 300, 40000.0, 0.1, 1000 },
+    // High precision.
+    { 300, 3.0, 0.1, 100000 },
+    // Few enough atoms to fit into the preallocated buffers.
+    { 15, 2.0, 0.1, 1000 },
+};
+
+INSTANTIATE_TEST_CASE_P(CoversDecoderPaths, XtcCompressionTest,
+                        ::testing::ValuesIn(c_xtcTestCases));
+
+} // namespace
@@ -123,6 +123,7 @@ enum tpxv {
     tpxv_PullPrevStepCOMAsReference,                         /**< Enabled using the COM of the pull group of the last frame as reference for PBC */
     tpxv_MimicQMMM,                                          /**< Inroduced support for MiMiC QM/MM interface */
     tpxv_PullAverage,                                        /**< Added possibility to output average pull force and position */
+    tpxv_MultipleTimeStepping,                               /**< Added multiple time stepping of long-range and pull forces */
     tpxv_Count                                               /**< the total number of tpxv versions */
 };
 
@@ -1065,6 +1066,19 @@ static void do_inputrec(t_fileio *fio, t_inputrec *ir, gmx_bool bRead,
 
     gmx_fio_do_int(fio, ir->simulation_part);
 
+    if (file_version >= tpxv_MultipleTimeStepping)
+    {
+        gmx_fio_do_gmx_bool(fio, ir->useMts);
+        gmx_fio_do_int(fio, ir->mtsLevel2Forces);
+        gmx_fio_do_int(fio, ir->mtsFactor);
+    }
+    else
+    {
+        ir->useMts          = FALSE;
+        ir->mtsLevel2Forces = 0;
+        ir->mtsFactor       = 1;
+    }
+
     if (file_version >= 67)
     {
         gmx_fio_do_int(fio, ir->nstcalcenergy);
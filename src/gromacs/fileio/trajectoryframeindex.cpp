@@ -0,0 +1,435 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements gmx::TrajectoryFrameIndex.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "trajectoryframeindex.h"
+
+#include <cstdio>
+
+#include <algorithm>
+
+#include "gromacs/fileio/filetypes.h"
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/gmxfio_xdr.h"
+#include "gromacs/fileio/trrio.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/inmemoryserializer.h"
+#include "gromacs/utility/stringutil.h"
+
+namespace gmx
+{
+
+namespace
+{
+
+//! Magic string identifying a frame index file.
+const char     c_sidecarMagic[]    = "GMX_TRAJECTORY_FRAME_INDEX";
+//! Version of the frame index file format.
+const int      c_sidecarVersion    = 1;
+//! Magic number at the start of each xtc frame.
+const int      c_xtcMagic          = 1995;
+//! Number of bytes in the compressed xtc coordinate header after the precision.
+const int64_t  c_xtcCoordHeaderSize = 7*sizeof(int32_t);
+
+//! Returns the size of \p filename in bytes.
+int64_t fileSize(const std::string &filename)
+{
+    FILE *fp = gmx_ffopen(filename, "rb");
+    gmx_fseek(fp, 0, SEEK_END);
+    int64_t size = gmx_ftell(fp);
+    gmx_ffclose(fp);
+    return size;
+}
+
+/*! \brief
+ * Reads the xtc frame header at the current position of \p fio.
+ *
+ * \returns The offset of the end of the frame, or -1 if the frame could not
+ *     be read.
+ */
+int64_t readXtcFrameHeader(t_fileio *fio, TrajectoryFrameIndexEntry *entry)
+{
+    XDR *xd     = gmx_fio_getxdr(fio);
+    int  magic  = 0;
+    int  intStep;
+    float time;
+    if (!xdr_int(xd, &magic) || magic != c_xtcMagic
+        || !xdr_int(xd, &entry->natoms) || !xdr_int(xd, &intStep)
+        || !xdr_float(xd, &time))
+    {
+        return -1;
+    }
+    entry->step = intStep;
+    entry->time = time;
+    for (int i = 0; i < DIM; i++)
+    {
+        for (int j = 0; j < DIM; j++)
+        {
+            float value;
+            if (!xdr_float(xd, &value))
+            {
+                return -1;
+            }
+            entry->box[i][j] = value;
+        }
+    }
+    int lsize;
+    if (!xdr_int(xd, &lsize) || lsize != entry->natoms)
+    {
+        return -1;
+    }
+    int64_t coordinateSize;
+    if (lsize <= 9)
+    {
+        coordinateSize = static_cast<int64_t>(lsize)*DIM*sizeof(float);
+    }
+    else
+    {
+        // Skip the precision and the compression parameters to reach the
+        // byte count of the compressed data.
+        if (gmx_fio_seek(fio, gmx_fio_ftell(fio) + sizeof(float) + c_xtcCoordHeaderSize) != 0)
+        {
+            return -1;
+        }
+        int byteCount;
+        if (!xdr_int(xd, &byteCount) || byteCount < 0)
+        {
+            return -1;
+        }
+        // XDR opaque data is padded to a multiple of four bytes.
+        coordinateSize = (static_cast<int64_t>(byteCount) + 3) & ~static_cast<int64_t>(3);
+    }
+    return gmx_fio_ftell(fio) + coordinateSize;
+}
+
+/*! \brief
+ * Reads the trr frame header at the current position of \p fio.
+ *
+ * \returns The offset of the end of the frame, or -1 if the frame could not
+ *     be read.
+ */
+int64_t readTrrFrameHeader(t_fileio *fio, TrajectoryFrameIndexEntry *entry)
+{
+    gmx_trr_header_t header;
+    gmx_bool         bOK;
+    if (!gmx_trr_read_frame_header(fio, &header, &bOK) || !bOK)
+    {
+        return -1;
+    }
+    entry->natoms = header.natoms;
+    entry->step   = header.step;
+    entry->time   = header.t;
+    clear_mat(entry->box);
+    int64_t dataSize = 0;
+    if (header.box_size != 0)
+    {
+        if (!gmx_fio_ndo_rvec(fio, entry->box, DIM))
+        {
+            return -1;
+        }
+    }
+    dataSize += header.vir_size + header.pres_size;
+    dataSize += static_cast<int64_t>(header.x_size) + header.v_size + header.f_size;
+    return gmx_fio_ftell(fio) + dataSize;
+}
+
+//! Reads the header of the frame at \p offset, returning the end of the frame.
+int64_t readFrameHeader(t_fileio *fio, int ftp, int64_t offset,
+                        TrajectoryFrameIndexEntry *entry)
+{
+    if (gmx_fio_seek(fio, offset) != 0)
+    {
+        return -1;
+    }
+    entry->offset = offset;
+    return (ftp == efXTC)
+           ? readXtcFrameHeader(fio, entry)
+           : readTrrFrameHeader(fio, entry);
+}
+
+//! Serializes the contents of \p entry.
+void serializeEntry(ISerializer *serializer, TrajectoryFrameIndexEntry *entry)
+{
+    serializer->doInt64(&entry->offset);
+    serializer->doInt64(&entry->step);
+    serializer->doDouble(&entry->time);
+    serializer->doInt(&entry->natoms);
+    for (int i = 0; i < DIM; i++)
+    {
+        for (int j = 0; j < DIM; j++)
+        {
+            double value = entry->box[i][j];
+            serializer->doDouble(&value);
+            entry->box[i][j] = value;
+        }
+    }
+}
+
+//! Returns the number of bytes used to serialize a single entry.
+size_t serializedEntrySize()
+{
+    InMemorySerializer        serializer;
+    TrajectoryFrameIndexEntry entry = {};
+    serializeEntry(&serializer, &entry);
+    return serializer.finishAndGetBuffer().size();
+}
+
+}   // namespace
+
+bool TrajectoryFrameIndex::isSupportedFormat(const std::string &trajectoryFile)
+{
+    const int ftp = fn2ftp(trajectoryFile.c_str());
+    return ftp == efXTC || ftp == efTRR;
+}
+
+std::string TrajectoryFrameIndex::sidecarFileName(const std::string &trajectoryFile)
+{
+    return trajectoryFile + ".gmxidx";
+}
+
+TrajectoryFrameIndex::TrajectoryFrameIndex(const std::string &trajectoryFile)
+    : trajectoryFile_(trajectoryFile), indexedSize_(0), bTimeOrdered_(true)
+{
+    if (!isSupportedFormat(trajectoryFile))
+    {
+        GMX_THROW(InvalidInputError(formatString(
+                                            "Frame index can only be built for xtc and trr files, not '%s'",
+                                            trajectoryFile.c_str())));
+    }
+}
+
+void TrajectoryFrameIndex::update()
+{
+    const int64_t size = fileSize(trajectoryFile_);
+    if (size <= indexedSize_)
+    {
+        return;
+    }
+    const int     ftp = fn2ftp(trajectoryFile_.c_str());
+    t_fileio     *fio = gmx_fio_open(trajectoryFile_.c_str(), "r");
+    int64_t       offset = indexedSize_;
+    while (offset < size)
+    {
+        TrajectoryFrameIndexEntry entry;
+        const int64_t             end = readFrameHeader(fio, ftp, offset, &entry);
+        if (end < 0 || end > size)
+        {
+            // A frame that is not completely written (e.g., by a running
+            // simulation) ends the index; it is indexed by a later update().
+            break;
+        }
+        if (!frames_.empty() && entry.time <= frames_.back().time)
+        {
+            bTimeOrdered_ = false;
+        }
+        frames_.push_back(entry);
+        offset = end;
+    }
+    gmx_fio_close(fio);
+    if (offset == indexedSize_ && frames_.empty())
+    {
+        GMX_THROW(FileIOError(formatString(
+                                      "Could not read any frames from '%s'",
+                                      trajectoryFile_.c_str())));
+    }
+    indexedSize_ = offset;
+}
+
+bool TrajectoryFrameIndex::isOutOfDate() const
+{
+    return fileSize(trajectoryFile_) > indexedSize_;
+}
+
+bool TrajectoryFrameIndex::readSidecar()
+{
+    const std::string sidecarFile = sidecarFileName(trajectoryFile_);
+    if (!gmx_fexist(sidecarFile))
+    {
+        return false;
+    }
+    std::vector<char> buffer;
+    {
+        FILE *fp = gmx_ffopen(sidecarFile, "rb");
+        gmx_fseek(fp, 0, SEEK_END);
+        buffer.resize(gmx_ftell(fp));
+        gmx_fseek(fp, 0, SEEK_SET);
+        const size_t bytesRead = fread(buffer.data(), 1, buffer.size(), fp);
+        gmx_ffclose(fp);
+        if (bytesRead != buffer.size())
+        {
+            return false;
+        }
+    }
+
+    // Check the sizes before deserializing, as the deserializer does not.
+    std::vector<char> header;
+    {
+        InMemorySerializer serializer;
+        std::string        magic(c_sidecarMagic);
+        int                version        = c_sidecarVersion;
+        int64_t            indexedSize    = 0;
+        int64_t            frameCount     = 0;
+        serializer.doString(&magic);
+        serializer.doInt(&version);
+        serializer.doInt64(&indexedSize);
+        serializer.doInt64(&frameCount);
+        header = serializer.finishAndGetBuffer();
+    }
+    if (buffer.size() < header.size()
+        || !std::equal(header.begin(), header.begin() + header.size() - 2*sizeof(int64_t),
+                       buffer.begin()))
+    {
+        return false;
+    }
+    InMemoryDeserializer deserializer(buffer);
+    std::string          magic;
+    int                  version;
+    int64_t              indexedSize;
+    int64_t              frameCount;
+    deserializer.doString(&magic);
+    deserializer.doInt(&version);
+    deserializer.doInt64(&indexedSize);
+    deserializer.doInt64(&frameCount);
+    if (frameCount <= 0
+        || buffer.size() != header.size() + frameCount*serializedEntrySize())
+    {
+        return false;
+    }
+    std::vector<TrajectoryFrameIndexEntry> frames(frameCount);
+    bool                                   bTimeOrdered = true;
+    for (auto &entry : frames)
+    {
+        serializeEntry(&deserializer, &entry);
+        if (&entry != &frames.front() && entry.time <= (&entry - 1)->time)
+        {
+            bTimeOrdered = false;
+        }
+    }
+
+    // Check that the trajectory has not been replaced since the index was
+    // written by re-reading the last indexed frame.
+    if (fileSize(trajectoryFile_) < indexedSize)
+    {
+        return false;
+    }
+    TrajectoryFrameIndexEntry lastFrame;
+    t_fileio                 *fio = gmx_fio_open(trajectoryFile_.c_str(), "r");
+    const int64_t             end = readFrameHeader(fio, fn2ftp(trajectoryFile_.c_str()),
+                                                    frames.back().offset, &lastFrame);
+    gmx_fio_close(fio);
+    if (end != indexedSize || lastFrame.step != frames.back().step
+        || lastFrame.natoms != frames.back().natoms)
+    {
+        return false;
+    }
+
+    frames_       = std::move(frames);
+    indexedSize_  = indexedSize;
+    bTimeOrdered_ = bTimeOrdered;
+    return true;
+}
+
+void TrajectoryFrameIndex::writeSidecar() const
+{
+    InMemorySerializer serializer;
+    std::string        magic(c_sidecarMagic);
+    int                version     = c_sidecarVersion;
+    int64_t            indexedSize = indexedSize_;
+    int64_t            frameCount  = frames_.size();
+    serializer.doString(&magic);
+    serializer.doInt(&version);
+    serializer.doInt64(&indexedSize);
+    serializer.doInt64(&frameCount);
+    for (TrajectoryFrameIndexEntry entry : frames_)
+    {
+        serializeEntry(&serializer, &entry);
+    }
+    const std::vector<char> buffer = serializer.finishAndGetBuffer();
+
+    const std::string       sidecarFile = sidecarFileName(trajectoryFile_);
+    FILE                   *fp          = gmx_ffopen(sidecarFile, "wb");
+    const size_t            written     = fwrite(buffer.data(), 1, buffer.size(), fp);
+    gmx_ffclose(fp);
+    if (written != buffer.size())
+    {
+        GMX_THROW(FileIOError(formatString(
+                                      "Could not write frame index to '%s'",
+                                      sidecarFile.c_str())));
+    }
+}
+
+int64_t TrajectoryFrameIndex::findFirstFrameAtTime(double time) const
+{
+    if (bTimeOrdered_)
+    {
+        auto frame = std::lower_bound(frames_.begin(), frames_.end(), time,
+                                      [](const TrajectoryFrameIndexEntry &entry, double t)
+                                      { return entry.time < t; });
+        return frame - frames_.begin();
+    }
+    auto frame = std::find_if(frames_.begin(), frames_.end(),
+                              [time](const TrajectoryFrameIndexEntry &entry)
+                              { return entry.time >= time; });
+    return frame - frames_.begin();
+}
+
+std::vector<std::pair<int64_t, int64_t> >
+TrajectoryFrameIndex::splitIntoRanges(int rangeCount) const
+{
+    GMX_RELEASE_ASSERT(rangeCount > 0, "Need at least one range");
+    std::vector<std::pair<int64_t, int64_t> > ranges;
+    const int64_t frameCount = frames_.size();
+    for (int i = 0; i < rangeCount; ++i)
+    {
+        const int64_t begin = frameCount*i/rangeCount;
+        const int64_t end   = frameCount*(i + 1)/rangeCount;
+        if (end > begin)
+        {
+            ranges.emplace_back(begin, end);
+        }
+    }
+    return ranges;
+}
+
+} // namespace gmx
@@ -0,0 +1,187 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \libinternal \file
+ * \brief
+ * Declares gmx::TrajectoryFrameIndex for random access to xtc and trr files.
+ *
+ * \inlibraryapi
+ * \ingroup module_fileio
+ */
+#ifndef GMX_FILEIO_TRAJECTORYFRAMEINDEX_H
+#define GMX_FILEIO_TRAJECTORYFRAMEINDEX_H
+
+#include <cstdint>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gromacs/math/vectypes.h"
+#include "gromacs/utility/real.h"
+
+namespace gmx
+{
+
+/*! \libinternal \brief
+ * Location and header information of a single trajectory frame.
+ *
+ * \inlibraryapi
+ * \ingroup module_fileio
+ */
+struct TrajectoryFrameIndexEntry
+{
+    //! Byte offset of the start of the frame in the file.
+    int64_t offset;
+    //! MD step of the frame.
+    int64_t step;
+    //! Time of the frame.
+    double  time;
+    //! Number of atoms in the frame.
+    int     natoms;
+    //! Box of the frame (zero if the frame has no box).
+    matrix  box;
+};
+
+/*! \libinternal \brief
+ * Index of the frames in an xtc or trr file.
+ *
+ * Maps frame numbers to file offsets, so that any frame can be read without
+ * scanning or bisecting the file.  The index is built by reading only the
+ * frame headers, and can be stored in a sidecar file next to the trajectory
+ * (see sidecarFileName()) so that it only needs to be built once.  Frames
+ * appended to the trajectory after the index was built are indexed by
+ * update().
+ *
+ * Typical use:
+ * \code
+   TrajectoryFrameIndex index(filename);
+   if (!index.readSidecar())
+   {
+       index.update();
+       index.writeSidecar();
+   }
+   \endcode
+ *
+ * \inlibraryapi
+ * \ingroup module_fileio
+ */
+class TrajectoryFrameIndex
+{
+    public:
+        //! Returns whether frames in \p trajectoryFile can be indexed.
+        static bool isSupportedFormat(const std::string &trajectoryFile);
+        //! Returns the name of the sidecar index file for \p trajectoryFile.
+        static std::string sidecarFileName(const std::string &trajectoryFile);
+
+        /*! \brief
+         * Creates an empty index for \p trajectoryFile.
+         *
+         * \throws InvalidInputError if the format cannot be indexed.
+         */
+        explicit TrajectoryFrameIndex(const std::string &trajectoryFile);
+
+        /*! \brief
+         * Indexes all frames not yet in the index.
+         *
+         * For an empty index, scans the whole file.  Otherwise, continues
+         * from the end of the last indexed frame.  A frame that has not been
+         * completely written is not indexed.
+         *
+         * \throws FileIOError if the file cannot be read or is corrupted.
+         */
+        void update();
+        /*! \brief
+         * Reads the index from the sidecar file, if one exists.
+         *
+         * \returns false if there is no sidecar file, or if it does not
+         *     match the trajectory (in which case the index is left empty).
+         *
+         * If the trajectory has grown since the sidecar was written, the
+         * new frames are not included until update() is called.
+         */
+        bool readSidecar();
+        /*! \brief
+         * Writes the index to the sidecar file.
+         *
+         * \throws FileIOError if the file cannot be written.
+         */
+        void writeSidecar() const;
+
+        //! Returns whether the file has frames that are not in the index.
+        bool isOutOfDate() const;
+        //! Returns the number of indexed frames.
+        int64_t frameCount() const { return frames_.size(); }
+        //! Returns information about frame \p frameIndex.
+        const TrajectoryFrameIndexEntry &frame(int64_t frameIndex) const
+        {
+            return frames_[frameIndex];
+        }
+        /*! \brief
+         * Returns the index of the first frame with time at or after \p time.
+         *
+         * Returns frameCount() if there is no such frame.  Uses bisection
+         * when the frame times are increasing.
+         */
+        int64_t findFirstFrameAtTime(double time) const;
+        /*! \brief
+         * Splits the frames into contiguous ranges of nearly equal size.
+         *
+         * \param[in] rangeCount  Number of ranges to create.
+         * \returns   Begin and end (exclusive) frame indices of each range.
+         *
+         * Intended for processing parts of a trajectory independently.
+         */
+        std::vector<std::pair<int64_t, int64_t> > splitIntoRanges(int rangeCount) const;
+
+    private:
+        //! Indexes xtc frames starting at \p offset.
+        void scanXtc(int64_t offset);
+        //! Indexes trr frames starting at \p offset.
+        void scanTrr(int64_t offset);
+
+        //! Name of the trajectory file.
+        std::string                             trajectoryFile_;
+        //! Information about each frame.
+        std::vector<TrajectoryFrameIndexEntry>  frames_;
+        //! File offset after the last indexed frame.
+        int64_t                                 indexedSize_;
+        //! Whether frame times are strictly increasing.
+        bool                                    bTimeOrdered_;
+};
+
+} // namespace gmx
+
+#endif
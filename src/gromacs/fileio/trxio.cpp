@@ -42,8 +42,12 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstdlib>
 #include <cstring>
 
+#include <algorithm>
+#include <memory>
+
 #include "gromacs/fileio/checkpoint.h"
 #include "gromacs/fileio/confio.h"
 #include "gromacs/fileio/filetypes.h"
@@ -51,11 +55,13 @@
 #include "gromacs/fileio/gmxfio.h"
 #include "gromacs/fileio/gmxfio_xdr.h"
 #include "gromacs/fileio/groio.h"
+#include "gromacs/fileio/mappedtrrreader.h"
 #include "gromacs/fileio/oenv.h"
 #include "gromacs/fileio/pdbio.h"
 #include "gromacs/fileio/timecontrol.h"
 #include "gromacs/fileio/tngio.h"
 #include "gromacs/fileio/tpxio.h"
+#include "gromacs/fileio/trajectoryframeindex.h"
 #include "gromacs/fileio/trrio.h"
 #include "gromacs/fileio/xdrf.h"
 #include "gromacs/fileio/xtcio.h"
@@ -65,6 +71,7 @@
 #include "gromacs/topology/symtab.h"
 #include "gromacs/topology/topology.h"
 #include "gromacs/trajectory/trajectoryframe.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/gmxassert.h"
@@ -93,6 +100,11 @@ struct t_trxstatus
     double                  DT, BOX[3];
     gmx_bool                bReadBox;
     char                   *persistent_line; /* Persistent line for reading g96 trajectories */
+    std::unique_ptr<gmx::TrajectoryFrameIndex> frameIndex; /* Frame index from the sidecar file, if any */
+    std::unique_ptr<gmx::MappedTrrReader>      trrReader;  /* Memory-mapped reader for trr files, if used */
+    gmx_bool                bFrameIndexRead;  /* Whether reading the frame index was tried */
+    gmx_bool                bSoughtBegin;     /* Whether the start time was sought */
+    gmx_bool                bMappedFrame;     /* Whether the last frame was read by trrReader */
 #if GMX_USE_PLUGINS
     gmx_vmdplugin_t        *vmdplugin;
 #endif
@@ -168,6 +180,11 @@ static void status_init(t_trxstatus *status)
     status->tf              = 0;
     status->persistent_line = nullptr;
     status->tng             = nullptr;
+    status->frameIndex      = nullptr;
+    status->trrReader       = nullptr;
+    status->bFrameIndexRead = FALSE;
+    status->bSoughtBegin    = FALSE;
+    status->bMappedFrame    = FALSE;
 }
 
 
@@ -479,7 +496,7 @@ trjtools_gmx_prepare_tng_writing(const char              *filename,
         gmx_incons("Sorry, can only prepare for TNG output.");
     }
     t_trxstatus *out;
-    snew(out, 1);
+    out = new t_trxstatus();
     status_init(out);
 
     if (in != nullptr)
@@ -648,7 +665,7 @@ void close_trx(t_trxstatus *status)
      * but the read_first_x/read_next_x functions are deprecated anyhow.
      * read_first_frame/read_next_frame and close_trx should be used.
      */
-    sfree(status);
+    delete status;
 }
 
 t_trxstatus *open_trx(const char *outfile, const char *filemode)
@@ -659,7 +676,7 @@ t_trxstatus *open_trx(const char *outfile, const char *filemode)
         gmx_fatal(FARGS, "Sorry, write_trx can only write");
     }
 
-    snew(stat, 1);
+    stat = new t_trxstatus();
     status_init(stat);
 
     stat->fio = gmx_fio_open(outfile, filemode);
@@ -671,9 +688,23 @@ static gmx_bool gmx_next_frame(t_trxstatus *status, t_trxframe *fr)
     gmx_trr_header_t sh;
     gmx_bool         bOK, bRet;
 
-    bRet = FALSE;
+    status->bMappedFrame = FALSE;
+    if (status->trrReader)
+    {
+        bool bMappedOK;
+        bRet = status->trrReader->readFrame(gmx_fio_ftell(status->fio), &bMappedOK);
+        bOK  = bMappedOK;
+        if (bRet)
+        {
+            sh = status->trrReader->header();
+        }
+    }
+    else
+    {
+        bRet = gmx_trr_read_frame_header(status->fio, &sh, &bOK);
+    }
 
-    if (gmx_trr_read_frame_header(status->fio, &sh, &bOK))
+    if (bRet)
     {
         fr->bDouble   = sh.bDouble;
         fr->natoms    = sh.natoms;
@@ -685,9 +716,11 @@ static gmx_bool gmx_next_frame(t_trxstatus *status, t_trxframe *fr)
         fr->bFepState = TRUE;
         fr->lambda    = sh.lambda;
         fr->bBox      = sh.box_size > 0;
+        /* With views of a mapped file, the vectors are not stored in the frame */
+        const bool bViews = (status->trrReader && (status->flags & TRX_MAPPED_VIEWS));
         if (status->flags & (TRX_READ_X | TRX_NEED_X))
         {
-            if (fr->x == nullptr)
+            if (fr->x == nullptr && !bViews)
             {
                 snew(fr->x, sh.natoms);
             }
@@ -695,7 +728,7 @@ static gmx_bool gmx_next_frame(t_trxstatus *status, t_trxframe *fr)
         }
         if (status->flags & (TRX_READ_V | TRX_NEED_V))
         {
-            if (fr->v == nullptr)
+            if (fr->v == nullptr && !bViews)
             {
                 snew(fr->v, sh.natoms);
             }
@@ -703,18 +736,26 @@ static gmx_bool gmx_next_frame(t_trxstatus *status, t_trxframe *fr)
         }
         if (status->flags & (TRX_READ_F | TRX_NEED_F))
         {
-            if (fr->f == nullptr)
+            if (fr->f == nullptr && !bViews)
             {
                 snew(fr->f, sh.natoms);
             }
             fr->bF = sh.f_size > 0;
         }
-        if (gmx_trr_read_frame_data(status->fio, &sh, fr->box, fr->x, fr->v, fr->f))
+        if (status->trrReader)
         {
-            bRet = TRUE;
+            /* Convert directly from the mapped file, and keep the file
+             * position in sync for seeking and rewinding. */
+            status->trrReader->copyFrameData(fr->box,
+                                             (status->flags & (TRX_READ_X | TRX_NEED_X)) && !bViews ? fr->x : nullptr,
+                                             (status->flags & (TRX_READ_V | TRX_NEED_V)) && !bViews ? fr->v : nullptr,
+                                             (status->flags & (TRX_READ_F | TRX_NEED_F)) && !bViews ? fr->f : nullptr);
+            gmx_fio_seek(status->fio, status->trrReader->frameEnd());
+            status->bMappedFrame = TRUE;
         }
-        else
+        else if (!gmx_trr_read_frame_data(status->fio, &sh, fr->box, fr->x, fr->v, fr->f))
         {
+            bRet       = FALSE;
             fr->not_ok = DATA_NOT_OK;
         }
     }
@@ -803,6 +844,79 @@ static int pdb_first_x(t_trxstatus *status, FILE *fp, t_trxframe *fr)
     return fr->natoms;
 }
 
+/*! \brief Returns the frame index of the trajectory, or nullptr if there is none.
+ *
+ * The index is only read from an existing sidecar file, and is updated
+ * in memory when frames have been appended to the trajectory since.
+ */
+static gmx::TrajectoryFrameIndex *getFrameIndex(t_trxstatus *status)
+{
+    if (!status->bFrameIndexRead)
+    {
+        status->bFrameIndexRead = TRUE;
+        const char *fn          = gmx_fio_getname(status->fio);
+        if (gmx::TrajectoryFrameIndex::isSupportedFormat(fn))
+        {
+            auto index = std::make_unique<gmx::TrajectoryFrameIndex>(fn);
+            if (index->readSidecar())
+            {
+                if (index->isOutOfDate())
+                {
+                    index->update();
+                }
+                status->frameIndex = std::move(index);
+            }
+        }
+    }
+    return status->frameIndex.get();
+}
+
+/*! \brief Seeks to just before the start time using the frame index.
+ *
+ * Returns TRUE if a frame index is available.  Only seeks forward, and only
+ * once, so that the normal frame skipping takes care of the remaining frames.
+ */
+static gmx_bool seekToBeginWithFrameIndex(t_trxstatus *status)
+{
+    if (status->bSoughtBegin)
+    {
+        return status->frameIndex != nullptr;
+    }
+    status->bSoughtBegin = TRUE;
+    gmx::TrajectoryFrameIndex *index = getFrameIndex(status);
+    if (index == nullptr)
+    {
+        return FALSE;
+    }
+    int64_t frame = index->findFirstFrameAtTime(rTimeValue(TBEGIN));
+    /* Start one frame earlier, as check_times() accepts frames within
+     * a tolerance of the begin time. */
+    frame = std::max<int64_t>(frame - 1, 0);
+    if (frame < index->frameCount()
+        && index->frame(frame).offset > gmx_fio_ftell(status->fio))
+    {
+        gmx_fio_seek(status->fio, index->frame(frame).offset);
+        initcount(status);
+    }
+    return TRUE;
+}
+
+gmx_bool trx_seek_frame(t_trxstatus *status, int64_t frame)
+{
+    if (status->tng != nullptr || status->fio == nullptr)
+    {
+        return FALSE;
+    }
+    gmx::TrajectoryFrameIndex *index = getFrameIndex(status);
+    if (index == nullptr || frame < 0 || frame >= index->frameCount())
+    {
+        return FALSE;
+    }
+    /* Disable seeking to the begin time, the caller chose the frame. */
+    status->bSoughtBegin = TRUE;
+    return gmx_fio_seek(status->fio, index->frame(frame).offset) == 0;
+}
+
 bool read_next_frame(const gmx_output_env_t *oenv, t_trxstatus *status, t_trxframe *fr)
 {
     real     pt;
@@ -829,6 +943,10 @@ bool read_next_frame(const gmx_output_env_t *oenv, t_trxstatus *status, t_trxfra
         switch (ftp)
         {
             case efTRR:
+                if (bTimeSet(TBEGIN) && (status->tf < rTimeValue(TBEGIN)))
+                {
+                    seekToBeginWithFrameIndex(status);
+                }
                 bRet = gmx_next_frame(status, fr);
                 break;
             case efCPT:
@@ -843,7 +961,8 @@ bool read_next_frame(const gmx_output_env_t *oenv, t_trxstatus *status, t_trxfra
                 break;
             }
             case efXTC:
-                if (bTimeSet(TBEGIN) && (status->tf < rTimeValue(TBEGIN)))
+                if (bTimeSet(TBEGIN) && (status->tf < rTimeValue(TBEGIN))
+                    && !seekToBeginWithFrameIndex(status))
                 {
                     if (xtc_seek_time(status->fio, rTimeValue(TBEGIN), fr->natoms, TRUE))
                     {
@@ -937,7 +1056,7 @@ bool read_first_frame(const gmx_output_env_t *oenv, t_trxstatus **status,
 
     bFirst = TRUE;
 
-    snew((*status), 1);
+    *status = new t_trxstatus();
 
     status_init( *status );
     initcount(*status);
@@ -955,6 +1074,21 @@ bool read_first_frame(const gmx_output_env_t *oenv, t_trxstatus **status,
     switch (ftp)
     {
         case efTRR:
+            if (gmx::MappedTrrReader::isSupported() && getenv("GMX_TRR_NO_MMAP") == nullptr)
+            {
+                try
+                {
+                    (*status)->trrReader = std::make_unique<gmx::MappedTrrReader>(fn);
+                }
+                catch (const gmx::GromacsException &ex)
+                {
+                    /* Fall back to reading through the XDR file handle */
+                    if (debug)
+                    {
+                        fprintf(debug, "Not memory-mapping '%s': %s\n", fn, ex.what());
+                    }
+                }
+            }
             break;
         case efCPT:
             read_checkpoint_trxframe(fio, fr);
@@ -1112,6 +1246,21 @@ gmx_bool read_next_x(const gmx_output_env_t *oenv, t_trxstatus *status, real *t,
     return bRet;
 }
 
+gmx_bool trx_get_mapped_frame_views(t_trxstatus                    *status,
+                                    gmx::ArrayRef<const gmx::RVec> *x,
+                                    gmx::ArrayRef<const gmx::RVec> *v,
+                                    gmx::ArrayRef<const gmx::RVec> *f)
+{
+    if (!status->bMappedFrame)
+    {
+        return FALSE;
+    }
+    *x = (status->flags & (TRX_READ_X | TRX_NEED_X)) ? status->trrReader->x() : gmx::ArrayRef<const gmx::RVec>();
+    *v = (status->flags & (TRX_READ_V | TRX_NEED_V)) ? status->trrReader->v() : gmx::ArrayRef<const gmx::RVec>();
+    *f = (status->flags & (TRX_READ_F | TRX_NEED_F)) ? status->trrReader->f() : gmx::ArrayRef<const gmx::RVec>();
+    return TRUE;
+}
+
 void rewind_trj(t_trxstatus *status)
 {
     initcount(status);
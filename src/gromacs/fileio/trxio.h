@@ -39,6 +39,7 @@
 #define GMX_FILEIO_TRXIO_H
 
 #include "gromacs/fileio/pdbio.h"
+#include "gromacs/math/vectypes.h"
 #include "gromacs/utility/arrayref.h"
 
 struct gmx_mtop_t;
@@ -202,6 +203,11 @@ int check_times(real t);
 #define TRX_NEED_F    (1<<5)
 /* Useful for reading natoms from a trajectory without skipping */
 #define TRX_DONT_SKIP (1<<6)
+/* Do not copy x, v and f of trr frames read through a memory map into
+ * the frame, they are only available from trx_get_mapped_frame_views().
+ * The frame flags bX, bV and bF are still set.
+ */
+#define TRX_MAPPED_VIEWS (1<<7)
 
 /* For trxframe.not_ok */
 #define HEADER_NOT_OK (1<<0)
@@ -237,9 +243,32 @@ gmx_bool read_next_x(const gmx_output_env_t *oenv, t_trxstatus *status, real *t,
  * status is the integer set in read_first_x.
  */
 
+gmx_bool trx_get_mapped_frame_views(t_trxstatus                    *status,
+                                    gmx::ArrayRef<const gmx::RVec> *x,
+                                    gmx::ArrayRef<const gmx::RVec> *v,
+                                    gmx::ArrayRef<const gmx::RVec> *f);
+/* When the last frame read from status came from a memory-mapped trr
+ * file (see gmx::MappedTrrReader), sets x, v and f to views of its
+ * coordinates, velocities and forces and returns TRUE. A view is empty
+ * when the frame does not contain the data or it was not requested
+ * with the READ or NEED flags. The views point directly into the file
+ * when its byte order and precision match those of the build, and
+ * otherwise into a buffer converted in a single pass. They are valid
+ * until the next frame is read. Returns FALSE otherwise, in which case
+ * the data is in the frame.
+ */
+
 void rewind_trj(t_trxstatus *status);
 /* Rewind trajectory file as opened with read_first_x */
 
+gmx_bool trx_seek_frame(t_trxstatus *status, int64_t frame);
+/* Position an xtc or trr trajectory opened with read_first_frame such
+ * that the next call to read_next_frame reads frame number frame,
+ * using the frame index stored next to the trajectory (see
+ * gmx::TrajectoryFrameIndex). Returns FALSE when there is no frame
+ * index or the frame is out of range.
+ */
+
 struct t_topology *read_top(const char *fn, int *ePBC);
 /* Extract a topology data structure from a topology file.
  * If ePBC!=NULL *ePBC gives the pbc type.
@@ -51,6 +51,8 @@
 #include "gromacs/mdtypes/md_enums.h"
 #include "gromacs/utility/fatalerror.h"
 
+#include "nb_free_energy_simd.h"
+
 void
 gmx_nb_free_energy_kernel(const t_nblist * gmx_restrict    nlist,
                           rvec * gmx_restrict              xx,
@@ -60,6 +62,25 @@ gmx_nb_free_energy_kernel(const t_nblist * gmx_restrict    nlist,
                           nb_kernel_data_t * gmx_restrict  kernel_data,
                           t_nrnb * gmx_restrict            nrnb)
 {
+    if (gmx_nb_free_energy_kernel_simd_supported(fr))
+    {
+        gmx_nb_free_energy_kernel_simd(nlist, xx, ff, fr, mdatoms, kernel_data, nrnb);
+    }
+    else
+    {
+        gmx_nb_free_energy_kernel_reference(nlist, xx, ff, fr, mdatoms, kernel_data, nrnb);
+    }
+}
+
+void
+gmx_nb_free_energy_kernel_reference(const t_nblist * gmx_restrict    nlist,
+                                    rvec * gmx_restrict              xx,
+                                    rvec * gmx_restrict              ff,
+                                    t_forcerec * gmx_restrict        fr,
+                                    const t_mdatoms * gmx_restrict   mdatoms,
+                                    nb_kernel_data_t * gmx_restrict  kernel_data,
+                                    t_nrnb * gmx_restrict            nrnb)
+{
 
 #define  STATE_A  0
 #define  STATE_B  1
@@ -46,6 +46,12 @@
 
 struct t_forcerec;
 
+/*! \brief Computes the perturbed non-bonded interactions in \p nlist
+ *
+ * Uses the SIMD kernel when it supports the interaction setup in \p fr,
+ * see gmx_nb_free_energy_kernel_simd_supported(), and the plain-C
+ * reference kernel otherwise.
+ */
 void
     gmx_nb_free_energy_kernel(const t_nblist * gmx_restrict    nlist,
                               rvec * gmx_restrict              xx,
@@ -55,4 +61,18 @@ void
                               nb_kernel_data_t * gmx_restrict  kernel_data,
                               t_nrnb * gmx_restrict            nrnb);
 
+/*! \brief Plain-C free-energy kernel
+ *
+ * Supports all interaction setups, also those of the group scheme.
+ * Also serves as the reference for testing the SIMD kernel.
+ */
+void
+    gmx_nb_free_energy_kernel_reference(const t_nblist * gmx_restrict    nlist,
+                                        rvec * gmx_restrict              xx,
+                                        rvec * gmx_restrict              ff,
+                                        t_forcerec * gmx_restrict        fr,
+                                        const t_mdatoms * gmx_restrict   mdatoms,
+                                        nb_kernel_data_t * gmx_restrict  kernel_data,
+                                        t_nrnb * gmx_restrict            nrnb);
+
 #endif
@@ -0,0 +1,822 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+#include "gmxpre.h"
+
+#include "nb_free_energy_simd.h"
+
+#include "config.h"
+
+#include <cmath>
+
+#include <algorithm>
+
+#include "gromacs/gmxlib/nrnb.h"
+#include "gromacs/gmxlib/nonbonded/nb_kernel.h"
+#include "gromacs/gmxlib/nonbonded/nonbonded.h"
+#include "gromacs/math/functions.h"
+#include "gromacs/mdtypes/forcerec.h"
+#include "gromacs/mdtypes/interaction_const.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/simd/simd.h"
+#include "gromacs/simd/simd_math.h"
+#include "gromacs/simd/vector_operations.h"
+#include "gromacs/utility/basedefinitions.h"
+#include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/real.h"
+
+using namespace gmx; // TODO: Remove when this file is moved into gmx namespace
+
+namespace
+{
+
+#if GMX_SIMD_HAVE_REAL
+
+//! The soft-core r-powers the SIMD kernel is instantiated for
+enum class SoftCoreTreatment
+{
+    RPower6,  //!< Soft-core with r^6, evaluated directly
+    RPower48  //!< Soft-core with r^48, evaluated in the log domain to avoid under/overflow
+};
+
+//! The number of lambda end states
+constexpr int c_numStates = 2;
+
+//! Distances for a SIMD batch of pairs
+struct PairDistance
+{
+    //! r^2
+    SimdReal rsq;
+    //! r
+    SimdReal r;
+    //! 1/r, 0 at r=0
+    SimdReal rInv;
+    //! ln(r^2), only set with r-power 48, 0 at r=0
+    SimdReal logRsq;
+    //! Whether r > 0
+    SimdBool rsqPositive;
+};
+
+//! Soft-core distance terms for one state and one interaction type
+struct SoftCoreDistance
+{
+    //! The soft-core distance r_sc
+    SimdReal r;
+    //! 1/r_sc
+    SimdReal rInv;
+    //! 1/r_sc^6
+    SimdReal rInv6;
+    //! r^(p-2)/r_sc^p, converts dV/dr_sc*r_sc to the scalar force
+    SimdReal forceFactor;
+    //! sigma^p/r_sc^p, converts dV/dr_sc*r_sc to the soft-core dV/dlambda
+    SimdReal dvdlFactor;
+};
+
+/*! \brief Computes the soft-core distance r_sc = (alpha*lfac*sigma^p + r^p)^(1/p)
+ *
+ * \p alphaLambdaFactor is alpha times the lambda factor of the state,
+ * which is zero when soft-core is not applied. The results are only
+ * meaningful in lanes set in \p mask, but are finite in all lanes.
+ */
+template<SoftCoreTreatment softCoreTreatment>
+static inline SoftCoreDistance gmx_simdcall
+softCoreDistance(SimdReal            alphaLambdaFactor,
+                 SimdReal            sigma6,
+                 const PairDistance &pair,
+                 SimdBool            mask)
+{
+    const SimdReal   zero = setZero();
+    const SimdReal   one(1.0);
+    const SimdBool   noSoftCore = (alphaLambdaFactor == zero);
+
+    SoftCoreDistance sc;
+
+    if (softCoreTreatment == SoftCoreTreatment::RPower6)
+    {
+        const SimdReal rsq2        = pair.rsq*pair.rsq;
+        const SimdReal denominator = blend(one, fma(alphaLambdaFactor, sigma6, rsq2*pair.rsq), mask);
+        const SimdReal rpInv       = inv(denominator);
+
+        sc.r           = exp(log(denominator)*SimdReal(1.0/6.0));
+        sc.rInv        = inv(sc.r);
+        sc.rInv6       = rpInv;
+        sc.forceFactor = rpInv*rsq2;
+        sc.dvdlFactor  = rpInv*sigma6;
+    }
+    else
+    {
+        /* With r^48 and sigma^48 the terms below easily under- or overflow,
+         * also in double precision, so we work with logarithms and only
+         * exponentiate the (bounded) ratios of powers.
+         */
+        const SimdReal minusHuge(-0.5*GMX_REAL_MAX);
+        const SimdReal maxExpArgument(std::log(GMX_REAL_MAX) - 1.0);
+        const SimdBool alphaPositive  = (zero < alphaLambdaFactor);
+        const SimdReal logSigma6      = log(blend(one, sigma6, zero < sigma6));
+        const SimdReal logAlphaSigmap = blend(minusHuge,
+                                              log(blend(one, alphaLambdaFactor, alphaPositive)) + SimdReal(8.0)*logSigma6,
+                                              alphaPositive);
+        const SimdReal logRp          = blend(minusHuge, SimdReal(24.0)*pair.logRsq, pair.rsqPositive);
+        const SimdReal logMax         = max(logAlphaSigmap, logRp);
+        const SimdReal logDenominator = selectByMask(logMax + log(exp(logAlphaSigmap - logMax) + exp(logRp - logMax)),
+                                                     mask);
+
+        sc.r                  = exp(logDenominator*SimdReal(1.0/48.0));
+        sc.rInv               = inv(sc.r);
+        const SimdReal rInv2  = sc.rInv*sc.rInv;
+        sc.rInv6              = rInv2*rInv2*rInv2;
+        sc.forceFactor        = selectByMask(exp(min(SimdReal(23.0)*pair.logRsq - logDenominator, maxExpArgument)),
+                                             pair.rsqPositive);
+        sc.dvdlFactor         = exp(min(SimdReal(8.0)*logSigma6 - logDenominator, maxExpArgument));
+    }
+
+    /* Without soft-core we can use the exact distance */
+    sc.r    = blend(sc.r, pair.r, noSoftCore);
+    sc.rInv = blend(sc.rInv, pair.rInv, noSoftCore);
+
+    return sc;
+}
+
+//! Coefficients of the fifth order potential switch
+struct PotentialSwitch
+{
+    //! Initializes the coefficients for switching between \p rSwitch and \p rCut
+    PotentialSwitch(real rSwitch, real rCut)
+    {
+        const real d = rCut - rSwitch;
+
+        rSwitch_ = SimdReal(rSwitch);
+        rCut_    = SimdReal(rCut);
+        swV3_    = SimdReal(-10.0/(d*d*d));
+        swV4_    = SimdReal( 15.0/(d*d*d*d));
+        swV5_    = SimdReal( -6.0/(d*d*d*d*d));
+        swF2_    = SimdReal(-30.0/(d*d*d));
+        swF3_    = SimdReal( 60.0/(d*d*d*d));
+        swF4_    = SimdReal(-30.0/(d*d*d*d*d));
+    }
+
+    //! Applies the switch at distance \p r to potential \p v and scalar force \p f
+    inline void gmx_simdcall apply(SimdReal r, SimdReal *v, SimdReal *f) const
+    {
+        const SimdReal one(1.0);
+        const SimdReal d   = max(r - rSwitch_, setZero());
+        const SimdReal d2  = d*d;
+        const SimdReal sw  = fma(d2*d, fma(d, fma(d, swV5_, swV4_), swV3_), one);
+        const SimdReal dsw = d2*fma(d, fma(d, swF4_, swF3_), swF2_);
+        const SimdBool withinCutoff = (r < rCut_);
+
+        *f = selectByMask(*f*sw - r*(*v)*dsw, withinCutoff);
+        *v = selectByMask(*v*sw, withinCutoff);
+    }
+
+    //! Switching distance
+    SimdReal rSwitch_;
+    //! Cut-off distance
+    SimdReal rCut_;
+    //! Potential coefficients
+    SimdReal swV3_, swV4_, swV5_;
+    //! Force coefficients
+    SimdReal swF2_, swF3_, swF4_;
+};
+
+/*! \brief SIMD free-energy kernel, processes GMX_SIMD_REAL_WIDTH j-entries at once
+ *
+ * The per-pair parameters are gathered into aligned buffers with plain-C
+ * code, the soft-core and interaction computations are done in SIMD.
+ * Pairs beyond the cut-off get zero parameters, so they do not contribute
+ * and need no masking in the SIMD part.
+ *
+ * \tparam softCoreTreatment  The soft-core r-power
+ * \tparam elecIsEwald        Whether electrostatics is (converted) Ewald, reaction-field otherwise
+ * \tparam vdwIsLJEwald       Whether Van der Waals is (converted) LJ-PME, plain LJ otherwise
+ */
+template<SoftCoreTreatment softCoreTreatment, bool elecIsEwald, bool vdwIsLJEwald>
+static void
+nbFreeEnergyKernelSimd(const t_nblist * gmx_restrict    nlist,
+                       rvec * gmx_restrict              xx,
+                       rvec * gmx_restrict              ff,
+                       t_forcerec * gmx_restrict        fr,
+                       const t_mdatoms * gmx_restrict   mdatoms,
+                       nb_kernel_data_t * gmx_restrict  kernel_data,
+                       t_nrnb * gmx_restrict            nrnb)
+{
+    constexpr int              c_width = GMX_SIMD_REAL_WIDTH;
+
+    const interaction_const_t *ic      = fr->ic;
+
+    const real                *x        = xx[0];
+    real                      *f        = ff[0];
+    real                      *fshift   = fr->fshift[0];
+    const real                *shiftvec = fr->shift_vec[0];
+
+    const int                 *iinr     = nlist->iinr;
+    const int                 *jindex   = nlist->jindex;
+    const int                 *jjnr     = nlist->jjnr;
+    const char                *exclFep  = nlist->excl_fep;
+    const int                 *shift    = nlist->shift;
+    const int                 *gid      = nlist->gid;
+
+    const real                *chargeA  = mdatoms->chargeA;
+    const real                *chargeB  = mdatoms->chargeB;
+    const int                 *typeA    = mdatoms->typeA;
+    const int                 *typeB    = mdatoms->typeB;
+    const int                  ntype    = fr->ntype;
+    const real                *nbfp     = fr->nbfp;
+    const real                *nbfpGrid = fr->ljpme_c6grid;
+
+    const real                 facel    = ic->epsfac;
+    const real                 rcoulomb = ic->rcoulomb;
+    const real                 rvdw     = ic->rvdw;
+    const real                 rcutoffMax2 = gmx::square(std::max(ic->rcoulomb, ic->rvdw));
+
+    const real                 lambdaCoul = kernel_data->lambda[efptCOUL];
+    const real                 lambdaVdw  = kernel_data->lambda[efptVDW];
+    const real                 lamPower   = fr->sc_power;
+    const real                 scRPower   = fr->sc_r_power;
+
+    const bool                 doForces       = ((kernel_data->flags & GMX_NONBONDED_DO_FORCE) != 0);
+    const bool                 doShiftForces  = ((kernel_data->flags & GMX_NONBONDED_DO_SHIFTFORCE) != 0);
+    const bool                 doPotential    = ((kernel_data->flags & GMX_NONBONDED_DO_POTENTIAL) != 0);
+    const bool                 elecPotSwitch  = (ic->coulomb_modifier == eintmodPOTSWITCH);
+    const bool                 vdwPotSwitch   = (ic->vdw_modifier == eintmodPOTSWITCH);
+
+    const real                *ewtab          = ic->tabq_coul_FDV0;
+    const real                *tabEwaldFLJ    = ic->tabq_vdw_F;
+    const real                *tabEwaldVLJ    = ic->tabq_vdw_V;
+    const real                 ewtabscale     = (elecIsEwald || vdwIsLJEwald) ? ic->tabq_scale : 0;
+    const real                 ewtabhalfspace = (elecIsEwald || vdwIsLJEwald) ? 0.5/ic->tabq_scale : 0;
+
+    /* Lambda factors and their derivatives for state A and B */
+    real lfc[c_numStates], lfv[c_numStates], lfacCoul[c_numStates], lfacVdw[c_numStates];
+    real dlfacCoul[c_numStates], dlfacVdw[c_numStates];
+    const real dlf[c_numStates] = { -1, 1 };
+
+    lfc[0] = 1 - lambdaCoul;
+    lfv[0] = 1 - lambdaVdw;
+    lfc[1] = lambdaCoul;
+    lfv[1] = lambdaVdw;
+    for (int s = 0; s < c_numStates; s++)
+    {
+        lfacCoul[s]  = (lamPower == 2 ? (1 - lfc[s])*(1 - lfc[s]) : (1 - lfc[s]));
+        dlfacCoul[s] = dlf[s]*lamPower/scRPower*(lamPower == 2 ? (1 - lfc[s]) : 1);
+        lfacVdw[s]   = (lamPower == 2 ? (1 - lfv[s])*(1 - lfv[s]) : (1 - lfv[s]));
+        dlfacVdw[s]  = dlf[s]*lamPower/scRPower*(lamPower == 2 ? (1 - lfv[s]) : 1);
+    }
+
+    const SimdReal  zero = setZero();
+    const SimdReal  two(2.0);
+    const SimdReal  oneTwelfth(1.0/12.0);
+    const SimdReal  oneSixth(1.0/6.0);
+    const SimdReal  rcoulombS(rcoulomb);
+    const SimdReal  rvdwS(rvdw);
+    const SimdReal  krf(ic->k_rf);
+    const SimdReal  crf(ic->c_rf);
+    const SimdReal  shEwald(ic->sh_ewald);
+    const SimdReal  shInvrc6(ic->sh_invrc6);
+    const SimdReal  shLjEwald(ic->sh_lj_ewald);
+    const SimdReal  alphaCoul(fr->sc_alphacoul);
+    const SimdReal  alphaVdw(fr->sc_alphavdw);
+    const SimdReal  sigma6Def(fr->sc_sigma6_def);
+    const SimdReal  sigma6Min(fr->sc_sigma6_min);
+    const SimdReal  half(0.5);
+
+    const PotentialSwitch elecSwitch(elecPotSwitch ? ic->rcoulomb_switch : 0, ic->rcoulomb);
+    const PotentialSwitch vdwSwitch(vdwPotSwitch ? ic->rvdw_switch : 0, ic->rvdw);
+
+    alignas(GMX_SIMD_ALIGNMENT) real dxBuf[c_width], dyBuf[c_width], dzBuf[c_width];
+    alignas(GMX_SIMD_ALIGNMENT) real qqBuf[c_numStates][c_width];
+    alignas(GMX_SIMD_ALIGNMENT) real c6Buf[c_numStates][c_width];
+    alignas(GMX_SIMD_ALIGNMENT) real c12Buf[c_numStates][c_width];
+    alignas(GMX_SIMD_ALIGNMENT) real c6GridBuf[c_numStates][c_width];
+    alignas(GMX_SIMD_ALIGNMENT) real interactBuf[c_width];
+    alignas(GMX_SIMD_ALIGNMENT) real selfBuf[c_width];
+    alignas(GMX_SIMD_ALIGNMENT) real rBuf[c_width];
+    alignas(GMX_SIMD_ALIGNMENT) real fCoulLrBuf[c_width], vCoulLrBuf[c_width];
+    alignas(GMX_SIMD_ALIGNMENT) real fVdwLrBuf[c_width], vVdwLrBuf[c_width];
+    alignas(GMX_SIMD_ALIGNMENT) real txBuf[c_width], tyBuf[c_width], tzBuf[c_width];
+    bool withinCutoff[c_width];
+
+    double dvdlCoul = 0;
+    double dvdlVdw  = 0;
+
+    int    n;
+    for (n = 0; n < nlist->nri; n++)
+    {
+        const int  is3  = 3*shift[n];
+        const int  ii   = iinr[n];
+        const int  ii3  = 3*ii;
+        const real ix   = shiftvec[is3]   + x[ii3];
+        const real iy   = shiftvec[is3+1] + x[ii3+1];
+        const real iz   = shiftvec[is3+2] + x[ii3+2];
+        const real iqA  = facel*chargeA[ii];
+        const real iqB  = facel*chargeB[ii];
+        const int  ntiA = 2*ntype*typeA[ii];
+        const int  ntiB = 2*ntype*typeB[ii];
+
+        SimdReal   vCoulTot = zero;
+        SimdReal   vVdwTot  = zero;
+        SimdReal   dvdlCoulS = zero;
+        SimdReal   dvdlVdwS  = zero;
+        SimdReal   fix      = zero;
+        SimdReal   fiy      = zero;
+        SimdReal   fiz      = zero;
+        int        npairWithinCutoff = 0;
+
+        for (int k = jindex[n]; k < jindex[n+1]; k += c_width)
+        {
+            /* Gather the pair data, zero parameters for pairs beyond the cut-off
+             * and for padding lanes make those not contribute.
+             */
+            int numWithinCutoff = 0;
+            for (int l = 0; l < c_width; l++)
+            {
+                const int kl  = k + l;
+                withinCutoff[l] = false;
+                if (kl < jindex[n+1])
+                {
+                    const int  jnr = jjnr[kl];
+                    const int  j3  = 3*jnr;
+                    dxBuf[l]       = ix - x[j3];
+                    dyBuf[l]       = iy - x[j3+1];
+                    dzBuf[l]       = iz - x[j3+2];
+                    withinCutoff[l] = (dxBuf[l]*dxBuf[l] + dyBuf[l]*dyBuf[l] + dzBuf[l]*dzBuf[l] < rcutoffMax2);
+                    selfBuf[l]     = (ii == jnr) ? 0.5 : 1.0;
+                }
+                else
+                {
+                    dxBuf[l]       = 0;
+                    dyBuf[l]       = 0;
+                    dzBuf[l]       = 0;
+                    selfBuf[l]     = 1;
+                }
+                if (withinCutoff[l])
+                {
+                    const int jnr   = jjnr[kl];
+                    const int tjA   = ntiA + 2*typeA[jnr];
+                    const int tjB   = ntiB + 2*typeB[jnr];
+                    qqBuf[0][l]     = iqA*chargeA[jnr];
+                    qqBuf[1][l]     = iqB*chargeB[jnr];
+                    c6Buf[0][l]     = nbfp[tjA];
+                    c6Buf[1][l]     = nbfp[tjB];
+                    c12Buf[0][l]    = nbfp[tjA+1];
+                    c12Buf[1][l]    = nbfp[tjB+1];
+                    c6GridBuf[0][l] = vdwIsLJEwald ? nbfpGrid[tjA] : 0;
+                    c6GridBuf[1][l] = vdwIsLJEwald ? nbfpGrid[tjB] : 0;
+                    interactBuf[l]  = (exclFep == nullptr || exclFep[kl]) ? 1 : 0;
+                    numWithinCutoff++;
+                }
+                else
+                {
+                    for (int s = 0; s < c_numStates; s++)
+                    {
+                        qqBuf[s][l]     = 0;
+                        c6Buf[s][l]     = 0;
+                        c12Buf[s][l]    = 0;
+                        c6GridBuf[s][l] = 0;
+                    }
+                    interactBuf[l] = 0;
+                }
+            }
+            if (numWithinCutoff == 0)
+            {
+                /* We save significant time by skipping all code below.
+                 * Note that with soft-core interactions, the actual cut-off
+                 * check might be different. But since the soft-core distance
+                 * is always larger than r, checking on r here is safe.
+                 */
+                continue;
+            }
+            npairWithinCutoff += numWithinCutoff;
+
+            const SimdReal dx = load<SimdReal>(dxBuf);
+            const SimdReal dy = load<SimdReal>(dyBuf);
+            const SimdReal dz = load<SimdReal>(dzBuf);
+
+            PairDistance   pair;
+            pair.rsq         = norm2(dx, dy, dz);
+            pair.rsqPositive = (zero < pair.rsq);
+            /* The force at r=0 is zero, because of symmetry.
+             * But note that the potential is in general non-zero,
+             * since the soft-cored r will be non-zero.
+             */
+            pair.rInv        = maskzInvsqrt(pair.rsq, pair.rsqPositive);
+            pair.r           = pair.rsq*pair.rInv;
+            if (softCoreTreatment == SoftCoreTreatment::RPower48)
+            {
+                pair.logRsq  = selectByMask(log(blend(SimdReal(1.0), pair.rsq, pair.rsqPositive)),
+                                            pair.rsqPositive);
+            }
+
+            const SimdReal self     = load<SimdReal>(selfBuf);
+            const SimdReal interact = load<SimdReal>(interactBuf);
+            SimdReal       qq[c_numStates], c6[c_numStates], c12[c_numStates], c6Grid[c_numStates];
+            for (int s = 0; s < c_numStates; s++)
+            {
+                qq[s]     = load<SimdReal>(qqBuf[s]);
+                c6[s]     = load<SimdReal>(c6Buf[s]);
+                c12[s]    = load<SimdReal>(c12Buf[s]);
+                c6Grid[s] = load<SimdReal>(c6GridBuf[s]);
+            }
+
+            SimdReal       fScal        = zero;
+            const SimdBool interactMask = (zero < interact);
+
+            if (anyTrue(interactMask))
+            {
+                /* Only use soft-core if one of the states has a zero end state,
+                 * soft-core is for avoiding infinities.
+                 */
+                const SimdBool bothC12Positive = (zero < c12[0]) && (zero < c12[1]);
+                const SimdReal alphaCoulEff    = selectByNotMask(alphaCoul, bothC12Positive);
+                const SimdReal alphaVdwEff     = selectByNotMask(alphaVdw, bothC12Positive);
+
+                for (int s = 0; s < c_numStates; s++)
+                {
+                    /* c12 is stored scaled with 12.0 and c6 is scaled with 6.0 - correct for this */
+                    const SimdBool c6c12Positive = (zero < c6[s]) && (zero < c12[s]);
+                    SimdReal       sigma6        = half*c12[s]*maskzInv(c6[s], c6c12Positive);
+                    /* for disappearing coul and vdw with soft core at the same time */
+                    sigma6                       = blend(sigma6Def, max(sigma6, sigma6Min), c6c12Positive);
+
+                    const SimdBool haveQ         = (qq[s] != zero);
+                    const SimdBool haveLJ        = (c6[s] != zero) || (c12[s] != zero);
+                    const SimdBool stateMask     = interactMask && (haveQ || haveLJ);
+                    if (!anyTrue(stateMask))
+                    {
+                        continue;
+                    }
+
+                    const SoftCoreDistance rC =
+                        softCoreDistance<softCoreTreatment>(alphaCoulEff*SimdReal(lfacCoul[s]), sigma6, pair, stateMask);
+                    const SoftCoreDistance rV =
+                        softCoreDistance<softCoreTreatment>(alphaVdwEff*SimdReal(lfacVdw[s]), sigma6, pair, stateMask);
+
+                    /* Electrostatics, with Ewald only the 1/r part is soft-cored,
+                     * the reciprocal-space part is subtracted below.
+                     */
+                    SimdReal vCoul, fCoul;
+                    if (elecIsEwald)
+                    {
+                        vCoul = qq[s]*(rC.rInv - shEwald);
+                        fCoul = qq[s]*rC.rInv;
+                    }
+                    else
+                    {
+                        const SimdReal krfRsq = krf*rC.r*rC.r;
+                        vCoul = qq[s]*(rC.rInv + krfRsq - crf);
+                        fCoul = qq[s]*fnma(two, krfRsq, rC.rInv);
+                    }
+                    if (elecPotSwitch)
+                    {
+                        elecSwitch.apply(rC.r, &vCoul, &fCoul);
+                    }
+                    const SimdBool elecMask = stateMask && haveQ && ((elecIsEwald ? pair.r : rC.r) < rcoulombS);
+                    vCoul = selectByMask(vCoul, elecMask);
+                    fCoul = selectByMask(fCoul, elecMask);
+
+                    /* Van der Waals, with LJ-PME only the r^-6 grid part is soft-cored */
+                    const SimdReal vVdw6   = c6[s]*rV.rInv6;
+                    const SimdReal vVdw12  = c12[s]*rV.rInv6*rV.rInv6;
+                    SimdReal       vVdwSh6 = vVdw6 - c6[s]*shInvrc6;
+                    if (vdwIsLJEwald)
+                    {
+                        vVdwSh6 = vVdwSh6 - c6Grid[s]*shLjEwald;
+                    }
+                    SimdReal       vVdw = (vVdw12 - c12[s]*shInvrc6*shInvrc6)*oneTwelfth - vVdwSh6*oneSixth;
+                    SimdReal       fVdw = vVdw12 - vVdw6;
+                    if (vdwPotSwitch)
+                    {
+                        vdwSwitch.apply(rV.r, &vVdw, &fVdw);
+                    }
+                    const SimdBool vdwMask = stateMask && haveLJ && ((vdwIsLJEwald ? pair.r : rV.r) < rvdwS);
+                    vVdw = selectByMask(vVdw, vdwMask);
+                    fVdw = selectByMask(fVdw, vdwMask);
+
+                    /* fCoul (and fVdw) contain: dV/drC * rC
+                     * The force factor turns this into dV/drC * (r/rC)^1-p * r^-2,
+                     * which we multiply by the vector r further down.
+                     */
+                    const SimdReal lfcS(lfc[s]);
+                    const SimdReal lfvS(lfv[s]);
+                    vCoulTot  = fma(lfcS, vCoul, vCoulTot);
+                    vVdwTot   = fma(lfvS, vVdw, vVdwTot);
+                    fScal     = fma(lfcS*fCoul, rC.forceFactor, fScal);
+                    fScal     = fma(lfvS*fVdw, rV.forceFactor, fScal);
+                    dvdlCoulS = fma(SimdReal(dlf[s]), vCoul, dvdlCoulS);
+                    dvdlCoulS = fma(SimdReal(lfc[s]*dlfacCoul[s])*alphaCoulEff*fCoul, rC.dvdlFactor, dvdlCoulS);
+                    dvdlVdwS  = fma(SimdReal(dlf[s]), vVdw, dvdlVdwS);
+                    dvdlVdwS  = fma(SimdReal(lfv[s]*dlfacVdw[s])*alphaVdwEff*fVdw, rV.dvdlFactor, dvdlVdwS);
+                }
+            }
+
+            /* Linear combinations of the A and B state parameters */
+            const SimdReal qqLambda  = fma(SimdReal(lfc[0]), qq[0], SimdReal(lfc[1])*qq[1]);
+            const SimdReal qqDLambda = qq[1] - qq[0];
+
+            if (!elecIsEwald)
+            {
+                /* For excluded pairs, which are only in this pair list when
+                 * using the Verlet scheme, we don't use soft-core.
+                 * As there is no singularity, there is no need for soft-core.
+                 */
+                const SimdBool exclMask = (interact == zero);
+                const SimdReal vExcl    = selectByMask((krf*pair.rsq - crf)*self, exclMask);
+                const SimdReal fExcl    = selectByMask(-two*krf, exclMask);
+
+                vCoulTot  = fma(qqLambda, vExcl, vCoulTot);
+                fScal     = fma(qqLambda, fExcl, fScal);
+                dvdlCoulS = fma(qqDLambda, vExcl, dvdlCoulS);
+            }
+
+            if (elecIsEwald || vdwIsLJEwald)
+            {
+                /* Subtract the reciprocal-space Ewald components, which made it
+                 * possible to apply the soft-core to the plain 1/r and r^-6 terms
+                 * above. Note that any possible Ewald shift has already been
+                 * applied in the normal interaction part above.
+                 */
+                store(rBuf, pair.r);
+                for (int l = 0; l < c_width; l++)
+                {
+                    fCoulLrBuf[l] = 0;
+                    vCoulLrBuf[l] = 0;
+                    fVdwLrBuf[l]  = 0;
+                    vVdwLrBuf[l]  = 0;
+                    if (!withinCutoff[l])
+                    {
+                        continue;
+                    }
+                    if (elecIsEwald && rBuf[l] < rcoulomb)
+                    {
+                        const real ewrt   = rBuf[l]*ewtabscale;
+                        int        ewitab = static_cast<int>(ewrt);
+                        const real eweps  = ewrt - ewitab;
+                        ewitab            = 4*ewitab;
+                        fCoulLrBuf[l]     = ewtab[ewitab] + eweps*ewtab[ewitab+1];
+                        vCoulLrBuf[l]     = ewtab[ewitab+2] - ewtabhalfspace*eweps*(ewtab[ewitab] + fCoulLrBuf[l]);
+                    }
+                    if (vdwIsLJEwald && rBuf[l] < rvdw)
+                    {
+                        /* We could also use the analytical form here
+                         * iso a table, but that can cause issues for
+                         * r close to 0 for non-interacting pairs.
+                         */
+                        const real rs   = rBuf[l]*ewtabscale;
+                        const int  ri   = static_cast<int>(rs);
+                        const real frac = rs - ri;
+                        fVdwLrBuf[l]    = (1 - frac)*tabEwaldFLJ[ri] + frac*tabEwaldFLJ[ri+1];
+                        vVdwLrBuf[l]    = tabEwaldVLJ[ri] - ewtabhalfspace*frac*(tabEwaldFLJ[ri] + fVdwLrBuf[l]);
+                    }
+                }
+
+                if (elecIsEwald)
+                {
+                    /* Self-interactions occur twice, scale them by half */
+                    const SimdReal vLr = load<SimdReal>(vCoulLrBuf)*self;
+                    const SimdReal fLr = load<SimdReal>(fCoulLrBuf)*pair.rInv;
+
+                    vCoulTot  = fnma(qqLambda, vLr, vCoulTot);
+                    fScal     = fnma(qqLambda, fLr, fScal);
+                    dvdlCoulS = fnma(qqDLambda, vLr, dvdlCoulS);
+                }
+                if (vdwIsLJEwald)
+                {
+                    /* TODO: Currently the Ewald LJ table does not contain
+                     * the factor 1/6, we should add this.
+                     */
+                    const SimdReal c6GridLambda  = fma(SimdReal(lfv[0]), c6Grid[0], SimdReal(lfv[1])*c6Grid[1]);
+                    const SimdReal c6GridDLambda = c6Grid[1] - c6Grid[0];
+                    const SimdReal vLr           = load<SimdReal>(vVdwLrBuf)*oneSixth*self;
+                    const SimdReal fLr           = load<SimdReal>(fVdwLrBuf)*pair.rInv*oneSixth;
+
+                    vVdwTot  = fma(c6GridLambda, vLr, vVdwTot);
+                    fScal    = fma(c6GridLambda, fLr, fScal);
+                    dvdlVdwS = fma(c6GridDLambda, vLr, dvdlVdwS);
+                }
+            }
+
+            if (doForces)
+            {
+                const SimdReal tx = fScal*dx;
+                const SimdReal ty = fScal*dy;
+                const SimdReal tz = fScal*dz;
+                fix = fix + tx;
+                fiy = fiy + ty;
+                fiz = fiz + tz;
+                store(txBuf, tx);
+                store(tyBuf, ty);
+                store(tzBuf, tz);
+                for (int l = 0; l < c_width; l++)
+                {
+                    if (withinCutoff[l])
+                    {
+                        const int j3 = 3*jjnr[k + l];
+                        /* As in the reference kernel, we use atomics
+                         * instead of thread-local output buffers.
+                         */
+#pragma omp atomic
+                        f[j3]   -= txBuf[l];
+#pragma omp atomic
+                        f[j3+1] -= tyBuf[l];
+#pragma omp atomic
+                        f[j3+2] -= tzBuf[l];
+                    }
+                }
+            }
+        }
+
+        dvdlCoul += reduce(dvdlCoulS);
+        dvdlVdw  += reduce(dvdlVdwS);
+
+        /* The atomics below are expensive with many OpenMP threads.
+         * Here unperturbed i-particles will usually only have a few
+         * (perturbed) j-particles in the list. Thus with a buffered list
+         * we can skip a significant number of i-reductions with a check.
+         */
+        if (npairWithinCutoff > 0)
+        {
+            if (doForces || doShiftForces)
+            {
+                const real fixR = reduce(fix);
+                const real fiyR = reduce(fiy);
+                const real fizR = reduce(fiz);
+                if (doForces)
+                {
+#pragma omp atomic
+                    f[ii3]        += fixR;
+#pragma omp atomic
+                    f[ii3+1]      += fiyR;
+#pragma omp atomic
+                    f[ii3+2]      += fizR;
+                }
+                if (doShiftForces)
+                {
+#pragma omp atomic
+                    fshift[is3]   += fixR;
+#pragma omp atomic
+                    fshift[is3+1] += fiyR;
+#pragma omp atomic
+                    fshift[is3+2] += fizR;
+                }
+            }
+            if (doPotential)
+            {
+                const int  ggid  = gid[n];
+                const real vctot = reduce(vCoulTot);
+                const real vvtot = reduce(vVdwTot);
+#pragma omp atomic
+                kernel_data->energygrp_elec[ggid] += vctot;
+#pragma omp atomic
+                kernel_data->energygrp_vdw[ggid]  += vvtot;
+            }
+        }
+    }
+
+#pragma omp atomic
+    kernel_data->dvdl[efptCOUL] += dvdlCoul;
+#pragma omp atomic
+    kernel_data->dvdl[efptVDW]  += dvdlVdw;
+
+    /* Estimate flops, average for free energy stuff:
+     * 12  flops per outer iteration
+     * 150 flops per inner iteration
+     */
+#pragma omp atomic
+    inc_nrnb(nrnb, eNR_NBKERNEL_FREE_ENERGY, nlist->nri*12 + nlist->jindex[n]*150);
+}
+
+//! Pointer to a SIMD free-energy kernel instantiation
+using KernelFunction = void (*)(const t_nblist * gmx_restrict    nlist,
+                                rvec * gmx_restrict              xx,
+                                rvec * gmx_restrict              ff,
+                                t_forcerec * gmx_restrict        fr,
+                                const t_mdatoms * gmx_restrict   mdatoms,
+                                nb_kernel_data_t * gmx_restrict  kernel_data,
+                                t_nrnb * gmx_restrict            nrnb);
+
+//! Returns the kernel instantiation for the given soft-core and interaction types
+template<SoftCoreTreatment softCoreTreatment>
+static KernelFunction
+dispatchKernelOnInteractionTypes(bool elecIsEwald, bool vdwIsLJEwald)
+{
+    if (elecIsEwald)
+    {
+        return (vdwIsLJEwald ?
+                nbFreeEnergyKernelSimd<softCoreTreatment, true, true> :
+                nbFreeEnergyKernelSimd<softCoreTreatment, true, false>);
+    }
+    else
+    {
+        return (vdwIsLJEwald ?
+                nbFreeEnergyKernelSimd<softCoreTreatment, false, true> :
+                nbFreeEnergyKernelSimd<softCoreTreatment, false, false>);
+    }
+}
+
+#endif // GMX_SIMD_HAVE_REAL
+
+}      // namespace
+
+bool gmx_nb_free_energy_kernel_simd_supported(const t_forcerec *fr)
+{
+#if GMX_SIMD_HAVE_REAL
+    const interaction_const_t *ic = fr->ic;
+
+    /* The SIMD kernel assumes the Verlet setups set up in the reference
+     * kernel: converted Ewald and LJ-PME, so no potential-switch with these.
+     */
+    if (fr->cutoff_scheme != ecutsVERLET)
+    {
+        return false;
+    }
+    if (fr->sc_r_power != 6 && fr->sc_r_power != 48)
+    {
+        return false;
+    }
+    if (!(ic->eeltype == eelCUT || EEL_RF(ic->eeltype) ||
+          (EEL_PME_EWALD(ic->eeltype) && ic->coulomb_modifier != eintmodPOTSWITCH)))
+    {
+        return false;
+    }
+    if (EVDW_PME(ic->vdwtype) && ic->vdw_modifier == eintmodPOTSWITCH)
+    {
+        return false;
+    }
+
+    return true;
+#else
+    GMX_UNUSED_VALUE(fr);
+
+    return false;
+#endif
+}
+
+void
+gmx_nb_free_energy_kernel_simd(const t_nblist * gmx_restrict    nlist,
+                               rvec * gmx_restrict              xx,
+                               rvec * gmx_restrict              ff,
+                               t_forcerec * gmx_restrict        fr,
+                               const t_mdatoms * gmx_restrict   mdatoms,
+                               nb_kernel_data_t * gmx_restrict  kernel_data,
+                               t_nrnb * gmx_restrict            nrnb)
+{
+#if GMX_SIMD_HAVE_REAL
+    GMX_ASSERT(gmx_nb_free_energy_kernel_simd_supported(fr), "The SIMD free-energy kernel should support the setup");
+
+    const interaction_const_t *ic           = fr->ic;
+    const bool                 elecIsEwald  = EEL_PME_EWALD(ic->eeltype);
+    const bool                 vdwIsLJEwald = EVDW_PME(ic->vdwtype);
+
+    KernelFunction             kernel;
+    if (fr->sc_r_power == 6)
+    {
+        kernel = dispatchKernelOnInteractionTypes<SoftCoreTreatment::RPower6>(elecIsEwald, vdwIsLJEwald);
+    }
+    else
+    {
+        kernel = dispatchKernelOnInteractionTypes<SoftCoreTreatment::RPower48>(elecIsEwald, vdwIsLJEwald);
+    }
+    kernel(nlist, xx, ff, fr, mdatoms, kernel_data, nrnb);
+#else
+    GMX_UNUSED_VALUE(nlist);
+    GMX_UNUSED_VALUE(xx);
+    GMX_UNUSED_VALUE(ff);
+    GMX_UNUSED_VALUE(fr);
+    GMX_UNUSED_VALUE(mdatoms);
+    GMX_UNUSED_VALUE(kernel_data);
+    GMX_UNUSED_VALUE(nrnb);
+    gmx_incons("The SIMD free-energy kernel was called without SIMD support");
+#endif
+}
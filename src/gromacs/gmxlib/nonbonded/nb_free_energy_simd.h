@@ -0,0 +1,71 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+#ifndef GMX_GMXLIB_NONBONDED_NB_FREE_ENERGY_SIMD_H
+#define GMX_GMXLIB_NONBONDED_NB_FREE_ENERGY_SIMD_H
+
+#include "gromacs/gmxlib/nrnb.h"
+#include "gromacs/gmxlib/nonbonded/nb_kernel.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/mdtypes/mdatom.h"
+#include "gromacs/mdtypes/nblist.h"
+
+struct t_forcerec;
+
+/*! \brief Returns whether the SIMD free-energy kernel supports the setup in \p fr
+ *
+ * The SIMD kernel handles the Verlet scheme setups, i.e. (reaction-field)
+ * cut-off or Ewald electrostatics and plain or LJ-PME Van der Waals
+ * interactions, with soft-core r-power 6 or 48. Returns false when
+ * the build has no SIMD support.
+ */
+bool gmx_nb_free_energy_kernel_simd_supported(const t_forcerec *fr);
+
+/*! \brief SIMD free-energy kernel
+ *
+ * Computes the same interactions as gmx_nb_free_energy_kernel_reference(),
+ * processing GMX_SIMD_REAL_WIDTH j-particles of an i-entry at once.
+ * Should only be called when gmx_nb_free_energy_kernel_simd_supported()
+ * returns true.
+ */
+void
+    gmx_nb_free_energy_kernel_simd(const t_nblist * gmx_restrict    nlist,
+                                   rvec * gmx_restrict              xx,
+                                   rvec * gmx_restrict              ff,
+                                   t_forcerec * gmx_restrict        fr,
+                                   const t_mdatoms * gmx_restrict   mdatoms,
+                                   nb_kernel_data_t * gmx_restrict  kernel_data,
+                                   t_nrnb * gmx_restrict            nrnb);
+
+#endif
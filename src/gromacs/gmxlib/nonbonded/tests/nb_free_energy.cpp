@@ -0,0 +1,382 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests the free-energy non-bonded kernel against the plain-C reference.
+ */
+#include "gmxpre.h"
+
+#include "gromacs/gmxlib/nonbonded/nb_free_energy.h"
+
+#include <cmath>
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/ewald/ewald_utils.h"
+#include "gromacs/gmxlib/nrnb.h"
+#include "gromacs/gmxlib/nonbonded/nb_kernel.h"
+#include "gromacs/gmxlib/nonbonded/nonbonded.h"
+#include "gromacs/math/functions.h"
+#include "gromacs/math/units.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/mdlib/dispersioncorrection.h"
+#include "gromacs/mdlib/forcerec.h"
+#include "gromacs/mdtypes/forcerec.h"
+#include "gromacs/mdtypes/interaction_const.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/mdtypes/mdatom.h"
+#include "gromacs/mdtypes/nblist.h"
+#include "gromacs/nbnxm/nbnxm.h"
+#include "gromacs/pbcutil/ishift.h"
+#include "gromacs/random/threefry.h"
+#include "gromacs/random/uniformrealdistribution.h"
+#include "gromacs/utility/smalloc.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace
+{
+
+//! The number of atoms in the test system
+constexpr int  c_numAtoms         = 16;
+//! The number of perturbed atoms, these are the i-atoms of the pair list
+constexpr int  c_numPerturbedAtoms = 4;
+//! The number of atom types, the last type has no LJ interactions
+constexpr int  c_numTypes         = 3;
+//! The cut-off distance for all interactions
+constexpr real c_cutoff           = 1.0;
+
+//! Electrostatics types to test
+enum class ElecType
+{
+    ReactionField, Ewald
+};
+
+//! Van der Waals types to test
+enum class VdwType
+{
+    CutPotShift, CutPotSwitch, LJPme
+};
+
+/*! \brief Test parameters: soft-core r-power, soft-core alpha, lambda,
+ * electrostatics and Van der Waals types
+ */
+typedef std::tuple<real, real, real, ElecType, VdwType> FepKernelTestParameters;
+
+//! Output of a free-energy kernel call
+struct KernelOutput
+{
+    //! Forces
+    std::vector<RVec> f;
+    //! Shift forces
+    std::vector<RVec> fshift;
+    //! Coulomb energy
+    real              vCoul = 0;
+    //! Van der Waals energy
+    real              vVdw  = 0;
+    //! dV/dlambda for Coulomb and Van der Waals
+    real              dvdl[efptNR] = { 0 };
+};
+
+/*! \brief Test fixture that sets up a small system with perturbed atoms
+ *
+ * The first c_numPerturbedAtoms atoms lose their charges and LJ
+ * interactions in state B. The pair list contains, for each perturbed
+ * atom, all atoms with equal or higher index, with the self pair and
+ * the pair with the next atom excluded, as with the Verlet scheme.
+ */
+class FreeEnergyKernelTest : public ::testing::TestWithParam<FepKernelTestParameters>
+{
+    public:
+        FreeEnergyKernelTest()
+        {
+            ic_ = {};
+            nbl_ = {};
+
+            /* Place atoms pseudo-randomly in a cube of roughly the cut-off
+             * size, with two atoms close to a perturbed atom to test the
+             * soft-core at short distance.
+             */
+            ThreeFry2x64<64>                rng(123456, RandomDomain::Other);
+            UniformRealDistribution<real>   dist(0, 1.2);
+            x_.resize(c_numAtoms);
+            for (auto &x : x_)
+            {
+                x = { dist(rng), dist(rng), dist(rng) };
+            }
+            x_[c_numPerturbedAtoms]     = x_[0] + RVec(0.12, 0.02, 0);
+            x_[c_numPerturbedAtoms + 1] = x_[1] + RVec(0, 0.15, 0.1);
+
+            chargeA_.resize(c_numAtoms);
+            chargeB_.resize(c_numAtoms);
+            typeA_.resize(c_numAtoms);
+            typeB_.resize(c_numAtoms);
+            for (int a = 0; a < c_numAtoms; a++)
+            {
+                chargeA_[a] = (a % 2 == 0 ? 0.5 : -0.4);
+                typeA_[a]   = a % 2;
+                if (a < c_numPerturbedAtoms)
+                {
+                    chargeB_[a] = 0;
+                    typeB_[a]   = c_numTypes - 1;
+                }
+                else
+                {
+                    chargeB_[a] = chargeA_[a];
+                    typeB_[a]   = typeA_[a];
+                }
+            }
+
+            /* The parameters are stored scaled by 6 and 12 */
+            const real sigma[c_numTypes]   = { 0.3, 0.25, 0 };
+            const real epsilon[c_numTypes] = { 0.6, 0.4, 0 };
+            nbfp_.resize(2*c_numTypes*c_numTypes);
+            nbfpGrid_.resize(2*c_numTypes*c_numTypes);
+            for (int ti = 0; ti < c_numTypes; ti++)
+            {
+                for (int tj = 0; tj < c_numTypes; tj++)
+                {
+                    const real s       = 0.5*(sigma[ti] + sigma[tj]);
+                    const real e       = std::sqrt(epsilon[ti]*epsilon[tj]);
+                    const real s6      = gmx::power6(s);
+                    const int  index   = 2*(ti*c_numTypes + tj);
+                    nbfp_[index]       = 6*4*e*s6;
+                    nbfp_[index + 1]   = 12*4*e*s6*s6;
+                    nbfpGrid_[index]   = 0.9*nbfp_[index];
+                }
+            }
+
+            mdatoms_.chargeA = chargeA_.data();
+            mdatoms_.chargeB = chargeB_.data();
+            mdatoms_.typeA   = typeA_.data();
+            mdatoms_.typeB   = typeB_.data();
+
+            for (int i = 0; i < c_numPerturbedAtoms; i++)
+            {
+                iinr_.push_back(i);
+                gid_.push_back(0);
+                shift_.push_back(CENTRAL);
+                jindex_.push_back(jjnr_.size());
+                for (int j = i; j < c_numAtoms; j++)
+                {
+                    jjnr_.push_back(j);
+                    exclFep_.push_back(j == i || j == i + 1 ? 0 : 1);
+                }
+            }
+            jindex_.push_back(jjnr_.size());
+            nbl_.nri      = iinr_.size();
+            nbl_.nrj      = jjnr_.size();
+            nbl_.iinr     = iinr_.data();
+            nbl_.gid      = gid_.data();
+            nbl_.shift    = shift_.data();
+            nbl_.jindex   = jindex_.data();
+            nbl_.jjnr     = jjnr_.data();
+            nbl_.excl_fep = exclFep_.data();
+
+            shiftVec_.resize(SHIFTS, { 0, 0, 0 });
+        }
+
+        ~FreeEnergyKernelTest() override
+        {
+            sfree_aligned(ic_.tabq_coul_FDV0);
+            sfree_aligned(ic_.tabq_coul_F);
+            sfree_aligned(ic_.tabq_coul_V);
+            sfree_aligned(ic_.tabq_vdw_FDV0);
+            sfree_aligned(ic_.tabq_vdw_F);
+            sfree_aligned(ic_.tabq_vdw_V);
+        }
+
+        //! Sets up the interaction constants and soft-core parameters
+        void setupInteractions(real scRPower, real scAlpha, ElecType elecType, VdwType vdwType)
+        {
+            ic_.cutoff_scheme    = ecutsVERLET;
+            ic_.rcoulomb         = c_cutoff;
+            ic_.rvdw             = c_cutoff;
+            ic_.epsfac           = ONE_4PI_EPS0;
+            ic_.coulomb_modifier = eintmodPOTSHIFT;
+            if (elecType == ElecType::ReactionField)
+            {
+                ic_.eeltype      = eelRF;
+                ic_.k_rf         = 1/(2*gmx::power3(c_cutoff));
+                ic_.c_rf         = 1/c_cutoff + ic_.k_rf*c_cutoff*c_cutoff;
+            }
+            else
+            {
+                ic_.eeltype      = eelPME;
+                ic_.ewaldcoeff_q = calc_ewaldcoeff_q(c_cutoff, 1e-5);
+                ic_.sh_ewald     = std::erfc(ic_.ewaldcoeff_q*c_cutoff)/c_cutoff;
+            }
+            ic_.vdwtype          = evdwCUT;
+            ic_.vdw_modifier     = eintmodPOTSHIFT;
+            ic_.sh_invrc6        = 1/gmx::power6(c_cutoff);
+            if (vdwType == VdwType::CutPotSwitch)
+            {
+                ic_.vdw_modifier = eintmodPOTSWITCH;
+                ic_.rvdw_switch  = 0.8;
+                ic_.sh_invrc6    = 0;
+            }
+            else if (vdwType == VdwType::LJPme)
+            {
+                ic_.vdwtype       = evdwPME;
+                ic_.ewaldcoeff_lj = calc_ewaldcoeff_lj(c_cutoff, 1e-3);
+                const real br2    = gmx::square(ic_.ewaldcoeff_lj*c_cutoff);
+                ic_.sh_lj_ewald   = (std::exp(-br2)*(1 + br2 + 0.5*br2*br2) - 1)/gmx::power6(c_cutoff);
+            }
+            init_interaction_const_tables(nullptr, &ic_, 0);
+
+            fr_.ic            = &ic_;
+            fr_.cutoff_scheme = ecutsVERLET;
+            fr_.ntype         = c_numTypes;
+            fr_.nbfp          = nbfp_.data();
+            fr_.ljpme_c6grid  = nbfpGrid_.data();
+            fr_.shift_vec     = as_rvec_array(shiftVec_.data());
+            fr_.sc_alphacoul  = scAlpha;
+            fr_.sc_alphavdw   = scAlpha;
+            fr_.sc_power      = 1;
+            fr_.sc_r_power    = scRPower;
+            fr_.sc_sigma6_def = gmx::power6(0.3);
+            fr_.sc_sigma6_min = gmx::power6(0.25);
+        }
+
+        //! Runs \p kernel at \p lambda and returns the output
+        KernelOutput runKernel(decltype(&gmx_nb_free_energy_kernel) kernel, real lambda)
+        {
+            KernelOutput output;
+            output.f.resize(c_numAtoms, { 0, 0, 0 });
+            output.fshift.resize(SHIFTS, { 0, 0, 0 });
+            fr_.fshift = as_rvec_array(output.fshift.data());
+
+            real             lambdas[efptNR] = { 0 };
+            lambdas[efptCOUL] = lambda;
+            lambdas[efptVDW]  = lambda;
+
+            nb_kernel_data_t kernelData = {};
+            kernelData.flags            = (GMX_NONBONDED_DO_SR | GMX_NONBONDED_DO_FORCE |
+                                           GMX_NONBONDED_DO_SHIFTFORCE | GMX_NONBONDED_DO_POTENTIAL);
+            kernelData.lambda           = lambdas;
+            kernelData.dvdl             = output.dvdl;
+            kernelData.energygrp_elec   = &output.vCoul;
+            kernelData.energygrp_vdw    = &output.vVdw;
+
+            t_nrnb nrnb;
+            init_nrnb(&nrnb);
+
+            kernel(&nbl_, as_rvec_array(x_.data()), as_rvec_array(output.f.data()),
+                   &fr_, &mdatoms_, &kernelData, &nrnb);
+
+            return output;
+        }
+
+        std::vector<RVec>   x_;
+        std::vector<real>   chargeA_, chargeB_;
+        std::vector<int>    typeA_, typeB_;
+        std::vector<real>   nbfp_, nbfpGrid_;
+        std::vector<int>    iinr_, gid_, shift_, jindex_, jjnr_;
+        std::vector<char>   exclFep_;
+        std::vector<RVec>   shiftVec_;
+        interaction_const_t ic_;
+        t_forcerec          fr_;
+        t_mdatoms           mdatoms_ = {};
+        t_nblist            nbl_;
+};
+
+//! Returns the largest absolute force component in \p f
+real maxAbsForceComponent(const std::vector<RVec> &f)
+{
+    real fMax = 0;
+    for (const auto &fi : f)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            fMax = std::max(fMax, std::abs(fi[d]));
+        }
+    }
+    return fMax;
+}
+
+TEST_P(FreeEnergyKernelTest, MatchesReferenceKernel)
+{
+    real     scRPower, scAlpha, lambda;
+    ElecType elecType;
+    VdwType  vdwType;
+    std::tie(scRPower, scAlpha, lambda, elecType, vdwType) = GetParam();
+
+    setupInteractions(scRPower, scAlpha, elecType, vdwType);
+
+    const KernelOutput reference = runKernel(gmx_nb_free_energy_kernel_reference, lambda);
+    const KernelOutput output    = runKernel(gmx_nb_free_energy_kernel, lambda);
+
+    /* The kernels use different, but equally accurate, math for the
+     * soft-core powers, so we compare relative to the magnitudes.
+     */
+    const real relTol = (GMX_DOUBLE ? 1e-9 : 5e-5);
+    const real fMax   = maxAbsForceComponent(reference.f);
+    const auto fTol   = test::relativeToleranceAsFloatingPoint(fMax, relTol);
+    for (int a = 0; a < c_numAtoms; a++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_REAL_EQ_TOL(reference.f[a][d], output.f[a][d], fTol) << "atom " << a << " dim " << d;
+        }
+    }
+    for (int d = 0; d < DIM; d++)
+    {
+        EXPECT_REAL_EQ_TOL(reference.fshift[CENTRAL][d], output.fshift[CENTRAL][d], fTol);
+    }
+    EXPECT_REAL_EQ_TOL(reference.vCoul, output.vCoul,
+                       test::relativeToleranceAsFloatingPoint(reference.vCoul, relTol));
+    EXPECT_REAL_EQ_TOL(reference.vVdw, output.vVdw,
+                       test::relativeToleranceAsFloatingPoint(reference.vVdw, relTol));
+    EXPECT_REAL_EQ_TOL(reference.dvdl[efptCOUL], output.dvdl[efptCOUL],
+                       test::relativeToleranceAsFloatingPoint(reference.dvdl[efptCOUL], relTol));
+    EXPECT_REAL_EQ_TOL(reference.dvdl[efptVDW], output.dvdl[efptVDW],
+                       test::relativeToleranceAsFloatingPoint(reference.dvdl[efptVDW], relTol));
+}
+
+INSTANTIATE_TEST_CASE_P(SoftCore, FreeEnergyKernelTest,
+                            ::testing::Combine(::testing::Values(6, 48),
+                                                   ::testing::Values(0, 0.5),
+                                                   ::testing::Values(0, 0.35, 1),
+                                                   ::testing::Values(ElecType::ReactionField, ElecType::Ewald),
+                                                   ::testing::Values(VdwType::CutPotShift, VdwType::CutPotSwitch, VdwType::LJPme)));
+
+}      // namespace
+}      // namespace gmx
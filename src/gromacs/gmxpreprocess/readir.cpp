@@ -45,6 +45,7 @@
 
 #include <algorithm>
 #include <string>
+#include <utility>
 
 #include "gromacs/awh/read_params.h"
 #include "gromacs/fileio/readinp.h"
@@ -102,7 +103,7 @@ typedef struct t_inputrec_strings
          energy[STRLEN], user1[STRLEN], user2[STRLEN], vcm[STRLEN], x_compressed_groups[STRLEN],
          couple_moltype[STRLEN], orirefitgrp[STRLEN], egptable[STRLEN], egpexcl[STRLEN],
          wall_atomtype[STRLEN], wall_density[STRLEN], deform[STRLEN], QMMM[STRLEN],
-         imd_grp[STRLEN];
+         imd_grp[STRLEN], mtsLevel2Forces[STRLEN];
     char   fep_lambda[efptNR][STRLEN];
     char   lambda_weights[STRLEN];
     char **pull_grp;
@@ -1353,6 +1354,55 @@ void check_ir(const char *mdparin, t_inputrec *ir, t_gromppopts *opts,
     {
         gmx_fatal(FARGS, "AdResS simulations are no longer supported");
     }
+
+    if (ir->useMts)
+    {
+        sprintf(err_buf, "Multiple time stepping is only supported with integrator %s",
+                ei_names[eiMD]);
+        CHECK(ir->eI != eiMD);
+        sprintf(err_buf, "mts-level2-factor should be larger than 0");
+        CHECK(ir->mtsFactor < 1);
+        sprintf(err_buf, "With multiple time stepping, mts-level2-forces should contain at least one force group");
+        CHECK(ir->mtsLevel2Forces == 0);
+        if (ir->mtsFactor >= 1)
+        {
+            /* Energies, virials and output forces are only complete
+             * at steps where the level-2 forces are computed.
+             */
+            const std::pair<const char *, int> nstValues[] = {
+                { "nstcalcenergy", ir->nstcalcenergy },
+                { "nstenergy", ir->nstenergy },
+                { "nstlog", ir->nstlog },
+                { "nstfout", ir->nstfout },
+                { "nstdhdl", ir->efep != efepNO ? ir->fepvals->nstdhdl : 0 },
+                { "nstpcouple", ir->epc != epcNO ? ir->nstpcouple : 0 }
+            };
+            for (const auto &nstValue : nstValues)
+            {
+                sprintf(err_buf, "With multiple time stepping, %s should be a multiple of mts-level2-factor=%d",
+                        nstValue.first, ir->mtsFactor);
+                CHECK(nstValue.second % ir->mtsFactor != 0);
+            }
+        }
+        if (isMtsLevel2Force(*ir, emtsLONGRANGE_NONBONDED))
+        {
+            sprintf(err_buf, "With long-range nonbonded forces in mts-level2-forces, coulombtype or vdwtype should use a lattice sum method");
+            CHECK(!EEL_FULL(ir->coulombtype) && !EVDW_PME(ir->vdwtype));
+        }
+        if (isMtsLevel2Force(*ir, emtsPULL))
+        {
+            sprintf(err_buf, "With pull forces in mts-level2-forces, pulling should be active");
+            CHECK(!ir->bPull);
+            sprintf(err_buf, "Multiple time stepping of pull forces is not supported with AWH");
+            CHECK(ir->bDoAwh);
+            if (ir->bPull)
+            {
+                sprintf(err_buf, "With pull forces in mts-level2-forces, pull-nstxout and pull-nstfout should be multiples of mts-level2-factor=%d",
+                        ir->mtsFactor);
+                CHECK(ir->pull->nstxout % ir->mtsFactor != 0 || ir->pull->nstfout % ir->mtsFactor != 0);
+            }
+        }
+    }
 }
 
 /* interpret a number of doubles from a string and put them in an array,
@@ -1865,6 +1915,11 @@ void get_ir(const char *mdparin, const char *mdparout,
     ir->init_step = get_eint64(&inp, "init-step",  0, wi);
     printStringNoNewline(&inp, "Part index is updated automatically on checkpointing (keeps files separate)");
     ir->simulation_part = get_eint(&inp, "simulation-part", 1, wi);
+    printStringNoNewline(&inp, "Multiple time-stepping");
+    ir->useMts = (get_eeenum(&inp, "mts", yesno_names, wi) != 0);
+    printStringNoNewline(&inp, "Force groups computed only every mts-level2-factor steps");
+    setStringEntry(&inp, "mts-level2-forces", is->mtsLevel2Forces, "longrange-nonbonded");
+    ir->mtsFactor = get_eint(&inp, "mts-level2-factor", 2, wi);
     printStringNoNewline(&inp, "mode for center of mass motion removal");
     ir->comm_mode = get_eeenum(&inp, "comm-mode",  ecm_names, wi);
     printStringNoNewline(&inp, "number of steps for center of mass motion removal");
@@ -2491,6 +2546,40 @@ void get_ir(const char *mdparin, const char *mdparout,
         ir->fepvals->n_lambda = 0;
     }
 
+    /* MULTIPLE TIME STEPPING */
+
+    ir->mtsLevel2Forces = 0;
+    if (ir->useMts)
+    {
+        for (const auto &forceGroupName : gmx::splitString(is->mtsLevel2Forces))
+        {
+            int forceGroup = 0;
+            while (forceGroup < emtsNR &&
+                   gmx_strcasecmp(forceGroupName.c_str(), emts_names[forceGroup]) != 0)
+            {
+                forceGroup++;
+            }
+            if (forceGroup < emtsNR)
+            {
+                ir->mtsLevel2Forces |= (1 << forceGroup);
+            }
+            else
+            {
+                sprintf(warn_buf, "Unknown mts-level2-forces entry '%s', options are:",
+                        forceGroupName.c_str());
+                for (int g = 0; g < emtsNR; g++)
+                {
+                    sprintf(warn_buf + strlen(warn_buf), " %s", emts_names[g]);
+                }
+                warning_error(wi, warn_buf);
+            }
+        }
+    }
+    else
+    {
+        ir->mtsFactor = 1;
+    }
+
     /* WALL PARAMETERS */
 
     do_wall_params(ir, is->wall_atomtype, is->wall_density, opts, wi);
@@ -69,6 +69,7 @@
 #include "gromacs/simd/vector_operations.h"
 #include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/real.h"
 #include "gromacs/utility/smalloc.h"
 
@@ -114,6 +115,118 @@ static int pbc_rvec_sub(const t_pbc *pbc, const rvec xi, const rvec xj, rvec dx)
     }
 }
 
+#if GMX_SIMD_HAVE_REAL
+
+/*! \brief Periodic shift of SIMD distance vectors
+ *
+ * The number of box vectors along each box vector that
+ * pbc_correct_dx_simd() subtracted from the distances.
+ */
+struct SimdPbcShift
+{
+    SimdReal x; //!< Shift along the first box vector
+    SimdReal y; //!< Shift along the second box vector
+    SimdReal z; //!< Shift along the third box vector
+};
+
+//! Corrects \p dx, \p dy, \p dz for PBC and returns the shift that was subtracted
+static inline SimdPbcShift gmx_simdcall
+pbcCorrectDxWithShift(SimdReal *dx, SimdReal *dy, SimdReal *dz, const real *pbc_simd)
+{
+    SimdPbcShift shift;
+
+    pbc_correct_dx_simd(dx, dy, dz, pbc_simd, &shift.x, &shift.y, &shift.z);
+
+    return shift;
+}
+
+//! Returns the shift of the distance vector pointing in the opposite direction
+static inline SimdPbcShift gmx_simdcall
+operator-(const SimdPbcShift &shift)
+{
+    return { -shift.x, -shift.y, -shift.z };
+}
+
+//! Which quantities the SIMD bonded kernels compute
+enum class BondedKernelFlavor
+{
+    ForcesOnly,              //!< Only forces
+    ForcesAndVirialAndEnergy //!< Forces, shift forces and energies
+};
+
+/*! \brief Adds shift forces for forces computed with SIMD
+ *
+ * Adds the force \p fx, \p fy, \p fz acting on atom ai[s] in lane s
+ * to the shift vector of ai[s] relative to aj[s] and subtracts it from
+ * the central shift vector. Calling this for all atoms of an interaction
+ * but the reference atom aj gives the same virial as the plain-C kernels,
+ * which add the force on aj to the central shift vector.
+ * Without a graph, the shift index is computed in SIMD from \p pbcShift,
+ * the shift pbc_correct_dx_simd() subtracted from x[ai[s]] - x[aj[s]],
+ * and we return after a single SIMD test when all lanes are central.
+ * With a graph, the shift indices are taken from the graph.
+ * Lanes of padding entries should have zero force.
+ */
+static void gmx_simdcall
+addShiftForcesSimd(const int *ai, const int *aj,
+                   SimdReal fx, SimdReal fy, SimdReal fz,
+                   const SimdPbcShift &pbcShift, const t_graph *g,
+                   rvec fshift[])
+{
+    alignas(GMX_SIMD_ALIGNMENT) real fbuf[DIM*GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real tbuf[GMX_SIMD_REAL_WIDTH];
+
+    if (g == nullptr)
+    {
+        const SimdReal zero_S = setZero();
+
+        /* Central contributions cancel */
+        if (!anyTrue(pbcShift.x != zero_S || pbcShift.y != zero_S || pbcShift.z != zero_S))
+        {
+            return;
+        }
+
+        /* The image of ai used is minus the shift, so this is XYZ2IS(-shift) */
+        const SimdReal t_S = fma(SimdReal(N_BOX_X),
+                                 fma(SimdReal(N_BOX_Y), SimdReal(D_BOX_Z) - pbcShift.z,
+                                     SimdReal(D_BOX_Y) - pbcShift.y),
+                                 SimdReal(D_BOX_X) - pbcShift.x);
+        store(tbuf, t_S);
+    }
+
+    store(fbuf + XX*GMX_SIMD_REAL_WIDTH, fx);
+    store(fbuf + YY*GMX_SIMD_REAL_WIDTH, fy);
+    store(fbuf + ZZ*GMX_SIMD_REAL_WIDTH, fz);
+
+    for (int s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+    {
+        int t;
+        if (g == nullptr)
+        {
+            t = static_cast<int>(tbuf[s]);
+        }
+        else
+        {
+            ivec dt;
+
+            ivec_sub(SHIFT_IVEC(g, ai[s]), SHIFT_IVEC(g, aj[s]), dt);
+            t = IVEC2IS(dt);
+        }
+        GMX_ASSERT(t >= 0 && t < N_IVEC, "Periodic shifts in bonded interactions should be within the shift range");
+
+        if (t != CENTRAL)
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                fshift[t][d]       += fbuf[d*GMX_SIMD_REAL_WIDTH + s];
+                fshift[CENTRAL][d] -= fbuf[d*GMX_SIMD_REAL_WIDTH + s];
+            }
+        }
+    }
+}
+
+#endif // GMX_SIMD_HAVE_REAL
+
 /*! \brief Morse potential bond
  *
  * By Frank Everdij. Three parameters needed:
@@ -413,6 +526,108 @@ real bonds(int nbonds,
     return vtot;
 }
 
+#if GMX_SIMD_HAVE_REAL
+
+/* As bonds, but using SIMD to calculate many bonds at once.
+ * Only uses the A-state parameters, so this can not be used with
+ * perturbed interactions. Energies and shift forces are computed
+ * only with flavor ForcesAndVirialAndEnergy.
+ */
+template <BondedKernelFlavor flavor>
+static real
+bonds_simd(int nbonds,
+           const t_iatom forceatoms[], const t_iparams forceparams[],
+           const rvec x[], rvec4 f[], rvec fshift[],
+           const t_pbc *pbc, const t_graph *g,
+           real gmx_unused lambda, real gmx_unused *dvdlambda,
+           const t_mdatoms gmx_unused *md, t_fcdata gmx_unused *fcd,
+           int gmx_unused *global_atom_index)
+{
+    constexpr int            nfa1 = 3;
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t    ai[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t    aj[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real            coeff[2*GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real            pbc_simd[9*GMX_SIMD_REAL_WIDTH];
+
+    set_pbc_simd(pbc, pbc_simd);
+
+    SimdReal vtot_S = setZero();
+
+    /* nbonds is the number of bonds times nfa1, here we step GMX_SIMD_REAL_WIDTH bonds */
+    for (int i = 0; i < nbonds; i += GMX_SIMD_REAL_WIDTH*nfa1)
+    {
+        /* Collect atoms pairs for GMX_SIMD_REAL_WIDTH bonds.
+         * iu indexes into forceatoms, we should not let iu go beyond nbonds.
+         */
+        int iu = i;
+        for (int s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+        {
+            const int type = forceatoms[iu];
+            ai[s] = forceatoms[iu+1];
+            aj[s] = forceatoms[iu+2];
+
+            /* At the end fill the arrays with the last atoms and 0 params */
+            if (i + s*nfa1 < nbonds)
+            {
+                coeff[s]                     = forceparams[type].harmonic.krA;
+                coeff[GMX_SIMD_REAL_WIDTH+s] = forceparams[type].harmonic.rA;
+
+                if (iu + nfa1 < nbonds)
+                {
+                    iu += nfa1;
+                }
+            }
+            else
+            {
+                coeff[s]                     = 0;
+                coeff[GMX_SIMD_REAL_WIDTH+s] = 0;
+            }
+        }
+
+        SimdReal xi_S, yi_S, zi_S;
+        SimdReal xj_S, yj_S, zj_S;
+
+        /* Store the non PBC corrected distances packed and aligned */
+        gatherLoadUTranspose<3>(reinterpret_cast<const real *>(x), ai, &xi_S, &yi_S, &zi_S);
+        gatherLoadUTranspose<3>(reinterpret_cast<const real *>(x), aj, &xj_S, &yj_S, &zj_S);
+        SimdReal       dx_S = xi_S - xj_S;
+        SimdReal       dy_S = yi_S - yj_S;
+        SimdReal       dz_S = zi_S - zj_S;
+
+        const SimdReal k_S  = load<SimdReal>(coeff);
+        const SimdReal b0_S = load<SimdReal>(coeff+GMX_SIMD_REAL_WIDTH);
+
+        const SimdPbcShift shift_S = pbcCorrectDxWithShift(&dx_S, &dy_S, &dz_S, pbc_simd);
+
+        const SimdReal dr2_S    = norm2(dx_S, dy_S, dz_S);
+
+        /* As the plain-C code, skip bonds of zero length */
+        const SimdBool nonzero  = (setZero() < dr2_S);
+        const SimdReal invdr_S  = maskzInvsqrt(dr2_S, nonzero);
+        const SimdReal dr_S     = dr2_S * invdr_S;
+        const SimdReal ddr_S    = dr_S - b0_S;
+
+        const SimdReal fscal_S  = -k_S * ddr_S * invdr_S;
+        const SimdReal fx_S     = fscal_S * dx_S;
+        const SimdReal fy_S     = fscal_S * dy_S;
+        const SimdReal fz_S     = fscal_S * dz_S;
+
+        transposeScatterIncrU<4>(reinterpret_cast<real *>(f), ai, fx_S, fy_S, fz_S);
+        transposeScatterDecrU<4>(reinterpret_cast<real *>(f), aj, fx_S, fy_S, fz_S);
+
+        if (flavor == BondedKernelFlavor::ForcesAndVirialAndEnergy)
+        {
+            vtot_S = vtot_S + selectByMask(0.5 * k_S * ddr_S * ddr_S, nonzero);
+
+            addShiftForcesSimd(ai, aj, fx_S, fy_S, fz_S, shift_S, g, fshift);
+        }
+    }
+
+    return reduce(vtot_S);
+}
+
+#endif // GMX_SIMD_HAVE_REAL
+
 real restraint_bonds(int nbonds,
                      const t_iatom forceatoms[], const t_iparams forceparams[],
                      const rvec x[], rvec4 f[], rvec fshift[],
@@ -896,16 +1111,18 @@ real angles(int nbonds,
 #if GMX_SIMD_HAVE_REAL
 
 /* As angles, but using SIMD to calculate many angles at once.
- * This routines does not calculate energies and shift forces.
+ * Only uses the A-state parameters. Energies and shift forces are
+ * computed only with flavor ForcesAndVirialAndEnergy.
  */
-void
-angles_noener_simd(int nbonds,
-                   const t_iatom forceatoms[], const t_iparams forceparams[],
-                   const rvec x[], rvec4 f[],
-                   const t_pbc *pbc, const t_graph gmx_unused *g,
-                   real gmx_unused lambda,
-                   const t_mdatoms gmx_unused *md, t_fcdata gmx_unused *fcd,
-                   int gmx_unused *global_atom_index)
+template <BondedKernelFlavor flavor>
+static real
+angles_simd(int nbonds,
+            const t_iatom forceatoms[], const t_iparams forceparams[],
+            const rvec x[], rvec4 f[], rvec fshift[],
+            const t_pbc *pbc, const t_graph *g,
+            real gmx_unused lambda, real gmx_unused *dvdlambda,
+            const t_mdatoms gmx_unused *md, t_fcdata gmx_unused *fcd,
+            int gmx_unused *global_atom_index)
 {
     const int            nfa1 = 4;
     int                  i, iu, s;
@@ -933,6 +1150,7 @@ angles_noener_simd(int nbonds,
     SimdReal             cik_S, cii_S, ckk_S;
     SimdReal             f_ix_S, f_iy_S, f_iz_S;
     SimdReal             f_kx_S, f_ky_S, f_kz_S;
+    SimdReal             vtot_S = setZero();
     alignas(GMX_SIMD_ALIGNMENT) real    pbc_simd[9*GMX_SIMD_REAL_WIDTH];
 
     set_pbc_simd(pbc, pbc_simd);
@@ -983,8 +1201,8 @@ angles_noener_simd(int nbonds,
         k_S       = load<SimdReal>(coeff);
         theta0_S  = load<SimdReal>(coeff+GMX_SIMD_REAL_WIDTH) * deg2rad_S;
 
-        pbc_correct_dx_simd(&rijx_S, &rijy_S, &rijz_S, pbc_simd);
-        pbc_correct_dx_simd(&rkjx_S, &rkjy_S, &rkjz_S, pbc_simd);
+        const SimdPbcShift shift_ij_S = pbcCorrectDxWithShift(&rijx_S, &rijy_S, &rijz_S, pbc_simd);
+        const SimdPbcShift shift_kj_S = pbcCorrectDxWithShift(&rkjx_S, &rkjy_S, &rkjz_S, pbc_simd);
 
         rij_rkj_S = iprod(rijx_S, rijy_S, rijz_S,
                           rkjx_S, rkjy_S, rkjz_S);
@@ -1033,7 +1251,19 @@ angles_noener_simd(int nbonds,
         transposeScatterIncrU<4>(reinterpret_cast<real *>(f), ai, f_ix_S, f_iy_S, f_iz_S);
         transposeScatterDecrU<4>(reinterpret_cast<real *>(f), aj, f_ix_S + f_kx_S, f_iy_S + f_ky_S, f_iz_S + f_kz_S);
         transposeScatterIncrU<4>(reinterpret_cast<real *>(f), ak, f_kx_S, f_ky_S, f_kz_S);
+
+        if (flavor == BondedKernelFlavor::ForcesAndVirialAndEnergy)
+        {
+            const SimdReal dtheta_S = theta_S - theta0_S;
+
+            vtot_S = fma(0.5 * k_S * dtheta_S, dtheta_S, vtot_S);
+
+            addShiftForcesSimd(ai, aj, f_ix_S, f_iy_S, f_iz_S, shift_ij_S, g, fshift);
+            addShiftForcesSimd(ak, aj, f_kx_S, f_ky_S, f_kz_S, shift_kj_S, g, fshift);
+        }
     }
+
+    return reduce(vtot_S);
 }
 
 #endif // GMX_SIMD_HAVE_REAL
@@ -1219,15 +1449,18 @@ real urey_bradley(int nbonds,
 #if GMX_SIMD_HAVE_REAL
 
 /* As urey_bradley, but using SIMD to calculate many potentials at once.
- * This routines does not calculate energies and shift forces.
+ * Only uses the A-state parameters. Energies and shift forces are
+ * computed only with flavor ForcesAndVirialAndEnergy.
  */
-void urey_bradley_noener_simd(int nbonds,
-                              const t_iatom forceatoms[], const t_iparams forceparams[],
-                              const rvec x[], rvec4 f[],
-                              const t_pbc *pbc, const t_graph gmx_unused *g,
-                              real gmx_unused lambda,
-                              const t_mdatoms gmx_unused *md, t_fcdata gmx_unused *fcd,
-                              int gmx_unused *global_atom_index)
+template <BondedKernelFlavor flavor>
+static real
+urey_bradley_simd(int nbonds,
+                  const t_iatom forceatoms[], const t_iparams forceparams[],
+                  const rvec x[], rvec4 f[], rvec fshift[],
+                  const t_pbc *pbc, const t_graph *g,
+                  real gmx_unused lambda, real gmx_unused *dvdlambda,
+                  const t_mdatoms gmx_unused *md, t_fcdata gmx_unused *fcd,
+                  int gmx_unused *global_atom_index)
 {
     constexpr int            nfa1 = 4;
     alignas(GMX_SIMD_ALIGNMENT) std::int32_t    ai[GMX_SIMD_REAL_WIDTH];
@@ -1238,6 +1471,8 @@ void urey_bradley_noener_simd(int nbonds,
 
     set_pbc_simd(pbc, pbc_simd);
 
+    SimdReal vtot_S = setZero();
+
     /* nbonds is the number of angles times nfa1, here we step GMX_SIMD_REAL_WIDTH angles */
     for (int i = 0; i < nbonds; i += GMX_SIMD_REAL_WIDTH*nfa1)
     {
@@ -1297,8 +1532,8 @@ void urey_bradley_noener_simd(int nbonds,
         const SimdReal kUB_S    = load<SimdReal>(coeff+2*GMX_SIMD_REAL_WIDTH);
         const SimdReal r13_S    = load<SimdReal>(coeff+3*GMX_SIMD_REAL_WIDTH);
 
-        pbc_correct_dx_simd(&rijx_S, &rijy_S, &rijz_S, pbc_simd);
-        pbc_correct_dx_simd(&rkjx_S, &rkjy_S, &rkjz_S, pbc_simd);
+        const SimdPbcShift shift_ij_S = pbcCorrectDxWithShift(&rijx_S, &rijy_S, &rijz_S, pbc_simd);
+        const SimdPbcShift shift_kj_S = pbcCorrectDxWithShift(&rkjx_S, &rkjy_S, &rkjz_S, pbc_simd);
         pbc_correct_dx_simd(&rikx_S, &riky_S, &rikz_S, pbc_simd);
 
         const SimdReal rij_rkj_S = iprod(rijx_S, rijy_S, rijz_S,
@@ -1351,7 +1586,21 @@ void urey_bradley_noener_simd(int nbonds,
         transposeScatterIncrU<4>(reinterpret_cast<real *>(f), ai, f_ix_S, f_iy_S, f_iz_S);
         transposeScatterDecrU<4>(reinterpret_cast<real *>(f), aj, f_ix_S + f_kx_S, f_iy_S + f_ky_S, f_iz_S + f_kz_S);
         transposeScatterIncrU<4>(reinterpret_cast<real *>(f), ak, f_kx_S, f_ky_S, f_kz_S);
+
+        if (flavor == BondedKernelFlavor::ForcesAndVirialAndEnergy)
+        {
+            const SimdReal dtheta_S = theta_S - theta0_S;
+            const SimdReal dr13_S   = dr_S - r13_S;
+
+            vtot_S = fma(0.5 * ktheta_S * dtheta_S, dtheta_S, vtot_S);
+            vtot_S = fma(0.5 * kUB_S * dr13_S, dr13_S, vtot_S);
+
+            addShiftForcesSimd(ai, aj, f_ix_S, f_iy_S, f_iz_S, shift_ij_S, g, fshift);
+            addShiftForcesSimd(ak, aj, f_kx_S, f_ky_S, f_kz_S, shift_kj_S, g, fshift);
+        }
     }
+
+    return reduce(vtot_S);
 }
 
 #endif // GMX_SIMD_HAVE_REAL
@@ -1464,6 +1713,7 @@ real dih_angle(const rvec xi, const rvec xj, const rvec xk, const rvec xl,
 
 /* As dih_angle above, but calculates 4 dihedral angles at once using SIMD,
  * also calculates the pre-factor required for the dihedral force update.
+ * Returns in shift_S the periodic shifts of atoms i, k and l relative to j.
  * Note that bv and buf should be register aligned.
  */
 static inline void
@@ -1476,7 +1726,8 @@ dih_angle_simd(const rvec *x,
                SimdReal *nrkj_m2_S,
                SimdReal *nrkj_n2_S,
                SimdReal *p_S,
-               SimdReal *q_S)
+               SimdReal *q_S,
+               SimdPbcShift shift_S[3])
 {
     SimdReal xi_S, yi_S, zi_S;
     SimdReal xj_S, yj_S, zj_S;
@@ -1518,9 +1769,11 @@ dih_angle_simd(const rvec *x,
     rkly_S = yk_S - yl_S;
     rklz_S = zk_S - zl_S;
 
-    pbc_correct_dx_simd(&rijx_S, &rijy_S, &rijz_S, pbc_simd);
-    pbc_correct_dx_simd(&rkjx_S, &rkjy_S, &rkjz_S, pbc_simd);
-    pbc_correct_dx_simd(&rklx_S, &rkly_S, &rklz_S, pbc_simd);
+    shift_S[0] = pbcCorrectDxWithShift(&rijx_S, &rijy_S, &rijz_S, pbc_simd);
+    shift_S[1] = pbcCorrectDxWithShift(&rkjx_S, &rkjy_S, &rkjz_S, pbc_simd);
+    const SimdPbcShift shift_kl_S = pbcCorrectDxWithShift(&rklx_S, &rkly_S, &rklz_S, pbc_simd);
+    /* x_l - x_j = r_kj - r_kl, so the image of l follows from those of k */
+    shift_S[2]    = { shift_S[1].x - shift_kl_S.x, shift_S[1].y - shift_kl_S.y, shift_S[1].z - shift_kl_S.z };
 
     cprod(rijx_S, rijy_S, rijz_S,
           rkjx_S, rkjy_S, rkjz_S,
@@ -1687,13 +1940,18 @@ do_dih_fup_noshiftf(int i, int j, int k, int l, real ddphi,
 }
 
 #if GMX_SIMD_HAVE_REAL
-/* As do_dih_fup_noshiftf above, but with SIMD and pre-calculated pre-factors */
+/* As do_dih_fup above, but with SIMD and pre-calculated pre-factors.
+ * Shift forces are only computed with flavor ForcesAndVirialAndEnergy,
+ * using the shifts of i, k and l relative to j from dih_angle_simd.
+ */
+template <BondedKernelFlavor flavor>
 static inline void gmx_simdcall
-do_dih_fup_noshiftf_simd(const int *ai, const int *aj, const int *ak, const int *al,
-                         SimdReal p, SimdReal q,
-                         SimdReal f_i_x,  SimdReal f_i_y,  SimdReal f_i_z,
-                         SimdReal mf_l_x, SimdReal mf_l_y, SimdReal mf_l_z,
-                         rvec4 f[])
+do_dih_fup_simd(const int *ai, const int *aj, const int *ak, const int *al,
+                SimdReal p, SimdReal q,
+                SimdReal f_i_x,  SimdReal f_i_y,  SimdReal f_i_z,
+                SimdReal mf_l_x, SimdReal mf_l_y, SimdReal mf_l_z,
+                rvec4 f[], rvec fshift[],
+                const SimdPbcShift shift_S[3], const t_graph *g)
 {
     SimdReal sx    = p * f_i_x + q * mf_l_x;
     SimdReal sy    = p * f_i_y + q * mf_l_y;
@@ -1708,6 +1966,13 @@ do_dih_fup_noshiftf_simd(const int *ai, const int *aj, const int *ak, const int
     transposeScatterDecrU<4>(reinterpret_cast<real *>(f), aj, f_j_x, f_j_y, f_j_z);
     transposeScatterIncrU<4>(reinterpret_cast<real *>(f), ak, f_k_x, f_k_y, f_k_z);
     transposeScatterDecrU<4>(reinterpret_cast<real *>(f), al, mf_l_x, mf_l_y, mf_l_z);
+
+    if (flavor == BondedKernelFlavor::ForcesAndVirialAndEnergy)
+    {
+        addShiftForcesSimd(ai, aj, f_i_x, f_i_y, f_i_z, shift_S[0], g, fshift);
+        addShiftForcesSimd(ak, aj, f_k_x, f_k_y, f_k_z, shift_S[1], g, fshift);
+        addShiftForcesSimd(al, aj, -mf_l_x, -mf_l_y, -mf_l_z, shift_S[2], g, fshift);
+    }
 }
 #endif // GMX_SIMD_HAVE_REAL
 
@@ -1891,15 +2156,19 @@ pdihs_noener(int nbonds,
 
 #if GMX_SIMD_HAVE_REAL
 
-/* As pdihs_noner above, but using SIMD to calculate many dihedrals at once */
-void
-pdihs_noener_simd(int nbonds,
-                  const t_iatom forceatoms[], const t_iparams forceparams[],
-                  const rvec x[], rvec4 f[],
-                  const t_pbc *pbc, const t_graph gmx_unused *g,
-                  real gmx_unused lambda,
-                  const t_mdatoms gmx_unused *md, t_fcdata gmx_unused *fcd,
-                  int gmx_unused *global_atom_index)
+/* As pdihs above, but using SIMD to calculate many dihedrals at once.
+ * Only uses the A-state parameters. Energies and shift forces are
+ * computed only with flavor ForcesAndVirialAndEnergy.
+ */
+template <BondedKernelFlavor flavor>
+static real
+pdihs_simd(int nbonds,
+           const t_iatom forceatoms[], const t_iparams forceparams[],
+           const rvec x[], rvec4 f[], rvec fshift[],
+           const t_pbc *pbc, const t_graph *g,
+           real gmx_unused lambda, real gmx_unused *dvdlambda,
+           const t_mdatoms gmx_unused *md, t_fcdata gmx_unused *fcd,
+           int gmx_unused *global_atom_index)
 {
     const int             nfa1 = 5;
     int                   i, iu, s;
@@ -1912,6 +2181,7 @@ pdihs_noener_simd(int nbonds,
     real                 *cp, *phi0, *mult;
     SimdReal              deg2rad_S(DEG2RAD);
     SimdReal              p_S, q_S;
+    SimdPbcShift          shift_S[3];
     SimdReal              phi0_S, phi_S;
     SimdReal              mx_S, my_S, mz_S;
     SimdReal              nx_S, ny_S, nz_S;
@@ -1920,6 +2190,7 @@ pdihs_noener_simd(int nbonds,
     SimdReal              sin_S, cos_S;
     SimdReal              mddphi_S;
     SimdReal              sf_i_S, msf_l_S;
+    SimdReal              vtot_S = setZero();
     alignas(GMX_SIMD_ALIGNMENT) real            pbc_simd[9*GMX_SIMD_REAL_WIDTH];
 
     /* Extract aligned pointer for parameters and variables */
@@ -1971,7 +2242,7 @@ pdihs_noener_simd(int nbonds,
                        &nx_S, &ny_S, &nz_S,
                        &nrkj_m2_S,
                        &nrkj_n2_S,
-                       &p_S, &q_S);
+                       &p_S, &q_S, shift_S);
 
         cp_S     = load<SimdReal>(cp);
         phi0_S   = load<SimdReal>(phi0) * deg2rad_S;
@@ -1995,26 +2266,34 @@ pdihs_noener_simd(int nbonds,
         ny_S     = msf_l_S * ny_S;
         nz_S     = msf_l_S * nz_S;
 
-        do_dih_fup_noshiftf_simd(ai, aj, ak, al,
-                                 p_S, q_S,
-                                 mx_S, my_S, mz_S,
-                                 nx_S, ny_S, nz_S,
-                                 f);
+        do_dih_fup_simd<flavor>(ai, aj, ak, al,
+                                p_S, q_S,
+                                mx_S, my_S, mz_S,
+                                nx_S, ny_S, nz_S,
+                                f, fshift, shift_S, g);
+
+        if (flavor == BondedKernelFlavor::ForcesAndVirialAndEnergy)
+        {
+            vtot_S = fma(cp_S, 1.0 + cos_S, vtot_S);
+        }
     }
+
+    return reduce(vtot_S);
 }
 
-/* This is mostly a copy of pdihs_noener_simd above, but with using
+/* This is mostly a copy of pdihs_simd above, but with using
  * the RB potential instead of a harmonic potential.
- * This function can replace rbdihs() when no energy and virial are needed.
+ * This function can replace rbdihs() without perturbed interactions.
  */
-void
-rbdihs_noener_simd(int nbonds,
-                   const t_iatom forceatoms[], const t_iparams forceparams[],
-                   const rvec x[], rvec4 f[],
-                   const t_pbc *pbc, const t_graph gmx_unused *g,
-                   real gmx_unused lambda,
-                   const t_mdatoms gmx_unused *md, t_fcdata gmx_unused *fcd,
-                   int gmx_unused *global_atom_index)
+template <BondedKernelFlavor flavor>
+static real
+rbdihs_simd(int nbonds,
+            const t_iatom forceatoms[], const t_iparams forceparams[],
+            const rvec x[], rvec4 f[], rvec fshift[],
+            const t_pbc *pbc, const t_graph *g,
+            real gmx_unused lambda, real gmx_unused *dvdlambda,
+            const t_mdatoms gmx_unused *md, t_fcdata gmx_unused *fcd,
+            int gmx_unused *global_atom_index)
 {
     const int             nfa1 = 5;
     int                   i, iu, s, j;
@@ -2026,6 +2305,7 @@ rbdihs_noener_simd(int nbonds,
     alignas(GMX_SIMD_ALIGNMENT) real          parm[NR_RBDIHS*GMX_SIMD_REAL_WIDTH];
 
     SimdReal              p_S, q_S;
+    SimdPbcShift          shift_S[3];
     SimdReal              phi_S;
     SimdReal              ddphi_S, cosfac_S;
     SimdReal              mx_S, my_S, mz_S;
@@ -2034,6 +2314,7 @@ rbdihs_noener_simd(int nbonds,
     SimdReal              parm_S, c_S;
     SimdReal              sin_S, cos_S;
     SimdReal              sf_i_S, msf_l_S;
+    SimdReal              vtot_S = setZero();
     alignas(GMX_SIMD_ALIGNMENT) real          pbc_simd[9*GMX_SIMD_REAL_WIDTH];
 
     SimdReal              pi_S(M_PI);
@@ -2059,10 +2340,10 @@ rbdihs_noener_simd(int nbonds,
             /* At the end fill the arrays with the last atoms and 0 params */
             if (i + s*nfa1 < nbonds)
             {
-                /* We don't need the first parameter, since that's a constant
-                 * which only affects the energies, not the forces.
+                /* The first parameter is a constant which only affects
+                 * the energies, not the forces.
                  */
-                for (j = 1; j < NR_RBDIHS; j++)
+                for (j = 0; j < NR_RBDIHS; j++)
                 {
                     parm[j*GMX_SIMD_REAL_WIDTH + s] =
                         forceparams[type].rbdihs.rbcA[j];
@@ -2075,7 +2356,7 @@ rbdihs_noener_simd(int nbonds,
             }
             else
             {
-                for (j = 1; j < NR_RBDIHS; j++)
+                for (j = 0; j < NR_RBDIHS; j++)
                 {
                     parm[j*GMX_SIMD_REAL_WIDTH + s] = 0;
                 }
@@ -2089,7 +2370,7 @@ rbdihs_noener_simd(int nbonds,
                        &nx_S, &ny_S, &nz_S,
                        &nrkj_m2_S,
                        &nrkj_n2_S,
-                       &p_S, &q_S);
+                       &p_S, &q_S, shift_S);
 
         /* Change to polymer convention */
         phi_S = phi_S - pi_S;
@@ -2099,12 +2380,20 @@ rbdihs_noener_simd(int nbonds,
         ddphi_S   = setZero();
         c_S       = one_S;
         cosfac_S  = one_S;
+        if (flavor == BondedKernelFlavor::ForcesAndVirialAndEnergy)
+        {
+            vtot_S = vtot_S + load<SimdReal>(parm);
+        }
         for (j = 1; j < NR_RBDIHS; j++)
         {
             parm_S   = load<SimdReal>(parm + j*GMX_SIMD_REAL_WIDTH);
             ddphi_S  = fma(c_S * parm_S, cosfac_S, ddphi_S);
             cosfac_S = cosfac_S * cos_S;
             c_S      = c_S + one_S;
+            if (flavor == BondedKernelFlavor::ForcesAndVirialAndEnergy)
+            {
+                vtot_S = fma(parm_S, cosfac_S, vtot_S);
+            }
         }
 
         /* Note that here we do not use the minus sign which is present
@@ -2125,12 +2414,14 @@ rbdihs_noener_simd(int nbonds,
         ny_S     = msf_l_S * ny_S;
         nz_S     = msf_l_S * nz_S;
 
-        do_dih_fup_noshiftf_simd(ai, aj, ak, al,
-                                 p_S, q_S,
-                                 mx_S, my_S, mz_S,
-                                 nx_S, ny_S, nz_S,
-                                 f);
+        do_dih_fup_simd<flavor>(ai, aj, ak, al,
+                                p_S, q_S,
+                                mx_S, my_S, mz_S,
+                                nx_S, ny_S, nz_S,
+                                f, fshift, shift_S, g);
     }
+
+    return reduce(vtot_S);
 }
 
 #endif // GMX_SIMD_HAVE_REAL
@@ -2200,6 +2491,124 @@ real idihs(int nbonds,
     return vtot;
 }
 
+#if GMX_SIMD_HAVE_REAL
+
+/* As idihs above, but using SIMD to calculate many dihedrals at once.
+ * Only uses the A-state parameters. Energies and shift forces are
+ * computed only with flavor ForcesAndVirialAndEnergy.
+ */
+template <BondedKernelFlavor flavor>
+static real
+idihs_simd(int nbonds,
+           const t_iatom forceatoms[], const t_iparams forceparams[],
+           const rvec x[], rvec4 f[], rvec fshift[],
+           const t_pbc *pbc, const t_graph *g,
+           real gmx_unused lambda, real gmx_unused *dvdlambda,
+           const t_mdatoms gmx_unused *md, t_fcdata gmx_unused *fcd,
+           int gmx_unused *global_atom_index)
+{
+    constexpr int         nfa1 = 5;
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t    ai[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t    aj[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t    ak[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t    al[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real            coeff[2*GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real            pbc_simd[9*GMX_SIMD_REAL_WIDTH];
+
+    const SimdReal        twoPi_S(2*M_PI);
+    const SimdReal        invTwoPi_S(1/(2*M_PI));
+    SimdReal              vtot_S = setZero();
+
+    set_pbc_simd(pbc, pbc_simd);
+
+    /* nbonds is the number of dihedrals times nfa1, here we step GMX_SIMD_REAL_WIDTH dihs */
+    for (int i = 0; i < nbonds; i += GMX_SIMD_REAL_WIDTH*nfa1)
+    {
+        /* Collect atoms quadruplets for GMX_SIMD_REAL_WIDTH dihedrals.
+         * iu indexes into forceatoms, we should not let iu go beyond nbonds.
+         */
+        int iu = i;
+        for (int s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+        {
+            const int type = forceatoms[iu];
+            ai[s] = forceatoms[iu+1];
+            aj[s] = forceatoms[iu+2];
+            ak[s] = forceatoms[iu+3];
+            al[s] = forceatoms[iu+4];
+
+            /* At the end fill the arrays with the last atoms and 0 params */
+            if (i + s*nfa1 < nbonds)
+            {
+                coeff[s]                     = forceparams[type].harmonic.krA;
+                coeff[GMX_SIMD_REAL_WIDTH+s] = forceparams[type].harmonic.rA;
+
+                if (iu + nfa1 < nbonds)
+                {
+                    iu += nfa1;
+                }
+            }
+            else
+            {
+                coeff[s]                     = 0;
+                coeff[GMX_SIMD_REAL_WIDTH+s] = 0;
+            }
+        }
+
+        SimdReal phi_S;
+        SimdReal mx_S, my_S, mz_S;
+        SimdReal nx_S, ny_S, nz_S;
+        SimdReal nrkj_m2_S, nrkj_n2_S;
+        SimdReal p_S, q_S;
+        SimdPbcShift shift_S[3];
+
+        /* Caclulate GMX_SIMD_REAL_WIDTH dihedral angles at once */
+        dih_angle_simd(x, ai, aj, ak, al, pbc_simd,
+                       &phi_S,
+                       &mx_S, &my_S, &mz_S,
+                       &nx_S, &ny_S, &nz_S,
+                       &nrkj_m2_S,
+                       &nrkj_n2_S,
+                       &p_S, &q_S, shift_S);
+
+        const SimdReal k_S    = load<SimdReal>(coeff);
+        const SimdReal phi0_S = load<SimdReal>(coeff+GMX_SIMD_REAL_WIDTH) * DEG2RAD;
+
+        /* As make_dp_periodic, take phi - phi0 modulo (-Pi,Pi) */
+        SimdReal       dp_S   = phi_S - phi0_S;
+        dp_S                  = fnma(twoPi_S, round(dp_S * invTwoPi_S), dp_S);
+
+        /* Minus the derivative of the potential with respect to phi */
+        const SimdReal mddphi_S = -k_S * dp_S;
+        const SimdReal sf_i_S   = mddphi_S * nrkj_m2_S;
+        const SimdReal msf_l_S  = mddphi_S * nrkj_n2_S;
+
+        /* After this m?_S will contain f[i] */
+        mx_S     = sf_i_S * mx_S;
+        my_S     = sf_i_S * my_S;
+        mz_S     = sf_i_S * mz_S;
+
+        /* After this m?_S will contain -f[l] */
+        nx_S     = msf_l_S * nx_S;
+        ny_S     = msf_l_S * ny_S;
+        nz_S     = msf_l_S * nz_S;
+
+        do_dih_fup_simd<flavor>(ai, aj, ak, al,
+                                p_S, q_S,
+                                mx_S, my_S, mz_S,
+                                nx_S, ny_S, nz_S,
+                                f, fshift, shift_S, g);
+
+        if (flavor == BondedKernelFlavor::ForcesAndVirialAndEnergy)
+        {
+            vtot_S = fma(0.5 * k_S * dp_S, dp_S, vtot_S);
+        }
+    }
+
+    return reduce(vtot_S);
+}
+
+#endif // GMX_SIMD_HAVE_REAL
+
 static real low_angres(int nbonds,
                        const t_iatom forceatoms[], const t_iparams forceparams[],
                        const rvec x[], rvec4 f[], rvec fshift[],
@@ -2524,6 +2933,132 @@ real restrangles(int nbonds,
 }
 
 
+#if GMX_SIMD_HAVE_REAL
+
+/* As restrangles above, but using SIMD to calculate many angles at once.
+ * The factors follow compute_factors_restangles(), but are computed
+ * in real instead of double precision. Energies and shift forces are
+ * computed only with flavor ForcesAndVirialAndEnergy.
+ */
+template <BondedKernelFlavor flavor>
+static real
+restrangles_simd(int nbonds,
+                 const t_iatom forceatoms[], const t_iparams forceparams[],
+                 const rvec x[], rvec4 f[], rvec fshift[],
+                 const t_pbc *pbc, const t_graph *g,
+                 real gmx_unused lambda, real gmx_unused *dvdlambda,
+                 const t_mdatoms gmx_unused *md, t_fcdata gmx_unused *fcd,
+                 int gmx_unused *global_atom_index)
+{
+    constexpr int            nfa1 = 4;
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t    ai[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t    aj[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t    ak[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real            coeff[2*GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real            pbc_simd[9*GMX_SIMD_REAL_WIDTH];
+
+    set_pbc_simd(pbc, pbc_simd);
+
+    SimdReal vtot_S = setZero();
+
+    /* nbonds is the number of angles times nfa1, here we step GMX_SIMD_REAL_WIDTH angles */
+    for (int i = 0; i < nbonds; i += GMX_SIMD_REAL_WIDTH*nfa1)
+    {
+        /* Collect atoms for GMX_SIMD_REAL_WIDTH angles.
+         * iu indexes into forceatoms, we should not let iu go beyond nbonds.
+         */
+        int iu = i;
+        for (int s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+        {
+            const int type = forceatoms[iu];
+            ai[s] = forceatoms[iu+1];
+            aj[s] = forceatoms[iu+2];
+            ak[s] = forceatoms[iu+3];
+
+            /* At the end fill the arrays with the last atoms and 0 params */
+            if (i + s*nfa1 < nbonds)
+            {
+                /* The equilibrium angle is defined with respect to the
+                 * vectors j-i and k-j, so cos(Pi - theta0) = -cos(theta0).
+                 */
+                coeff[s]                     = forceparams[type].harmonic.krA;
+                coeff[GMX_SIMD_REAL_WIDTH+s] = -std::cos(forceparams[type].harmonic.rA*DEG2RAD);
+
+                if (iu + nfa1 < nbonds)
+                {
+                    iu += nfa1;
+                }
+            }
+            else
+            {
+                coeff[s]                     = 0;
+                coeff[GMX_SIMD_REAL_WIDTH+s] = 0;
+            }
+        }
+
+        SimdReal xi_S, yi_S, zi_S;
+        SimdReal xj_S, yj_S, zj_S;
+        SimdReal xk_S, yk_S, zk_S;
+
+        /* Store the non PBC corrected distances packed and aligned */
+        gatherLoadUTranspose<3>(reinterpret_cast<const real *>(x), ai, &xi_S, &yi_S, &zi_S);
+        gatherLoadUTranspose<3>(reinterpret_cast<const real *>(x), aj, &xj_S, &yj_S, &zj_S);
+        gatherLoadUTranspose<3>(reinterpret_cast<const real *>(x), ak, &xk_S, &yk_S, &zk_S);
+        SimdReal       dax_S = xj_S - xi_S;
+        SimdReal       day_S = yj_S - yi_S;
+        SimdReal       daz_S = zj_S - zi_S;
+        SimdReal       dpx_S = xk_S - xj_S;
+        SimdReal       dpy_S = yk_S - yj_S;
+        SimdReal       dpz_S = zk_S - zj_S;
+
+        const SimdReal k_S         = load<SimdReal>(coeff);
+        const SimdReal cosTheta0_S = load<SimdReal>(coeff+GMX_SIMD_REAL_WIDTH);
+
+        const SimdPbcShift shift_ji_S = pbcCorrectDxWithShift(&dax_S, &day_S, &daz_S, pbc_simd);
+        const SimdPbcShift shift_kj_S = pbcCorrectDxWithShift(&dpx_S, &dpy_S, &dpz_S, pbc_simd);
+        const SimdPbcShift shift_ij_S = -shift_ji_S;
+
+        const SimdReal c_ante_S    = norm2(dax_S, day_S, daz_S);
+        const SimdReal c_cros_S    = iprod(dax_S, day_S, daz_S, dpx_S, dpy_S, dpz_S);
+        const SimdReal c_post_S    = norm2(dpx_S, dpy_S, dpz_S);
+
+        const SimdReal norm_S      = invsqrt(c_ante_S * c_post_S);
+        const SimdReal cos_S       = c_cros_S * norm_S;
+        const SimdReal sin2_S      = 1.0 - cos_S * cos_S;
+        const SimdReal invSin2_S   = inv(sin2_S);
+
+        const SimdReal ratioAnte_S = c_cros_S * inv(c_ante_S);
+        const SimdReal ratioPost_S = c_cros_S * inv(c_post_S);
+
+        const SimdReal dcos_S      = cos_S - cosTheta0_S;
+        const SimdReal term_S      = fnma(cos_S, cosTheta0_S, SimdReal(1.0));
+        const SimdReal prefactor_S = -k_S * dcos_S * norm_S * term_S * invSin2_S * invSin2_S;
+
+        const SimdReal f_ix_S      = prefactor_S * fms(ratioAnte_S, dax_S, dpx_S);
+        const SimdReal f_iy_S      = prefactor_S * fms(ratioAnte_S, day_S, dpy_S);
+        const SimdReal f_iz_S      = prefactor_S * fms(ratioAnte_S, daz_S, dpz_S);
+        const SimdReal f_kx_S      = prefactor_S * fnma(ratioPost_S, dpx_S, dax_S);
+        const SimdReal f_ky_S      = prefactor_S * fnma(ratioPost_S, dpy_S, day_S);
+        const SimdReal f_kz_S      = prefactor_S * fnma(ratioPost_S, dpz_S, daz_S);
+
+        transposeScatterIncrU<4>(reinterpret_cast<real *>(f), ai, f_ix_S, f_iy_S, f_iz_S);
+        transposeScatterDecrU<4>(reinterpret_cast<real *>(f), aj, f_ix_S + f_kx_S, f_iy_S + f_ky_S, f_iz_S + f_kz_S);
+        transposeScatterIncrU<4>(reinterpret_cast<real *>(f), ak, f_kx_S, f_ky_S, f_kz_S);
+
+        if (flavor == BondedKernelFlavor::ForcesAndVirialAndEnergy)
+        {
+            vtot_S = fma(0.5 * k_S * dcos_S * dcos_S, invSin2_S, vtot_S);
+
+            addShiftForcesSimd(ai, aj, f_ix_S, f_iy_S, f_iz_S, shift_ij_S, g, fshift);
+            addShiftForcesSimd(ak, aj, f_kx_S, f_ky_S, f_kz_S, shift_kj_S, g, fshift);
+        }
+    }
+
+    return reduce(vtot_S);
+}
+
+#endif // GMX_SIMD_HAVE_REAL
+
 real restrdihs(int nbonds,
                const t_iatom forceatoms[], const t_iparams forceparams[],
                const rvec x[], rvec4 f[], rvec fshift[],
@@ -2887,6 +3422,54 @@ cmap_setup_grid_index(int ip, int grid_spacing, int *ipm1, int *ipp1, int *ipp2)
 
 }
 
+/*! \brief Computes the bicubic interpolation coefficients \p tc of a CMAP grid cell
+ *
+ * Multiplies the function values and derivatives \p tx at the cell
+ * corners with cmap_coeff_matrix. This is the bulk of the CMAP work,
+ * so with SIMD we compute GMX_SIMD_REAL_WIDTH coefficients at once.
+ * \p tc should be aligned to GMX_SIMD_ALIGNMENT.
+ */
+static void cmapInterpolationCoefficients(const real tx[16], real tc[16])
+{
+#if GMX_SIMD_HAVE_REAL
+    static_assert(16 % GMX_SIMD_REAL_WIDTH == 0, "The CMAP coefficient count should be a multiple of the SIMD width");
+
+    /* SIMD-aligned copy of cmap_coeff_matrix in real */
+    struct CoefficientMatrix
+    {
+        CoefficientMatrix()
+        {
+            for (int i = 0; i < 16*16; i++)
+            {
+                c[i] = cmap_coeff_matrix[i];
+            }
+        }
+
+        alignas(GMX_SIMD_ALIGNMENT) real c[16*16];
+    };
+    static const CoefficientMatrix matrix;
+
+    for (int idx = 0; idx < 16; idx += GMX_SIMD_REAL_WIDTH)
+    {
+        SimdReal tc_S = setZero();
+        for (int k = 0; k < 16; k++)
+        {
+            tc_S = fma(load<SimdReal>(matrix.c + k*16 + idx), SimdReal(tx[k]), tc_S);
+        }
+        store(tc + idx, tc_S);
+    }
+#else
+    for (int idx = 0; idx < 16; idx++)
+    {
+        tc[idx] = 0;
+        for (int k = 0; k < 16; k++)
+        {
+            tc[idx] += cmap_coeff_matrix[k*16+idx]*tx[k];
+        }
+    }
+#endif
+}
+
 real
 cmap_dihs(int nbonds,
           const t_iatom forceatoms[], const t_iparams forceparams[],
@@ -3140,14 +3723,8 @@ cmap_dihs(int nbonds,
             tx[i+12] = ty12[i]*dx*dx;
         }
 
-        real tc[16] = {0};
-        for (int idx = 0; idx < 16; idx++) /* 1056 */
-        {
-            for (int k = 0; k < 16; k++)
-            {
-                tc[idx] += cmap_coeff_matrix[k*16+idx]*tx[k];
-            }
-        }
+        alignas(GMX_SIMD_ALIGNMENT) real tc[16];
+        cmapInterpolationCoefficients(tx, tc); /* 1056 */
 
         tt    = (xphi1-iphi1*dx)/dx;
         tu    = (xphi2-iphi2*dx)/dx;
@@ -3812,3 +4389,46 @@ real tab_dihs(int nbonds,
 }
 
 //! \endcond
+
+BondedFunction simdBondedFunction(int ftype, bool computeEnergyAndVirial)
+{
+#if GMX_SIMD_HAVE_REAL
+    if (computeEnergyAndVirial)
+    {
+        constexpr BondedKernelFlavor flavor = BondedKernelFlavor::ForcesAndVirialAndEnergy;
+
+        switch (ftype)
+        {
+            case F_BONDS:         return bonds_simd<flavor>;
+            case F_ANGLES:        return angles_simd<flavor>;
+            case F_RESTRANGLES:   return restrangles_simd<flavor>;
+            case F_UREY_BRADLEY:  return urey_bradley_simd<flavor>;
+            case F_PDIHS:         return pdihs_simd<flavor>;
+            case F_RBDIHS:        return rbdihs_simd<flavor>;
+            case F_IDIHS:         return idihs_simd<flavor>;
+            default:              return nullptr;
+        }
+    }
+    else
+    {
+        constexpr BondedKernelFlavor flavor = BondedKernelFlavor::ForcesOnly;
+
+        switch (ftype)
+        {
+            case F_BONDS:         return bonds_simd<flavor>;
+            case F_ANGLES:        return angles_simd<flavor>;
+            case F_RESTRANGLES:   return restrangles_simd<flavor>;
+            case F_UREY_BRADLEY:  return urey_bradley_simd<flavor>;
+            case F_PDIHS:         return pdihs_simd<flavor>;
+            case F_RBDIHS:        return rbdihs_simd<flavor>;
+            case F_IDIHS:         return idihs_simd<flavor>;
+            default:              return nullptr;
+        }
+    }
+#else
+    GMX_UNUSED_VALUE(ftype);
+    GMX_UNUSED_VALUE(computeEnergyAndVirial);
+
+    return nullptr;
+#endif
+}
@@ -429,63 +429,29 @@ calc_one_bond(int thread,
                           md, fcd, global_atom_index);
         }
 #if GMX_SIMD_HAVE_REAL
-        else if (ftype == F_ANGLES && bUseSIMD && computeForcesOnly)
+        else if (bUseSIMD && !useFreeEnergy &&
+                 simdBondedFunction(ftype, bCalcEnerVir) != nullptr)
         {
-            /* No energies, shift forces, dvdl */
-            angles_noener_simd(nbn, idef->il[ftype].iatoms+nb0,
-                               idef->iparams,
-                               x, f,
-                               pbc, g, lambda[efptFTYPE], md, fcd,
-                               global_atom_index);
-            v = 0;
-        }
-
-        else if (ftype == F_UREY_BRADLEY && bUseSIMD && computeForcesOnly)
-        {
-            /* No energies, shift forces, dvdl */
-            urey_bradley_noener_simd(nbn, idef->il[ftype].iatoms+nb0,
-                                     idef->iparams,
-                                     x, f,
-                                     pbc, g, lambda[efptFTYPE], md, fcd,
-                                     global_atom_index);
-            v = 0;
+            /* Without perturbed interactions we can use SIMD,
+             * also when we need energies and shift forces.
+             */
+            v = simdBondedFunction(ftype, bCalcEnerVir)(nbn, iatoms+nb0,
+                                                        idef->iparams,
+                                                        x, f, fshift,
+                                                        pbc, g, lambda[efptFTYPE], &(dvdl[efptFTYPE]),
+                                                        md, fcd, global_atom_index);
         }
 #endif
         else if (ftype == F_PDIHS && computeForcesOnly)
         {
             /* No energies, shift forces, dvdl */
-#if GMX_SIMD_HAVE_REAL
-            if (bUseSIMD)
-            {
-                pdihs_noener_simd(nbn, idef->il[ftype].iatoms+nb0,
-                                  idef->iparams,
-                                  x, f,
-                                  pbc, g, lambda[efptFTYPE], md, fcd,
-                                  global_atom_index);
-            }
-            else
-#endif
-            {
-                pdihs_noener(nbn, idef->il[ftype].iatoms+nb0,
-                             idef->iparams,
-                             x, f,
-                             pbc, g, lambda[efptFTYPE], md, fcd,
-                             global_atom_index);
-            }
-            v = 0;
-        }
-#if GMX_SIMD_HAVE_REAL
-        else if (ftype == F_RBDIHS && bUseSIMD && computeForcesOnly)
-        {
-            /* No energies, shift forces, dvdl */
-            rbdihs_noener_simd(nbn, idef->il[ftype].iatoms+nb0,
-                               idef->iparams,
-                               static_cast<const rvec*>(x), f,
-                               pbc, g, lambda[efptFTYPE], md, fcd,
-                               global_atom_index);
+            pdihs_noener(nbn, idef->il[ftype].iatoms+nb0,
+                         idef->iparams,
+                         x, f,
+                         pbc, g, lambda[efptFTYPE], md, fcd,
+                         global_atom_index);
             v = 0;
         }
-#endif
         else
         {
             v = bondedFunction(ftype)(nbn, iatoms+nb0,
@@ -44,11 +44,14 @@
 #define GMX_LISTED_FORCES_LISTED_INTERNAL_H
 
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "gromacs/math/vectypes.h"
 #include "gromacs/mdtypes/enerdata.h"
 #include "gromacs/topology/idef.h"
 #include "gromacs/topology/ifunc.h"
+#include "gromacs/utility/alignedallocator.h"
 #include "gromacs/utility/bitmask.h"
 
 /* We reduce the force array in blocks of 32 atoms. This is large enough
@@ -118,6 +121,14 @@ struct f_thread_t
     real              dvdl[efptNR];           /**< Free-energy dV/dl output */
 };
 
+/*! \internal \brief Energy, dV/dlambda and virial of position restraints, used per thread */
+struct PositionRestraintOutput
+{
+    real v         = 0;     /**< Potential energy */
+    real dvdlambda = 0;     /**< Derivative of the energy with respect to lambda */
+    rvec virial    = { 0 }; /**< Virial contribution */
+};
+
 /*! \internal \brief struct contain all data for bonded force threading */
 struct bonded_threading_t
 {
@@ -149,6 +160,18 @@ struct bonded_threading_t
 
     //! Work division for free-energy foreign lambda calculations, always uses 1 thread
     WorkDivision foreignLambdaWorkDivision;
+
+    //! Whether the interactions are sorted on locality, only done with domain decomposition
+    bool                                 sortedOnLocality;
+    //! Buffer for pairs of sort key and index, used for sorting interactions on locality
+    std::vector < std::pair < int, int>> sortKeyBuffer;
+    //! Buffer for interaction atoms, used for sorting interactions on locality
+    std::vector<t_iatom>                 iatomBuffer;
+
+    //! Energy and virial output of (flat-bottomed) position restraints per thread
+    std::vector<PositionRestraintOutput>           posresThreadOutput;
+    //! Forces of (flat-bottomed) position restraints, x, y and z components stored consecutively
+    std::vector<real, gmx::AlignedAllocator<real> > posresForceBuffer;
 };
 
 
@@ -54,6 +54,8 @@
 
 #include <algorithm>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "gromacs/listed_forces/gpubonded.h"
 #include "gromacs/mdlib/gmx_omp_nthreads.h"
@@ -67,6 +69,125 @@
 #include "listed_internal.h"
 #include "utilities.h"
 
+/*! \brief Returns the locality sort key of the interaction starting at \p iatoms
+ *
+ * This is the lowest local atom index of the interaction.
+ * With domain decomposition the home atoms are ordered along the nbnxm
+ * grid, so interactions with close keys are also close in space.
+ */
+static inline int localityKey(const t_iatom *iatoms,
+                              int            nral)
+{
+    int key = iatoms[1];
+    for (int a = 2; a <= nral; a++)
+    {
+        key = std::min(key, iatoms[a]);
+    }
+
+    return key;
+}
+
+//! Returns whether the interactions of type \p ftype may be reordered
+static bool ftypeCanBeReordered(int ftype)
+{
+    /* Distance and orientation restraints with the same label
+     * are combined, which relies on the order of the interactions.
+     */
+    return (ftype_is_bonded_potential(ftype) &&
+            ftype != F_DISRES && ftype != F_ORIRES);
+}
+
+/*! \brief Sorts interactions with index range \p begin to \p end in \p il on locality
+ *
+ * Interactions with equal keys keep their relative order, so the result
+ * is deterministic.
+ */
+static void sortInteractionsByLocality(bonded_threading_t *bt,
+                                       t_ilist            *il,
+                                       int                 nral,
+                                       int                 begin,
+                                       int                 end)
+{
+    const int  stride          = 1 + nral;
+    const int  numInteractions = (end - begin)/stride;
+    t_iatom   *iatoms          = il->iatoms + begin;
+
+    std::vector < std::pair < int, int>> &keys = bt->sortKeyBuffer;
+    keys.resize(numInteractions);
+    bool                                  isSorted = true;
+    for (int i = 0; i < numInteractions; i++)
+    {
+        keys[i] = { localityKey(iatoms + i*stride, nral), i };
+        if (i > 0 && keys[i].first < keys[i - 1].first)
+        {
+            isSorted = false;
+        }
+    }
+    if (isSorted)
+    {
+        /* Common without domain decomposition */
+        return;
+    }
+
+    /* The index in the second element makes the sort stable */
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<t_iatom> &buffer = bt->iatomBuffer;
+    buffer.assign(iatoms, iatoms + numInteractions*stride);
+    for (int i = 0; i < numInteractions; i++)
+    {
+        std::copy_n(buffer.data() + keys[i].second*stride, stride, iatoms + i*stride);
+    }
+}
+
+/*! \brief Sorts the bonded interaction lists in \p idef on locality
+ *
+ * After sorting, consecutive interactions, and thus the interactions
+ * assigned to a thread, touch a compact set of atoms. This reduces
+ * the working set of the force accumulation and the number of force
+ * blocks that need to be reduced over threads.
+ * Perturbed interactions are kept after the non-perturbed ones.
+ *
+ * Sorting is only done with domain decomposition, since only then
+ * the local atom order follows the nbnxm grid. Without domain
+ * decomposition the atoms of an interaction are usually close
+ * in the topology, which already gives good locality.
+ */
+static void sort_bondeds_by_locality(bonded_threading_t *bt,
+                                     bool                haveDomainDecomposition,
+                                     t_idef             *idef)
+{
+    bt->sortedOnLocality = false;
+
+    if (!haveDomainDecomposition ||
+        (idef->ilsort != ilsortNO_FE && idef->ilsort != ilsortFE_SORTED))
+    {
+        return;
+    }
+
+    for (int ftype = 0; ftype < F_NRE; ftype++)
+    {
+        t_ilist *il = &idef->il[ftype];
+
+        if (il->nr == 0 || !ftypeCanBeReordered(ftype))
+        {
+            continue;
+        }
+
+        if (idef->ilsort == ilsortFE_SORTED)
+        {
+            sortInteractionsByLocality(bt, il, NRAL(ftype), 0, il->nr_nonperturbed);
+            sortInteractionsByLocality(bt, il, NRAL(ftype), il->nr_nonperturbed, il->nr);
+        }
+        else
+        {
+            sortInteractionsByLocality(bt, il, NRAL(ftype), 0, il->nr);
+        }
+    }
+
+    bt->sortedOnLocality = true;
+}
+
 /*! \brief struct for passing all data required for a function type */
 typedef struct {
     const t_ilist *il;    /**< pointer to t_ilist entry corresponding to ftype */
@@ -85,9 +206,15 @@ static void divide_bondeds_by_locality(bonded_threading_t *bt,
                                        int                 ntype,
                                        const ilist_data_t *ild)
 {
+    /* Returns the locality key with sorted lists, the first atom otherwise */
+    auto divisionKey = [bt](const t_iatom *iatoms, int nral)
+        {
+            return (bt->sortedOnLocality ? localityKey(iatoms, nral) : iatoms[1]);
+        };
+
     int nat_tot, nat_sum;
     int ind[F_NRE];    /* index into the ild[].il->iatoms */
-    int at_ind[F_NRE]; /* index of the first atom of the interaction at ind */
+    int at_ind[F_NRE]; /* locality key of the interaction at ind */
     int f, t;
 
     assert(ntype <= F_NRE);
@@ -101,7 +228,7 @@ static void divide_bondeds_by_locality(bonded_threading_t *bt,
         ind[f]    = 0;
         /* Initialize the next atom index array */
         assert(ild[f].il->nr > 0);
-        at_ind[f] = ild[f].il->iatoms[1];
+        at_ind[f] = divisionKey(ild[f].il->iatoms, ild[f].nat);
     }
 
     nat_sum = 0;
@@ -132,15 +259,14 @@ static void divide_bondeds_by_locality(bonded_threading_t *bt,
         while (nat_sum < nat_thread)
         {
             /* To divide bonds based on atom order, we compare
-             * the index of the first atom in the bonded interaction.
-             * This works well, since the domain decomposition generates
-             * bondeds in order of the atoms by looking up interactions
-             * which are linked to the first atom in each interaction.
-             * It usually also works well without DD, since than the atoms
-             * in bonded interactions are usually in increasing order.
-             * If they are not assigned in increasing order, the balancing
-             * is still good, but the memory access and reduction cost will
-             * be higher.
+             * the lowest atom index in the bonded interaction.
+             * This works well, since with domain decomposition
+             * sort_bondeds_by_locality() has sorted the interactions
+             * on this index. Without DD we compare the first atom,
+             * since the atoms in bonded interactions are usually in
+             * increasing order. If they are not assigned in increasing
+             * order, the balancing is still good, but the memory
+             * access and reduction cost will be higher.
              */
             int f_min;
 
@@ -164,7 +290,8 @@ static void divide_bondeds_by_locality(bonded_threading_t *bt,
             /* Update the first unassigned atom index for this type */
             if (ind[f_min] < ild[f_min].il->nr)
             {
-                at_ind[f_min] = ild[f_min].il->iatoms[ind[f_min] + 1];
+                at_ind[f_min] = divisionKey(ild[f_min].il->iatoms + ind[f_min],
+                                            ild[f_min].nat);
             }
             else
             {
@@ -278,6 +405,23 @@ static void divide_bondeds_over_threads(bonded_threading_t *bt,
                         nr_t += stride;
                     }
                 }
+                else if (bt->sortedOnLocality && ftypeCanBeReordered(ftype))
+                {
+                    /* Keep interactions with their lowest atom in the same
+                     * reduction block on one thread. This reduces the number
+                     * of blocks shared between neighbouring threads, but the
+                     * other atoms of these interactions can still be in
+                     * blocks that other threads also write to.
+                     * The interactions are sorted, so this moves the bound
+                     * by at most the interactions of one block.
+                     */
+                    while (nr_t > 0 && nr_t < nrToAssignToCpuThreads &&
+                           (localityKey(il.iatoms + nr_t, NRAL(ftype)) >> reduction_block_bits) ==
+                           (localityKey(il.iatoms + nr_t - stride, NRAL(ftype)) >> reduction_block_bits))
+                    {
+                        nr_t += stride;
+                    }
+                }
 
                 bt->workDivision.setBound(ftype, t, nr_t);
             }
@@ -404,12 +548,18 @@ calc_bonded_reduction_mask(int                       natoms,
 void setup_bonded_threading(bonded_threading_t *bt,
                             int                 numAtoms,
                             bool                useGpuForBondeds,
-                            const t_idef       &idef)
+                            bool                haveDomainDecomposition,
+                            t_idef             *idefPtr)
 {
     int                 ctot = 0;
 
     assert(bt->nthreads >= 1);
 
+    /* Make the interactions of each thread spatially compact */
+    sort_bondeds_by_locality(bt, haveDomainDecomposition, idefPtr);
+
+    const t_idef &idef = *idefPtr;
+
     /* Divide the bonded interaction over the threads */
     divide_bondeds_over_threads(bt, useGpuForBondeds, idef);
 
@@ -516,7 +666,8 @@ bonded_threading_t::bonded_threading_t(const int numThreads,
     nblock_used(0),
     haveBondeds(false),
     workDivision(nthreads),
-    foreignLambdaWorkDivision(1)
+    foreignLambdaWorkDivision(1),
+    sortedOnLocality(false)
 {
     f_t.resize(numThreads);
 #pragma omp parallel for num_threads(nthreads) schedule(static)
@@ -53,13 +53,18 @@ struct t_idef;
  *
  * Uses fr->nthreads for the number of threads, and sets up the
  * thread-force buffer reduction.
+ * With domain decomposition, before dividing, the bonded interaction
+ * lists in \p idef are sorted on the lowest local atom index of each
+ * interaction, so the order of the interactions in \p idef changes.
+ * Distance and orientation restraints keep their order.
  * This should be called each time the bonded setup changes;
  * i.e. at start-up without domain decomposition and at DD.
  */
 void setup_bonded_threading(bonded_threading_t *bt,
                             int                 numAtoms,
                             bool                useGpuForBondes,
-                            const t_idef       &idef);
+                            bool                haveDomainDecomposition,
+                            t_idef             *idef);
 
 //! Destructor.
 void tear_down_bonded_threading(bonded_threading_t *bt);
@@ -48,6 +48,10 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstdint>
+
+#include <algorithm>
+#include <vector>
 
 #include "gromacs/gmxlib/nrnb.h"
 #include "gromacs/math/functions.h"
@@ -58,11 +62,16 @@
 #include "gromacs/mdtypes/inputrec.h"
 #include "gromacs/mdtypes/md_enums.h"
 #include "gromacs/pbcutil/pbc.h"
+#include "gromacs/pbcutil/pbc_simd.h"
+#include "gromacs/simd/simd.h"
 #include "gromacs/timing/wallcycle.h"
 #include "gromacs/topology/idef.h"
 #include "gromacs/utility/basedefinitions.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 
+#include "listed_internal.h"
+
 struct gmx_wallcycle;
 
 namespace
@@ -179,53 +188,150 @@ real do_fbposres_cylinder(int fbdim, rvec fm, rvec dx, real rfb, real kk, gmx_bo
     return v;
 }
 
+#if GMX_SIMD_HAVE_REAL
+//! The number of restraints computed together, thread ranges start at multiples of this
+constexpr int c_restraintBlockSize = GMX_SIMD_REAL_WIDTH;
+#else
+//! The number of restraints computed together, thread ranges start at multiples of this
+constexpr int c_restraintBlockSize = 1;
+#endif
+
+//! The minimum number of restraints per thread, below this OpenMP overhead dominates
+constexpr int c_minRestraintsPerThread = 256;
+
+/*! \brief Settings for computing the reference positions of restraints */
+struct ReferenceSetup
+{
+    const t_pbc *pbc;              //!< PBC information, nullptr without PBC
+    int          refcoord_scaling; //!< The refcoord-scaling type
+    int          npbcdim;          //!< The number of dimensions with PBC
+    rvec         comA_sc;          //!< The scaled COM of the reference in state A
+    rvec         comB_sc;          //!< The scaled COM of the reference in state B
+};
+
+//! Returns the reference setup, with the scaled COMs for erscCOM
+ReferenceSetup makeReferenceSetup(const t_pbc *pbc,
+                                  int refcoord_scaling, int ePBC,
+                                  const rvec comA, const rvec comB)
+{
+    ReferenceSetup setup;
+
+    setup.pbc              = pbc;
+    setup.refcoord_scaling = refcoord_scaling;
+    setup.npbcdim          = ePBC2npbcdim(ePBC);
+    GMX_ASSERT((ePBC == epbcNONE) ==  (setup.npbcdim == 0), "");
+    clear_rvec(setup.comA_sc);
+    clear_rvec(setup.comB_sc);
+    if (refcoord_scaling == erscCOM)
+    {
+        for (int m = 0; m < setup.npbcdim; m++)
+        {
+            assert(setup.npbcdim <= DIM);
+            for (int d = m; d < setup.npbcdim; d++)
+            {
+                setup.comA_sc[m] += comA[d]*pbc->box[d][m];
+                setup.comB_sc[m] += comB[d]*pbc->box[d][m];
+            }
+        }
+    }
+
+    return setup;
+}
+
+/*! \brief Computes restraints over threads using \p computeRange
+ *
+ * \p computeRange is called with a range of restraint indices and
+ * the output to accumulate to. The ranges start at multiples of
+ * c_restraintBlockSize. The thread outputs are summed in thread
+ * order, so the result does not depend on the OpenMP scheduling.
+ */
+template<typename ComputeRange>
+PositionRestraintOutput
+computeOverThreads(bonded_threading_t *bt,
+                   int                 numRestraints,
+                   ComputeRange        computeRange)
+{
+    const int numBlocks  = (numRestraints + c_restraintBlockSize - 1)/c_restraintBlockSize;
+    const int numThreads = std::max(1, std::min(bt->nthreads, numRestraints/c_minRestraintsPerThread));
+
+    std::vector<PositionRestraintOutput> &threadOutput = bt->posresThreadOutput;
+    threadOutput.resize(numThreads);
+
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+    for (int t = 0; t < numThreads; t++)
+    {
+        try
+        {
+            const int start = (numBlocks*t/numThreads)*c_restraintBlockSize;
+            const int end   = std::min(numRestraints, (numBlocks*(t + 1)/numThreads)*c_restraintBlockSize);
+
+            threadOutput[t] = PositionRestraintOutput();
+            computeRange(start, end, &threadOutput[t]);
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+
+    PositionRestraintOutput output;
+    for (const PositionRestraintOutput &out : threadOutput)
+    {
+        output.v         += out.v;
+        output.dvdlambda += out.dvdlambda;
+        rvec_inc(output.virial, out.virial);
+    }
+
+    return output;
+}
+
+/*! \brief Adds the restraint forces stored in \p forceBuffer to \p f
+ *
+ * This is done serially, since atoms can have multiple restraints.
+ */
+void addRestraintForces(int numRestraints, const t_iatom forceatoms[],
+                        const real *forceBuffer, int bufferStride,
+                        rvec f[])
+{
+    for (int r = 0; r < numRestraints; r++)
+    {
+        const int ai = forceatoms[2*r + 1];
+        for (int m = 0; m < DIM; m++)
+        {
+            f[ai][m] += forceBuffer[m*bufferStride + r];
+        }
+    }
+}
+
 /*! \brief Compute energies and forces for flat-bottomed position restraints
+ * with index \p start to \p end
  *
- * Returns the flat-bottomed potential. Same PBC treatment as in
- * normal position restraints */
-real fbposres(int nbonds,
+ * Same PBC treatment as in normal position restraints.
+ * The forces are stored in \p forceBuffer, the energy and
+ * virial are added to \p output.
+ */
+void fbposres(int start, int end,
               const t_iatom forceatoms[], const t_iparams forceparams[],
               const rvec x[],
-              gmx::ForceWithVirial *forceWithVirial,
-              const t_pbc *pbc,
-              int refcoord_scaling, int ePBC, const rvec com)
+              const ReferenceSetup &setup,
+              real *forceBuffer, int bufferStride,
+              PositionRestraintOutput *output)
 /* compute flat-bottomed positions restraints */
 {
-    int              i, ai, m, d, type, npbcdim = 0, fbdim;
+    int              r, ai, m, type, fbdim;
     const t_iparams *pr;
     real             kk, v;
     real             dr, dr2, rfb, rfb2, fact;
-    rvec             com_sc, rdist, dx, dpdl, fm;
+    rvec             rdist, dx, dpdl, fm;
     gmx_bool         bInvert;
 
-    npbcdim = ePBC2npbcdim(ePBC);
-    GMX_ASSERT((ePBC == epbcNONE) ==  (npbcdim == 0), "");
-    if (refcoord_scaling == erscCOM)
-    {
-        clear_rvec(com_sc);
-        for (m = 0; m < npbcdim; m++)
-        {
-            assert(npbcdim <= DIM);
-            for (d = m; d < npbcdim; d++)
-            {
-                com_sc[m] += com[d]*pbc->box[d][m];
-            }
-        }
-    }
-
-    rvec *f      = as_rvec_array(forceWithVirial->force_.data());
-    real  vtot   = 0.0;
-    rvec  virial = { 0 };
-    for (i = 0; (i < nbonds); )
+    for (r = start; r < end; r++)
     {
-        type = forceatoms[i++];
-        ai   = forceatoms[i++];
+        type = forceatoms[2*r];
+        ai   = forceatoms[2*r + 1];
         pr   = &forceparams[type];
 
         /* same calculation as for normal posres, but with identical A and B states, and lambda==0 */
         posres_dx(x[ai], forceparams[type].fbposres.pos0, forceparams[type].fbposres.pos0,
-                  com_sc, com_sc, 0.0,
-                  pbc, refcoord_scaling, npbcdim,
+                  setup.comA_sc, setup.comA_sc, 0.0,
+                  setup.pbc, setup.refcoord_scaling, setup.npbcdim,
                   dx, rdist, dpdl);
 
         clear_rvec(fm);
@@ -294,104 +400,275 @@ real fbposres(int nbonds,
                 break;
         }
 
-        vtot += v;
+        output->v += v;
 
         for (m = 0; (m < DIM); m++)
         {
-            f[ai][m]  += fm[m];
+            forceBuffer[m*bufferStride + r] = fm[m];
             /* Here we correct for the pbc_dx which included rdist */
-            virial[m] -= 0.5*(dx[m] + rdist[m])*fm[m];
+            output->virial[m] -= 0.5*(dx[m] + rdist[m])*fm[m];
         }
     }
-
-    forceWithVirial->addVirialContribution(virial);
-
-    return vtot;
 }
 
 
-/*! \brief Compute energies and forces, when requested, for position restraints
+/*! \brief Compute energies and forces, when requested, for position
+ * restraints with index \p start to \p end
  *
  * Note that position restraints require a different pbc treatment
- * from other bondeds */
+ * from other bondeds.
+ * The forces are stored in \p forceBuffer, the energy, dV/dlambda
+ * and virial are added to \p output.
+ */
 template<bool computeForce>
-real posres(int nbonds,
+void posres(int start, int end,
             const t_iatom forceatoms[], const t_iparams forceparams[],
             const rvec x[],
-            gmx::ForceWithVirial *forceWithVirial,
-            const struct t_pbc *pbc,
-            real lambda, real *dvdlambda,
-            int refcoord_scaling, int ePBC, const rvec comA, const rvec comB)
+            const ReferenceSetup &setup,
+            real lambda,
+            real *forceBuffer, int bufferStride,
+            PositionRestraintOutput *output)
 {
-    int              i, ai, m, d, type, npbcdim = 0;
+    int              r, ai, m, type;
     const t_iparams *pr;
     real             kk, fm;
-    rvec             comA_sc, comB_sc, rdist, dpdl, dx;
+    rvec             rdist, dpdl, dx;
 
-    npbcdim = ePBC2npbcdim(ePBC);
-    GMX_ASSERT((ePBC == epbcNONE) ==  (npbcdim == 0), "");
-    if (refcoord_scaling == erscCOM)
+    const real       L1 = 1.0 - lambda;
+
+    for (r = start; r < end; r++)
     {
-        clear_rvec(comA_sc);
-        clear_rvec(comB_sc);
-        for (m = 0; m < npbcdim; m++)
+        type = forceatoms[2*r];
+        ai   = forceatoms[2*r + 1];
+        pr   = &forceparams[type];
+
+        /* return dx, rdist, and dpdl */
+        posres_dx(x[ai], forceparams[type].posres.pos0A, forceparams[type].posres.pos0B,
+                  setup.comA_sc, setup.comB_sc, lambda,
+                  setup.pbc, setup.refcoord_scaling, setup.npbcdim,
+                  dx, rdist, dpdl);
+
+        for (m = 0; (m < DIM); m++)
         {
-            assert(npbcdim <= DIM);
-            for (d = m; d < npbcdim; d++)
+            kk                 = L1*pr->posres.fcA[m] + lambda*pr->posres.fcB[m];
+            fm                 = -kk*dx[m];
+            output->v         += 0.5*kk*dx[m]*dx[m];
+            output->dvdlambda +=
+                0.5*(pr->posres.fcB[m] - pr->posres.fcA[m])*dx[m]*dx[m]
+                + fm*dpdl[m];
+
+            /* Here we correct for the pbc_dx which included rdist */
+            if (computeForce)
             {
-                comA_sc[m] += comA[d]*pbc->box[d][m];
-                comB_sc[m] += comB[d]*pbc->box[d][m];
+                forceBuffer[m*bufferStride + r] = fm;
+                output->virial[m]              -= 0.5*(dx[m] + rdist[m])*fm;
             }
         }
     }
+}
 
-    const real  L1     = 1.0 - lambda;
+#if GMX_SIMD_HAVE_REAL
 
-    rvec       *f;
-    if (computeForce)
+/*! \brief SIMD version of posres()
+ *
+ * \p start should be a multiple of GMX_SIMD_REAL_WIDTH and \p forceBuffer
+ * should have space for restraints up to \p end rounded up to a multiple
+ * of GMX_SIMD_REAL_WIDTH. This kernel does not support screw PBC and for
+ * triclinic boxes it only uses the shortest periodic image for distances
+ * to the reference up to half the smallest box diagonal element.
+ */
+template<bool computeForce>
+void posres_simd(int start, int end,
+                 const t_iatom forceatoms[], const t_iparams forceparams[],
+                 const rvec x[],
+                 const ReferenceSetup &setup,
+                 real lambda,
+                 real *forceBuffer, int bufferStride,
+                 PositionRestraintOutput *output)
+{
+    using namespace gmx;
+
+    /* Parameter offsets of pos0A, fcA, pos0B and fcB in param */
+    constexpr int                               c_pos0A = 0;
+    constexpr int                               c_fcA   = DIM*GMX_SIMD_REAL_WIDTH;
+    constexpr int                               c_pos0B = 2*DIM*GMX_SIMD_REAL_WIDTH;
+    constexpr int                               c_fcB   = 3*DIM*GMX_SIMD_REAL_WIDTH;
+
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t    ai[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real            param[4*DIM*GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real            pbc_simd[9*GMX_SIMD_REAL_WIDTH];
+
+    const SimdReal                              lambda_S(lambda);
+    const SimdReal                              L1_S(1.0 - lambda);
+    const SimdReal                              half_S(0.5);
+    SimdReal                                    v_S    = setZero();
+    SimdReal                                    dvdl_S = setZero();
+    SimdReal                                    virial_S[DIM];
+    SimdReal                                    x_S[DIM], dx_S[DIM], rdist_S[DIM], dpdl_S[DIM];
+
+    for (int m = 0; m < DIM; m++)
     {
-        GMX_ASSERT(forceWithVirial != nullptr, "When forces are requested we need a force object");
-        f              = as_rvec_array(forceWithVirial->force_.data());
+        virial_S[m] = setZero();
     }
-    real        vtot   = 0.0;
-    /* Use intermediate virial buffer to reduce reduction rounding errors */
-    rvec        virial = { 0 };
-    for (i = 0; (i < nbonds); )
+
+    set_pbc_simd(setup.pbc, pbc_simd);
+
+    for (int r = start; r < end; r += GMX_SIMD_REAL_WIDTH)
     {
-        type = forceatoms[i++];
-        ai   = forceatoms[i++];
-        pr   = &forceparams[type];
+        /* Collect atoms and parameters for GMX_SIMD_REAL_WIDTH restraints.
+         * At the end fill with the last atom and zero force constants.
+         */
+        for (int s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+        {
+            const int        rs = std::min(r + s, end - 1);
+            const t_iparams &pr = forceparams[forceatoms[2*rs]];
 
-        /* return dx, rdist, and dpdl */
-        posres_dx(x[ai], forceparams[type].posres.pos0A, forceparams[type].posres.pos0B,
-                  comA_sc, comB_sc, lambda,
-                  pbc, refcoord_scaling, npbcdim,
-                  dx, rdist, dpdl);
+            ai[s] = forceatoms[2*rs + 1];
+            for (int m = 0; m < DIM; m++)
+            {
+                const real fcScale = (r + s < end ? 1 : 0);
 
-        for (m = 0; (m < DIM); m++)
+                param[c_pos0A + m*GMX_SIMD_REAL_WIDTH + s] = pr.posres.pos0A[m];
+                param[c_fcA   + m*GMX_SIMD_REAL_WIDTH + s] = fcScale*pr.posres.fcA[m];
+                param[c_pos0B + m*GMX_SIMD_REAL_WIDTH + s] = pr.posres.pos0B[m];
+                param[c_fcB   + m*GMX_SIMD_REAL_WIDTH + s] = fcScale*pr.posres.fcB[m];
+            }
+        }
+
+        gatherLoadUTranspose<3>(reinterpret_cast<const real *>(x), ai, &x_S[XX], &x_S[YY], &x_S[ZZ]);
+
+        /* The same reference computation as in posres_dx() */
+        for (int m = 0; m < DIM; m++)
         {
-            kk          = L1*pr->posres.fcA[m] + lambda*pr->posres.fcB[m];
-            fm          = -kk*dx[m];
-            vtot       += 0.5*kk*dx[m]*dx[m];
-            *dvdlambda +=
-                0.5*(pr->posres.fcB[m] - pr->posres.fcA[m])*dx[m]*dx[m]
-                + fm*dpdl[m];
+            SimdReal posA_S = load<SimdReal>(param + c_pos0A + m*GMX_SIMD_REAL_WIDTH);
+            SimdReal posB_S = load<SimdReal>(param + c_pos0B + m*GMX_SIMD_REAL_WIDTH);
+            SimdReal ref_S  = setZero();
+
+            if (m < setup.npbcdim && setup.refcoord_scaling != erscALL)
+            {
+                rdist_S[m] = L1_S*posA_S + lambda_S*posB_S;
+                dpdl_S[m]  = posB_S - posA_S;
+                if (setup.refcoord_scaling == erscCOM)
+                {
+                    ref_S      = L1_S*SimdReal(setup.comA_sc[m]) + lambda_S*SimdReal(setup.comB_sc[m]);
+                    dpdl_S[m]  = dpdl_S[m] + SimdReal(setup.comB_sc[m] - setup.comA_sc[m]);
+                }
+            }
+            else
+            {
+                if (m < setup.npbcdim)
+                {
+                    /* Box relative coordinates are stored for dimensions with pbc */
+                    const matrix &box = setup.pbc->box;
+
+                    posA_S = posA_S*SimdReal(box[m][m]);
+                    posB_S = posB_S*SimdReal(box[m][m]);
+                    for (int d = m + 1; d < setup.npbcdim; d++)
+                    {
+                        posA_S = fma(load<SimdReal>(param + c_pos0A + d*GMX_SIMD_REAL_WIDTH), SimdReal(box[d][m]), posA_S);
+                        posB_S = fma(load<SimdReal>(param + c_pos0B + d*GMX_SIMD_REAL_WIDTH), SimdReal(box[d][m]), posB_S);
+                    }
+                }
+                ref_S      = L1_S*posA_S + lambda_S*posB_S;
+                rdist_S[m] = setZero();
+                dpdl_S[m]  = posB_S - posA_S;
+            }
+
+            /* We do pbc_dx with ref+rdist,
+             * since with only ref we can be up to half a box vector wrong.
+             */
+            dx_S[m] = x_S[m] - (ref_S + rdist_S[m]);
+        }
+
+        pbc_correct_dx_simd(&dx_S[XX], &dx_S[YY], &dx_S[ZZ], pbc_simd);
+
+        for (int m = 0; m < DIM; m++)
+        {
+            SimdReal fcA_S = load<SimdReal>(param + c_fcA + m*GMX_SIMD_REAL_WIDTH);
+            SimdReal fcB_S = load<SimdReal>(param + c_fcB + m*GMX_SIMD_REAL_WIDTH);
+            SimdReal kk_S  = L1_S*fcA_S + lambda_S*fcB_S;
+            SimdReal fm_S  = -kk_S*dx_S[m];
+            SimdReal dx2_S = dx_S[m]*dx_S[m];
+
+            v_S    = fma(half_S*kk_S, dx2_S, v_S);
+            dvdl_S = dvdl_S + half_S*(fcB_S - fcA_S)*dx2_S + fm_S*dpdl_S[m];
 
-            /* Here we correct for the pbc_dx which included rdist */
             if (computeForce)
             {
-                f[ai][m]  += fm;
-                virial[m] -= 0.5*(dx[m] + rdist[m])*fm;
+                store(forceBuffer + m*bufferStride + r, fm_S);
+                /* Here we correct for the pbc_dx which included rdist */
+                virial_S[m] = fnma(half_S*(dx_S[m] + rdist_S[m]), fm_S, virial_S[m]);
             }
         }
     }
 
+    output->v         += reduce(v_S);
+    output->dvdlambda += reduce(dvdl_S);
     if (computeForce)
     {
-        forceWithVirial->addVirialContribution(virial);
+        for (int m = 0; m < DIM; m++)
+        {
+            output->virial[m] += reduce(virial_S[m]);
+        }
     }
+}
 
-    return vtot;
+#endif // GMX_SIMD_HAVE_REAL
+
+/*! \brief Compute energies and forces, when requested, for all position restraints
+ *
+ * The restraints are computed over threads, with SIMD when available.
+ * Returns the energy, dV/dlambda and virial contribution.
+ */
+template<bool computeForce>
+PositionRestraintOutput
+posresOverThreads(const t_ilist &il, const t_iparams forceparams[],
+                  const rvec x[],
+                  rvec *f,
+                  const t_pbc *pbc,
+                  real lambda,
+                  int refcoord_scaling, int ePBC, const rvec comA, const rvec comB,
+                  bonded_threading_t *bt)
+{
+    const ReferenceSetup setup         = makeReferenceSetup(pbc, refcoord_scaling, ePBC, comA, comB);
+    const int            numRestraints = gmx::exactDiv(il.nr, 2);
+    const int            bufferStride  = (numRestraints + c_restraintBlockSize - 1)/c_restraintBlockSize*c_restraintBlockSize;
+    real                *forceBuffer   = nullptr;
+    if (computeForce)
+    {
+        GMX_ASSERT(f != nullptr, "When forces are requested we need a force array");
+        bt->posresForceBuffer.resize(DIM*bufferStride);
+        forceBuffer = bt->posresForceBuffer.data();
+    }
+
+#if GMX_SIMD_HAVE_REAL
+    const bool useSimd = (pbc == nullptr || pbc->ePBC != epbcSCREW);
+#endif
+
+    PositionRestraintOutput output =
+        computeOverThreads(bt, numRestraints,
+                           [&](int start, int end, PositionRestraintOutput *out)
+                           {
+#if GMX_SIMD_HAVE_REAL
+                               if (useSimd)
+                               {
+                                   posres_simd<computeForce>(start, end, il.iatoms, forceparams, x,
+                                                             setup, lambda,
+                                                             forceBuffer, bufferStride, out);
+                                   return;
+                               }
+#endif
+                               posres<computeForce>(start, end, il.iatoms, forceparams, x,
+                                                    setup, lambda,
+                                                    forceBuffer, bufferStride, out);
+                           });
+
+    if (computeForce)
+    {
+        addRestraintForces(numRestraints, il.iatoms, forceBuffer, bufferStride, f);
+    }
+
+    return output;
 }
 
 } // namespace
@@ -406,21 +683,22 @@ posres_wrapper(t_nrnb               *nrnb,
                const t_forcerec     *fr,
                gmx::ForceWithVirial *forceWithVirial)
 {
-    real  v, dvdl;
-
-    dvdl = 0;
-    v    = posres<true>(idef->il[F_POSRES].nr, idef->il[F_POSRES].iatoms,
-                        idef->iparams_posres,
-                        x,
-                        forceWithVirial,
-                        fr->ePBC == epbcNONE ? nullptr : pbc,
-                        lambda[efptRESTRAINT], &dvdl,
-                        fr->rc_scaling, fr->ePBC, fr->posres_com, fr->posres_comB);
-    enerd->term[F_POSRES] += v;
+    GMX_ASSERT(forceWithVirial != nullptr, "When forces are requested we need a force object");
+
+    PositionRestraintOutput output =
+        posresOverThreads<true>(idef->il[F_POSRES], idef->iparams_posres,
+                                x,
+                                as_rvec_array(forceWithVirial->force_.data()),
+                                fr->ePBC == epbcNONE ? nullptr : pbc,
+                                lambda[efptRESTRAINT],
+                                fr->rc_scaling, fr->ePBC, fr->posres_com, fr->posres_comB,
+                                fr->bondedThreading);
+    forceWithVirial->addVirialContribution(output.virial);
+    enerd->term[F_POSRES] += output.v;
     /* If just the force constant changes, the FEP term is linear,
      * but if k changes, it is not.
      */
-    enerd->dvdl_nonlin[efptRESTRAINT] += dvdl;
+    enerd->dvdl_nonlin[efptRESTRAINT] += output.dvdlambda;
     inc_nrnb(nrnb, eNR_POSRES, gmx::exactDiv(idef->il[F_POSRES].nr, 2));
 }
 
@@ -434,8 +712,6 @@ posres_wrapper_lambda(struct gmx_wallcycle *wcycle,
                       const real           *lambda,
                       const t_forcerec     *fr)
 {
-    real  v;
-
     if (0 == idef->il[F_POSRES].nr)
     {
         return;
@@ -444,15 +720,16 @@ posres_wrapper_lambda(struct gmx_wallcycle *wcycle,
     wallcycle_sub_start_nocount(wcycle, ewcsRESTRAINTS);
     for (size_t i = 0; i < enerd->enerpart_lambda.size(); i++)
     {
-        real dvdl_dum = 0, lambda_dum;
+        real lambda_dum;
 
         lambda_dum = (i == 0 ? lambda[efptRESTRAINT] : fepvals->all_lambda[efptRESTRAINT][i-1]);
-        v          = posres<false>(idef->il[F_POSRES].nr, idef->il[F_POSRES].iatoms,
-                                   idef->iparams_posres,
-                                   x, nullptr,
-                                   fr->ePBC == epbcNONE ? nullptr : pbc, lambda_dum, &dvdl_dum,
-                                   fr->rc_scaling, fr->ePBC, fr->posres_com, fr->posres_comB);
-        enerd->enerpart_lambda[i] += v;
+        PositionRestraintOutput output =
+            posresOverThreads<false>(idef->il[F_POSRES], idef->iparams_posres,
+                                     x, nullptr,
+                                     fr->ePBC == epbcNONE ? nullptr : pbc, lambda_dum,
+                                     fr->rc_scaling, fr->ePBC, fr->posres_com, fr->posres_comB,
+                                     fr->bondedThreading);
+        enerd->enerpart_lambda[i] += output.v;
     }
     wallcycle_sub_stop(wcycle, ewcsRESTRAINTS);
 }
@@ -467,14 +744,28 @@ void fbposres_wrapper(t_nrnb               *nrnb,
                       const t_forcerec     *fr,
                       gmx::ForceWithVirial *forceWithVirial)
 {
-    real  v;
-
-    v = fbposres(idef->il[F_FBPOSRES].nr, idef->il[F_FBPOSRES].iatoms,
-                 idef->iparams_fbposres,
-                 x,
-                 forceWithVirial,
-                 fr->ePBC == epbcNONE ? nullptr : pbc,
-                 fr->rc_scaling, fr->ePBC, fr->posres_com);
-    enerd->term[F_FBPOSRES] += v;
-    inc_nrnb(nrnb, eNR_FBPOSRES, gmx::exactDiv(idef->il[F_FBPOSRES].nr, 2));
+    const t_ilist        &il            = idef->il[F_FBPOSRES];
+    const ReferenceSetup  setup         = makeReferenceSetup(fr->ePBC == epbcNONE ? nullptr : pbc,
+                                                             fr->rc_scaling, fr->ePBC,
+                                                             fr->posres_com, fr->posres_com);
+    const int             numRestraints = gmx::exactDiv(il.nr, 2);
+    const int             bufferStride  = (numRestraints + c_restraintBlockSize - 1)/c_restraintBlockSize*c_restraintBlockSize;
+    bonded_threading_t   *bt            = fr->bondedThreading;
+
+    bt->posresForceBuffer.resize(DIM*bufferStride);
+    real                 *forceBuffer = bt->posresForceBuffer.data();
+
+    PositionRestraintOutput output =
+        computeOverThreads(bt, numRestraints,
+                           [&](int start, int end, PositionRestraintOutput *out)
+                           {
+                               fbposres(start, end, il.iatoms, idef->iparams_fbposres, x,
+                                        setup, forceBuffer, bufferStride, out);
+                           });
+
+    addRestraintForces(numRestraints, il.iatoms, forceBuffer, bufferStride,
+                       as_rvec_array(forceWithVirial->force_.data()));
+    forceWithVirial->addVirialContribution(output.virial);
+    enerd->term[F_FBPOSRES] += output.v;
+    inc_nrnb(nrnb, eNR_FBPOSRES, numRestraints);
 }
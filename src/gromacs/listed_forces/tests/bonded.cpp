@@ -45,6 +45,7 @@
 
 #include <cmath>
 
+#include <algorithm>
 #include <memory>
 #include <unordered_map>
 
@@ -56,6 +57,7 @@
 #include "gromacs/math/vectypes.h"
 #include "gromacs/mdtypes/mdatom.h"
 #include "gromacs/pbcutil/ishift.h"
+#include "gromacs/pbcutil/mshift.h"
 #include "gromacs/pbcutil/pbc.h"
 #include "gromacs/topology/idef.h"
 #include "gromacs/utility/strconvert.h"
@@ -82,8 +84,8 @@ struct OutputQuantities
     real  dvdlambda      = 0;
     //! Shift vectors
     rvec  fshift[N_IVEC] = {{0}};
-    //! Forces
-    rvec4 f[c_numAtoms]  = {{0}};
+    //! Forces, aligned as the SIMD kernels require
+    alignas(4*sizeof(real)) rvec4 f[c_numAtoms] = {{0}};
 };
 
 /*! \brief Utility to check the output from bonded tests
@@ -562,6 +564,115 @@ class ListedForcesTest : public ::testing::TestWithParam<std::tuple<iListInput,
             // and bonded functions.
             EXPECT_TRUE((input_.fep || (output.dvdlambda == 0.0)));
             checkOutput(checker, output);
+            if (!input_.fep)
+            {
+                // Also test with periodic images of atoms, which gives
+                // contributions to non-central shift forces.
+                std::vector<gmx::RVec> xShifted(x_);
+                if (epbc_ != epbcNONE)
+                {
+                    rvec_inc(xShifted.front(), box_[XX]);
+                    rvec_dec(xShifted.back(), box_[YY]);
+                }
+                // And with a graph, which sets the shifts of the atoms.
+                ivec    graphShifts[c_numAtoms + 1] = { { 1, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 }, { 0, -1, 0 }, { 0, 0, 0 } };
+                t_graph graph                       = {};
+                graph.ishift                        = graphShifts;
+                for (bool computeEnergyAndVirial : { false, true })
+                {
+                    testSimdIfunc(iatoms, x_, nullptr, computeEnergyAndVirial);
+                    testSimdIfunc(iatoms, xShifted, nullptr, computeEnergyAndVirial);
+                    testSimdIfunc(iatoms, x_, &graph, computeEnergyAndVirial);
+                }
+            }
+        }
+        /*! \brief Compares a SIMD kernel, when present, with the plain-C kernel
+         *
+         * \param[in] iatoms                 The interaction list
+         * \param[in] x                      The coordinates
+         * \param[in] g                      The graph with the shifts of the atoms, can be nullptr
+         * \param[in] computeEnergyAndVirial Whether to test the kernel computing energies and shift forces
+         */
+        void testSimdIfunc(const std::vector<t_iatom>   &iatoms,
+                           const std::vector<gmx::RVec> &x,
+                           const t_graph                *g,
+                           bool                          computeEnergyAndVirial)
+        {
+            BondedFunction simdFunction = simdBondedFunction(input_.ftype, computeEnergyAndVirial);
+            if (simdFunction == nullptr)
+            {
+                return;
+            }
+            SCOPED_TRACE(std::string("Testing SIMD kernel ") +
+                         (computeEnergyAndVirial ? "with" : "without") + " energy and virial" +
+                         (g ? " and a graph" : ""));
+            // The SIMD kernels might read beyond the last atom
+            std::vector<gmx::RVec> xPadded(x);
+            xPadded.resize(x.size() + 1, { 0, 0, 0 });
+            OutputQuantities  reference;
+            reference.energy = bondedFunction(input_.ftype) (iatoms.size(),
+                                                             iatoms.data(),
+                                                             &input_.iparams,
+                                                             as_rvec_array(xPadded.data()),
+                                                             reference.f, reference.fshift,
+                                                             &pbc_, g,
+                                                             0.0, &reference.dvdlambda,
+                                                             /* const t_mdatoms *md */ nullptr,
+                                                             /* struct t_fcdata * */ nullptr,
+                                                             /* int *ddgatindex */ nullptr);
+            OutputQuantities  output;
+            output.energy = simdFunction(iatoms.size(),
+                                         iatoms.data(),
+                                         &input_.iparams,
+                                         as_rvec_array(xPadded.data()),
+                                         output.f, output.fshift,
+                                         &pbc_, g,
+                                         0.0, &output.dvdlambda,
+                                         /* const t_mdatoms *md */ nullptr,
+                                         /* struct t_fcdata * */ nullptr,
+                                         /* int *ddgatindex */ nullptr);
+            // The SIMD math functions differ slightly from the plain-C ones,
+            // so we compare relative to the magnitude of the quantities.
+            real forceMagnitude = 0;
+            for (const auto &f : reference.f)
+            {
+                forceMagnitude = std::max(forceMagnitude, std::sqrt(norm2(f)));
+            }
+            const real toler = (GMX_DOUBLE ? input_.dtoler : input_.ftoler);
+            const auto forceTolerance
+                = test::absoluteTolerance(std::max<real>(forceMagnitude, 1)*toler);
+            EXPECT_REAL_EQ_TOL(0, output.dvdlambda, test::ulpTolerance(0));
+            for (int i = 0; i < c_numAtoms; i++)
+            {
+                for (int d = 0; d < DIM; d++)
+                {
+                    EXPECT_REAL_EQ_TOL(reference.f[i][d], output.f[i][d], forceTolerance);
+                }
+            }
+            if (computeEnergyAndVirial)
+            {
+                const auto energyTolerance
+                    = test::absoluteTolerance(std::max<real>(std::abs(reference.energy), 1)*toler);
+                EXPECT_REAL_EQ_TOL(reference.energy, output.energy, energyTolerance);
+                for (int i = 0; i < N_IVEC; i++)
+                {
+                    for (int d = 0; d < DIM; d++)
+                    {
+                        EXPECT_REAL_EQ_TOL(reference.fshift[i][d], output.fshift[i][d], forceTolerance);
+                    }
+                }
+            }
+            else
+            {
+                EXPECT_REAL_EQ_TOL(0, output.energy, test::ulpTolerance(0));
+                for (int i = 0; i < N_IVEC; i++)
+                {
+                    for (int d = 0; d < DIM; d++)
+                    {
+                        EXPECT_REAL_EQ_TOL(0, output.fshift[i][d], test::ulpTolerance(0));
+                    }
+                }
+            }
         }
         void testIfunc()
         {
@@ -685,6 +796,117 @@ INSTANTIATE_TEST_CASE_P(Polarize, ListedForcesTest, ::testing::Combine(::testing
 
 INSTANTIATE_TEST_CASE_P(Restraints, ListedForcesTest, ::testing::Combine(::testing::ValuesIn(c_InputRestraints), ::testing::ValuesIn(c_coordinatesForTests), ::testing::ValuesIn(c_pbcForTests)));
 
+/*! \brief Returns a bicubic polynomial \p v and its derivatives of CMAP grid angles in degrees
+ *
+ * Bicubic interpolation reproduces this polynomial exactly.
+ */
+void cmapPolynomial(double u, double w, double *v, double *dvdu, double *dvdw, double *d2vdudw)
+{
+    // Scale the angles to keep the terms of similar magnitude
+    const double s = u/100;
+    const double t = w/100;
+    *v       = 2 + 0.5*s - 0.3*t + 2*s*t - 0.5*s*s*t + 0.1*s*t*t*t + 0.03*s*s*s;
+    *dvdu    = (0.5 + 2*t - s*t + 0.1*t*t*t + 0.09*s*s)/100;
+    *dvdw    = (-0.3 + 2*s - 0.5*s*s + 0.3*s*t*t)/100;
+    *d2vdudw = (2 - s + 0.3*t*t)/(100*100);
+}
+
+//! Returns the CMAP grid angle in degrees of dihedral angle \p phi in radians
+double cmapGridAngle(real phi)
+{
+    return phi*RAD2DEG + 180;
+}
+
+TEST(CmapTest, InterpolatesBicubicPolynomialWithConsistentForces)
+{
+    const int  gridSpacing = 12;
+    const real gridDx      = 360.0/gridSpacing;
+    gmx_cmap_t cmapGrid;
+    cmapGrid.grid_spacing = gridSpacing;
+    cmapGrid.cmapdata.resize(1);
+    std::vector<real> &cmapData = cmapGrid.cmapdata[0].cmap;
+    cmapData.resize(4*gridSpacing*gridSpacing);
+    for (int i = 0; i < gridSpacing; i++)
+    {
+        for (int j = 0; j < gridSpacing; j++)
+        {
+            double v, dvdu, dvdw, d2vdudw;
+            cmapPolynomial(i*gridDx, j*gridDx, &v, &dvdu, &dvdw, &d2vdudw);
+            const int pos = i*gridSpacing + j;
+            cmapData[pos*4]     = v;
+            cmapData[pos*4 + 1] = dvdu;
+            cmapData[pos*4 + 2] = dvdw;
+            cmapData[pos*4 + 3] = d2vdudw;
+        }
+    }
+    t_iparams              iparams;
+    iparams.cmap.cmapA = 0;
+    iparams.cmap.cmapB = 0;
+    std::vector<t_iatom>   iatoms = { 0, 0, 1, 2, 3, 4 };
+    std::vector<gmx::RVec> x      = {
+        { 0.05, -0.08, 0.1 }, { 0.15, 0.0, 0.0 }, { 0.2, 0.14, 0.0 }, { 0.35, 0.15, 0.06 }, { 0.38, 0.27, 0.14 }
+    };
+
+    // Returns the CMAP energy for coordinates x and, when requested, the forces
+    auto computeCmap = [&](const std::vector<gmx::RVec> &coordinates, std::vector<gmx::RVec> *forces)
+        {
+            alignas(4*sizeof(real)) rvec4 f[5] = {{0}};
+            rvec fshift[N_IVEC]                = {{0}};
+            real dvdlambda                     = 0;
+            real energy                        = cmap_dihs(iatoms.size(), iatoms.data(), &iparams, &cmapGrid,
+                                                           as_rvec_array(coordinates.data()), f, fshift,
+                                                           nullptr, nullptr, 0.0, &dvdlambda,
+                                                           nullptr, nullptr, nullptr);
+            if (forces != nullptr)
+            {
+                forces->resize(coordinates.size());
+                for (size_t i = 0; i < coordinates.size(); i++)
+                {
+                    for (int d = 0; d < DIM; d++)
+                    {
+                        (*forces)[i][d] = f[i][d];
+                    }
+                }
+            }
+            return energy;
+        };
+
+    std::vector<gmx::RVec> forces;
+    const real             energy = computeCmap(x, &forces);
+
+    rvec                   r_ij, r_kj, r_kl, m, n;
+    int                    t1, t2, t3;
+    const real             phi1 = dih_angle(x[0], x[1], x[2], x[3], nullptr, r_ij, r_kj, r_kl, m, n, &t1, &t2, &t3);
+    const real             phi2 = dih_angle(x[1], x[2], x[3], x[4], nullptr, r_ij, r_kj, r_kl, m, n, &t1, &t2, &t3);
+    double                 v, dvdu, dvdw, d2vdudw;
+    cmapPolynomial(cmapGridAngle(phi1), cmapGridAngle(phi2), &v, &dvdu, &dvdw, &d2vdudw);
+    EXPECT_REAL_EQ_TOL(v, energy, test::relativeToleranceAsFloatingPoint(v, GMX_DOUBLE ? 1e-9 : 1e-5));
+
+    // The forces should be minus the derivatives of the energy,
+    // which we compute by central differences
+    const real delta = (GMX_DOUBLE ? 1e-6 : 2e-4);
+    real       forceMagnitude = 0;
+    for (const auto &f : forces)
+    {
+        forceMagnitude = std::max(forceMagnitude, std::sqrt(norm2(f)));
+    }
+    const auto forceTolerance
+        = test::absoluteTolerance(std::max<real>(forceMagnitude, 1)*(GMX_DOUBLE ? 1e-6 : 1e-2));
+    for (size_t i = 0; i < x.size(); i++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            std::vector<gmx::RVec> xDisplaced(x);
+            xDisplaced[i][d] = x[i][d] + delta;
+            const real energyPlus  = computeCmap(xDisplaced, nullptr);
+            xDisplaced[i][d] = x[i][d] - delta;
+            const real energyMinus = computeCmap(xDisplaced, nullptr);
+            EXPECT_REAL_EQ_TOL(-(energyPlus - energyMinus)/(2*delta), forces[i][d], forceTolerance)
+            << "atom " << i << ", dimension " << d;
+        }
+    }
+}
+
 }  // namespace
 
 }  // namespace gmx
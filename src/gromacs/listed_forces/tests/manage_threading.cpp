@@ -0,0 +1,332 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief Tests for the division of listed interactions over threads
+ *
+ * Checks the block-usage masks of the thread-local force buffers and
+ * the reduction of these buffers, with interactions in random order,
+ * as with domain decomposition, against a serial reference.
+ *
+ * \ingroup module_listed_forces
+ */
+#include "gmxpre.h"
+
+#include "gromacs/listed_forces/manage_threading.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/gmxlib/nrnb.h"
+#include "gromacs/listed_forces/bonded.h"
+#include "gromacs/listed_forces/listed_forces.h"
+#include "gromacs/listed_forces/listed_internal.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/mdlib/dispersioncorrection.h"
+#include "gromacs/mdlib/force_flags.h"
+#include "gromacs/mdtypes/enerdata.h"
+#include "gromacs/mdtypes/fcdata.h"
+#include "gromacs/mdtypes/forceoutput.h"
+#include "gromacs/mdtypes/forcerec.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/nbnxm/nbnxm.h"
+#include "gromacs/pbcutil/ishift.h"
+#include "gromacs/topology/idef.h"
+#include "gromacs/topology/ifunc.h"
+#include "gromacs/utility/bitmask.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! The number of atoms, spanning several reduction blocks
+constexpr int c_numAtoms = 400;
+
+/*! \brief Test fixture, parametrized on the number of threads and
+ * on whether we have domain decomposition, which sorts on locality */
+class ListedThreadingTest : public ::testing::TestWithParam < std::tuple < int, bool>>
+{
+    public:
+        ListedThreadingTest() :
+            numThreads_(std::get<0>(GetParam())),
+            haveDomainDecomposition_(std::get<1>(GetParam())),
+            bondedThreading_(numThreads_, 1),
+            x_(c_numAtoms),
+            enerd_(1, 0)
+        {
+            /* With more threads, the interactions are divided by locality */
+            bondedThreading_.max_nthread_uniform = 4;
+
+            iparams_.resize(2);
+            iparams_[0].harmonic.rA  = 0.15;
+            iparams_[0].harmonic.krA = 1000;
+            iparams_[1].harmonic.rA  = 110;
+            iparams_[1].harmonic.krA = 300;
+
+            /* A chain with bonds and angles, and bonds to atoms further
+             * along the chain, that end up in other reduction blocks */
+            std::vector<t_iatom> bonds, angles;
+            for (int a = 0; a + 1 < c_numAtoms; a++)
+            {
+                bonds.insert(bonds.end(), { 0, a, a + 1 });
+                if (a % 7 == 0 && a + 37 < c_numAtoms)
+                {
+                    bonds.insert(bonds.end(), { 0, a + 37, a });
+                }
+                if (a + 2 < c_numAtoms)
+                {
+                    angles.insert(angles.end(), { 1, a, a + 1, a + 2 });
+                }
+            }
+            /* Shuffle the interactions, as the local atom order with
+             * domain decomposition does not follow the topology */
+            bonds_  = permute(bonds, 3);
+            angles_ = permute(angles, 4);
+
+            for (int a = 0; a < c_numAtoms; a++)
+            {
+                x_[a] = { 0.3f*std::cos(1.2f*a), 0.3f*std::sin(1.2f*a), 0.05f*a };
+            }
+
+            idef_.ntypes                   = iparams_.size();
+            idef_.iparams                  = iparams_.data();
+            idef_.il[F_BONDS].nr           = bonds_.size();
+            idef_.il[F_BONDS].iatoms       = bonds_.data();
+            idef_.il[F_ANGLES].nr          = angles_.size();
+            idef_.il[F_ANGLES].iatoms      = angles_.data();
+            idef_.ilsort                   = ilsortNO_FE;
+
+            fshift_.resize(SHIFTS, { 0, 0, 0 });
+            fr_.natoms_force    = c_numAtoms;
+            fr_.fshift          = as_rvec_array(fshift_.data());
+            fr_.efep            = efepNO;
+            fr_.bondedThreading = &bondedThreading_;
+            init_nrnb(&nrnb_);
+        }
+
+        //! Returns \p iatoms with interactions of \p stride entries in a scrambled order
+        static std::vector<t_iatom> permute(const std::vector<t_iatom> &iatoms, int stride)
+        {
+            const int            numInteractions = iatoms.size()/stride;
+            std::vector<t_iatom> permuted;
+            for (int i = 0; i < numInteractions; i++)
+            {
+                /* 7919 is prime, so this is a permutation */
+                const int j = (i*7919) % numInteractions;
+                permuted.insert(permuted.end(), iatoms.begin() + j*stride, iatoms.begin() + (j + 1)*stride);
+            }
+            return permuted;
+        }
+
+        //! Returns the blocks that the interactions assigned to \p thread write to
+        std::set<int> blocksOfThread(int thread) const
+        {
+            std::set<int> blocks;
+            for (int ftype : { F_BONDS, F_ANGLES })
+            {
+                const WorkDivision &workDivision = bondedThreading_.workDivision;
+                const int           stride       = 1 + NRAL(ftype);
+                for (int i = workDivision.bound(ftype, thread); i < workDivision.bound(ftype, thread + 1); i += stride)
+                {
+                    for (int a = 1; a < stride; a++)
+                    {
+                        blocks.insert(idef_.il[ftype].iatoms[i + a] >> reduction_block_bits);
+                    }
+                }
+            }
+            return blocks;
+        }
+
+        //! The number of threads
+        int                    numThreads_;
+        //! Whether to set up as with domain decomposition
+        bool                   haveDomainDecomposition_;
+        //! Threading setup
+        bonded_threading_t     bondedThreading_;
+        //! Interaction parameters
+        std::vector<t_iparams> iparams_;
+        //! The bonds
+        std::vector<t_iatom>   bonds_;
+        //! The angles
+        std::vector<t_iatom>   angles_;
+        //! The interaction definitions
+        t_idef                 idef_ = {};
+        //! The coordinates
+        std::vector<RVec>      x_;
+        //! The shift forces
+        std::vector<RVec>      fshift_;
+        //! Force record with the settings used by the listed forces
+        t_forcerec             fr_;
+        //! Energy output
+        gmx_enerdata_t         enerd_;
+        //! Flop counting
+        t_nrnb                 nrnb_;
+};
+
+TEST_P(ListedThreadingTest, ReductionMasksMatchInteractions)
+{
+    setup_bonded_threading(&bondedThreading_, c_numAtoms, false, haveDomainDecomposition_, &idef_);
+
+    ASSERT_TRUE(bondedThreading_.haveBondeds);
+    EXPECT_EQ(haveDomainDecomposition_, bondedThreading_.sortedOnLocality);
+    for (int ftype : { F_BONDS, F_ANGLES })
+    {
+        EXPECT_EQ(0, bondedThreading_.workDivision.bound(ftype, 0));
+        EXPECT_EQ(idef_.il[ftype].nr, bondedThreading_.workDivision.end(ftype));
+    }
+
+    const int          numBlocks = (c_numAtoms + reduction_block_size - 1) >> reduction_block_bits;
+    std::vector<int>   usedBlocks;
+    std::vector<int>   numThreadsOfBlock(numBlocks, 0);
+    for (int t = 0; t < numThreads_; t++)
+    {
+        const std::set<int> blocks = blocksOfThread(t);
+        const f_thread_t   &threadBuffers = *bondedThreading_.f_t[t];
+        for (int b = 0; b < numBlocks; b++)
+        {
+            const bool isUsed = (blocks.count(b) > 0);
+            EXPECT_EQ(isUsed, bitmask_is_set(threadBuffers.mask[b], t)) << "thread " << t << " block " << b;
+            EXPECT_EQ(isUsed, bitmask_is_set(bondedThreading_.mask[b], t)) << "thread " << t << " block " << b;
+            numThreadsOfBlock[b] += (isUsed ? 1 : 0);
+        }
+        ASSERT_EQ(static_cast<int>(blocks.size()), threadBuffers.nblock_used);
+        EXPECT_TRUE(std::equal(blocks.begin(), blocks.end(), threadBuffers.block_index));
+    }
+    for (int b = 0; b < numBlocks; b++)
+    {
+        if (numThreadsOfBlock[b] > 0)
+        {
+            usedBlocks.push_back(b);
+        }
+    }
+    ASSERT_EQ(static_cast<int>(usedBlocks.size()), bondedThreading_.nblock_used);
+    EXPECT_TRUE(std::equal(usedBlocks.begin(), usedBlocks.end(), bondedThreading_.block_index.begin()));
+
+    if (bondedThreading_.sortedOnLocality && numThreads_ <= bondedThreading_.max_nthread_uniform)
+    {
+        /* The thread bounds are moved such that interactions with
+         * the lowest atom in the same block are on the same thread.
+         * Other atoms of those interactions can still be in blocks
+         * that other threads also write to.
+         */
+        for (int ftype : { F_BONDS, F_ANGLES })
+        {
+            const t_ilist &il     = idef_.il[ftype];
+            const int      stride = 1 + NRAL(ftype);
+            for (int t = 1; t < numThreads_; t++)
+            {
+                const int bound = bondedThreading_.workDivision.bound(ftype, t);
+                if (bound > 0 && bound < il.nr)
+                {
+                    auto lowestAtomBlock = [&il, stride](int i)
+                        {
+                            return *std::min_element(il.iatoms + i + 1, il.iatoms + i + stride) >> reduction_block_bits;
+                        };
+                    EXPECT_NE(lowestAtomBlock(bound - stride), lowestAtomBlock(bound)) << "bound of thread " << t;
+                }
+            }
+        }
+    }
+}
+
+TEST_P(ListedThreadingTest, ReducedForcesMatchSerialReference)
+{
+    /* Compute the reference with the interactions in the original order */
+    std::vector<real> fReference(4*c_numAtoms, 0);
+    rvec              fshiftReference[SHIFTS] = {{ 0 }};
+    real              energyReference[F_NRE]  = { 0 };
+    for (int ftype : { F_BONDS, F_ANGLES })
+    {
+        real dvdlambda          = 0;
+        energyReference[ftype] += bondedFunction(ftype)(idef_.il[ftype].nr, idef_.il[ftype].iatoms, idef_.iparams,
+                                                        as_rvec_array(x_.data()),
+                                                        reinterpret_cast<rvec4 *>(fReference.data()), fshiftReference,
+                                                        nullptr, nullptr, 0, &dvdlambda,
+                                                        nullptr, nullptr, nullptr);
+    }
+
+    setup_bonded_threading(&bondedThreading_, c_numAtoms, false, haveDomainDecomposition_, &idef_);
+
+    std::vector<RVec> f(c_numAtoms, { 0, 0, 0 });
+    ForceWithVirial   forceWithVirial(f, true);
+    t_fcdata          fcd          = {};
+    real              lambda[efptNR] = { 0 };
+    calc_listed(nullptr, nullptr, nullptr, &idef_, as_rvec_array(x_.data()), nullptr,
+                as_rvec_array(f.data()), &forceWithVirial, &fr_, nullptr, nullptr, nullptr,
+                &enerd_, &nrnb_, lambda, nullptr, &fcd, nullptr,
+                GMX_FORCE_FORCES | GMX_FORCE_VIRIAL | GMX_FORCE_ENERGY);
+
+    real forceMagnitude = 0;
+    for (int a = 0; a < c_numAtoms; a++)
+    {
+        forceMagnitude = std::max(forceMagnitude, std::sqrt(norm2(&fReference[4*a])));
+    }
+    const FloatingPointTolerance forceTolerance = relativeToleranceAsFloatingPoint(forceMagnitude, 1e-5);
+    for (int a = 0; a < c_numAtoms; a++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_REAL_EQ_TOL(fReference[4*a + d], f[a][d], forceTolerance) << "atom " << a << " dimension " << d;
+        }
+    }
+    for (int d = 0; d < DIM; d++)
+    {
+        EXPECT_REAL_EQ_TOL(fshiftReference[CENTRAL][d], fshift_[CENTRAL][d], forceTolerance);
+    }
+    for (int ftype : { F_BONDS, F_ANGLES })
+    {
+        EXPECT_REAL_EQ_TOL(energyReference[ftype], enerd_.term[ftype],
+                           relativeToleranceAsFloatingPoint(energyReference[ftype], 1e-5));
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(WithThreadsAndDomainDecomposition, ListedThreadingTest,
+                            ::testing::Combine(::testing::Values(1, 2, 3, 8),
+                                                   ::testing::Bool()));
+
+}  // namespace
+}  // namespace test
+}  // namespace gmx
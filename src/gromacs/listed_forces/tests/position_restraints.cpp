@@ -0,0 +1,561 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief Tests for (flat-bottomed) position restraints
+ *
+ * Checks the position restraint kernels, which use SIMD when available
+ * and are run over threads, against a reference computed in double
+ * precision in the test. A triclinic box that differs from the box
+ * the reference coordinates were generated with mimics pressure
+ * coupling, which matters for refcoord-scaling ALL and COM.
+ *
+ * \ingroup module_listed_forces
+ */
+#include "gmxpre.h"
+
+#include "gromacs/listed_forces/position_restraints.h"
+
+#include <cmath>
+
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/gmxlib/nrnb.h"
+#include "gromacs/listed_forces/listed_internal.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/mdlib/dispersioncorrection.h"
+#include "gromacs/mdtypes/enerdata.h"
+#include "gromacs/mdtypes/forceoutput.h"
+#include "gromacs/mdtypes/forcerec.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/nbnxm/nbnxm.h"
+#include "gromacs/pbcutil/pbc.h"
+#include "gromacs/random/threefry.h"
+#include "gromacs/random/uniformrealdistribution.h"
+#include "gromacs/topology/idef.h"
+#include "gromacs/topology/ifunc.h"
+#include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/real.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+/*! \brief The number of restraints
+ *
+ * Large enough to use 4 threads and not a multiple of the SIMD width.
+ */
+constexpr int c_numRestraints = 1103;
+
+//! The free-energy lambda for the restraints
+constexpr real c_lambda = 0.3;
+
+//! The box the reference coordinates are generated with
+const matrix c_referenceBox = { { 3.1, 0, 0 }, { 0.6, 3.3, 0 }, { -0.4, 0.7, 3.5 } };
+
+//! The current box, scaled and deformed with respect to c_referenceBox
+const matrix c_box = { { 3.16, 0, 0 }, { 0.58, 3.24, 0 }, { -0.42, 0.73, 3.6 } };
+
+//! Reference energy, dV/dlambda, virial and forces, in double precision
+struct ReferenceOutput
+{
+    //! The energy
+    double            v               = 0;
+    //! dV/dlambda
+    double            dvdlambda       = 0;
+    //! The diagonal of the virial
+    DVec              virial          = { 0, 0, 0 };
+    //! The sum of the absolute virial contributions, used for the tolerance
+    double            virialMagnitude = 0;
+    //! The forces
+    std::vector<DVec> f;
+};
+
+/*! \brief Returns the reference position for \p pos0A and \p pos0B
+ *
+ * Stores the part of the position that is not scaled with the box
+ * in \p rdist and d pos/d lambda in \p dpdl, all dimensions have PBC.
+ */
+DVec referencePosition(const rvec pos0A, const rvec pos0B,
+                       const rvec comA, const rvec comB,
+                       int refcoordScaling, double lambda,
+                       DVec *rdist, DVec *dpdl)
+{
+    const double L1 = 1 - lambda;
+    DVec         pos;
+
+    for (int m = 0; m < DIM; m++)
+    {
+        double posA = pos0A[m];
+        double posB = pos0B[m];
+        double ref  = 0;
+        switch (refcoordScaling)
+        {
+            case erscNO:
+                (*rdist)[m] = L1*posA + lambda*posB;
+                (*dpdl)[m]  = posB - posA;
+                break;
+            case erscALL:
+                posA = 0;
+                posB = 0;
+                for (int d = m; d < DIM; d++)
+                {
+                    posA += pos0A[d]*c_box[d][m];
+                    posB += pos0B[d]*c_box[d][m];
+                }
+                ref         = L1*posA + lambda*posB;
+                (*rdist)[m] = 0;
+                (*dpdl)[m]  = posB - posA;
+                break;
+            case erscCOM:
+            {
+                double comA_sc = 0;
+                double comB_sc = 0;
+                for (int d = m; d < DIM; d++)
+                {
+                    comA_sc += comA[d]*c_box[d][m];
+                    comB_sc += comB[d]*c_box[d][m];
+                }
+                ref         = L1*comA_sc + lambda*comB_sc;
+                (*rdist)[m] = L1*posA + lambda*posB;
+                (*dpdl)[m]  = comB_sc - comA_sc + posB - posA;
+                break;
+            }
+        }
+        pos[m] = ref + (*rdist)[m];
+    }
+
+    return pos;
+}
+
+//! Returns the shortest periodic image of \p x - \p pos in c_box
+DVec minimumImageDistance(const rvec x, const DVec &pos)
+{
+    DVec   dxMin;
+    double dx2Min = GMX_DOUBLE_MAX;
+    for (int i = -1; i <= 1; i++)
+    {
+        for (int j = -1; j <= 1; j++)
+        {
+            for (int k = -1; k <= 1; k++)
+            {
+                DVec dx;
+                for (int m = 0; m < DIM; m++)
+                {
+                    dx[m] = x[m] - pos[m] + i*c_box[XX][m] + j*c_box[YY][m] + k*c_box[ZZ][m];
+                }
+                if (norm2(dx) < dx2Min)
+                {
+                    dxMin  = dx;
+                    dx2Min = norm2(dx);
+                }
+            }
+        }
+    }
+
+    return dxMin;
+}
+
+//! Adds the force \p fm on atom \p ai and its virial to \p output
+void addForceAndVirial(int ai, const DVec &fm, const DVec &dx, const DVec &rdist,
+                       ReferenceOutput *output)
+{
+    for (int m = 0; m < DIM; m++)
+    {
+        const double virial = -0.5*(dx[m] + rdist[m])*fm[m];
+
+        output->f[ai][m]        += fm[m];
+        output->virial[m]       += virial;
+        output->virialMagnitude += std::abs(virial);
+    }
+}
+
+//! Computes position restraints in double precision
+ReferenceOutput computeReferencePosres(const t_ilist &il, const t_iparams iparams[],
+                                       const std::vector<RVec> &x,
+                                       int refcoordScaling,
+                                       const rvec comA, const rvec comB)
+{
+    ReferenceOutput output;
+    output.f.resize(x.size(), { 0, 0, 0 });
+
+    for (int i = 0; i < il.nr; i += 2)
+    {
+        const t_iparams &pr = iparams[il.iatoms[i]];
+        const int        ai = il.iatoms[i + 1];
+
+        DVec             rdist, dpdl;
+        const DVec       pos = referencePosition(pr.posres.pos0A, pr.posres.pos0B, comA, comB,
+                                                 refcoordScaling, c_lambda, &rdist, &dpdl);
+        const DVec       dx  = minimumImageDistance(x[ai], pos);
+        DVec             fm;
+        for (int m = 0; m < DIM; m++)
+        {
+            const double kk = (1 - c_lambda)*pr.posres.fcA[m] + c_lambda*pr.posres.fcB[m];
+
+            fm[m]             = -kk*dx[m];
+            output.v         += 0.5*kk*dx[m]*dx[m];
+            output.dvdlambda += 0.5*(pr.posres.fcB[m] - pr.posres.fcA[m])*dx[m]*dx[m] + fm[m]*dpdl[m];
+        }
+        addForceAndVirial(ai, fm, dx, rdist, &output);
+    }
+
+    return output;
+}
+
+/*! \brief Returns the flat-bottomed potential and sets the force in \p fm
+ *
+ * The restraint acts on the distance \p dr in the dimensions
+ * for which \p useDim is true.
+ */
+double flatBottomedPotential(const DVec &dx, const bool useDim[DIM],
+                             double k, double r, DVec *fm)
+{
+    const bool invert = (r < 0);
+    r                 = std::abs(r);
+
+    double     dr2    = 0;
+    for (int m = 0; m < DIM; m++)
+    {
+        if (useDim[m])
+        {
+            dr2 += dx[m]*dx[m];
+        }
+    }
+    const double dr = std::sqrt(dr2);
+
+    *fm = { 0, 0, 0 };
+    if (dr == 0 || (dr > r) == invert)
+    {
+        return 0;
+    }
+    for (int m = 0; m < DIM; m++)
+    {
+        if (useDim[m])
+        {
+            (*fm)[m] = -k*(dr - r)*dx[m]/dr;
+        }
+    }
+
+    return 0.5*k*(dr - r)*(dr - r);
+}
+
+//! Computes flat-bottomed position restraints in double precision
+ReferenceOutput computeReferenceFbposres(const t_ilist &il, const t_iparams iparams[],
+                                         const std::vector<RVec> &x,
+                                         int refcoordScaling, const rvec com)
+{
+    ReferenceOutput output;
+    output.f.resize(x.size(), { 0, 0, 0 });
+
+    for (int i = 0; i < il.nr; i += 2)
+    {
+        const t_iparams &pr = iparams[il.iatoms[i]];
+        const int        ai = il.iatoms[i + 1];
+
+        DVec             rdist, dpdl;
+        const DVec       pos = referencePosition(pr.fbposres.pos0, pr.fbposres.pos0, com, com,
+                                                 refcoordScaling, 0, &rdist, &dpdl);
+        const DVec       dx  = minimumImageDistance(x[ai], pos);
+
+        bool             useDim[DIM] = { true, true, true };
+        switch (pr.fbposres.geom)
+        {
+            case efbposresSPHERE:
+                break;
+            case efbposresCYLINDERX:
+                useDim[XX] = false;
+                break;
+            case efbposresCYLINDERZ:
+                useDim[ZZ] = false;
+                break;
+            case efbposresY:
+                useDim[XX] = false;
+                useDim[ZZ] = false;
+                break;
+            default:
+                GMX_RELEASE_ASSERT(false, "Geometry not used in this test");
+        }
+        DVec fm;
+        output.v += flatBottomedPotential(dx, useDim, pr.fbposres.k, pr.fbposres.r, &fm);
+        addForceAndVirial(ai, fm, dx, rdist, &output);
+    }
+
+    return output;
+}
+
+/*! \brief Test fixture for position restraints
+ *
+ * The parameters are the refcoord-scaling type and the number of threads.
+ */
+class PositionRestraintsTest : public ::testing::TestWithParam < std::tuple < int, int>>
+{
+    public:
+        //! Sets up the coordinates, interaction list, box and force record
+        PositionRestraintsTest() :
+            refcoordScaling_(std::get<0>(GetParam())),
+            iatoms_(2*c_numRestraints),
+            iparams_(c_numRestraints),
+            x_(c_numRestraints),
+            bondedThreading_(std::get<1>(GetParam()), 1),
+            enerd_(1, 0)
+        {
+            const rvec comA = { 0.45, 0.52, 0.48 };
+            const rvec comB = { 0.47, 0.50, 0.49 };
+            copy_rvec(comA, fr_.posres_com);
+            copy_rvec(comB, fr_.posres_comB);
+            fr_.ePBC            = epbcXYZ;
+            fr_.rc_scaling      = refcoordScaling_;
+            fr_.bondedThreading = &bondedThreading_;
+
+            set_pbc(&pbc_, epbcXYZ, c_box);
+            init_nrnb(&nrnb_);
+
+            for (int r = 0; r < c_numRestraints; r++)
+            {
+                /* The restraints are not in atom order */
+                iatoms_[2*r]     = r;
+                iatoms_[2*r + 1] = (r*17) % c_numRestraints;
+            }
+        }
+
+        /*! \brief Returns reference coordinates for the refcoord-scaling type
+         *
+         * With refcoord-scaling ALL these are in box units, otherwise
+         * absolute, with COM relative to the center of mass.
+         */
+        RVec generateReferenceCoordinates(DefaultRandomEngine *rng)
+        {
+            UniformRealDistribution<real> dist;
+            RVec                          fraction;
+            for (int m = 0; m < DIM; m++)
+            {
+                fraction[m] = dist(*rng);
+            }
+            RVec                          pos0;
+            switch (refcoordScaling_)
+            {
+                case erscALL:
+                    pos0 = fraction;
+                    break;
+                case erscCOM:
+                    for (int m = 0; m < DIM; m++)
+                    {
+                        pos0[m] = 2*fraction[m] - 1;
+                    }
+                    break;
+                default:
+                    tmvmul_ur0(c_referenceBox, fraction, pos0);
+                    break;
+            }
+
+            return pos0;
+        }
+
+        /*! \brief Sets the coordinates close to the reference positions
+         *
+         * Part of the atoms are put in another periodic image.
+         */
+        void generateCoordinates(const rvec pos0A, const rvec pos0B,
+                                 int atom, DefaultRandomEngine *rng)
+        {
+            UniformRealDistribution<real> dist;
+            DVec                          rdist, dpdl;
+            const DVec                    pos = referencePosition(pos0A, pos0B,
+                                                                  fr_.posres_com, fr_.posres_comB,
+                                                                  refcoordScaling_, c_lambda,
+                                                                  &rdist, &dpdl);
+            for (int m = 0; m < DIM; m++)
+            {
+                x_[atom][m] = pos[m] + 0.6*(dist(*rng) - 0.5);
+            }
+            const int shift = static_cast<int>(3*dist(*rng)) - 1;
+            rvec_inc(x_[atom], RVec(shift*c_box[ZZ][XX], shift*c_box[ZZ][YY], shift*c_box[ZZ][ZZ]));
+        }
+
+        //! Checks the forces, energy and virial against the reference
+        void checkOutput(const ReferenceOutput &reference,
+                         real energy, const ForceWithVirial &forceWithVirial,
+                         const std::vector<RVec> &f)
+        {
+            const FloatingPointTolerance energyTolerance =
+                relativeToleranceAsFloatingPoint(reference.v, 1e-5);
+            EXPECT_REAL_EQ_TOL(reference.v, energy, energyTolerance);
+
+            const FloatingPointTolerance virialTolerance =
+                relativeToleranceAsFloatingPoint(reference.virialMagnitude, 1e-5);
+            for (int d1 = 0; d1 < DIM; d1++)
+            {
+                for (int d2 = 0; d2 < DIM; d2++)
+                {
+                    EXPECT_REAL_EQ_TOL(d1 == d2 ? reference.virial[d1] : 0,
+                                       forceWithVirial.getVirial()[d1][d2],
+                                       virialTolerance) << "virial element " << d1 << " " << d2;
+                }
+            }
+
+            double forceMagnitude = 0;
+            for (const DVec &fRef : reference.f)
+            {
+                forceMagnitude = std::max(forceMagnitude, norm(fRef));
+            }
+            const FloatingPointTolerance forceTolerance =
+                relativeToleranceAsFloatingPoint(forceMagnitude, 1e-5);
+            for (int a = 0; a < c_numRestraints; a++)
+            {
+                for (int m = 0; m < DIM; m++)
+                {
+                    EXPECT_REAL_EQ_TOL(reference.f[a][m], f[a][m], forceTolerance)
+                    << "atom " << a << " dimension " << m;
+                }
+            }
+        }
+
+        //! The refcoord-scaling type
+        int                    refcoordScaling_;
+        //! The restraint interactions
+        std::vector<t_iatom>   iatoms_;
+        //! The restraint parameters, one set per restraint
+        std::vector<t_iparams> iparams_;
+        //! The coordinates
+        std::vector<RVec>      x_;
+        //! PBC information
+        t_pbc                  pbc_;
+        //! Threading setup
+        bonded_threading_t     bondedThreading_;
+        //! Force record with the settings used by the restraints
+        t_forcerec             fr_;
+        //! Energy output
+        gmx_enerdata_t         enerd_;
+        //! Flop counting
+        t_nrnb                 nrnb_;
+};
+
+TEST_P(PositionRestraintsTest, PosresMatchesReference)
+{
+    DefaultRandomEngine           rng(1234);
+    UniformRealDistribution<real> dist;
+
+    for (int r = 0; r < c_numRestraints; r++)
+    {
+        auto      &posres = iparams_[r].posres;
+        const RVec pos0A = generateReferenceCoordinates(&rng);
+        RVec       pos0B = pos0A;
+        pos0B[XX] += (refcoordScaling_ == erscALL ? 0.01 : 0.03);
+        copy_rvec(pos0A, posres.pos0A);
+        copy_rvec(pos0B, posres.pos0B);
+        for (int m = 0; m < DIM; m++)
+        {
+            posres.fcA[m] = 500 + 1000*dist(rng);
+            posres.fcB[m] = (m == YY ? posres.fcA[m] : 2*posres.fcA[m]);
+        }
+        generateCoordinates(pos0A, pos0B, iatoms_[2*r + 1], &rng);
+    }
+
+    t_idef idef = {};
+    idef.il[F_POSRES].nr     = 2*c_numRestraints;
+    idef.il[F_POSRES].iatoms = iatoms_.data();
+    idef.iparams_posres      = iparams_.data();
+
+    real lambda[efptNR] = { 0 };
+    lambda[efptRESTRAINT] = c_lambda;
+
+    std::vector<RVec> f(c_numRestraints, { 0, 0, 0 });
+    ForceWithVirial   forceWithVirial(f, true);
+    posres_wrapper(&nrnb_, &idef, &pbc_, as_rvec_array(x_.data()), &enerd_, lambda, &fr_,
+                   &forceWithVirial);
+
+    const ReferenceOutput reference =
+        computeReferencePosres(idef.il[F_POSRES], iparams_.data(), x_,
+                               refcoordScaling_, fr_.posres_com, fr_.posres_comB);
+
+    checkOutput(reference, enerd_.term[F_POSRES], forceWithVirial, f);
+    EXPECT_REAL_EQ_TOL(reference.dvdlambda, enerd_.dvdl_nonlin[efptRESTRAINT],
+                       relativeToleranceAsFloatingPoint(reference.v, 1e-5));
+}
+
+TEST_P(PositionRestraintsTest, FbposresMatchesReference)
+{
+    const int                     geometries[] = { efbposresSPHERE, efbposresCYLINDERX, efbposresCYLINDERZ, efbposresY };
+    DefaultRandomEngine           rng(4321);
+    UniformRealDistribution<real> dist;
+
+    /* Flat-bottomed restraints use the A-state center of mass */
+    copy_rvec(fr_.posres_com, fr_.posres_comB);
+    for (int r = 0; r < c_numRestraints; r++)
+    {
+        auto       &fbposres = iparams_[r].fbposres;
+        const RVec  pos0     = generateReferenceCoordinates(&rng);
+        copy_rvec(pos0, fbposres.pos0);
+        fbposres.geom = geometries[r % 4];
+        fbposres.k    = 500 + 1000*dist(rng);
+        /* Every third restraint is inverted */
+        fbposres.r    = (r % 3 == 0 ? -0.15 : 0.15);
+        generateCoordinates(pos0, pos0, iatoms_[2*r + 1], &rng);
+    }
+
+    t_idef idef = {};
+    idef.il[F_FBPOSRES].nr     = 2*c_numRestraints;
+    idef.il[F_FBPOSRES].iatoms = iatoms_.data();
+    idef.iparams_fbposres      = iparams_.data();
+
+    std::vector<RVec> f(c_numRestraints, { 0, 0, 0 });
+    ForceWithVirial   forceWithVirial(f, true);
+    fbposres_wrapper(&nrnb_, &idef, &pbc_, as_rvec_array(x_.data()), &enerd_, &fr_,
+                     &forceWithVirial);
+
+    const ReferenceOutput reference =
+        computeReferenceFbposres(idef.il[F_FBPOSRES], iparams_.data(), x_,
+                                 refcoordScaling_, fr_.posres_com);
+
+    checkOutput(reference, enerd_.term[F_FBPOSRES], forceWithVirial, f);
+}
+
+INSTANTIATE_TEST_CASE_P(WithRefcoordScalingAndThreads, PositionRestraintsTest,
+                            ::testing::Combine(::testing::Values(erscNO, erscALL, erscCOM),
+                                                   ::testing::Values(1, 4)));
+
+}  // namespace
+}  // namespace test
+}  // namespace gmx
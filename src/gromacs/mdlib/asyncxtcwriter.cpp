@@ -0,0 +1,203 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements gmx::AsyncXtcWriter.
+ *
+ * \ingroup module_mdlib
+ */
+#include "gmxpre.h"
+
+#include "asyncxtcwriter.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gromacs/fileio/xtcio.h"
+#include "gromacs/math/vec.h"
+
+namespace gmx
+{
+
+/*! \internal \brief
+ * Private implementation class for AsyncXtcWriter.
+ *
+ * \ingroup module_mdlib
+ */
+class AsyncXtcWriter::Impl
+{
+    public:
+        //! A frame waiting to be written.
+        struct Frame
+        {
+            //! MD step.
+            int64_t           step;
+            //! Simulation time.
+            real              time;
+            //! Simulation box.
+            matrix            box;
+            //! Coordinates.
+            std::vector<RVec> x;
+        };
+
+        //! Number of frame buffers (double buffering).
+        static constexpr int c_bufferCount = 2;
+
+        Impl(t_fileio *fio, int natoms, real precision);
+        ~Impl();
+
+        //! Main loop of the writer thread.
+        void writeFrames();
+
+        //! File to write to.
+        t_fileio               *fio_;
+        //! Number of atoms in a frame.
+        int                     natoms_;
+        //! Precision for compression.
+        real                    precision_;
+        //! Frame buffers, used in a round-robin fashion.
+        Frame                   frames_[c_bufferCount];
+        //! Total number of frames queued by write().
+        int64_t                 queuedCount_;
+        //! Total number of frames written by the writer thread.
+        int64_t                 writtenCount_;
+        //! Whether writing any frame has failed.
+        bool                    bFailed_;
+        //! Whether the writer thread should exit once all frames are written.
+        bool                    bStop_;
+        //! Protects the counters and the flags.
+        std::mutex              mutex_;
+        //! Signals changes in the counters and the flags.
+        std::condition_variable cond_;
+        //! The writer thread.
+        std::thread             thread_;
+};
+
+AsyncXtcWriter::Impl::Impl(t_fileio *fio, int natoms, real precision)
+    : fio_(fio), natoms_(natoms), precision_(precision),
+      queuedCount_(0), writtenCount_(0), bFailed_(false), bStop_(false)
+{
+    for (Frame &frame : frames_)
+    {
+        frame.x.resize(natoms);
+    }
+    thread_ = std::thread([this] { writeFrames(); });
+}
+
+AsyncXtcWriter::Impl::~Impl()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        bStop_ = true;
+    }
+    cond_.notify_all();
+    thread_.join();
+}
+
+void AsyncXtcWriter::Impl::writeFrames()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        cond_.wait(lock, [this] { return bStop_ || writtenCount_ < queuedCount_; });
+        if (writtenCount_ == queuedCount_)
+        {
+            // Stop was requested, and everything has been written.
+            return;
+        }
+        Frame &frame = frames_[writtenCount_ % c_bufferCount];
+        lock.unlock();
+        const bool bOK = (write_xtc(fio_, natoms_, frame.step, frame.time, frame.box,
+                                    as_rvec_array(frame.x.data()), precision_) != 0);
+        lock.lock();
+        if (!bOK)
+        {
+            bFailed_ = true;
+        }
+        ++writtenCount_;
+        cond_.notify_all();
+    }
+}
+
+AsyncXtcWriter::AsyncXtcWriter(t_fileio *fio, int natoms, real precision)
+    : impl_(new Impl(fio, natoms, precision))
+{
+}
+
+AsyncXtcWriter::~AsyncXtcWriter()
+{
+}
+
+bool AsyncXtcWriter::write(int64_t step, real time, const matrix box, const rvec *x)
+{
+    Impl::Frame *frame;
+    {
+        std::unique_lock<std::mutex> lock(impl_->mutex_);
+        impl_->cond_.wait(lock, [this]
+                          {
+                              return impl_->queuedCount_ - impl_->writtenCount_ < Impl::c_bufferCount;
+                          });
+        if (impl_->bFailed_)
+        {
+            return false;
+        }
+        frame = &impl_->frames_[impl_->queuedCount_ % Impl::c_bufferCount];
+    }
+    // The writer thread does not touch this buffer until it is queued below.
+    frame->step = step;
+    frame->time = time;
+    copy_mat(box, frame->box);
+    for (int i = 0; i < impl_->natoms_; ++i)
+    {
+        copy_rvec(x[i], frame->x[i]);
+    }
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex_);
+        ++impl_->queuedCount_;
+    }
+    impl_->cond_.notify_all();
+    return true;
+}
+
+bool AsyncXtcWriter::waitForCompletion()
+{
+    std::unique_lock<std::mutex> lock(impl_->mutex_);
+    impl_->cond_.wait(lock, [this] { return impl_->writtenCount_ == impl_->queuedCount_; });
+    return !impl_->bFailed_;
+}
+
+} // namespace gmx
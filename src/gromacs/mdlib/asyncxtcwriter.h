@@ -0,0 +1,121 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \libinternal \file
+ * \brief
+ * Declares gmx::AsyncXtcWriter, which compresses and writes xtc frames
+ * in a background thread.
+ *
+ * \inlibraryapi
+ * \ingroup module_mdlib
+ */
+#ifndef GMX_MDLIB_ASYNCXTCWRITER_H
+#define GMX_MDLIB_ASYNCXTCWRITER_H
+
+#include <cstdint>
+
+#include "gromacs/math/vectypes.h"
+#include "gromacs/utility/classhelpers.h"
+#include "gromacs/utility/real.h"
+
+struct t_fileio;
+
+namespace gmx
+{
+
+/*! \libinternal
+ * \brief
+ * Writes xtc frames from a dedicated I/O thread.
+ *
+ * Compressing the coordinates of a large system can take a significant
+ * part of an MD step.  write() copies the frame into one of two
+ * buffers and returns, and a background thread compresses and writes the
+ * buffered frames in order, so that the simulation continues while the
+ * frame is encoded.  If both buffers are in use, write() waits until the
+ * older frame has been written.
+ *
+ * While an object exists, the file must not be accessed by other code
+ * unless waitForCompletion() has been called since the last write(), as the
+ * background thread may be writing to it.
+ *
+ * \inlibraryapi
+ * \ingroup module_mdlib
+ */
+class AsyncXtcWriter
+{
+    public:
+        /*! \brief
+         * Starts the writer thread.
+         *
+         * \param[in] fio       Open xtc file to write to.
+         * \param[in] natoms    Number of atoms in each frame.
+         * \param[in] precision Precision for the compression.
+         */
+        AsyncXtcWriter(t_fileio *fio, int natoms, real precision);
+        /*! \brief
+         * Writes all pending frames and stops the writer thread.
+         *
+         * Does not close the file.
+         */
+        ~AsyncXtcWriter();
+
+        /*! \brief
+         * Queues a frame for writing.
+         *
+         * \param[in] step  MD step number.
+         * \param[in] time  Simulation time.
+         * \param[in] box   Simulation box.
+         * \param[in] x     Coordinates of the \p natoms atoms.
+         * \returns   false if writing any earlier frame has failed.
+         *
+         * \p x and \p box are copied, and can be modified once this
+         * function returns.
+         */
+        bool write(int64_t step, real time, const matrix box, const rvec *x);
+        /*! \brief
+         * Waits until all queued frames have been written.
+         *
+         * \returns false if writing any frame has failed.
+         */
+        bool waitForCompletion();
+
+    private:
+        class Impl;
+
+        PrivateImplPointer<Impl> impl_;
+};
+
+} // namespace gmx
+
+#endif
@@ -110,6 +110,7 @@ void do_force_lowlevel(t_forcerec                   *fr,
                        history_t                    *hist,
                        rvec                         *forceForUseWithShiftForces,
                        gmx::ForceWithVirial         *forceWithVirial,
+                       gmx::ForceWithVirial         *forceWithVirialLongRange,
                        gmx_enerdata_t               *enerd,
                        t_fcdata                     *fcd,
                        const matrix                  box,
@@ -197,9 +198,10 @@ void do_force_lowlevel(t_forcerec                   *fr,
     /* Do long-range electrostatics and/or LJ-PME
      * and compute PME surface terms when necessary.
      */
-    if (computePmeOnCpu ||
-        fr->ic->eeltype == eelEWALD ||
-        haveEwaldSurfaceTerms)
+    if (forceWithVirialLongRange != nullptr &&
+        (computePmeOnCpu ||
+         fr->ic->eeltype == eelEWALD ||
+         haveEwaldSurfaceTerms))
     {
         int  status            = 0;
         real Vlr_q             = 0, Vlr_lj = 0;
@@ -239,7 +241,7 @@ void do_force_lowlevel(t_forcerec                   *fr,
                         /* Threading is only supported with the Verlet cut-off
                          * scheme and then only single particle forces (no
                          * exclusion forces) are calculated, so we can store
-                         * the forces in the normal, single forceWithVirial->force_ array.
+                         * the forces in the normal, single forceWithVirialLongRange->force_ array.
                          */
                         ewald_LRcorrection(md->homenr, cr, nthreads, t, fr, ir,
                                            md->chargeA, md->chargeB,
@@ -247,7 +249,7 @@ void do_force_lowlevel(t_forcerec                   *fr,
                                            x, box, mu_tot,
                                            ir->ewald_geometry,
                                            ir->epsilon_surface,
-                                           as_rvec_array(forceWithVirial->force_.data()),
+                                           as_rvec_array(forceWithVirialLongRange->force_.data()),
                                            &ewc_t.Vcorr_q,
                                            lambda[efptCOUL],
                                            &ewc_t.dvdl[efptCOUL]);
@@ -303,7 +305,7 @@ void do_force_lowlevel(t_forcerec                   *fr,
                     status = gmx_pme_do(fr->pmedata,
                                         0, md->homenr - fr->n_tpi,
                                         x,
-                                        as_rvec_array(forceWithVirial->force_.data()),
+                                        as_rvec_array(forceWithVirialLongRange->force_.data()),
                                         md->chargeA, md->chargeB,
                                         md->sqrt_c6A, md->sqrt_c6B,
                                         md->sigmaA, md->sigmaB,
@@ -351,7 +353,7 @@ void do_force_lowlevel(t_forcerec                   *fr,
 
         if (fr->ic->eeltype == eelEWALD)
         {
-            Vlr_q = do_ewald(ir, x, as_rvec_array(forceWithVirial->force_.data()),
+            Vlr_q = do_ewald(ir, x, as_rvec_array(forceWithVirialLongRange->force_.data()),
                              md->chargeA, md->chargeB,
                              box, cr, md->homenr,
                              ewaldOutput.vir_q, fr->ic->ewaldcoeff_q,
@@ -362,8 +364,8 @@ void do_force_lowlevel(t_forcerec                   *fr,
         /* Note that with separate PME nodes we get the real energies later */
         // TODO it would be simpler if we just accumulated a single
         // long-range virial contribution.
-        forceWithVirial->addVirialContribution(ewaldOutput.vir_q);
-        forceWithVirial->addVirialContribution(ewaldOutput.vir_lj);
+        forceWithVirialLongRange->addVirialContribution(ewaldOutput.vir_q);
+        forceWithVirialLongRange->addVirialContribution(ewaldOutput.vir_lj);
         enerd->dvdl_lin[efptCOUL] += ewaldOutput.dvdl[efptCOUL];
         enerd->dvdl_lin[efptVDW]  += ewaldOutput.dvdl[efptVDW];
         enerd->term[F_COUL_RECIP]  = Vlr_q + ewaldOutput.Vcorr_q;
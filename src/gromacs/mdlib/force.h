@@ -87,6 +87,7 @@ void do_force(FILE                                     *log,
               gmx::ArrayRefWithPadding<gmx::RVec>       coordinates,
               history_t                                *hist,
               gmx::ArrayRefWithPadding<gmx::RVec>       force,
+              gmx::ArrayRefWithPadding<gmx::RVec>       forceMtsCombined,
               tensor                                    vir_force,
               const t_mdatoms                          *mdatoms,
               gmx_enerdata_t                           *enerd,
@@ -109,6 +110,12 @@ void do_force(FILE                                     *log,
  * Spread forces for vsites (if present).
  *
  * f is always required.
+ * With multiple time stepping, at steps that are multiples of mtsFactor,
+ * forceMtsCombined returns the normal forces plus mtsFactor times the level-2
+ * forces, for use in the integration; force then contains the total force.
+ * At other steps the level-2 forces are only computed when energies or
+ * the virial are requested, and then only contribute to those.
+ * forceMtsCombined can be empty without multiple time stepping.
  */
 
 
@@ -125,6 +132,7 @@ do_force_lowlevel(t_forcerec                   *fr,
                   history_t                    *hist,
                   rvec                         *f_shortrange,
                   gmx::ForceWithVirial         *forceWithVirial,
+                  gmx::ForceWithVirial         *forceWithVirialLongRange,
                   gmx_enerdata_t               *enerd,
                   t_fcdata                     *fcd,
                   const matrix                  box,
@@ -133,6 +141,11 @@ do_force_lowlevel(t_forcerec                   *fr,
                   const rvec                   *mu_tot,
                   int                           flags,
                   const DDBalanceRegionHandler &ddBalanceRegionHandler);
-/* Call all the force routines */
+/* Call all the force routines.
+ * The long-range (PME/Ewald) forces and virial are added to
+ * forceWithVirialLongRange, which can be the same object as forceWithVirial.
+ * When forceWithVirialLongRange=nullptr, the long-range part is skipped,
+ * which is used with multiple time stepping.
+ */
 
 #endif
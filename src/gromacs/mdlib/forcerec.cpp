@@ -1215,6 +1215,10 @@ void forcerec_set_ranges(t_forcerec *fr,
     {
         fr->forceBufferForDirectVirialContributions->resize(natoms_f_novirsum);
     }
+    if (fr->forceBufferMtsLevel2 != nullptr)
+    {
+        fr->forceBufferMtsLevel2->resize(natoms_f_novirsum);
+    }
 }
 
 static real cutoff_inf(real cutoff)
@@ -2050,6 +2054,10 @@ void init_forcerec(FILE                             *fp,
     {
         fr->forceBufferForDirectVirialContributions = new std::vector<gmx::RVec>;
     }
+    if (ir->useMts)
+    {
+        fr->forceBufferMtsLevel2 = new std::vector<gmx::RVec>;
+    }
 
     if (fr->shift_vec == nullptr)
     {
@@ -127,6 +127,27 @@ struct Task
     real             dhdlambda;
 };
 
+/*! \brief Constraints grouped on connected components of the coupling graph
+ *
+ * Used for assigning constraints to tasks. Stored in Lincs to avoid
+ * reallocation at every domain decomposition step.
+ */
+struct ConstraintComponents
+{
+    //! The constraints to assign, grouped per component
+    std::vector<int>     constraints;
+    //! Component c consists of constraints[index[c]] to constraints[index[c+1]]
+    std::vector<int>     index;
+    //! The estimated cost of each component, in flops
+    std::vector<int64_t> weight;
+    //! Union-find parent of each atom, work array
+    std::vector<int>     atomParent;
+    //! Component index of each union-find root atom, work array
+    std::vector<int>     rootComponent;
+    //! Component index of each constraint, -1 when not assigned, work array
+    std::vector<int>     constraintComponent;
+};
+
 /*! \brief Data for LINCS algorithm.
  */
 class Lincs
@@ -200,6 +221,12 @@ class Lincs
         bool                       bTaskDep = false;
         //! Are there triangle constraints that cross task borders?
         bool                       bTaskDepTri = false;
+        //! Work data for assigning coupled constraints to tasks
+        ConstraintComponents       components;
+        //! Log file for reporting the task load balance, can be nullptr
+        FILE                      *log = nullptr;
+        //! Whether the task load balance has been reported to log
+        bool                       haveReportedTaskLoad = false;
         //! Arrays for temporary storage in the LINCS algorithm.
         /*! @{ */
         PaddedVector<gmx::RVec>                   tmpv;
@@ -1228,9 +1255,9 @@ static void set_lincs_matrix_task(Lincs                *li,
         {
             const int k = li->blbnb[n];
 
-            /* If we are using multiple, independent tasks for LINCS,
-             * the calls to check_assign_connected should have
-             * put all connected constraints in our task.
+            /* With independent tasks (!bTaskDep), set_lincs assigns
+             * each coupled component as a whole to a single task,
+             * so all connected constraints are in our task.
              */
             assert(li->bTaskDep || (k >= li_task->b0 && k < li_task->b1));
 
@@ -1465,6 +1492,7 @@ Lincs *init_lincs(FILE *fplog, const gmx_mtop_t &mtop,
 
     li->nIter  = nIter;
     li->nOrder = nProjOrder;
+    li->log    = fplog;
 
     li->max_connect = 0;
     for (size_t mt = 0; mt < mtop.moltype.size(); mt++)
@@ -1511,15 +1539,13 @@ Lincs *init_lincs(FILE *fplog, const gmx_mtop_t &mtop,
     /* LINCS can run on any number of threads.
      * Currently the number is fixed for the whole simulation,
      * but it could be set in set_lincs().
-     * The current constraint to task assignment code can create independent
-     * tasks only when not more than two constraints are connected sequentially.
+     * Whether the tasks are dependent is determined in set_lincs(),
+     * based on the sizes of the coupled constraint components.
      */
     li->ntask    = gmx_omp_nthreads_get(emntLINCS);
-    li->bTaskDep = (li->ntask > 1 && bMoreThanTwoSeq);
     if (debug)
     {
-        fprintf(debug, "LINCS: using %d threads, tasks are %sdependent\n",
-                li->ntask, li->bTaskDep ? "" : "in");
+        fprintf(debug, "LINCS: using %d threads\n", li->ntask);
     }
     if (li->ntask == 1)
     {
@@ -1695,54 +1721,6 @@ static void assign_constraint(Lincs *li,
     li->nc++;
 }
 
-/*! \brief Check if constraint with topology index constraint_index is connected
- * to other constraints, and if so add those connected constraints to our task. */
-static void check_assign_connected(Lincs *li,
-                                   const t_iatom *iatom,
-                                   const t_idef &idef,
-                                   bool bDynamics,
-                                   int a1, int a2,
-                                   const t_blocka *at2con)
-{
-    /* Currently this function only supports constraint groups
-     * in which all constraints share at least one atom
-     * (e.g. H-bond constraints).
-     * Check both ends of the current constraint for
-     * connected constraints. We need to assign those
-     * to the same task.
-     */
-    int end;
-
-    for (end = 0; end < 2; end++)
-    {
-        int a, k;
-
-        a = (end == 0 ? a1 : a2);
-
-        for (k = at2con->index[a]; k < at2con->index[a + 1]; k++)
-        {
-            int cc;
-
-            cc = at2con->a[k];
-            /* Check if constraint cc has not yet been assigned */
-            if (li->con_index[cc] == -1)
-            {
-                int  type;
-                real lenA, lenB;
-
-                type = iatom[cc*3];
-                lenA = idef.iparams[type].constr.dA;
-                lenB = idef.iparams[type].constr.dB;
-
-                if (bDynamics || lenA != 0 || lenB != 0)
-                {
-                    assign_constraint(li, cc, iatom[3*cc + 1], iatom[3*cc + 2], lenA, lenB, at2con);
-                }
-            }
-        }
-    }
-}
-
 /*! \brief Check if constraint with topology index constraint_index is involved
  * in a constraint triangle, and if so add the other two constraints
  * in the triangle to our task. */
@@ -1846,6 +1824,171 @@ static void check_assign_triangle(Lincs *li,
     }
 }
 
+/*! \brief The estimated cost of a constraint in flops, excluding couplings
+ *
+ * Sum of the flop counts in do_lincs for the direction, right-hand side,
+ * iterative correction and the two atom updates.
+ */
+static constexpr int c_lincsFlopsPerConstraint = 80;
+
+//! Returns the estimated cost in flops of a constraint coupling in do_lincs
+static int lincsFlopsPerCoupling(const Lincs &li)
+{
+    /* 6 flops for the matrix element and 2 for each expansion order,
+     * which is applied once more for each iteration.
+     */
+    return 6 + 2*li.nOrder*(1 + li.nIter);
+}
+
+//! Returns the root of the union-find tree of atom \p a, halves the path
+static int findComponentRoot(std::vector<int> *atomParent,
+                             int               a)
+{
+    std::vector<int> &parent = *atomParent;
+    while (parent[a] != a)
+    {
+        parent[a] = parent[parent[a]];
+        a         = parent[a];
+    }
+    return a;
+}
+
+/*! \brief Groups the constraints to assign on connected components of the coupling graph
+ *
+ * Constraints are coupled when they share an atom. The components are
+ * ordered on their first constraint and the constraints within a component
+ * are kept in topology order, which preserves memory locality.
+ *
+ * \returns the weight of the largest component
+ */
+static int64_t groupConstraintsOnComponents(Lincs                *li,
+                                            const t_idef         &idef,
+                                            bool                  bDynamics,
+                                            int                   numAtoms,
+                                            const t_blocka       &at2con)
+{
+    ConstraintComponents &cc        = li->components;
+    const t_iatom        *iatom     = idef.il[F_CONSTR].iatoms;
+    const int             numConstr = idef.il[F_CONSTR].nr/3;
+
+    cc.atomParent.resize(numAtoms);
+    for (int a = 0; a < numAtoms; a++)
+    {
+        cc.atomParent[a] = a;
+    }
+
+    cc.constraintComponent.resize(numConstr);
+    for (int con = 0; con < numConstr; con++)
+    {
+        const int  type = iatom[3*con];
+        const real lenA = idef.iparams[type].constr.dA;
+        const real lenB = idef.iparams[type].constr.dB;
+        /* Skip the flexible constraints when not doing dynamics */
+        if (bDynamics || lenA != 0 || lenB != 0)
+        {
+            const int root1 = findComponentRoot(&cc.atomParent, iatom[3*con + 1]);
+            const int root2 = findComponentRoot(&cc.atomParent, iatom[3*con + 2]);
+            cc.atomParent[std::max(root1, root2)] = std::min(root1, root2);
+            cc.constraintComponent[con]           = 0;
+        }
+        else
+        {
+            cc.constraintComponent[con] = -1;
+        }
+    }
+
+    /* Number the components in order of their first constraint
+     * and count their constraints and weights.
+     */
+    const int flopsPerCoupling = lincsFlopsPerCoupling(*li);
+    cc.rootComponent.assign(numAtoms, -1);
+    cc.index.clear();
+    cc.weight.clear();
+    for (int con = 0; con < numConstr; con++)
+    {
+        if (cc.constraintComponent[con] < 0)
+        {
+            continue;
+        }
+        const int a1   = iatom[3*con + 1];
+        const int a2   = iatom[3*con + 2];
+        const int root = findComponentRoot(&cc.atomParent, a1);
+        if (cc.rootComponent[root] < 0)
+        {
+            cc.rootComponent[root] = cc.weight.size();
+            cc.index.push_back(0);
+            cc.weight.push_back(0);
+        }
+        const int component             = cc.rootComponent[root];
+        cc.constraintComponent[con]     = component;
+        const int numCouplings          =
+            at2con.index[a1 + 1] - at2con.index[a1] - 1 +
+            at2con.index[a2 + 1] - at2con.index[a2] - 1;
+        cc.index[component]            += 1;
+        cc.weight[component]           += c_lincsFlopsPerConstraint + numCouplings*flopsPerCoupling;
+    }
+
+    /* Convert the counts to start indices and fill the constraint list */
+    const int numComponents = cc.weight.size();
+    int       start         = 0;
+    for (int c = 0; c < numComponents; c++)
+    {
+        const int count = cc.index[c];
+        cc.index[c]     = start;
+        start          += count;
+    }
+    cc.index.push_back(start);
+    cc.constraints.resize(start);
+    for (int con = 0; con < numConstr; con++)
+    {
+        const int component = cc.constraintComponent[con];
+        if (component >= 0)
+        {
+            cc.constraints[cc.index[component]++] = con;
+        }
+    }
+    /* Filling shifted the start indices up by one component, shift back */
+    for (int c = numComponents; c > 0; c--)
+    {
+        cc.index[c] = cc.index[c - 1];
+    }
+    cc.index[0] = 0;
+
+    int64_t maxWeight = 0;
+    for (int64_t weight : cc.weight)
+    {
+        maxWeight = std::max(maxWeight, weight);
+    }
+
+    return maxWeight;
+}
+
+//! Prints the number of constraints and the estimated load per task to \p fp
+static void printTaskLoad(FILE                        *fp,
+                          const Lincs                 &li,
+                          gmx::ArrayRef<const int64_t> taskWeight)
+{
+    int64_t totalWeight = 0;
+    int64_t maxWeight   = 0;
+    for (int64_t weight : taskWeight)
+    {
+        totalWeight += weight;
+        maxWeight    = std::max(maxWeight, weight);
+    }
+    const double averageWeight = totalWeight/static_cast<double>(li.ntask);
+
+    fprintf(fp, "LINCS: %d %s tasks, estimated load imbalance %.1f%%\n",
+            li.ntask, li.bTaskDep ? "dependent" : "independent",
+            averageWeight > 0 ? 100*(maxWeight/averageWeight - 1) : 0.0);
+    fprintf(fp, "  task  constraints  load\n");
+    for (int th = 0; th < li.ntask; th++)
+    {
+        fprintf(fp, "  %4d  %11d  %4.2f\n",
+                th, li.task[th].b1 - li.task[th].b0,
+                averageWeight > 0 ? taskWeight[th]/averageWeight : 0.0);
+    }
+}
+
 //! Sets matrix indices.
 static void set_matrix_indices(Lincs                *li,
                                const Task           &li_task,
@@ -1973,7 +2116,12 @@ void set_lincs(const t_idef         &idef,
     li->blnr[0]   = li->ncc;
 
     /* Assign the constraints for li->ntask LINCS tasks.
-     * We target a uniform distribution of constraints over the tasks.
+     * We target a uniform distribution of the estimated cost over the tasks.
+     * With multiple tasks we group the constraints on connected components
+     * of the coupling graph. When no component is larger than the average
+     * cost per task, we assign complete components to tasks, which makes
+     * the tasks independent so no barriers are required during LINCS.
+     * Otherwise we split components and tasks are dependent.
      * Note that when flexible constraints are present, but are removed here
      * (e.g. because we are doing EM) we get imbalance, but since that doesn't
      * happen during normal MD, that's ok.
@@ -1989,10 +2137,30 @@ void set_lincs(const t_idef         &idef,
         ncon_assign -= countFlexibleConstraints(idef.il, idef.iparams);
     }
 
-    /* Set the target constraint count per task to exactly uniform,
-     * this might be overridden below.
-     */
-    int ncon_target = (ncon_assign + li->ntask - 1)/li->ntask;
+    const ConstraintComponents &components = li->components;
+    bool                        splitComponents;
+    int64_t                     totalWeight;
+    int                         numToAssign;
+    if (li->ntask > 1)
+    {
+        const int64_t maxComponentWeight =
+            groupConstraintsOnComponents(li, idef, bDynamics, natoms, at2con);
+
+        totalWeight = 0;
+        for (int64_t weight : components.weight)
+        {
+            totalWeight += weight;
+        }
+        splitComponents = (maxComponentWeight*li->ntask > totalWeight);
+        numToAssign     = components.constraints.size();
+    }
+    else
+    {
+        splitComponents = false;
+        totalWeight     = 0;
+        numToAssign     = ncon_tot;
+    }
+    li->bTaskDep = splitComponents;
 
     /* Mark all constraints as unassigned by setting their index to -1 */
     for (int con = 0; con < ncon_tot; con++)
@@ -2000,38 +2168,56 @@ void set_lincs(const t_idef         &idef,
         li->con_index[con] = -1;
     }
 
-    int con = 0;
+    const int            flopsPerCoupling = lincsFlopsPerCoupling(*li);
+    std::vector<int64_t> taskWeight(li->ntask);
+    int64_t              assignedWeight   = 0;
+    int                  orderIndex       = 0;
+    int                  nextComponent    = 0;
     for (int th = 0; th < li->ntask; th++)
     {
         Task *li_task;
 
         li_task = &li->task[th];
 
-#if GMX_SIMD_HAVE_REAL
-        /* With indepedent tasks we likely have H-bond constraints or constraint
-         * pairs. The connected constraints will be pulled into the task, so the
-         * constraints per task will often exceed ncon_target.
-         * Triangle constraints can also increase the count, but there are
-         * relatively few of those, so we usually expect to get ncon_target.
-         */
-        if (li->bTaskDep)
-        {
-            /* We round ncon_target to a multiple of GMX_SIMD_WIDTH,
-             * since otherwise a lot of operations can be wasted.
-             * There are several ways to round here, we choose the one
-             * that alternates block sizes, which helps with Intel HT.
-             */
-            ncon_target = ((ncon_assign*(th + 1))/li->ntask - li->nc_real + GMX_SIMD_REAL_WIDTH - 1) & ~(GMX_SIMD_REAL_WIDTH - 1);
-        }
-#endif      // GMX_SIMD==2 && GMX_SIMD_HAVE_REAL
-
         /* Continue filling the arrays where we left off with the previous task,
          * including padding for SIMD.
          */
         li_task->b0 = li->nc;
 
-        while (con < ncon_tot && li->nc - li_task->b0 < ncon_target)
+        const int64_t taskEndWeight = (totalWeight*(th + 1))/li->ntask;
+        const int64_t weightStart   = assignedWeight;
+        const int     nccStart      = li->ncc;
+
+        while (orderIndex < numToAssign)
         {
+            const bool atComponentStart =
+                (li->ntask > 1 && orderIndex == components.index[nextComponent]);
+            if (th < li->ntask - 1)
+            {
+                /* Check if we should end this task here */
+                if (splitComponents)
+                {
+                    /* Round to a multiple of the SIMD width,
+                     * so no operations are wasted on padding.
+                     */
+                    if (assignedWeight >= taskEndWeight &&
+                        (li->nc - li_task->b0) % simd_width == 0)
+                    {
+                        break;
+                    }
+                }
+                else if (atComponentStart &&
+                         assignedWeight + components.weight[nextComponent]/2 >= taskEndWeight)
+                {
+                    break;
+                }
+            }
+            if (atComponentStart)
+            {
+                nextComponent++;
+            }
+
+            const int con = (li->ntask > 1 ? components.constraints[orderIndex] : orderIndex);
             if (li->con_index[con] == -1)
             {
                 int  type, a1, a2;
@@ -2047,15 +2233,7 @@ void set_lincs(const t_idef         &idef,
                 {
                     assign_constraint(li, con, a1, a2, lenA, lenB, &at2con);
 
-                    if (li->ntask > 1 && !li->bTaskDep)
-                    {
-                        /* We can generate independent tasks. Check if we
-                         * need to assign connected constraints to our task.
-                         */
-                        check_assign_connected(li, iatom, idef, bDynamics,
-                                               a1, a2, &at2con);
-                    }
-                    if (li->ntask > 1 && li->ncg_triangle > 0)
+                    if (splitComponents && li->ncg_triangle > 0)
                     {
                         /* Ensure constraints in one triangle are assigned
                          * to the same task.
@@ -2064,13 +2242,19 @@ void set_lincs(const t_idef         &idef,
                                               con, a1, a2, &at2con);
                     }
                 }
+
+                assignedWeight = weightStart +
+                    (li->nc - li_task->b0)*c_lincsFlopsPerConstraint +
+                    (li->ncc - nccStart)*static_cast<int64_t>(flopsPerCoupling);
             }
 
-            con++;
+            orderIndex++;
         }
 
         li_task->b1 = li->nc;
 
+        taskWeight[th] = assignedWeight - weightStart;
+
         if (simd_width > 1)
         {
             /* Copy the last atom pair indices and lengths for constraints
@@ -2103,6 +2287,20 @@ void set_lincs(const t_idef         &idef,
 
     assert(li->nc_real == ncon_assign);
 
+    if (li->ntask > 1)
+    {
+        /* Report the load balance of the first setup on this rank */
+        if (li->log && !li->haveReportedTaskLoad)
+        {
+            printTaskLoad(li->log, *li, taskWeight);
+            li->haveReportedTaskLoad = true;
+        }
+        if (debug)
+        {
+            printTaskLoad(debug, *li, taskWeight);
+        }
+    }
+
     bool bSortMatrix;
 
     /* Without DD we order the blbnb matrix to optimize memory access.
@@ -2147,7 +2345,7 @@ void set_lincs(const t_idef         &idef,
     if (!nlocat_dd.empty())
     {
         /* Convert nlocat from local topology to LINCS constraint indexing */
-        for (con = 0; con < ncon_tot; con++)
+        for (int con = 0; con < ncon_tot; con++)
         {
             li->nlocat[li->con_index[con]] = nlocat_dd[con];
         }
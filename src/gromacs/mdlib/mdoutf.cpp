@@ -36,16 +36,20 @@
 
 #include "mdoutf.h"
 
+#include <cstdlib>
+
 #include "gromacs/commandline/filenm.h"
 #include "gromacs/domdec/collect.h"
 #include "gromacs/domdec/domdec_struct.h"
 #include "gromacs/fileio/checkpoint.h"
 #include "gromacs/fileio/gmxfio.h"
 #include "gromacs/fileio/tngio.h"
+#include "gromacs/fileio/trajectoryframeindex.h"
 #include "gromacs/fileio/trrio.h"
 #include "gromacs/fileio/xtcio.h"
 #include "gromacs/fileio/xvgr.h"
 #include "gromacs/math/vec.h"
+#include "gromacs/mdlib/asyncxtcwriter.h"
 #include "gromacs/mdlib/trajectory_writing.h"
 #include "gromacs/mdrunutility/handlerestart.h"
 #include "gromacs/mdtypes/commrec.h"
@@ -80,8 +84,54 @@ struct gmx_mdoutf {
     gmx_wallcycle_t                wcycle;
     rvec                          *f_global;
     gmx::IMDOutputProvider        *outputProvider;
+    gmx::AsyncXtcWriter           *xtcWriter; /* non-NULL when XTC output is written from a separate thread */
+    gmx::TrajectoryFrameIndex     *xtcFrameIndex; /* frame index of the XTC file, extended at checkpoints */
+    gmx::TrajectoryFrameIndex     *trrFrameIndex; /* frame index of the TRR file, extended at checkpoints */
 };
 
+//! Message for failures in writing XTC output.
+static const char *const c_xtcErrorMessage =
+    "XTC error. This indicates you are out of disk space, or a "
+    "simulation with major instabilities resulting in coordinates "
+    "that are NaN or too large to be represented in the XTC format.\n";
+
+/*! \brief Waits until all XTC frames queued for the writer thread are written
+ *
+ * Needs to be called before anything else accesses the XTC file. */
+static void waitForXtcOutput(gmx_mdoutf_t of)
+{
+    if (of->xtcWriter != nullptr && !of->xtcWriter->waitForCompletion())
+    {
+        gmx_fatal(FARGS, "%s", c_xtcErrorMessage);
+    }
+}
+
+/*! \brief Returns a frame index for \p filename, continuing an existing
+ * index when appending to the file */
+static gmx::TrajectoryFrameIndex *initFrameIndex(const char *filename, bool restartWithAppending)
+{
+    gmx::TrajectoryFrameIndex *index = new gmx::TrajectoryFrameIndex(filename);
+    if (restartWithAppending)
+    {
+        /* An index that does not match the truncated file is rebuilt */
+        index->readSidecar();
+    }
+    return index;
+}
+
+/*! \brief Adds the frames written since the last call to \p index
+ * and writes it to its sidecar file
+ *
+ * Only reads the headers of the new frames, so the output files need
+ * to be flushed before calling this. */
+static void updateFrameIndex(gmx::TrajectoryFrameIndex *index)
+{
+    if (index != nullptr && index->isOutOfDate())
+    {
+        index->update();
+        index->writeSidecar();
+    }
+}
 
 gmx_mdoutf_t init_mdoutf(FILE *fplog, int nfile, const t_filenm fnm[],
                          const gmx::MdrunOptions &mdrunOptions,
@@ -114,6 +164,9 @@ gmx_mdoutf_t init_mdoutf(FILE *fplog, int nfile, const t_filenm fnm[],
     of->wcycle                  = wcycle;
     of->f_global                = nullptr;
     of->outputProvider          = outputProvider;
+    of->xtcWriter               = nullptr;
+    of->xtcFrameIndex           = nullptr;
+    of->trrFrameIndex           = nullptr;
 
     if (MASTER(cr))
     {
@@ -130,6 +183,7 @@ gmx_mdoutf_t init_mdoutf(FILE *fplog, int nfile, const t_filenm fnm[],
             {
                 case efXTC:
                     of->fp_xtc                  = open_xtc(filename, filemode);
+                    of->xtcFrameIndex           = initFrameIndex(filename, restartWithAppending);
                     break;
                 case efTNG:
                     gmx_tng_open(filename, filemode[0], &of->tng_low_prec);
@@ -164,7 +218,8 @@ gmx_mdoutf_t init_mdoutf(FILE *fplog, int nfile, const t_filenm fnm[],
                     if (ir->nstxout != 0 || ir->nstxout_compressed == 0 ||
                         !of->tng_low_prec)
                     {
-                        of->fp_trn = gmx_trr_open(filename, filemode);
+                        of->fp_trn        = gmx_trr_open(filename, filemode);
+                        of->trrFrameIndex = initFrameIndex(filename, restartWithAppending);
                     }
                     break;
                 case efTNG:
@@ -220,6 +275,18 @@ gmx_mdoutf_t init_mdoutf(FILE *fplog, int nfile, const t_filenm fnm[],
         {
             snew(of->f_global, top_global->natoms);
         }
+
+        if (of->fp_xtc != nullptr && getenv("GMX_XTC_OUTPUT_THREAD") != nullptr)
+        {
+            /* Compress and write XTC frames in the background, so that
+               the integration is not stalled by the compression. */
+            of->xtcWriter = new gmx::AsyncXtcWriter(of->fp_xtc, of->natoms_x_compressed,
+                                                    of->x_compression_precision);
+            if (fplog)
+            {
+                fprintf(fplog, "Writing compressed coordinates from a separate thread\n");
+            }
+        }
     }
 
     if (bCiteTng)
@@ -293,6 +360,8 @@ void mdoutf_write_to_trajectory_files(FILE *fplog, const t_commrec *cr,
     {
         if (mdof_flags & MDOF_CPT)
         {
+            /* The checkpoint stores the current XTC file position */
+            waitForXtcOutput(of);
             fflush_tng(of->tng);
             fflush_tng(of->tng_low_prec);
             ivec one_ivec = { 1, 1, 1 };
@@ -303,6 +372,11 @@ void mdoutf_write_to_trajectory_files(FILE *fplog, const t_commrec *cr,
                              of->eIntegrator, of->simulation_part,
                              of->bExpanded, of->elamstats, step, t,
                              state_global, observablesHistory);
+            /* The output files have been flushed by write_checkpoint,
+               so the frame indices can be extended without rereading
+               the earlier frames. */
+            updateFrameIndex(of->xtcFrameIndex);
+            updateFrameIndex(of->trrFrameIndex);
         }
 
         if (mdof_flags & (MDOF_X | MDOF_V | MDOF_F))
@@ -368,13 +442,17 @@ void mdoutf_write_to_trajectory_files(FILE *fplog, const t_commrec *cr,
                     }
                 }
             }
-            if (write_xtc(of->fp_xtc, of->natoms_x_compressed, step, t,
-                          state_local->box, xxtc, of->x_compression_precision) == 0)
+            if (of->xtcWriter != nullptr)
             {
-                gmx_fatal(FARGS,
-                          "XTC error. This indicates you are out of disk space, or a "
-                          "simulation with major instabilities resulting in coordinates "
-                          "that are NaN or too large to be represented in the XTC format.\n");
+                if (!of->xtcWriter->write(step, t, state_local->box, xxtc))
+                {
+                    gmx_fatal(FARGS, "%s", c_xtcErrorMessage);
+                }
+            }
+            else if (write_xtc(of->fp_xtc, of->natoms_x_compressed, step, t,
+                               state_local->box, xxtc, of->x_compression_precision) == 0)
+            {
+                gmx_fatal(FARGS, "%s", c_xtcErrorMessage);
             }
             gmx_fwrite_tng(of->tng_low_prec,
                            TRUE,
@@ -449,6 +527,11 @@ void done_mdoutf(gmx_mdoutf_t of)
     {
         done_ener_file(of->fp_ene);
     }
+    if (of->xtcWriter != nullptr)
+    {
+        waitForXtcOutput(of);
+        delete of->xtcWriter;
+    }
     if (of->fp_xtc)
     {
         close_xtc(of->fp_xtc);
@@ -457,6 +540,10 @@ void done_mdoutf(gmx_mdoutf_t of)
     {
         gmx_trr_close(of->fp_trn);
     }
+    updateFrameIndex(of->xtcFrameIndex);
+    updateFrameIndex(of->trrFrameIndex);
+    delete of->xtcFrameIndex;
+    delete of->trrFrameIndex;
     if (of->fp_dhdl != nullptr)
     {
         gmx_fio_fclose(of->fp_dhdl);
@@ -63,7 +63,9 @@ typedef struct gmx_mdoutf *gmx_mdoutf_t;
 /*! \brief Allocate and initialize object to manager trajectory writing output
  *
  * Returns a pointer to a data structure with all output file pointers
- * and names required by mdrun.
+ * and names required by mdrun. For XTC and TRR output, a frame index
+ * (see gmx::TrajectoryFrameIndex) is written next to the trajectory and
+ * extended at each checkpoint and when the files are closed.
  */
 gmx_mdoutf_t init_mdoutf(FILE                    *fplog,
                          int                      nfile,
@@ -308,6 +308,73 @@ static void post_process_forces(const t_commrec           *cr,
     }
 }
 
+/*! \brief Combines the MTS level-2 forces with the normal forces
+ *
+ * Spreads the level-2 forces on virtual sites and adds their virial
+ * contribution when requested. With \p applyMtsImpulse, returns in
+ * \p forceMtsCombined the forces for the integration with impulse-style
+ * MTS: the normal forces plus \p mtsFactor times the level-2 forces.
+ * The level-2 forces are then also added to \p force, which then contains
+ * the total force for output. Without \p applyMtsImpulse, the level-2
+ * forces were only computed for the energies and virial and the forces
+ * are left unchanged.
+ */
+static void combineMtsForces(const t_commrec          *cr,
+                             t_nrnb                   *nrnb,
+                             gmx_wallcycle_t           wcycle,
+                             const gmx_localtop_t     *top,
+                             const matrix              box,
+                             const rvec                x[],
+                             int                       mtsFactor,
+                             bool                      applyMtsImpulse,
+                             int                       numAtoms,
+                             gmx::ArrayRef<gmx::RVec>  force,
+                             gmx::ArrayRef<gmx::RVec>  forceMtsCombined,
+                             gmx::ForceWithVirial     *forceWithVirialMtsLevel2,
+                             tensor                    vir_force,
+                             const t_graph            *graph,
+                             const t_forcerec         *fr,
+                             const gmx_vsite_t        *vsite,
+                             int                       flags)
+{
+    GMX_RELEASE_ASSERT(!applyMtsImpulse || forceMtsCombined.ssize() >= numAtoms, "With MTS, do_force needs a combined force buffer");
+
+    rvec *fMtsLevel2 = as_rvec_array(forceWithVirialMtsLevel2->force_.data());
+
+    if (vsite)
+    {
+        matrix virial = { { 0 } };
+        spread_vsite_f(vsite, x, fMtsLevel2, nullptr,
+                       (flags & GMX_FORCE_VIRIAL) != 0, virial,
+                       nrnb,
+                       &top->idef, fr->ePBC, fr->bMolPBC, graph, box, cr, wcycle);
+        forceWithVirialMtsLevel2->addVirialContribution(virial);
+    }
+
+    if (flags & GMX_FORCE_VIRIAL)
+    {
+        /* The virial is computed with the unscaled level-2 forces */
+        m_add(vir_force, forceWithVirialMtsLevel2->getVirial(), vir_force);
+    }
+
+    if (!applyMtsImpulse)
+    {
+        return;
+    }
+
+    const real     factor = mtsFactor;
+    int gmx_unused nt     = gmx_omp_nthreads_get(emntDefault);
+#pragma omp parallel for num_threads(nt) schedule(static)
+    for (int i = 0; i < numAtoms; i++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            forceMtsCombined[i][d] = force[i][d] + factor*fMtsLevel2[i][d];
+            force[i][d]           += fMtsLevel2[i][d];
+        }
+    }
+}
+
 static void do_nb_verlet(t_forcerec                       *fr,
                          const interaction_const_t        *ic,
                          gmx_enerdata_t                   *enerd,
@@ -520,6 +587,9 @@ haveSpecialForces(const t_inputrec              *inputrec,
  * \param[in,out] ed               Essential dynamics pointer
  * \param[in]     bNS              Tells if we did neighbor searching this step, used for ED sampling
  *
+ * The pull (and AWH) forces are added to \p forceWithVirialPull, which is
+ * nullptr at steps where multiple time stepping skips the pull forces.
+ *
  * \todo Remove bNS, which is used incorrectly.
  * \todo Convert all other algorithms called here to ForceProviders.
  */
@@ -541,6 +611,7 @@ computeSpecialForces(FILE                          *fplog,
                      real                          *lambda,
                      int                            forceFlags,
                      gmx::ForceWithVirial          *forceWithVirial,
+                     gmx::ForceWithVirial          *forceWithVirialPull,
                      gmx_enerdata_t                *enerd,
                      gmx_edsam                     *ed,
                      gmx_bool                       bNS)
@@ -559,10 +630,10 @@ computeSpecialForces(FILE                          *fplog,
         forceProviders->calculateForces(forceProviderInput, &forceProviderOutput);
     }
 
-    if (inputrec->bPull && pull_have_potential(pull_work))
+    if (inputrec->bPull && pull_have_potential(pull_work) && forceWithVirialPull != nullptr)
     {
         pull_potential_wrapper(cr, inputrec, box, x,
-                               forceWithVirial,
+                               forceWithVirialPull,
                                mdatoms, enerd, pull_work, lambda, t,
                                wcycle);
 
@@ -570,7 +641,7 @@ computeSpecialForces(FILE                          *fplog,
         {
             enerd->term[F_COM_PULL] +=
                 awh->applyBiasForcesAndUpdateBias(inputrec->ePBC, *mdatoms, box,
-                                                  forceWithVirial,
+                                                  forceWithVirialPull,
                                                   t, step, wcycle, fplog);
         }
     }
@@ -713,14 +784,22 @@ static void alternatePmeNbGpuWaitReduce(nonbonded_verlet_t                  *nbv
 struct ForceOutputs
 {
     //! Constructor
-    ForceOutputs(rvec *f, gmx::ForceWithVirial const forceWithVirial) :
+    ForceOutputs(rvec *f, gmx::ForceWithVirial const forceWithVirial,
+                 gmx::ForceWithVirial const forceWithVirialMtsLevel2,
+                 bool haveForceWithVirialMtsLevel2) :
         f(f),
-        forceWithVirial(forceWithVirial) {}
+        forceWithVirial(forceWithVirial),
+        forceWithVirialMtsLevel2(forceWithVirialMtsLevel2),
+        haveForceWithVirialMtsLevel2(haveForceWithVirialMtsLevel2) {}
 
     //! Force output buffer used by legacy modules (without SIMD padding)
     rvec                 *const f;
     //! Force with direct virial contribution (if there are any; without SIMD padding)
     gmx::ForceWithVirial        forceWithVirial;
+    //! Force with virial for the multiple time stepping level-2 forces, only valid when haveForceWithVirialMtsLevel2
+    gmx::ForceWithVirial        forceWithVirialMtsLevel2;
+    //! Whether the MTS level-2 forces are computed at this step, always false without MTS
+    const bool                  haveForceWithVirialMtsLevel2;
 };
 
 /*! \brief Set up the different force buffers; also does clearing.
@@ -731,6 +810,7 @@ struct ForceOutputs
  * \param[in] force     force array
  * \param[in] bDoForces True if force are computed this step
  * \param[in] doVirial  True if virial is computed this step
+ * \param[in] doMtsLevel2Forces  True if the MTS level-2 forces are computed this step with MTS
  * \param[out] wcycle   wallcycle recording structure
  *
  * \returns             Cleared force output structure
@@ -742,6 +822,7 @@ setupForceOutputs(const t_forcerec                    *fr,
                   gmx::ArrayRefWithPadding<gmx::RVec>  force,
                   const bool                           bDoForces,
                   const bool                           doVirial,
+                  const bool                           doMtsLevel2Forces,
                   gmx_wallcycle_t                      wcycle)
 {
     wallcycle_sub_start(wcycle, ewcsCLEAR_FORCE_BUFFER);
@@ -777,6 +858,18 @@ setupForceOutputs(const t_forcerec                    *fr,
         clear_rvecs_omp(forceWithVirial.force_.size(), as_rvec_array(forceWithVirial.force_.data()));
     }
 
+    /* With MTS the level-2 forces always need a separate buffer,
+     * since they are scaled by the MTS factor before integration.
+     */
+    const bool           useMtsLevel2Buffer = (bDoForces && doMtsLevel2Forces);
+    gmx::ForceWithVirial forceWithVirialMtsLevel2(useMtsLevel2Buffer ?
+                                                  *fr->forceBufferMtsLevel2 : gmx::ArrayRef<gmx::RVec>(),
+                                                  doVirial);
+    if (useMtsLevel2Buffer)
+    {
+        clear_rvecs_omp(forceWithVirialMtsLevel2.force_.size(), as_rvec_array(forceWithVirialMtsLevel2.force_.data()));
+    }
+
     if (inputrec.bPull && pull_have_constraint(pull_work))
     {
         clear_pull_forces(pull_work);
@@ -784,7 +877,7 @@ setupForceOutputs(const t_forcerec                    *fr,
 
     wallcycle_sub_stop(wcycle, ewcsCLEAR_FORCE_BUFFER);
 
-    return ForceOutputs(f, forceWithVirial);
+    return ForceOutputs(f, forceWithVirial, forceWithVirialMtsLevel2, useMtsLevel2Buffer);
 }
 
 
@@ -830,6 +923,7 @@ void do_force(FILE                                     *fplog,
               gmx::ArrayRefWithPadding<gmx::RVec>       x,     //NOLINT(performance-unnecessary-value-param)
               history_t                                *hist,
               gmx::ArrayRefWithPadding<gmx::RVec>       force, //NOLINT(performance-unnecessary-value-param)
+              gmx::ArrayRefWithPadding<gmx::RVec>       forceMtsCombined,
               tensor                                    vir_force,
               const t_mdatoms                          *mdatoms,
               gmx_enerdata_t                           *enerd,
@@ -876,6 +970,25 @@ void do_force(FILE                                     *fplog,
 
     const bool useGpuXBufOps = (c_enableGpuBufOps && bUseGPU && (GMX_GPU == GMX_GPU_CUDA));
 
+    /* On CPU-only runs we overlap the first pulse of the non-local
+     * coordinate communication with the local non-bonded work.
+     * Enforced rotation needs all local coordinates before that.
+     */
+    const bool overlapHaloExchangeX = (havePPDomainDecomposition(cr) && !bNS &&
+                                       !bUseOrEmulGPU && !inputrec->bRot);
+
+    /* With multiple time stepping the level-2 forces are only applied
+     * every mtsFactor steps. At the other steps we skip their computation
+     * and, for long-range forces, the communication with the PME ranks,
+     * unless energies or the virial are requested, since those should
+     * include the level-2 contributions. mdrun can request these at any
+     * step, e.g. at the last step or at replica-exchange steps.
+     */
+    const bool isMtsStep              = isMtsLevel2Step(*inputrec, step);
+    const bool computeMtsLevel2Forces = (isMtsStep || (flags & (GMX_FORCE_ENERGY | GMX_FORCE_VIRIAL)) != 0);
+    const bool computeLongRangeForces = (!isMtsLevel2Force(*inputrec, emtsLONGRANGE_NONBONDED) || computeMtsLevel2Forces);
+    const bool computePullForces      = (!isMtsLevel2Force(*inputrec, emtsPULL) || computeMtsLevel2Forces);
+
     /* At a search step we need to start the first balancing region
      * somewhere early inside the step after communication during domain
      * decomposition (and not during the previous step as usual).
@@ -930,7 +1043,7 @@ void do_force(FILE                                     *fplog,
                                  fr->shift_vec, nbv->nbat.get());
 
 #if GMX_MPI
-    if (!thisRankHasDuty(cr, DUTY_PME))
+    if (!thisRankHasDuty(cr, DUTY_PME) && computeLongRangeForces)
     {
         /* Send particle coordinates to the pme nodes.
          * Since this is only implemented for domain decomposition
@@ -1121,6 +1234,13 @@ void do_force(FILE                                     *fplog,
                 nbv->atomdata_init_copy_x_to_nbat_x_gpu( Nbnxm::AtomLocality::NonLocal);
             }
         }
+        else if (overlapHaloExchangeX)
+        {
+            /* Start the first coordinate pulse here, the exchange is
+             * completed after the local non-bonded work below.
+             */
+            dd_move_x_start(cr->dd, box, x.unpaddedArrayRef(), wcycle);
+        }
         else
         {
             dd_move_x(cr->dd, box, x.unpaddedArrayRef(), wcycle);
@@ -1218,7 +1338,7 @@ void do_force(FILE                                     *fplog,
     reset_enerdata(enerd);
     clear_rvecs(SHIFTS, fr->fshift);
 
-    if (DOMAINDECOMP(cr) && !thisRankHasDuty(cr, DUTY_PME))
+    if (DOMAINDECOMP(cr) && !thisRankHasDuty(cr, DUTY_PME) && computeLongRangeForces)
     {
         wallcycle_start(wcycle, ewcPPDURINGPME);
         dd_force_flop_start(cr->dd, nrnb);
@@ -1238,7 +1358,24 @@ void do_force(FILE                                     *fplog,
 
     // set up and clear force outputs
     struct ForceOutputs forceOut = setupForceOutputs(fr, pull_work, *inputrec, force, bDoForces,
-                                                     ((flags & GMX_FORCE_VIRIAL) != 0), wcycle);
+                                                     ((flags & GMX_FORCE_VIRIAL) != 0),
+                                                     inputrec->useMts && computeMtsLevel2Forces, wcycle);
+
+    /* The output buffers for the forces that can be MTS level-2 forces,
+     * nullptr when these are not computed at this step.
+     */
+    gmx::ForceWithVirial *forceWithVirialLongRange = nullptr;
+    if (computeLongRangeForces)
+    {
+        forceWithVirialLongRange = (isMtsLevel2Force(*inputrec, emtsLONGRANGE_NONBONDED) && forceOut.haveForceWithVirialMtsLevel2 ?
+                                    &forceOut.forceWithVirialMtsLevel2 : &forceOut.forceWithVirial);
+    }
+    gmx::ForceWithVirial *forceWithVirialPull = nullptr;
+    if (computePullForces)
+    {
+        forceWithVirialPull = (isMtsLevel2Force(*inputrec, emtsPULL) && forceOut.haveForceWithVirialMtsLevel2 ?
+                               &forceOut.forceWithVirialMtsLevel2 : &forceOut.forceWithVirial);
+    }
 
     /* We calculate the non-bonded forces, when done on the CPU, here.
      * We do this before calling do_force_lowlevel, because in that
@@ -1254,6 +1391,18 @@ void do_force(FILE                                     *fplog,
                      step, nrnb, wcycle);
     }
 
+    if (overlapHaloExchangeX)
+    {
+        wallcycle_stop(wcycle, ewcFORCE);
+
+        dd_move_x_finish(cr->dd, box, x.unpaddedArrayRef(), wcycle);
+
+        nbv->setCoordinates(Nbnxm::AtomLocality::NonLocal, false,
+                            x.unpaddedArrayRef(), false, nullptr, wcycle);
+
+        wallcycle_start_nocount(wcycle, ewcFORCE);
+    }
+
     if (fr->efep != efepNO)
     {
         /* Calculate the local and non-local free energy interactions here.
@@ -1312,7 +1461,8 @@ void do_force(FILE                                     *fplog,
     /* Compute the bonded and non-bonded energies and optionally forces */
     do_force_lowlevel(fr, inputrec, &(top->idef),
                       cr, ms, nrnb, wcycle, mdatoms,
-                      as_rvec_array(x.unpaddedArrayRef().data()), hist, forceOut.f, &forceOut.forceWithVirial, enerd, fcd,
+                      as_rvec_array(x.unpaddedArrayRef().data()), hist, forceOut.f, &forceOut.forceWithVirial,
+                      forceWithVirialLongRange, enerd, fcd,
                       box, lambda.data(), graph, fr->mu_tot,
                       flags,
                       ddBalanceRegionHandler);
@@ -1322,7 +1472,7 @@ void do_force(FILE                                     *fplog,
     computeSpecialForces(fplog, cr, inputrec, awh, enforcedRotation,
                          imdSession, pull_work, step, t, wcycle,
                          fr->forceProviders, box, x.unpaddedArrayRef(), mdatoms, lambda.data(),
-                         flags, &forceOut.forceWithVirial, enerd,
+                         flags, &forceOut.forceWithVirial, forceWithVirialPull, enerd,
                          ed, bNS);
 
     // Will store the amount of cycles spent waiting for the GPU that
@@ -1499,12 +1649,12 @@ void do_force(FILE                                     *fplog,
         }
     }
 
-    if (PAR(cr) && !thisRankHasDuty(cr, DUTY_PME))
+    if (PAR(cr) && !thisRankHasDuty(cr, DUTY_PME) && computeLongRangeForces)
     {
         /* In case of node-splitting, the PP nodes receive the long-range
          * forces, virial and energy from the PME nodes here.
          */
-        pme_receive_force_ener(cr, &forceOut.forceWithVirial, enerd, wcycle);
+        pme_receive_force_ener(cr, forceWithVirialLongRange, enerd, wcycle);
     }
 
     if (bDoForces)
@@ -1513,6 +1663,15 @@ void do_force(FILE                                     *fplog,
                             top, box, as_rvec_array(x.unpaddedArrayRef().data()), forceOut.f, &forceOut.forceWithVirial,
                             vir_force, mdatoms, graph, fr, vsite,
                             flags);
+
+        if (forceOut.haveForceWithVirialMtsLevel2)
+        {
+            combineMtsForces(cr, nrnb, wcycle, top, box, as_rvec_array(x.unpaddedArrayRef().data()),
+                             inputrec->mtsFactor, isMtsStep, mdatoms->homenr,
+                             force.unpaddedArrayRef(), forceMtsCombined.unpaddedArrayRef(),
+                             &forceOut.forceWithVirialMtsLevel2,
+                             vir_force, graph, fr, vsite, flags);
+        }
     }
 
     if (flags & GMX_FORCE_ENERGY)
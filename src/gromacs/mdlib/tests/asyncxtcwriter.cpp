@@ -0,0 +1,113 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for gmx::AsyncXtcWriter.
+ *
+ * \ingroup module_mdlib
+ */
+#include "gmxpre.h"
+
+#include "gromacs/mdlib/asyncxtcwriter.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/xtcio.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/utility/smalloc.h"
+
+#include "testutils/testfilemanager.h"
+
+namespace
+{
+
+TEST(AsyncXtcWriterTest, WritesFramesInOrder)
+{
+    gmx::test::TestFileManager fileManager;
+    const std::string          filename   = fileManager.getTemporaryFilePath(".xtc");
+    const int                  natoms     = 100;
+    const int                  frameCount = 5;
+    const real                 precision  = 1000;
+    matrix                     box        = {{3, 0, 0}, {0, 3, 0}, {0, 0, 3}};
+    std::vector<gmx::RVec>     x(natoms);
+
+    t_fileio *fio = open_xtc(filename.c_str(), "w");
+    {
+        gmx::AsyncXtcWriter writer(fio, natoms, precision);
+        for (int frame = 0; frame < frameCount; ++frame)
+        {
+            for (int i = 0; i < natoms; ++i)
+            {
+                x[i] = { 0.01f*i, 0.1f*frame, 1.0f };
+            }
+            box[XX][XX] = 3 + frame;
+            ASSERT_TRUE(writer.write(frame, 0.5*frame, box, as_rvec_array(x.data())));
+            // The writer must have made a copy.
+            x[0] = { -1, -1, -1 };
+        }
+        EXPECT_TRUE(writer.waitForCompletion());
+    }
+    close_xtc(fio);
+
+    fio = open_xtc(filename.c_str(), "r");
+    int      readAtoms = 0;
+    int64_t  step;
+    real     time, prec;
+    rvec    *readX = nullptr;
+    gmx_bool bOK;
+    ASSERT_TRUE(read_first_xtc(fio, &readAtoms, &step, &time, box, &readX, &prec, &bOK));
+    ASSERT_EQ(natoms, readAtoms);
+    for (int frame = 0; frame < frameCount; ++frame)
+    {
+        if (frame > 0)
+        {
+            ASSERT_TRUE(read_next_xtc(fio, readAtoms, &step, &time, box, readX, &prec, &bOK));
+        }
+        EXPECT_EQ(frame, step);
+        EXPECT_FLOAT_EQ(0.5*frame, time);
+        EXPECT_FLOAT_EQ(3 + frame, box[XX][XX]);
+        EXPECT_NEAR(0.0, readX[0][XX], 1e-3);
+        EXPECT_NEAR(0.1*frame, readX[natoms - 1][YY], 1e-3);
+    }
+    EXPECT_FALSE(read_next_xtc(fio, readAtoms, &step, &time, box, readX, &prec, &bOK));
+    sfree(readX);
+    close_xtc(fio);
+}
+
+} // namespace
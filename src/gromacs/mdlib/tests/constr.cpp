@@ -525,12 +525,24 @@ class ConstraintsTest : public ::testing::TestWithParam<ConstraintsTestParameter
          * \param[in] pbc             Periodic boundary data.
          */
         static void applyLincs(ConstraintsTestData *testData, t_pbc pbc)
+        {
+            applyLincsOnTasks(testData, pbc, 1);
+        }
+
+        /*! \brief
+         * Initialize and apply LINCS constraints using \p numTasks tasks.
+         *
+         * \param[in] testData        Test data structure.
+         * \param[in] pbc             Periodic boundary data.
+         * \param[in] numTasks        Number of LINCS tasks (OpenMP threads).
+         */
+        static void applyLincsOnTasks(ConstraintsTestData *testData, t_pbc pbc, int numTasks)
         {
 
             Lincs                *lincsd;
             int                   maxwarn         = 100;
             int                   warncount_lincs = 0;
-            gmx_omp_nthreads_set(emntLINCS, 1);
+            gmx_omp_nthreads_set(emntLINCS, numTasks);
 
             // Make blocka structure for faster LINCS setup
             std::vector<t_blocka> at2con_mt;
@@ -572,6 +584,7 @@ class ConstraintsTest : public ::testing::TestWithParam<ConstraintsTestParameter
                 sfree(at2con_mt.at(i).a);
             }
             done_lincs(lincsd);
+            gmx_omp_nthreads_set(emntLINCS, 1);
         }
 
         /*! \brief
@@ -1159,6 +1172,152 @@ TEST_P(ConstraintsTest, TriangleOfConstraints){
 }
 
 
+/*! \brief Builds LINCS test data with deterministically displaced updated coordinates.
+ *
+ * \param[in] title          Human-friendly name of the system.
+ * \param[in] masses         Atom masses.
+ * \param[in] constraints    Constraints in type-i-j format.
+ * \param[in] constraintsR0  Reference lengths per constraint type.
+ * \param[in] x              Coordinates satisfying the constraints.
+ */
+static std::unique_ptr<ConstraintsTestData>
+makeDisplacedTestData(const std::string &title, const std::vector<real> &masses,
+                      const std::vector<int> &constraints, const std::vector<real> &constraintsR0,
+                      const std::vector<RVec> &x)
+{
+    const int         numAtoms = x.size();
+    std::vector<RVec> xPrime(numAtoms);
+    for (int i = 0; i < numAtoms; i++)
+    {
+        xPrime[i] = x[i] + RVec(0.01*std::sin(1.3*i), 0.01*std::cos(0.7*i), 0.01*std::sin(2.1*i + 0.5));
+    }
+    std::vector<RVec> v(numAtoms, { 0.0, 0.0, 0.0 });
+    tensor            virialScaledRef = {{0}};
+
+    return std::make_unique<ConstraintsTestData>
+               (title, numAtoms, masses,
+               constraints, constraintsR0,
+               true, virialScaledRef,
+               false, 0,
+               real(0.0), real(0.001),
+               x, xPrime, v,
+               real(0.0001), false,
+               1, 4, real(30.0));
+}
+
+/*! \brief Builds test data for \p numMolecules CH3-like groups.
+ *
+ * Each group is an independent coupled component of three
+ * constraints, so LINCS can assign whole groups to tasks.
+ */
+static std::unique_ptr<ConstraintsTestData> makeMethylGroupsTestData(int numMolecules)
+{
+    const std::vector<RVec> atomOffsets = {{ 0.0,  0.0, 0.0 },
+                                           { 0.1,  0.0, 0.0 },
+                                           { 0.0, -0.1, 0.0 },
+                                           { 0.0,  0.0, 0.1 }};
+
+    std::vector<real>       masses;
+    std::vector<int>        constraints;
+    std::vector<RVec>       x;
+    for (int m = 0; m < numMolecules; m++)
+    {
+        const int  centralAtom = x.size();
+        const RVec center(0.5*(m % 4), 0.5*((m/4) % 4), 0.5*(m/16));
+        for (const RVec &offset : atomOffsets)
+        {
+            x.push_back(center + offset);
+        }
+        masses.insert(masses.end(), { 12.0, 1.0, 1.0, 1.0 });
+        for (int h = 1; h <= 3; h++)
+        {
+            constraints.insert(constraints.end(), { 0, centralAtom, centralAtom + h });
+        }
+    }
+
+    return makeDisplacedTestData("CH3-like groups", masses, constraints, { 0.1 }, x);
+}
+
+/*! \brief Builds test data for a single zigzag chain of \p numAtoms atoms.
+ *
+ * The chain is one coupled component, so with multiple tasks LINCS
+ * has to split it over tasks that depend on each other.
+ */
+static std::unique_ptr<ConstraintsTestData> makeChainTestData(int numAtoms)
+{
+    std::vector<real> masses(numAtoms, 12.0);
+    std::vector<int>  constraints;
+    std::vector<RVec> x;
+    for (int a = 0; a < numAtoms; a++)
+    {
+        x.emplace_back(0.1*std::cos(M_PI/6)*a, 0.05*(a % 2), 0.0);
+        if (a > 0)
+        {
+            constraints.insert(constraints.end(), { 0, a - 1, a });
+        }
+    }
+
+    return makeDisplacedTestData("zigzag chain", masses, constraints, { 0.1 }, x);
+}
+
+/*! \brief Checks that LINCS with \p numTasks tasks reproduces LINCS with a single task.
+ *
+ * The coupling sums in the matrix expansion can be accumulated in a
+ * different order, so the comparison allows for rounding differences.
+ */
+static void checkLincsTasksMatchSingleTask(ConstraintsTestData *testData, int numTasks)
+{
+    t_pbc  pbc;
+    matrix boxNone = { {0, 0, 0}, {0, 0, 0}, {0, 0, 0} };
+    set_pbc(&pbc, epbcNONE, boxNone);
+
+    ConstraintsTest::applyLincsOnTasks(testData, pbc, 1);
+    const std::vector<RVec> xPrimeRef(testData->xPrime_.begin(), testData->xPrime_.end());
+    tensor                  virialRef;
+    copy_mat(testData->virialScaled_, virialRef);
+
+    testData->reset();
+    ConstraintsTest::applyLincsOnTasks(testData, pbc, numTasks);
+
+    const auto tolerance = absoluteTolerance(1e-5);
+    for (int i = 0; i < testData->numAtoms_; i++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_REAL_EQ_TOL(xPrimeRef[i][d], testData->xPrime_[i][d], tolerance)
+            << gmx::formatString("for atom %d, dimension %d, with %d tasks", i, d, numTasks);
+        }
+    }
+    for (int i = 0; i < DIM; i++)
+    {
+        for (int j = 0; j < DIM; j++)
+        {
+            EXPECT_REAL_EQ_TOL(virialRef[i][j], testData->virialScaled_[i][j], tolerance)
+            << gmx::formatString("for virial component %d %d, with %d tasks", i, j, numTasks);
+        }
+    }
+}
+
+TEST(LincsTasksTest, IndependentTasksMatchSingleTask)
+{
+    std::unique_ptr<ConstraintsTestData> testData = makeMethylGroupsTestData(48);
+    for (int numTasks : { 2, 4, 7 })
+    {
+        testData->reset();
+        checkLincsTasksMatchSingleTask(testData.get(), numTasks);
+    }
+}
+
+TEST(LincsTasksTest, SplitComponentTasksMatchSingleTask)
+{
+    std::unique_ptr<ConstraintsTestData> testData = makeChainTestData(96);
+    for (int numTasks : { 2, 4, 7 })
+    {
+        testData->reset();
+        checkLincsTasksMatchSingleTask(testData.get(), numTasks);
+    }
+}
+
 #if GMX_GPU == GMX_GPU_CUDA
 INSTANTIATE_TEST_CASE_P(WithParameters, ConstraintsTest,
                             ::testing::Combine(::testing::Values("PBCNone", "PBCXYZ"),
@@ -0,0 +1,259 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief Tests for the CPU leap-frog update
+ *
+ * Checks the simple leap-frog kernels, used with Berendsen-type
+ * temperature scaling and diagonal Parrinello-Rahman scaling, against
+ * a reference computed in the test. The SIMD kernel, which is used
+ * without partially frozen atoms, is also compared directly to the
+ * plain-C++ kernel, which is used with partially frozen atoms.
+ *
+ * \ingroup module_mdlib
+ */
+#include "gmxpre.h"
+
+#include "gromacs/mdlib/update.h"
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/math/paddedvector.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
+#include "gromacs/mdtypes/group.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/mdtypes/mdatom.h"
+#include "gromacs/mdtypes/state.h"
+#include "gromacs/utility/stringutil.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+/*! \brief The parameters for the test
+ *
+ * The number of atoms, the number of T-coupling groups and whether
+ * to apply diagonal Parrinello-Rahman velocity scaling.
+ */
+typedef std::tuple<int, int, bool> LeapFrogCpuTestParameters;
+
+/*! \brief Test fixture for the simple leap-frog update on the CPU
+ *
+ * Sets up a system with masses, T-scaling factors and velocities
+ * that differ per atom, so that mixing up atoms or groups is detected.
+ */
+class LeapFrogCpuTest : public ::testing::TestWithParam<LeapFrogCpuTestParameters>
+{
+    public:
+        //! Sets up the system and input for the parameters of the test
+        LeapFrogCpuTest() : update_(&inputrec_, nullptr)
+        {
+            std::tie(numAtoms_, numTCoupleGroups_, doParrinelloRahman_) = GetParam();
+
+            inputrec_.eI         = eiMD;
+            inputrec_.delta_t    = 0.002;
+            inputrec_.etc        = etcBERENDSEN;
+            inputrec_.nsttcouple = 1;
+            inputrec_.epc        = (doParrinelloRahman_ ? epcPARRINELLORAHMAN : epcNO);
+            inputrec_.nstpcouple = 1;
+
+            ekind_.ngtc  = numTCoupleGroups_;
+            ekind_.bNEMD = FALSE;
+            ekind_.tcstat.resize(numTCoupleGroups_);
+            for (int g = 0; g < numTCoupleGroups_; g++)
+            {
+                ekind_.tcstat[g].lambda = 0.95 + 0.05*g;
+            }
+
+            invMass_.resizeWithPadding(numAtoms_);
+            invMassPerDim_.resize(numAtoms_);
+            cTC_.resize(numAtoms_);
+            x_.resizeWithPadding(numAtoms_);
+            v_.resizeWithPadding(numAtoms_);
+            f_.resizeWithPadding(numAtoms_);
+            for (int a = 0; a < numAtoms_; a++)
+            {
+                invMass_[a] = 1.0/(1.0 + 0.5*(a % 5));
+                invMassPerDim_[a] = RVec(invMass_[a], invMass_[a], invMass_[a]);
+                cTC_[a]     = a % numTCoupleGroups_;
+                x_[a]       = RVec(0.1*a, 0.2 + 0.05*a, 1.0 - 0.01*a);
+                v_[a]       = RVec(0.5 + 0.01*a, -0.3 + 0.02*a, 0.2 - 0.01*a);
+                f_[a]       = RVec(10.0 - a, 5.0 + 0.5*a, -20.0 + a);
+            }
+
+            md_.homenr        = numAtoms_;
+            md_.invmass       = invMass_.data();
+            md_.invMassPerDim = as_rvec_array(invMassPerDim_.data());
+            md_.cTC           = cTC_.data();
+
+            clear_mat(M_);
+            if (doParrinelloRahman_)
+            {
+                M_[XX][XX] = 0.01;
+                M_[YY][YY] = 0.02;
+                M_[ZZ][ZZ] = -0.03;
+            }
+
+            update_.setNumAtoms(numAtoms_);
+        }
+
+        /*! \brief Runs a leap-frog step starting from the initial state
+         *
+         * With \p havePartiallyFrozenAtoms set the plain-C++ kernel is
+         * used, otherwise the SIMD kernel is used when available.
+         * The updated coordinates and velocities are returned in
+         * \p xPrime and \p v.
+         */
+        void runUpdate(bool               havePartiallyFrozenAtoms,
+                       std::vector<RVec> *xPrime,
+                       std::vector<RVec> *v)
+        {
+            md_.havePartiallyFrozenAtoms = havePartiallyFrozenAtoms;
+
+            t_state state;
+            state.flags = 0;
+            state.x.resizeWithPadding(numAtoms_);
+            state.v.resizeWithPadding(numAtoms_);
+            std::copy(x_.begin(), x_.end(), state.x.begin());
+            std::copy(v_.begin(), v_.end(), state.v.begin());
+            clear_mat(state.box);
+
+            gmx_omp_nthreads_set(emntUpdate, 1);
+            update_coords(0, &inputrec_, &md_, &state, f_.arrayRefWithPadding(),
+                          nullptr, &ekind_, M_, &update_, etrtPOSITION, nullptr, nullptr);
+
+            const PaddedVector<RVec> &xp = *update_.xp();
+            xPrime->assign(xp.begin(), xp.begin() + numAtoms_);
+            v->assign(state.v.begin(), state.v.begin() + numAtoms_);
+        }
+
+        //! Checks \p xPrime and \p v against a reference computed here in double precision
+        void checkAgainstReference(const std::vector<RVec> &xPrime,
+                                   const std::vector<RVec> &v)
+        {
+            const double dt        = inputrec_.delta_t;
+            const auto   tolerance = relativeToleranceAsFloatingPoint(1.0, 1e-6);
+            for (int a = 0; a < numAtoms_; a++)
+            {
+                const double lambda = ekind_.tcstat[cTC_[a]].lambda;
+                for (int d = 0; d < DIM; d++)
+                {
+                    const double vRef = lambda*v_[a][d] + f_[a][d]*invMass_[a]*dt
+                        - inputrec_.nstpcouple*dt*M_[d][d]*v_[a][d];
+                    const double xRef = x_[a][d] + vRef*dt;
+                    EXPECT_REAL_EQ_TOL(vRef, v[a][d], tolerance)
+                    << formatString("velocity of atom %d, dimension %d", a, d);
+                    EXPECT_REAL_EQ_TOL(xRef, xPrime[a][d], tolerance)
+                    << formatString("coordinate of atom %d, dimension %d", a, d);
+                }
+            }
+        }
+
+        //! Number of atoms
+        int                   numAtoms_;
+        //! Number of T-coupling groups
+        int                   numTCoupleGroups_;
+        //! Whether to apply Parrinello-Rahman velocity scaling
+        bool                  doParrinelloRahman_;
+        //! Input record
+        t_inputrec            inputrec_;
+        //! Kinetic energy data with the T-scaling factors
+        gmx_ekindata_t        ekind_ {};
+        //! Atom data
+        t_mdatoms             md_ {};
+        //! Inverse masses
+        PaddedVector<real>    invMass_;
+        //! Inverse masses per dimension
+        std::vector<RVec>     invMassPerDim_;
+        //! T-coupling group indices
+        std::vector<unsigned short> cTC_;
+        //! Initial coordinates
+        PaddedVector<RVec>    x_;
+        //! Initial velocities
+        PaddedVector<RVec>    v_;
+        //! Forces
+        PaddedVector<RVec>    f_;
+        //! Parrinello-Rahman velocity scaling matrix
+        matrix                M_;
+        //! Update object holding the updated coordinates
+        Update                update_;
+};
+
+TEST_P(LeapFrogCpuTest, SimdKernelMatchesPlainKernel)
+{
+    std::vector<RVec> xPrimeSimd, vSimd;
+    runUpdate(false, &xPrimeSimd, &vSimd);
+    std::vector<RVec> xPrimePlain, vPlain;
+    runUpdate(true, &xPrimePlain, &vPlain);
+
+    checkAgainstReference(xPrimePlain, vPlain);
+    checkAgainstReference(xPrimeSimd, vSimd);
+
+    // The kernels only differ in the use of fused multiply-add
+    const auto tolerance = relativeToleranceAsFloatingPoint(1.0, 1e-6);
+    for (int a = 0; a < numAtoms_; a++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_REAL_EQ_TOL(vPlain[a][d], vSimd[a][d], tolerance)
+            << formatString("velocity of atom %d, dimension %d", a, d);
+            EXPECT_REAL_EQ_TOL(xPrimePlain[a][d], xPrimeSimd[a][d], tolerance)
+            << formatString("coordinate of atom %d, dimension %d", a, d);
+        }
+    }
+}
+
+//! Atom counts, most of which are not a multiple of the SIMD width
+const int c_numAtoms[] = { 1, 7, 16, 37 };
+
+INSTANTIATE_TEST_CASE_P(WithParameters, LeapFrogCpuTest,
+                            ::testing::Combine(::testing::ValuesIn(c_numAtoms),
+                                                   ::testing::Values(1, 3),
+                                                   ::testing::Bool()));
+
+} // namespace
+} // namespace test
+} // namespace gmx
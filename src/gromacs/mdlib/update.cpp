@@ -315,31 +315,63 @@ static inline void simdStoreRvecs(rvec     *r,
     store(realPtr + 2*GMX_SIMD_REAL_WIDTH, r2);
 }
 
-/*! \brief Integrate using leap-frog with single group T-scaling and SIMD
+/*! \brief Integrate using leap-frog with T-scaling, optionally diagonal Parrinello-Rahman p-coupling and SIMD
  *
+ * This is the SIMD version of updateMDLeapfrogSimple(). It uses 1/mass
+ * per atom instead of per dimension, so it can only be used without
+ * partially frozen atoms.
+ *
+ * \tparam       numTempScaleValues     The number of different T-couple values
+ * \tparam       applyPRVScaling        Apply Parrinello-Rahman velocity scaling
  * \param[in]    start                  Index of first atom to update
  * \param[in]    nrend                  Last atom to update: \p nrend - 1
  * \param[in]    dt                     The time step
+ * \param[in]    dtPressureCouple       Time step for pressure coupling
  * \param[in]    invMass                1/mass per atom
  * \param[in]    tcstat                 Temperature coupling information
+ * \param[in]    cTC                    T-coupling group index per atom
+ * \param[in]    pRVScaleMatrixDiagonal Parrinello-Rahman v-scale matrix diagonal
  * \param[in]    x                      Input coordinates
  * \param[out]   xprime                 Updated coordinates
  * \param[inout] v                      Velocities
  * \param[in]    f                      Forces
  */
+template<NumTempScaleValues            numTempScaleValues,
+         ApplyParrinelloRahmanVScaling applyPRVScaling>
 static void
 updateMDLeapfrogSimpleSimd(int                               start,
                            int                               nrend,
                            real                              dt,
+                           real                              dtPressureCouple,
                            const real * gmx_restrict         invMass,
                            gmx::ArrayRef<const t_grp_tcstat> tcstat,
+                           const unsigned short            * cTC,
+                           const rvec                        pRVScaleMatrixDiagonal,
                            const rvec * gmx_restrict         x,
                            rvec       * gmx_restrict         xprime,
                            rvec       * gmx_restrict         v,
                            const rvec * gmx_restrict         f)
 {
     SimdReal                  timestep(dt);
-    SimdReal                  lambdaSystem(tcstat[0].lambda);
+    SimdReal                  lambda0(tcstat[0].lambda);
+    SimdReal                  lambda1 = lambda0;
+    SimdReal                  lambda2 = lambda0;
+
+    /* The Parrinello-Rahman scaling factors, laid out as three rvec registers */
+    SimdReal                  prScale0 = setZero();
+    SimdReal                  prScale1 = setZero();
+    SimdReal                  prScale2 = setZero();
+    if (applyPRVScaling == ApplyParrinelloRahmanVScaling::diagonal)
+    {
+        alignas(GMX_SIMD_ALIGNMENT) real prScaleTriplets[DIM*GMX_SIMD_REAL_WIDTH];
+        for (int i = 0; i < DIM*GMX_SIMD_REAL_WIDTH; i++)
+        {
+            prScaleTriplets[i] = dtPressureCouple*pRVScaleMatrixDiagonal[i % DIM];
+        }
+        prScale0 = simdLoad(prScaleTriplets + 0*GMX_SIMD_REAL_WIDTH);
+        prScale1 = simdLoad(prScaleTriplets + 1*GMX_SIMD_REAL_WIDTH);
+        prScale2 = simdLoad(prScaleTriplets + 2*GMX_SIMD_REAL_WIDTH);
+    }
 
     /* We declare variables here, since code is often slower when declaring them inside the loop */
 
@@ -348,6 +380,18 @@ updateMDLeapfrogSimpleSimd(int                               start,
 
     for (int a = start; a < nrend; a += GMX_SIMD_REAL_WIDTH)
     {
+        if (numTempScaleValues == NumTempScaleValues::multiple)
+        {
+            /* cTC is not padded, so we repeat the last atom beyond nrend */
+            alignas(GMX_SIMD_ALIGNMENT) real lambdaAtom[GMX_SIMD_REAL_WIDTH];
+            for (int i = 0; i < GMX_SIMD_REAL_WIDTH; i++)
+            {
+                lambdaAtom[i] = tcstat[cTC[std::min(a + i, nrend - 1)]].lambda;
+            }
+            expandScalarsToTriplets(simdLoad(lambdaAtom),
+                                    &lambda0, &lambda1, &lambda2);
+        }
+
         SimdReal invMass0, invMass1, invMass2;
         expandScalarsToTriplets(simdLoad(invMass + a),
                                 &invMass0, &invMass1, &invMass2);
@@ -357,18 +401,25 @@ updateMDLeapfrogSimpleSimd(int                               start,
         simdLoadRvecs(v, a, &v0, &v1, &v2);
         simdLoadRvecs(f, a, &f0, &f1, &f2);
 
-        v0 = fma(f0*invMass0, timestep, lambdaSystem*v0);
-        v1 = fma(f1*invMass1, timestep, lambdaSystem*v1);
-        v2 = fma(f2*invMass2, timestep, lambdaSystem*v2);
+        SimdReal vNew0 = fma(f0*invMass0, timestep, lambda0*v0);
+        SimdReal vNew1 = fma(f1*invMass1, timestep, lambda1*v1);
+        SimdReal vNew2 = fma(f2*invMass2, timestep, lambda2*v2);
 
-        simdStoreRvecs(v, a, v0, v1, v2);
+        if (applyPRVScaling == ApplyParrinelloRahmanVScaling::diagonal)
+        {
+            vNew0 = fnma(prScale0, v0, vNew0);
+            vNew1 = fnma(prScale1, v1, vNew1);
+            vNew2 = fnma(prScale2, v2, vNew2);
+        }
+
+        simdStoreRvecs(v, a, vNew0, vNew1, vNew2);
 
         SimdReal x0, x1, x2;
         simdLoadRvecs(x, a, &x0, &x1, &x2);
 
-        SimdReal xprime0 = fma(v0, timestep, x0);
-        SimdReal xprime1 = fma(v1, timestep, x1);
-        SimdReal xprime2 = fma(v2, timestep, x2);
+        SimdReal xprime0 = fma(vNew0, timestep, x0);
+        SimdReal xprime1 = fma(vNew1, timestep, x1);
+        SimdReal xprime2 = fma(vNew2, timestep, x2);
 
         simdStoreRvecs(xprime, a, xprime0, xprime1, xprime2);
     }
@@ -376,18 +427,66 @@ updateMDLeapfrogSimpleSimd(int                               start,
 
 #endif // GMX_HAVE_SIMD_UPDATE
 
+/*! \brief Integrate using the SIMD or the plain-C++ simple leap-frog kernel
+ *
+ * The SIMD kernel uses 1/mass per atom, which is only possible
+ * without partially frozen atoms. Note that modern compilers are pretty
+ * good at vectorizing updateMDLeapfrogSimple(). But the SIMD version will
+ * still be faster because invMass lowers the cache pressure compared
+ * to invMassPerDim.
+ *
+ * \tparam       numTempScaleValues     The number of different T-couple values
+ * \tparam       applyPRVScaling        Apply Parrinello-Rahman velocity scaling
+ */
+template<NumTempScaleValues            numTempScaleValues,
+         ApplyParrinelloRahmanVScaling applyPRVScaling>
+static void
+updateMDLeapfrogSimpleDispatch(int                               start,
+                               int                               nrend,
+                               real                              dt,
+                               real                              dtPressureCouple,
+                               const t_mdatoms                 * md,
+                               gmx::ArrayRef<const t_grp_tcstat> tcstat,
+                               const rvec                        pRVScaleMatrixDiagonal,
+                               const rvec * gmx_restrict         x,
+                               rvec       * gmx_restrict         xprime,
+                               rvec       * gmx_restrict         v,
+                               const rvec * gmx_restrict         f)
+{
+#if GMX_HAVE_SIMD_UPDATE
+    /* Check if we can use invmass instead of invMassPerDim */
+    if (!md->havePartiallyFrozenAtoms)
+    {
+        updateMDLeapfrogSimpleSimd<numTempScaleValues, applyPRVScaling>
+            (start, nrend, dt, dtPressureCouple,
+            md->invmass, tcstat, md->cTC, pRVScaleMatrixDiagonal, x, xprime, v, f);
+        return;
+    }
+#endif
+    updateMDLeapfrogSimple<numTempScaleValues, applyPRVScaling>
+        (start, nrend, dt, dtPressureCouple,
+        md->invMassPerDim, tcstat, md->cTC, pRVScaleMatrixDiagonal, x, xprime, v, f);
+}
+
 /*! \brief Sets the NEMD acceleration type */
 enum class AccelerationType
 {
     none, group, cosine
 };
 
+/*! \brief Sets if to apply Nose-Hoover velocity scaling */
+enum class ApplyNoseHooverVScaling
+{
+    no,  //!< Do not apply Nose-Hoover scaling (not a NH run or step)
+    yes  //!< Apply Nose-Hoover scaling
+};
+
 /*! \brief Integrate using leap-frog with support for everything
  *
  * \tparam       accelerationType       Type of NEMD acceleration
+ * \tparam       applyNHVScaling        Apply Nose-Hoover velocity scaling
  * \param[in]    start                  Index of first atom to update
  * \param[in]    nrend                  Last atom to update: \p nrend - 1
- * \param[in]    doNoseHoover           If to apply Nose-Hoover T-coupling
  * \param[in]    dt                     The time step
  * \param[in]    dtPressureCouple       Time step for pressure coupling, is 0 when no pressure coupling should be applied at this step
  * \param[in]    ir                     The input parameter record
@@ -401,11 +500,11 @@ enum class AccelerationType
  * \param[in]    nh_vxi                 Nose-Hoover velocity scaling factors
  * \param[in]    M                      Parrinello-Rahman scaling matrix
  */
-template<AccelerationType accelerationType>
+template<AccelerationType        accelerationType,
+         ApplyNoseHooverVScaling applyNHVScaling>
 static void
 updateMDLeapfrogGeneral(int                         start,
                         int                         nrend,
-                        bool                        doNoseHoover,
                         real                        dt,
                         real                        dtPressureCouple,
                         const t_inputrec          * ir,
@@ -475,7 +574,7 @@ updateMDLeapfrogGeneral(int                         start,
                 break;
         }
 
-        if (doNoseHoover)
+        if (applyNHVScaling == ApplyNoseHooverVScaling::yes)
         {
             /* Here we account for multiple time stepping, by increasing
              * the Nose-Hoover correction by nsttcouple
@@ -485,9 +584,11 @@ updateMDLeapfrogGeneral(int                         start,
 
         for (int d = 0; d < DIM; d++)
         {
-            real vNew =
-                (lg*vRel[d] + (f[n][d]*invMassPerDim[n][d]*dt - factorNH*vRel[d]
-                               - dtPressureCouple*iprod(M[d], vRel)))/(1 + factorNH);
+            real vNew = lg*vRel[d] + f[n][d]*invMassPerDim[n][d]*dt - dtPressureCouple*iprod(M[d], vRel);
+            if (applyNHVScaling == ApplyNoseHooverVScaling::yes)
+            {
+                vNew = (vNew - factorNH*vRel[d])/(1 + factorNH);
+            }
             switch (accelerationType)
             {
                 case AccelerationType::none:
@@ -510,6 +611,42 @@ updateMDLeapfrogGeneral(int                         start,
     }
 }
 
+/*! \brief Integrate using the general leap-frog kernel with or without Nose-Hoover scaling
+ *
+ * \tparam accelerationType  Type of NEMD acceleration
+ */
+template<AccelerationType accelerationType>
+static void
+updateMDLeapfrogGeneralDispatch(int                         start,
+                                int                         nrend,
+                                bool                        doNoseHoover,
+                                real                        dt,
+                                real                        dtPressureCouple,
+                                const t_inputrec          * ir,
+                                const t_mdatoms           * md,
+                                const gmx_ekindata_t      * ekind,
+                                const matrix                box,
+                                const rvec   * gmx_restrict x,
+                                rvec         * gmx_restrict xprime,
+                                rvec         * gmx_restrict v,
+                                const rvec   * gmx_restrict f,
+                                const double * gmx_restrict nh_vxi,
+                                const matrix                M)
+{
+    if (doNoseHoover)
+    {
+        updateMDLeapfrogGeneral<accelerationType, ApplyNoseHooverVScaling::yes>
+            (start, nrend, dt, dtPressureCouple,
+            ir, md, ekind, box, x, xprime, v, f, nh_vxi, M);
+    }
+    else
+    {
+        updateMDLeapfrogGeneral<accelerationType, ApplyNoseHooverVScaling::no>
+            (start, nrend, dt, dtPressureCouple,
+            ir, md, ekind, box, x, xprime, v, f, nh_vxi, M);
+    }
+}
+
 /*! \brief Handles the Leap-frog MD x and v integration */
 static void do_update_md(int                         start,
                          int                         nrend,
@@ -555,19 +692,19 @@ static void do_update_md(int                         start,
 
         if (!doAcceleration)
         {
-            updateMDLeapfrogGeneral<AccelerationType::none>
+            updateMDLeapfrogGeneralDispatch<AccelerationType::none>
                 (start, nrend, doNoseHoover, dt, dtPressureCouple,
                 ir, md, ekind, box, x, xprime, v, f, nh_vxi, stepM);
         }
         else if (ekind->bNEMD)
         {
-            updateMDLeapfrogGeneral<AccelerationType::group>
+            updateMDLeapfrogGeneralDispatch<AccelerationType::group>
                 (start, nrend, doNoseHoover, dt, dtPressureCouple,
                 ir, md, ekind, box, x, xprime, v, f, nh_vxi, stepM);
         }
         else
         {
-            updateMDLeapfrogGeneral<AccelerationType::cosine>
+            updateMDLeapfrogGeneralDispatch<AccelerationType::cosine>
                 (start, nrend, doNoseHoover, dt, dtPressureCouple,
                 ir, md, ekind, box, x, xprime, v, f, nh_vxi, stepM);
         }
@@ -594,11 +731,11 @@ static void do_update_md(int                         start,
          */
         bool haveSingleTempScaleValue = (!doTempCouple || ekind->ngtc == 1);
 
-        /* Extract some pointers needed by all cases */
-        const unsigned short             *cTC           = md->cTC;
-        gmx::ArrayRef<const t_grp_tcstat> tcstat        = ekind->tcstat;
-        const rvec                       *invMassPerDim = md->invMassPerDim;
+        gmx::ArrayRef<const t_grp_tcstat> tcstat = ekind->tcstat;
 
+        /* All kernels below have SIMD versions, which are used when
+         * there are no partially frozen atoms.
+         */
         if (doParrinelloRahman)
         {
             GMX_ASSERT(!doPROffDiagonal, "updateMDLeapfrogSimple only support diagonal Parrinello-Rahman scaling matrices");
@@ -611,54 +748,38 @@ static void do_update_md(int                         start,
 
             if (haveSingleTempScaleValue)
             {
-                updateMDLeapfrogSimple
+                updateMDLeapfrogSimpleDispatch
                 <NumTempScaleValues::single,
                  ApplyParrinelloRahmanVScaling::diagonal>
                     (start, nrend, dt, dtPressureCouple,
-                    invMassPerDim, tcstat, cTC, diagM, x, xprime, v, f);
+                    md, tcstat, diagM, x, xprime, v, f);
             }
             else
             {
-                updateMDLeapfrogSimple
+                updateMDLeapfrogSimpleDispatch
                 <NumTempScaleValues::multiple,
                  ApplyParrinelloRahmanVScaling::diagonal>
                     (start, nrend, dt, dtPressureCouple,
-                    invMassPerDim, tcstat, cTC, diagM, x, xprime, v, f);
+                    md, tcstat, diagM, x, xprime, v, f);
             }
         }
         else
         {
             if (haveSingleTempScaleValue)
             {
-                /* Note that modern compilers are pretty good at vectorizing
-                 * updateMDLeapfrogSimple(). But the SIMD version will still
-                 * be faster because invMass lowers the cache pressure
-                 * compared to invMassPerDim.
-                 */
-#if GMX_HAVE_SIMD_UPDATE
-                /* Check if we can use invmass instead of invMassPerDim */
-                if (!md->havePartiallyFrozenAtoms)
-                {
-                    updateMDLeapfrogSimpleSimd
-                        (start, nrend, dt, md->invmass, tcstat, x, xprime, v, f);
-                }
-                else
-#endif
-                {
-                    updateMDLeapfrogSimple
-                    <NumTempScaleValues::single,
-                     ApplyParrinelloRahmanVScaling::no>
-                        (start, nrend, dt, dtPressureCouple,
-                        invMassPerDim, tcstat, cTC, nullptr, x, xprime, v, f);
-                }
+                updateMDLeapfrogSimpleDispatch
+                <NumTempScaleValues::single,
+                 ApplyParrinelloRahmanVScaling::no>
+                    (start, nrend, dt, dtPressureCouple,
+                    md, tcstat, nullptr, x, xprime, v, f);
             }
             else
             {
-                updateMDLeapfrogSimple
+                updateMDLeapfrogSimpleDispatch
                 <NumTempScaleValues::multiple,
                  ApplyParrinelloRahmanVScaling::no>
                     (start, nrend, dt, dtPressureCouple,
-                    invMassPerDim, tcstat, cTC, nullptr, x, xprime, v, f);
+                    md, tcstat, nullptr, x, xprime, v, f);
             }
         }
     }
@@ -1621,8 +1742,12 @@ void finish_update(const t_inputrec       *inputrec, /* input record and box stu
             }
             if (partialFreezeAndConstraints)
             {
-                auto xp = makeArrayRef(*upd->xp()).subArray(0, homenr);
-                auto x  = makeConstArrayRef(state->x).subArray(0, homenr);
+                auto           xp  = makeArrayRef(*upd->xp()).subArray(0, homenr);
+                auto           x   = makeConstArrayRef(state->x).subArray(0, homenr);
+#ifndef __clang_analyzer__
+                int gmx_unused nth = gmx_omp_nthreads_get(emntUpdate);
+#endif
+#pragma omp parallel for num_threads(nth) schedule(static)
                 for (int i = 0; i < homenr; i++)
                 {
                     int g = md->cFREEZE[i];
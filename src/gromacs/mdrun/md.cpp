@@ -134,6 +134,7 @@
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/logger.h"
+#include "gromacs/utility/path.h"
 #include "gromacs/utility/real.h"
 #include "gromacs/utility/smalloc.h"
 
@@ -176,6 +177,8 @@ void gmx::Simulator::do_md()
     gmx_repl_ex_t           repl_ex = nullptr;
     gmx_localtop_t          top;
     PaddedVector<gmx::RVec> f {};
+    /* With MTS: the normal forces plus the scaled level-2 forces for integration */
+    PaddedVector<gmx::RVec> forceCombined {};
     gmx_global_stat_t       gstat;
     t_graph                *graph = nullptr;
     gmx_shellfc_t          *shellfc;
@@ -274,6 +277,10 @@ void gmx::Simulator::do_md()
     shellfc = init_shell_flexcon(fplog,
                                  top_global, constr ? constr->numFlexibleConstraints() : 0,
                                  ir->nstcalcenergy, DOMAINDECOMP(cr));
+    if (shellfc && ir->useMts)
+    {
+        gmx_fatal(FARGS, "Multiple time stepping is not supported with shells or flexible constraints");
+    }
 
     {
         double io = compute_io(ir, top_global->natoms, *groups, energyOutput.numEnergyTerms(), 1);
@@ -409,8 +416,12 @@ void gmx::Simulator::do_md()
     pme_load_balancing_t *pme_loadbal      = nullptr;
     if (bPMETune)
     {
+        /* The tuning cache is stored next to the checkpoint file */
+        const std::string pmeTuningCacheFilename =
+            gmx::Path::stripExtension(opt2fn("-cpo", nfile, fnm)) + "_pmetune.dat";
         pme_loadbal_init(&pme_loadbal, cr, mdlog, *ir, state->box,
                          *fr->ic, *fr->nbv, fr->pmedata, fr->nbv->useGpu(),
+                         top_global->natoms, pmeTuningCacheFilename,
                          &bPMETunePrinting);
     }
 
@@ -904,11 +915,16 @@ void gmx::Simulator::do_md()
              * This is parallellized as well, and does communication too.
              * Check comments in sim_util.c
              */
+            if (ir->useMts)
+            {
+                forceCombined.resizeWithPadding(f.size());
+            }
             do_force(fplog, cr, ms, ir, awh.get(), enforcedRotation, imdSession,
                      pull_work,
                      step, nrnb, wcycle, &top,
                      state->box, state->x.arrayRefWithPadding(), &state->hist,
-                     f.arrayRefWithPadding(), force_vir, mdatoms, enerd, fcd,
+                     f.arrayRefWithPadding(), forceCombined.arrayRefWithPadding(),
+                     force_vir, mdatoms, enerd, fcd,
                      state->lambda, graph,
                      fr, ppForceWorkload, vsite, mu_tot, t, ed ? ed->getLegacyED() : nullptr,
                      (bNS ? GMX_FORCE_NS : 0) | force_flags,
@@ -1184,18 +1200,23 @@ void gmx::Simulator::do_md()
         }
 
 
+        /* With multiple time stepping we integrate, at steps where
+         * the level-2 forces are computed, with the combined forces.
+         */
+        PaddedVector<gmx::RVec> &forceForUpdate = (ir->useMts && isMtsLevel2Step(*ir, step) ? forceCombined : f);
+
         if (c_useGpuLeapFrog)
         {
             integrator->copyCoordinatesToGpu(state->x.rvec_array());
             integrator->copyVelocitiesToGpu(state->v.rvec_array());
-            integrator->copyForcesToGpu(as_rvec_array(f.data()));
+            integrator->copyForcesToGpu(as_rvec_array(forceForUpdate.data()));
             integrator->integrate(ir->delta_t);
             integrator->copyCoordinatesFromGpu(upd.xp()->rvec_array());
             integrator->copyVelocitiesFromGpu(state->v.rvec_array());
         }
         else
         {
-            update_coords(step, ir, mdatoms, state, f.arrayRefWithPadding(), fcd,
+            update_coords(step, ir, mdatoms, state, forceForUpdate.arrayRefWithPadding(), fcd,
                           ekind, M, &upd, etrtPOSITION, cr, constr);
         }
         wallcycle_stop(wcycle, ewcUPDATE);
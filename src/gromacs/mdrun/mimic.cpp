@@ -453,7 +453,7 @@ void gmx::Simulator::do_mimic()
                      pull_work,
                      step, nrnb, wcycle, &top,
                      state->box, state->x.arrayRefWithPadding(), &state->hist,
-                     f.arrayRefWithPadding(), force_vir, mdatoms, enerd, fcd,
+                     f.arrayRefWithPadding(), {}, force_vir, mdatoms, enerd, fcd,
                      state->lambda, graph,
                      fr, ppForceWorkload, vsite, mu_tot, t, ed,
                      GMX_FORCE_NS | force_flags,
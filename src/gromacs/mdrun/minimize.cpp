@@ -850,7 +850,7 @@ EnergyEvaluator::run(em_state_t *ems, rvec mu_tot,
              pull_work,
              count, nrnb, wcycle, top,
              ems->s.box, ems->s.x.arrayRefWithPadding(), &ems->s.hist,
-             ems->f.arrayRefWithPadding(), force_vir, mdAtoms->mdatoms(), enerd, fcd,
+             ems->f.arrayRefWithPadding(), {}, force_vir, mdAtoms->mdatoms(), enerd, fcd,
              ems->s.lambda, graph, fr, ppForceWorkload, vsite, mu_tot, t, nullptr,
              GMX_FORCE_STATECHANGED | GMX_FORCE_ALLFORCES |
              GMX_FORCE_VIRIAL | GMX_FORCE_ENERGY |
@@ -262,6 +262,10 @@ void gmx::Simulator::do_rerun()
     {
         gmx_fatal(FARGS, "Interactive MD not supported by rerun.");
     }
+    if (ir->useMts)
+    {
+        gmx_fatal(FARGS, "Multiple time stepping not supported by rerun.");
+    }
     if (isMultiSim(ms))
     {
         gmx_fatal(FARGS, "Multiple simulations not supported by rerun.");
@@ -575,7 +579,7 @@ void gmx::Simulator::do_rerun()
                      pull_work,
                      step, nrnb, wcycle, &top,
                      state->box, state->x.arrayRefWithPadding(), &state->hist,
-                     f.arrayRefWithPadding(), force_vir, mdatoms, enerd, fcd,
+                     f.arrayRefWithPadding(), {}, force_vir, mdatoms, enerd, fcd,
                      state->lambda, graph,
                      fr, ppForceWorkload, vsite, mu_tot, t, ed,
                      GMX_FORCE_NS | force_flags,
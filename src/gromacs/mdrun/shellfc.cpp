@@ -1121,7 +1121,7 @@ void relax_shell_flexcon(FILE                                     *fplog,
              pull_work,
              mdstep, nrnb, wcycle, top,
              state->box, state->x.arrayRefWithPadding(), &state->hist,
-             forceWithPadding[Min], force_vir, md, enerd, fcd,
+             forceWithPadding[Min], {}, force_vir, md, enerd, fcd,
              state->lambda, graph,
              fr, ppForceWorkload, vsite, mu_tot, t, nullptr,
              (bDoNS ? GMX_FORCE_NS : 0) | shellfc_flags,
@@ -1232,7 +1232,7 @@ void relax_shell_flexcon(FILE                                     *fplog,
                  pull_work,
                  1, nrnb, wcycle,
                  top, state->box, posWithPadding[Try], &state->hist,
-                 forceWithPadding[Try], force_vir,
+                 forceWithPadding[Try], {}, force_vir,
                  md, enerd, fcd, state->lambda, graph,
                  fr, ppForceWorkload, vsite, mu_tot, t, nullptr,
                  shellfc_flags,
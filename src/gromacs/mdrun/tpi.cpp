@@ -655,7 +655,7 @@ Simulator::do_tpi()
                      pull_work,
                      step, nrnb, wcycle, &top,
                      state_global->box, state_global->x.arrayRefWithPadding(), &state_global->hist,
-                     f.arrayRefWithPadding(), force_vir, mdatoms, enerd, fcd,
+                     f.arrayRefWithPadding(), {}, force_vir, mdatoms, enerd, fcd,
                      state_global->lambda,
                      nullptr, fr, ppForceWorkload, nullptr, mu_tot, t, nullptr,
                      GMX_FORCE_NONBONDED | GMX_FORCE_ENERGY |
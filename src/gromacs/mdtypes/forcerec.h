@@ -227,6 +227,8 @@ struct t_forcerec { // NOLINT (clang-analyzer-optin.performance.Padding)
     gmx_bool                 haveDirectVirialContributions = FALSE;
     /* TODO: Replace the pointer by an object once we got rid of C */
     std::vector<gmx::RVec>  *forceBufferForDirectVirialContributions = nullptr;
+    /* Force buffer for the multiple time stepping level-2 forces, only used with MTS */
+    std::vector<gmx::RVec>  *forceBufferMtsLevel2 = nullptr;
 
     /* Data for PPPM/PME/Ewald */
     struct gmx_pme_t *pmedata                = nullptr;
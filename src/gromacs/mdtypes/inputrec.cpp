@@ -43,6 +43,7 @@
 #include <cstring>
 
 #include <algorithm>
+#include <string>
 
 #include "gromacs/math/veccompare.h"
 #include "gromacs/math/vecdump.h"
@@ -101,6 +102,16 @@ int ir_optimal_nstcalcenergy(const t_inputrec *ir)
     return nst_wanted(ir);
 }
 
+bool isMtsLevel2Force(const t_inputrec &ir, int mtsForceGroup)
+{
+    return ir.useMts && (ir.mtsLevel2Forces & (1 << mtsForceGroup)) != 0;
+}
+
+bool isMtsLevel2Step(const t_inputrec &ir, int64_t step)
+{
+    return !ir.useMts || step % ir.mtsFactor == 0;
+}
+
 int tcouple_min_integration_steps(int etc)
 {
     int n;
@@ -846,6 +857,20 @@ void pr_inputrec(FILE *fp, int indent, const char *title, const t_inputrec *ir,
         PSTEP("nsteps", ir->nsteps);
         PSTEP("init-step", ir->init_step);
         PI("simulation-part", ir->simulation_part);
+        PS("mts", EBOOL(ir->useMts));
+        if (ir->useMts)
+        {
+            std::string forceGroups;
+            for (int g = 0; g < emtsNR; g++)
+            {
+                if (isMtsLevel2Force(*ir, g))
+                {
+                    forceGroups += std::string(forceGroups.empty() ? "" : " ") + EMTSFORCEGROUP(g);
+                }
+            }
+            PS("mts-level2-forces", forceGroups.c_str());
+            PI("mts-level2-factor", ir->mtsFactor);
+        }
         PS("comm-mode", ECOM(ir->comm_mode));
         PI("nstcomm", ir->nstcomm);
 
@@ -1268,6 +1293,9 @@ void cmp_inputrec(FILE *fp, const t_inputrec *ir1, const t_inputrec *ir2, real f
     cmp_int64(fp, "inputrec->nsteps", ir1->nsteps, ir2->nsteps);
     cmp_int64(fp, "inputrec->init_step", ir1->init_step, ir2->init_step);
     cmp_int(fp, "inputrec->simulation_part", -1, ir1->simulation_part, ir2->simulation_part);
+    cmp_bool(fp, "inputrec->useMts", -1, ir1->useMts, ir2->useMts);
+    cmp_int(fp, "inputrec->mtsLevel2Forces", -1, ir1->mtsLevel2Forces, ir2->mtsLevel2Forces);
+    cmp_int(fp, "inputrec->mtsFactor", -1, ir1->mtsFactor, ir2->mtsFactor);
     cmp_int(fp, "inputrec->ePBC", -1, ir1->ePBC, ir2->ePBC);
     cmp_bool(fp, "inputrec->bPeriodicMols", -1, ir1->bPeriodicMols, ir2->bPeriodicMols);
     cmp_int(fp, "inputrec->cutoff_scheme", -1, ir1->cutoff_scheme, ir2->cutoff_scheme);
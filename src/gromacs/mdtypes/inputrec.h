@@ -338,6 +338,12 @@ struct t_inputrec // NOLINT (clang-analyzer-optin.performance.Padding)
     int                         simulation_part;
     //! Start at a stepcount >0 (used w. convert-tpr)
     int64_t                     init_step;
+    //! Whether to use multiple time stepping
+    gmx_bool                    useMts;
+    //! Bit mask of the force groups, enum emts, that are computed only every mtsFactor steps
+    int                         mtsLevel2Forces;
+    //! The interval in steps for computing the MTS level-2 forces
+    int                         mtsFactor;
     //! Frequency of energy calc. and T/P coupl. upd.
     int                         nstcalcenergy;
     //! Group or verlet cutoffs
@@ -591,6 +597,19 @@ struct t_inputrec // NOLINT (clang-analyzer-optin.performance.Padding)
 
 int ir_optimal_nstcalcenergy(const t_inputrec *ir);
 
+/*! \brief Returns whether force group \p mtsForceGroup is computed only every ir->mtsFactor steps
+ *
+ * \param[in] ir             The input record
+ * \param[in] mtsForceGroup  The force group, enum emts
+ */
+bool isMtsLevel2Force(const t_inputrec &ir, int mtsForceGroup);
+
+/*! \brief Returns whether the MTS level-2 forces are computed at \p step
+ *
+ * Returns true for all steps without multiple time stepping.
+ */
+bool isMtsLevel2Step(const t_inputrec &ir, int64_t step);
+
 int tcouple_min_integration_steps(int etc);
 
 int ir_optimal_nsttcouple(const t_inputrec *ir);
@@ -183,6 +183,10 @@ const char *ecm_names[ecmNR+1] = {
     "Linear", "Angular", "None", "Linear-acceleration-correction", nullptr
 };
 
+const char *emts_names[emtsNR+1] = {
+    "longrange-nonbonded", "pull", nullptr
+};
+
 const char *eann_names[eannNR+1] = {
     "No", "Single", "Periodic", nullptr
 };
@@ -457,6 +457,19 @@ extern const char *ecm_names[ecmNR+1];
 //! Macro for COM removal string
 #define ECOM(e)        enum_name(e, ecmNR, ecm_names)
 
+/*! \brief Force groups that multiple time stepping can compute less frequently
+ *
+ * These forces are computed every mts-level2-factor steps and then applied
+ * as an impulse, scaled by that factor.
+ */
+enum {
+    emtsLONGRANGE_NONBONDED, emtsPULL, emtsNR
+};
+//! String corresponding to multiple time stepping force groups
+extern const char *emts_names[emtsNR+1];
+//! Macro for multiple time stepping force group string
+#define EMTSFORCEGROUP(e) enum_name(e, emtsNR, emts_names)
+
 //! Algorithm for simulated annealing.
 enum {
     eannNO, eannSINGLE, eannPERIODIC, eannNR
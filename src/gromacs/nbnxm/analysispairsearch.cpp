@@ -0,0 +1,490 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+
+/*! \internal \file
+ *
+ * \brief
+ * Implements the AnalysisPairSearch class
+ *
+ * \ingroup module_nbnxm
+ */
+
+#include "gmxpre.h"
+
+#include "analysispairsearch.h"
+
+#include "config.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "gromacs/gmxlib/nrnb.h"
+#include "gromacs/math/functions.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/mdtypes/forcerec.h" // only for SET_CGINFO_*
+#include "gromacs/nbnxm/atomdata.h"
+#include "gromacs/nbnxm/nbnxm.h"
+#include "gromacs/pbcutil/ishift.h"
+#include "gromacs/pbcutil/pbc.h"
+#include "gromacs/topology/block.h"
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/logger.h"
+
+#include "grid.h"
+#include "gridset.h"
+#include "nbnxm_simd.h"
+#include "pairlistparams.h"
+#include "pairlistset.h"
+#include "pairsearch.h"
+
+namespace Nbnxm
+{
+
+namespace
+{
+
+//! Returns the kernel type that determines the cluster setup for the search.
+KernelType analysisKernelType()
+{
+#if GMX_SIMD && defined GMX_NBNXN_SIMD_4XN
+    return KernelType::Cpu4xN_Simd_4xN;
+#elif GMX_SIMD && defined GMX_NBNXN_SIMD_2XNN
+    return KernelType::Cpu4xN_Simd_2xNN;
+#else
+    return KernelType::Cpu4x4_PlainC;
+#endif
+}
+
+/*! \brief
+ * Returns the pairlist buffer that covers rounding differences between the
+ * bounding-box distances in the search and the exact pair distances.
+ */
+real listBuffer(const matrix box)
+{
+    const real boxSize = std::max(box[XX][XX], std::max(box[YY][YY], box[ZZ][ZZ]));
+    return 10*GMX_REAL_EPS*boxSize;
+}
+
+//! Minimum number of test positions per thread in findPairs().
+constexpr int c_minTestPositionsPerThread = 32;
+
+//! Returns the squared distance between \p x and a bounding box.
+float boundingBoxDistance2(const rvec x, const BoundingBox &bb)
+{
+    const float dx = std::max(std::max(bb.lower.x - x[XX], x[XX] - bb.upper.x), 0.0F);
+    const float dy = std::max(std::max(bb.lower.y - x[YY], x[YY] - bb.upper.y), 0.0F);
+    const float dz = std::max(std::max(bb.lower.z - x[ZZ], x[ZZ] - bb.upper.z), 0.0F);
+    return dx*dx + dy*dy + dz*dz;
+}
+
+//! Returns the grid column range along \p dim that is within \p rlist of \p x.
+void columnRange(const Grid::Dimensions &dims, const rvec x, real rlist, int dim,
+                 int *first, int *last)
+{
+    const int  maxIndex = dims.numCells[dim] - 1;
+    const real lower    = (x[dim] - rlist - dims.lowerCorner[dim])*dims.invCellSize[dim];
+    const real upper    = (x[dim] + rlist - dims.lowerCorner[dim])*dims.invCellSize[dim];
+    // Positions outside the grid are put in the edge columns, so the range
+    // is clamped instead of being skipped when it is outside the grid.
+    *first = std::min(std::max(static_cast<int>(std::floor(lower)), 0), maxIndex);
+    *last  = std::min(std::max(static_cast<int>(std::floor(upper)), 0), maxIndex);
+}
+
+}   // namespace
+
+/********************************************************************
+ * AnalysisPairSearch::Impl
+ */
+
+/*! \internal \brief
+ * Private implementation class for AnalysisPairSearch.
+ *
+ * \ingroup module_nbnxm
+ */
+class AnalysisPairSearch::Impl
+{
+    public:
+        explicit Impl(int numThreads);
+
+        //! Sets up the search objects for \p ePBC and \p rlist.
+        void setup(int ePBC, real rlist);
+        //! Constructs the cluster-pair list and extracts the pairs into \p selfPairs_.
+        void constructSelfPairs();
+
+        //! Number of OpenMP threads used in the search.
+        int                                  numThreads_;
+        //! PBC type the search objects are set up for.
+        int                                  ePBC_;
+        //! Pairlist cut-off the search objects are set up for.
+        real                                 rlist_;
+        //! The largest cut-off to search with for the current positions.
+        real                                 maxCutoff_;
+        //! The box for the current positions.
+        matrix                               box_;
+        //! The shift vectors for \p box_.
+        rvec                                 shiftVec_[SHIFTS];
+        //! Bounding box of all reference positions.
+        BoundingBox                          referenceBounds_;
+        //! Parameters of the pairlist; referenced by \p pairlistSet_.
+        std::unique_ptr<PairlistParams>      params_;
+        //! The grids.
+        std::unique_ptr<PairSearch>          pairSearch_;
+        //! The cluster-pair lists, one for each thread.
+        std::unique_ptr<PairlistSet>         pairlistSet_;
+        //! Coordinates in the search layout.
+        std::unique_ptr<nbnxn_atomdata_t>    nbat_;
+        //! Reference positions put in the box.
+        std::vector<gmx::RVec>               xInBox_;
+        //! Interaction flags for each position (all interact).
+        std::vector<int>                     atomInfo_;
+        //! Index array for the (empty) exclusions.
+        std::vector<int>                     exclusionIndex_;
+        //! Empty exclusions, needed for pairlist construction.
+        t_blocka                             exclusions_;
+        //! Flop counters filled by the search, not used.
+        t_nrnb                               nrnb_;
+        //! Whether \p selfPairs_ holds the pairs for the current positions.
+        bool                                 bSelfPairsValid_;
+        //! Pairs of reference positions within \p maxCutoff_.
+        std::vector<Pair>                    selfPairs_;
+        //! Pairs found by each thread.
+        std::vector<std::vector<Pair> >      threadPairs_;
+};
+
+AnalysisPairSearch::Impl::Impl(int numThreads)
+    : numThreads_(numThreads), ePBC_(-1), rlist_(-1), maxCutoff_(0),
+      bSelfPairsValid_(false)
+{
+    GMX_RELEASE_ASSERT(numThreads_ >= 1, "Need at least one thread");
+    clear_mat(box_);
+
+    // A single atom type without parameters: only the coordinates are used.
+    const real nbfp[2] = { 0, 0 };
+    nbat_ = std::make_unique<nbnxn_atomdata_t>(gmx::PinningPolicy::CannotBePinned);
+    nbnxn_atomdata_init(gmx::MDLogger(), nbat_.get(), analysisKernelType(),
+                        enbnxninitcombruleNONE, 1, nbfp, 1, numThreads_);
+
+    init_nrnb(&nrnb_);
+    exclusions_.nr           = 0;
+    exclusions_.index        = nullptr;
+    exclusions_.nra          = 0;
+    exclusions_.a            = nullptr;
+    exclusions_.nalloc_index = 0;
+    exclusions_.nalloc_a     = 0;
+    threadPairs_.resize(numThreads_);
+}
+
+void AnalysisPairSearch::Impl::setup(int ePBC, real rlist)
+{
+    if (pairSearch_ != nullptr && ePBC == ePBC_ && rlist == rlist_)
+    {
+        return;
+    }
+    // The pairlist set keeps a reference to the parameters.
+    pairlistSet_.reset();
+    params_      = std::make_unique<PairlistParams>(analysisKernelType(), false, rlist, false);
+    pairlistSet_ = std::make_unique<PairlistSet>(InteractionLocality::Local, *params_, numThreads_);
+    if (pairSearch_ == nullptr || ePBC != ePBC_)
+    {
+        pairSearch_ = std::make_unique<PairSearch>(ePBC, nullptr, nullptr,
+                                                   params_->pairlistType,
+                                                   false, numThreads_);
+    }
+    ePBC_  = ePBC;
+    rlist_ = rlist;
+}
+
+void AnalysisPairSearch::Impl::constructSelfPairs()
+{
+    pairlistSet_->constructPairlists(pairSearch_->gridSet(),
+                                     pairSearch_->work(),
+                                     nbat_.get(), &exclusions_,
+                                     0, &nrnb_,
+                                     &pairSearch_->cycleCounting_);
+
+    const gmx::ArrayRef<const int>              atomIndices = pairSearch_->gridSet().atomIndices();
+    const gmx::ArrayRef<const NbnxnPairlistCpu> lists       = pairlistSet_->cpuLists();
+    GMX_RELEASE_ASSERT(lists.ssize() <= gmx::ssize(threadPairs_),
+                       "Need a pair buffer for each pairlist");
+    const real                                  cutoff2     = maxCutoff_*maxCutoff_;
+
+#pragma omp parallel for num_threads(numThreads_) schedule(static)
+    for (int th = 0; th < lists.ssize(); ++th)
+    {
+        try
+        {
+            const NbnxnPairlistCpu &list        = lists[th];
+            std::vector<Pair>      &threadPairs = threadPairs_[th];
+            threadPairs.clear();
+            for (const nbnxn_ci_t &ciEntry : list.ci)
+            {
+                const int shift = ciEntry.shift & NBNXN_CI_SHIFT;
+                for (int i = 0; i < list.na_ci; ++i)
+                {
+                    const int ai = atomIndices[ciEntry.ci*list.na_ci + i];
+                    if (ai < 0)
+                    {
+                        continue;
+                    }
+                    rvec xi;
+                    rvec_add(xInBox_[ai], shiftVec_[shift], xi);
+                    for (int cjind = ciEntry.cj_ind_start; cjind < ciEntry.cj_ind_end; ++cjind)
+                    {
+                        const nbnxn_cj_t &cjEntry = list.cj[cjind];
+                        for (int j = 0; j < list.na_cj; ++j)
+                        {
+                            if (((cjEntry.excl >> (i*list.na_cj + j)) & 1) == 0)
+                            {
+                                continue;
+                            }
+                            const int aj = atomIndices[cjEntry.cj*list.na_cj + j];
+                            if (aj < 0)
+                            {
+                                continue;
+                            }
+                            Pair pair;
+                            rvec_sub(xi, xInBox_[aj], pair.dx);
+                            pair.r2 = norm2(pair.dx);
+                            if (pair.r2 <= cutoff2)
+                            {
+                                if (ai < aj)
+                                {
+                                    pair.i = ai;
+                                    pair.j = aj;
+                                }
+                                else
+                                {
+                                    pair.i = aj;
+                                    pair.j = ai;
+                                    svmul(-1, pair.dx, pair.dx);
+                                }
+                                threadPairs.push_back(pair);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+
+    selfPairs_.clear();
+    for (int th = 0; th < lists.ssize(); ++th)
+    {
+        selfPairs_.insert(selfPairs_.end(), threadPairs_[th].begin(), threadPairs_[th].end());
+    }
+    bSelfPairsValid_ = true;
+}
+
+/********************************************************************
+ * AnalysisPairSearch
+ */
+
+bool AnalysisPairSearch::isSupported(int ePBC, const matrix box, real cutoff)
+{
+    if (ePBC != epbcXYZ)
+    {
+        return false;
+    }
+    const real rlist = cutoff + listBuffer(box);
+    return gmx::square(rlist) < max_cutoff2(ePBC, box);
+}
+
+AnalysisPairSearch::AnalysisPairSearch(int numThreads)
+    : impl_(new Impl(numThreads))
+{
+}
+
+AnalysisPairSearch::~AnalysisPairSearch()
+{
+}
+
+void AnalysisPairSearch::setReferencePositions(int                            ePBC,
+                                               const matrix                   box,
+                                               real                           maxCutoff,
+                                               gmx::ArrayRef<const gmx::RVec> x)
+{
+    GMX_RELEASE_ASSERT(isSupported(ePBC, box, maxCutoff),
+                       "Cluster-pair search used for an unsupported system");
+    Impl &impl = *impl_;
+    impl.setup(ePBC, maxCutoff + listBuffer(box));
+    impl.maxCutoff_       = maxCutoff;
+    impl.bSelfPairsValid_ = false;
+    copy_mat(box, impl.box_);
+    calc_shifts(box, impl.shiftVec_);
+
+    const int numAtoms = x.ssize();
+    impl.xInBox_.assign(x.begin(), x.end());
+    put_atoms_in_box_omp(ePBC, box, impl.xInBox_, impl.numThreads_);
+    int atomInfo = 0;
+    SET_CGINFO_HAS_VDW(atomInfo);
+    SET_CGINFO_HAS_Q(atomInfo);
+    impl.atomInfo_.assign(numAtoms, atomInfo);
+    impl.exclusionIndex_.assign(numAtoms + 1, 0);
+    impl.exclusions_.nr    = numAtoms;
+    impl.exclusions_.index = impl.exclusionIndex_.data();
+
+    const rvec lowerCorner = { 0, 0, 0 };
+    const rvec upperCorner = { box[XX][XX], box[YY][YY], box[ZZ][ZZ] };
+    impl.pairSearch_->putOnGrid(box, 0, lowerCorner, upperCorner, nullptr,
+                                0, numAtoms, -1, impl.atomInfo_, impl.xInBox_,
+                                0, nullptr, impl.nbat_.get());
+
+    // The bounding box of all positions lets findPairs() skip periodic
+    // images of test positions that are far from all reference positions.
+    const Grid                      &grid   = impl.pairSearch_->gridSet().grids()[0];
+    gmx::ArrayRef<const BoundingBox> bbs    = grid.iBoundingBoxes();
+    BoundingBox                     &bounds = impl.referenceBounds_;
+    bounds.lower = { GMX_FLOAT_MAX, GMX_FLOAT_MAX, GMX_FLOAT_MAX, 0 };
+    bounds.upper = { -GMX_FLOAT_MAX, -GMX_FLOAT_MAX, -GMX_FLOAT_MAX, 0 };
+    for (int c = 0; c < grid.numCells(); ++c)
+    {
+        bounds.lower = BoundingBox::Corner::min(bounds.lower, bbs[c].lower);
+        bounds.upper = BoundingBox::Corner::max(bounds.upper, bbs[c].upper);
+    }
+}
+
+void AnalysisPairSearch::findSelfPairs(real               cutoff,
+                                       std::vector<Pair> *pairs)
+{
+    Impl &impl = *impl_;
+    GMX_RELEASE_ASSERT(cutoff <= impl.maxCutoff_, "The cut-off can not exceed the maximum cut-off");
+    if (!impl.bSelfPairsValid_)
+    {
+        impl.constructSelfPairs();
+    }
+    const real cutoff2 = cutoff*cutoff;
+    pairs->clear();
+    for (const Pair &pair : impl.selfPairs_)
+    {
+        if (pair.r2 <= cutoff2)
+        {
+            pairs->push_back(pair);
+        }
+    }
+}
+
+void AnalysisPairSearch::findPairs(real                            cutoff,
+                                   gmx::ArrayRef<const gmx::RVec>  x,
+                                   std::vector<Pair>              *pairs) const
+{
+    const Impl &impl = *impl_;
+    GMX_RELEASE_ASSERT(cutoff <= impl.maxCutoff_, "The cut-off can not exceed the maximum cut-off");
+
+    const Grid                      &grid        = impl.pairSearch_->gridSet().grids()[0];
+    const Grid::Dimensions          &dims        = grid.dimensions();
+    const int                        clusterSize = grid.geometry().numAtomsICluster;
+    gmx::ArrayRef<const BoundingBox> bbs         = grid.iBoundingBoxes();
+    gmx::ArrayRef<const int>         atomIndices = impl.pairSearch_->gridSet().atomIndices();
+    const real                       rlist       = cutoff + listBuffer(impl.box_);
+    const real                       rlist2      = rlist*rlist;
+    const real                       cutoff2     = cutoff*cutoff;
+
+    // The pairs are collected locally, so concurrent calls are safe.
+    const int numTestPositions = x.ssize();
+    const int numThreads       =
+        std::max(std::min(impl.numThreads_, numTestPositions/c_minTestPositionsPerThread), 1);
+    std::vector<std::vector<Pair> > threadPairs(numThreads);
+
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+    for (int th = 0; th < numThreads; ++th)
+    {
+        try
+        {
+            const int begin = (th*numTestPositions)/numThreads;
+            const int end   = ((th + 1)*numTestPositions)/numThreads;
+            for (int t = begin; t < end; ++t)
+            {
+                gmx::RVec xt = x[t];
+                put_atoms_in_box(impl.ePBC_, impl.box_, gmx::arrayRefFromArray(&xt, 1));
+                for (int s = 0; s < SHIFTS; ++s)
+                {
+                    rvec xs;
+                    rvec_add(xt, impl.shiftVec_[s], xs);
+                    if (boundingBoxDistance2(xs, impl.referenceBounds_) > rlist2)
+                    {
+                        continue;
+                    }
+                    int cxFirst, cxLast, cyFirst, cyLast;
+                    columnRange(dims, xs, rlist, XX, &cxFirst, &cxLast);
+                    columnRange(dims, xs, rlist, YY, &cyFirst, &cyLast);
+                    for (int cx = cxFirst; cx <= cxLast; ++cx)
+                    {
+                        for (int cy = cyFirst; cy <= cyLast; ++cy)
+                        {
+                            const int column    = cx*dims.numCells[YY] + cy;
+                            const int cellBegin = grid.firstCellInColumn(column);
+                            const int cellEnd   = cellBegin + grid.numCellsInColumn(column);
+                            for (int c = cellBegin; c < cellEnd; ++c)
+                            {
+                                if (boundingBoxDistance2(xs, bbs[c]) > rlist2)
+                                {
+                                    continue;
+                                }
+                                for (int k = 0; k < clusterSize; ++k)
+                                {
+                                    const int a = atomIndices[c*clusterSize + k];
+                                    if (a < 0)
+                                    {
+                                        continue;
+                                    }
+                                    Pair pair;
+                                    rvec_sub(impl.xInBox_[a], xs, pair.dx);
+                                    pair.r2 = norm2(pair.dx);
+                                    if (pair.r2 <= cutoff2)
+                                    {
+                                        pair.i = a;
+                                        pair.j = t;
+                                        threadPairs[th].push_back(pair);
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+
+    pairs->clear();
+    for (const std::vector<Pair> &threadPairList : threadPairs)
+    {
+        pairs->insert(pairs->end(), threadPairList.begin(), threadPairList.end());
+    }
+}
+
+} // namespace Nbnxm
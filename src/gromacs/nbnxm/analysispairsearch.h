@@ -0,0 +1,160 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+
+/*! \libinternal \file
+ *
+ * \brief
+ * Declares the AnalysisPairSearch class
+ *
+ * This class exposes the cluster-pair search of the non-bonded setup
+ * for finding all pairs of positions within a cut-off in analysis code.
+ *
+ * \inlibraryapi
+ * \ingroup module_nbnxm
+ */
+
+#ifndef GMX_NBNXM_ANALYSISPAIRSEARCH_H
+#define GMX_NBNXM_ANALYSISPAIRSEARCH_H
+
+#include <memory>
+#include <vector>
+
+#include "gromacs/math/vectypes.h"
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/real.h"
+
+namespace Nbnxm
+{
+
+/*! \libinternal \brief
+ * Finds pairs of positions within a cut-off using the cluster-pair search grid.
+ *
+ * The reference positions are put on an Nbnxm::GridSet once with
+ * setReferencePositions(), with the same code that mdrun uses.  Pairs
+ * between the reference positions are found with a cluster-pair list, which
+ * is constructed on the first call to findSelfPairs() and reused for later
+ * calls.  Pairs with other (test) positions are found with findPairs(), which
+ * checks the bounding boxes of the grid clusters around each test position.
+ * Only full 3D periodic systems are supported, see isSupported().
+ *
+ * The object keeps the grid and pairlist memory between frames, so it should
+ * be reused.  setReferencePositions() and findSelfPairs() can not be called
+ * concurrently with other methods, findPairs() can be called concurrently
+ * from multiple threads.  The searches use up to the number of OpenMP
+ * threads given at construction.
+ *
+ * \ingroup module_nbnxm
+ */
+class AnalysisPairSearch
+{
+    public:
+        //! A pair of positions within the cut-off.
+        struct Pair
+        {
+            //! Index of the first (reference) position.
+            int       i;
+            //! Index of the second (reference or test) position.
+            int       j;
+            //! Squared distance between the positions.
+            real      r2;
+            //! Distance vector from position \p j to position \p i.
+            gmx::RVec dx;
+        };
+
+        /*! \brief
+         * Returns whether the search supports the given periodic system.
+         *
+         * \param[in] ePBC    Type of periodic boundary conditions.
+         * \param[in] box     The periodic box.
+         * \param[in] cutoff  The cut-off.
+         */
+        static bool isSupported(int ePBC, const matrix box, real cutoff);
+
+        /*! \brief
+         * Creates the search.
+         *
+         * \param[in] numThreads  The number of OpenMP threads to use in the searches.
+         */
+        explicit AnalysisPairSearch(int numThreads);
+        ~AnalysisPairSearch();
+
+        /*! \brief
+         * Puts the reference positions on the grid.
+         *
+         * \param[in]  ePBC       Type of periodic boundary conditions.
+         * \param[in]  box        The periodic box.
+         * \param[in]  maxCutoff  The largest cut-off that will be searched with.
+         * \param[in]  x          Reference positions, do not need to be in the box.
+         *
+         * Must only be called when isSupported() returns true for the
+         * arguments.  Invalidates the pairs kept from findSelfPairs().
+         */
+        void setReferencePositions(int                            ePBC,
+                                   const matrix                   box,
+                                   real                           maxCutoff,
+                                   gmx::ArrayRef<const gmx::RVec> x);
+
+        /*! \brief
+         * Finds all pairs of reference positions within a cut-off.
+         *
+         * \param[in]  cutoff  The cut-off, at most the maximum cut-off.
+         * \param[out] pairs   Receives the pairs, in unspecified order.
+         *
+         * Each pair is returned once, with i < j.
+         */
+        void findSelfPairs(real               cutoff,
+                           std::vector<Pair> *pairs);
+
+        /*! \brief
+         * Finds all pairs of reference and test positions within a cut-off.
+         *
+         * \param[in]  cutoff  The cut-off, at most the maximum cut-off.
+         * \param[in]  x       Test positions, do not need to be in the box.
+         * \param[out] pairs   Receives the pairs, with i the reference and
+         *     j the test position index, sorted on j.
+         */
+        void findPairs(real                            cutoff,
+                       gmx::ArrayRef<const gmx::RVec>  x,
+                       std::vector<Pair>              *pairs) const;
+
+    private:
+        class Impl;
+
+        std::unique_ptr<Impl> impl_;
+};
+
+} // namespace Nbnxm
+
+#endif
@@ -677,7 +677,8 @@ void nbnxn_atomdata_init(const gmx::MDLogger &mdlog,
     nbat->buffer_flags.flag        = nullptr;
     nbat->buffer_flags.flag_nalloc = 0;
 
-    const int   nth = gmx_omp_nthreads_get(emntNonbonded);
+    /* There is one output buffer for each thread that reduces forces */
+    const int   nth = nout;
 
     const char *ptr = getenv("GMX_USE_TREEREDUCE");
     if (ptr != nullptr)
@@ -1005,6 +1006,7 @@ void nbnxn_atomdata_copy_x_to_nbat_x(const Nbnxm::GridSet     &gridSet,
                                      gmx_bool                  FillLocal,
                                      const rvec               *x,
                                      nbnxn_atomdata_t         *nbat,
+                                     int                       numThreads,
                                      gmx_nbnxn_gpu_t          *gpu_nbv,
                                      void                     *xPmeDevicePtr)
 {
@@ -1034,7 +1036,7 @@ void nbnxn_atomdata_copy_x_to_nbat_x(const Nbnxm::GridSet     &gridSet,
         nbat->natoms_local = gridSet.grids()[0].atomIndexEnd();
     }
 
-    const int nth = useGpu ? 1 : gmx_omp_nthreads_get(emntPairsearch);
+    const int nth = useGpu ? 1 : numThreads;
 
 #pragma omp parallel for num_threads(nth) schedule(static)
     for (int th = 0; th < nth; th++)
@@ -1106,6 +1108,7 @@ void nbnxn_atomdata_copy_x_to_nbat_x<true>(const Nbnxm::GridSet &,
                                            gmx_bool,
                                            const rvec*,
                                            nbnxn_atomdata_t *,
+                                           int,
                                            gmx_nbnxn_gpu_t*,
                                            void *);
 template
@@ -1114,6 +1117,7 @@ void nbnxn_atomdata_copy_x_to_nbat_x<false>(const Nbnxm::GridSet &,
                                             gmx_bool,
                                             const rvec*,
                                             nbnxn_atomdata_t *,
+                                            int,
                                             gmx_nbnxn_gpu_t*,
                                             void *);
 
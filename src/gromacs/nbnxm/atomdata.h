@@ -307,6 +307,7 @@ void nbnxn_atomdata_copy_shiftvec(gmx_bool          dynamic_box,
 
 /* Copy x to nbat->x.
  * FillLocal tells if the local filler particle coordinates should be zeroed.
+ * The copy uses numThreads OpenMP threads, or one with a GPU.
  */
 template <bool useGpu>
 void nbnxn_atomdata_copy_x_to_nbat_x(const Nbnxm::GridSet       &gridSet,
@@ -314,6 +315,7 @@ void nbnxn_atomdata_copy_x_to_nbat_x(const Nbnxm::GridSet       &gridSet,
                                      gmx_bool                    FillLocal,
                                      const rvec                 *x,
                                      nbnxn_atomdata_t           *nbat,
+                                     int                         numThreads,
                                      gmx_nbnxn_gpu_t            *gpu_nbv,
                                      void                       *xPmeDevicePtr);
 
@@ -323,6 +325,7 @@ void nbnxn_atomdata_copy_x_to_nbat_x<true>(const Nbnxm::GridSet &,
                                            gmx_bool,
                                            const rvec*,
                                            nbnxn_atomdata_t *,
+                                           int,
                                            gmx_nbnxn_gpu_t*,
                                            void *);
 extern template
@@ -331,6 +334,7 @@ void nbnxn_atomdata_copy_x_to_nbat_x<false>(const Nbnxm::GridSet &,
                                             gmx_bool,
                                             const rvec*,
                                             nbnxn_atomdata_t *,
+                                            int,
                                             gmx_nbnxn_gpu_t*,
                                             void *);
 
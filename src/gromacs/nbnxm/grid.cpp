@@ -53,7 +53,6 @@
 
 #include "gromacs/math/utilities.h"
 #include "gromacs/math/vec.h"
-#include "gromacs/mdlib/gmx_omp_nthreads.h"
 #include "gromacs/mdlib/updategroupscog.h"
 #include "gromacs/mdtypes/forcerec.h" // only for GET_CGINFO_*
 #include "gromacs/nbnxm/atomdata.h"
@@ -1309,7 +1308,7 @@ void Grid::setCellIndices(int                             ddZone,
 {
     cellOffset_ = cellOffset;
 
-    const int nthread = gmx_omp_nthreads_get(emntPairsearch);
+    const int nthread = gridWork.ssize();
 
     const int numAtomsPerCell = geometry_.numAtomsPerCell;
 
@@ -46,7 +46,6 @@
 
 #include "gridset.h"
 
-#include "gromacs/mdlib/gmx_omp_nthreads.h"
 #include "gromacs/mdlib/updategroupscog.h"
 #include "gromacs/nbnxm/atomdata.h"
 #include "gromacs/utility/fatalerror.h"
@@ -193,7 +192,8 @@ void GridSet::putOnGrid(const matrix                    box,
     /* Make space for the new cell indices */
     cells_.resize(atomEnd);
 
-    const int nthread = gmx_omp_nthreads_get(emntPairsearch);
+    /* We use one thread per grid work buffer */
+    const int nthread = gridWork_.size();
 
 #pragma omp parallel for num_threads(nthread) schedule(static)
     for (int thread = 0; thread < nthread; thread++)
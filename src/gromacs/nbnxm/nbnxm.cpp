@@ -148,7 +148,7 @@ void nonbonded_verlet_t::setCoordinates(const Nbnxm::AtomLocality       locality
 
     fnPtr(pairSearch_->gridSet(), locality, fillLocal,
           as_rvec_array(x.data()),
-          nbat.get(), gpu_nbv, xPmeDevicePtr);
+          nbat.get(), gmx::ssize(pairSearch_->work()), gpu_nbv, xPmeDevicePtr);
 
     wallcycle_sub_stop(wcycle, ewcsNB_X_BUF_OPS);
     wallcycle_stop(wcycle, ewcNB_XF_BUF_OPS);
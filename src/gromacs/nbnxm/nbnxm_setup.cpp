@@ -308,13 +308,15 @@ PairlistSets::PairlistSets(const PairlistParams &pairlistParams,
     params_(pairlistParams),
     minimumIlistCountForGpuBalancing_(minimumIlistCountForGpuBalancing)
 {
+    const int numLists = gmx_omp_nthreads_get(emntNonbonded);
+
     localSet_ = std::make_unique<PairlistSet>(Nbnxm::InteractionLocality::Local,
-                                              params_);
+                                              params_, numLists);
 
     if (haveMultipleDomains)
     {
         nonlocalSet_ = std::make_unique<PairlistSet>(Nbnxm::InteractionLocality::NonLocal,
-                                                     params_);
+                                                     params_, numLists);
     }
 }
 
@@ -683,7 +683,8 @@ NbnxnPairlistGpu::NbnxnPairlistGpu(gmx::PinningPolicy pinningPolicy) :
 
 // TODO: Move to pairlistset.cpp
 PairlistSet::PairlistSet(const Nbnxm::InteractionLocality  locality,
-                         const PairlistParams             &pairlistParams) :
+                         const PairlistParams             &pairlistParams,
+                         const int                         numLists) :
     locality_(locality),
     params_(pairlistParams)
 {
@@ -694,8 +695,6 @@ PairlistSet::PairlistSet(const Nbnxm::InteractionLocality  locality,
     // Currently GPU lists are always combined
     combineLists_ = !isCpuType_;
 
-    const int numLists = gmx_omp_nthreads_get(emntNonbonded);
-
     if (!combineLists_ &&
         numLists > NBNXN_BUFFERFLAG_MAX_THREADS)
     {
@@ -2688,7 +2687,8 @@ static void combine_nblists(gmx::ArrayRef<const NbnxnPairlistGpu>  nbls,
      * as otherwise data will go back and forth between different caches.
      */
 #if GMX_OPENMP && !(defined __clang_analyzer__)
-    int nthreads = gmx_omp_nthreads_get(emntPairsearch);
+    /* One thread for each list to copy */
+    int nthreads = nbls.ssize();
 #endif
 
 #pragma omp parallel for num_threads(nthreads) schedule(static)
@@ -76,9 +76,10 @@ class GridSet;
 class PairlistSet
 {
     public:
-        //! Constructor: initializes the pairlist set as empty
+        //! Constructor: initializes the pairlist set as empty, with \p numLists lists for building in parallel
         PairlistSet(Nbnxm::InteractionLocality  locality,
-                    const PairlistParams       &listParams);
+                    const PairlistParams       &listParams,
+                    int                         numLists);
 
         ~PairlistSet();
 
@@ -70,6 +70,38 @@ void set_pbc_simd(const t_pbc *pbc,
 
 #if GMX_SIMD_HAVE_REAL
 
+/*! \brief Correct SIMD distance vector *dx,*dy,*dz for PBC and return the shifts.
+ *
+ * As pbc_correct_dx_simd() below, but also returns in \p shx, \p shy and
+ * \p shz the number of box vectors that were subtracted from the distance
+ * vector. The periodic image of the first atom that was used is thus
+ * minus these shifts, which gives its shift index without redoing the
+ * PBC calculation.
+ */
+static inline void gmx_simdcall
+pbc_correct_dx_simd(gmx::SimdReal         *dx,
+                    gmx::SimdReal         *dy,
+                    gmx::SimdReal         *dz,
+                    const real            *pbc_simd,
+                    gmx::SimdReal         *shx,
+                    gmx::SimdReal         *shy,
+                    gmx::SimdReal         *shz)
+{
+    using namespace gmx;
+
+    *shz = round(*dz * load<SimdReal>(pbc_simd+0*GMX_SIMD_REAL_WIDTH)); // load inv_bzz
+    *dx  = *dx - *shz * load<SimdReal>(pbc_simd+1*GMX_SIMD_REAL_WIDTH); // load bzx
+    *dy  = *dy - *shz * load<SimdReal>(pbc_simd+2*GMX_SIMD_REAL_WIDTH); // load bzy
+    *dz  = *dz - *shz * load<SimdReal>(pbc_simd+3*GMX_SIMD_REAL_WIDTH); // load bzz
+
+    *shy = round(*dy * load<SimdReal>(pbc_simd+4*GMX_SIMD_REAL_WIDTH)); // load inv_byy
+    *dx  = *dx - *shy * load<SimdReal>(pbc_simd+5*GMX_SIMD_REAL_WIDTH); // load byx
+    *dy  = *dy - *shy * load<SimdReal>(pbc_simd+6*GMX_SIMD_REAL_WIDTH); // load byy
+
+    *shx = round(*dx * load<SimdReal>(pbc_simd+7*GMX_SIMD_REAL_WIDTH)); // load inv_bxx
+    *dx  = *dx - *shx * load<SimdReal>(pbc_simd+8*GMX_SIMD_REAL_WIDTH); // load bxx
+}
+
 /*! \brief Correct SIMD distance vector *dx,*dy,*dz for PBC using SIMD.
  *
  * For rectangular boxes all returned distance vectors are the shortest.
@@ -87,21 +119,9 @@ pbc_correct_dx_simd(gmx::SimdReal         *dx,
                     gmx::SimdReal         *dz,
                     const real            *pbc_simd)
 {
-    using namespace gmx;
-    SimdReal shz, shy, shx;
-
-    shz = round(*dz * load<SimdReal>(pbc_simd+0*GMX_SIMD_REAL_WIDTH)); // load inv_bzz
-    *dx = *dx - shz * load<SimdReal>(pbc_simd+1*GMX_SIMD_REAL_WIDTH);  // load bzx
-    *dy = *dy - shz * load<SimdReal>(pbc_simd+2*GMX_SIMD_REAL_WIDTH);  // load bzy
-    *dz = *dz - shz * load<SimdReal>(pbc_simd+3*GMX_SIMD_REAL_WIDTH);  // load bzz
-
-    shy = round(*dy * load<SimdReal>(pbc_simd+4*GMX_SIMD_REAL_WIDTH)); // load inv_byy
-    *dx = *dx - shy * load<SimdReal>(pbc_simd+5*GMX_SIMD_REAL_WIDTH);  // load byx
-    *dy = *dy - shy * load<SimdReal>(pbc_simd+6*GMX_SIMD_REAL_WIDTH);  // load byy
-
-    shx = round(*dx * load<SimdReal>(pbc_simd+7*GMX_SIMD_REAL_WIDTH)); // load inv_bxx
-    *dx = *dx - shx * load<SimdReal>(pbc_simd+8*GMX_SIMD_REAL_WIDTH);  // load bxx
+    gmx::SimdReal shx, shy, shz;
 
+    pbc_correct_dx_simd(dx, dy, dz, pbc_simd, &shx, &shy, &shz);
 }
 
 /*! \brief Calculates the PBC corrected distance between SIMD coordinates.
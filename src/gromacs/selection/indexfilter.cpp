@@ -0,0 +1,272 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements functions in indexfilter.h.
+ *
+ * \ingroup module_selection
+ */
+#include "gmxpre.h"
+
+#include "indexfilter.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <vector>
+
+#include "gromacs/selection/indexutil.h"
+#include "gromacs/simd/simd.h"
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/gmxomp.h"
+
+//! Whether the filtering uses SIMD.
+#define GMX_INDEXFILTER_SIMD (GMX_SIMD_HAVE_REAL && GMX_SIMD_HAVE_LOADU)
+
+namespace gmx
+{
+
+namespace
+{
+
+//! Minimum number of entries for splitting a filtering between threads.
+const int c_minParallelFilterCount = 20000;
+//! Minimum number of items for splitting computeMaskInParallel() between threads.
+const int c_minParallelTestCount   = 1000;
+
+/*! \brief
+ * Comparison test for filterIndex().
+ *
+ * \tparam op  Comparison to do.
+ */
+template <RealComparison op>
+class ComparisonTest
+{
+    public:
+        //! Initializes the test for comparing against \p limit.
+        explicit ComparisonTest(real limit) : limit_(limit) {}
+
+        //! Returns whether \p value passes.
+        bool operator()(real value) const
+        {
+            switch (op)
+            {
+                case RealComparison::Less:           return value <  limit_;
+                case RealComparison::LessOrEqual:    return value <= limit_;
+                case RealComparison::Greater:        return value >  limit_;
+                case RealComparison::GreaterOrEqual: return value >= limit_;
+            }
+            return false;
+        }
+#if GMX_INDEXFILTER_SIMD
+        //! Returns whether each value in \p value passes.
+        SimdBool operator()(SimdReal value) const
+        {
+            switch (op)
+            {
+                case RealComparison::Less:           return value <  SimdReal(limit_);
+                case RealComparison::LessOrEqual:    return value <= SimdReal(limit_);
+                case RealComparison::Greater:        return SimdReal(limit_) <  value;
+                case RealComparison::GreaterOrEqual: return SimdReal(limit_) <= value;
+            }
+            return value < value;
+        }
+#endif
+
+    private:
+        real limit_;
+};
+
+//! Range test for filterIndex().
+class RangeTest
+{
+    public:
+        //! Initializes the test for the closed range from \p lower to \p upper.
+        RangeTest(real lower, real upper) : lower_(lower), upper_(upper) {}
+
+        //! Returns whether \p value passes.
+        bool operator()(real value) const
+        {
+            return lower_ <= value && value <= upper_;
+        }
+#if GMX_INDEXFILTER_SIMD
+        //! Returns whether each value in \p value passes.
+        SimdBool operator()(SimdReal value) const
+        {
+            return (SimdReal(lower_) <= value) && (value <= SimdReal(upper_));
+        }
+#endif
+
+    private:
+        real lower_;
+        real upper_;
+};
+
+/*! \brief
+ * Filters a block of entries of an index group.
+ *
+ * \param[in]  index    Entries of the index group.
+ * \param[in]  values   Value for each entry.
+ * \param[in]  begin    First entry in the block.
+ * \param[in]  end      End of the block.
+ * \param[out] outIndex The passing entries are written here, starting at
+ *     \p begin.  Can be the same as \p index.
+ * \param[in]  test     Test for the values.
+ * \returns    Number of passing entries.
+ */
+template <class Test>
+int filterBlock(const int *index, const real *values, int begin, int end,
+                int *outIndex, const Test &test)
+{
+    int count = begin;
+    int i     = begin;
+#if GMX_INDEXFILTER_SIMD
+    for (; i + GMX_SIMD_REAL_WIDTH <= end; i += GMX_SIMD_REAL_WIDTH)
+    {
+        const SimdBool bPass = test(loadU<SimdReal>(values + i));
+        if (!anyTrue(bPass))
+        {
+            continue;
+        }
+        alignas(GMX_SIMD_ALIGNMENT) real passMask[GMX_SIMD_REAL_WIDTH];
+        store(passMask, selectByMask(SimdReal(1.0), bPass));
+        for (int k = 0; k < GMX_SIMD_REAL_WIDTH; ++k)
+        {
+            if (passMask[k] != 0)
+            {
+                outIndex[count++] = index[i + k];
+            }
+        }
+    }
+#endif
+    for (; i < end; ++i)
+    {
+        if (test(values[i]))
+        {
+            outIndex[count++] = index[i];
+        }
+    }
+    return count - begin;
+}
+
+/*! \brief
+ * Filters an index group, splitting large groups between threads.
+ *
+ * Each thread filters a contiguous block in place into \p out, and the
+ * blocks are then packed together, so the result does not depend on the
+ * number of threads.
+ */
+template <class Test>
+void filterIndex(const gmx_ana_index_t *g, const real *values, const Test &test,
+                 gmx_ana_index_t *out)
+{
+    const int count       = g->isize;
+    const int threadCount =
+        (count >= c_minParallelFilterCount ? gmx_omp_get_max_threads() : 1);
+    if (threadCount <= 1)
+    {
+        out->isize = filterBlock(g->index, values, 0, count, out->index, test);
+        return;
+    }
+    std::vector<int> blockPassCount(threadCount);
+#pragma omp parallel for num_threads(threadCount) schedule(static)
+    for (int t = 0; t < threadCount; ++t)
+    {
+        try
+        {
+            const int begin = static_cast<int>(static_cast<int64_t>(count)*t/threadCount);
+            const int end   = static_cast<int>(static_cast<int64_t>(count)*(t + 1)/threadCount);
+            blockPassCount[t] = filterBlock(g->index, values, begin, end, out->index, test);
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+    int passCount = blockPassCount[0];
+    for (int t = 1; t < threadCount; ++t)
+    {
+        const int begin = static_cast<int>(static_cast<int64_t>(count)*t/threadCount);
+        std::memmove(out->index + passCount, out->index + begin,
+                     blockPassCount[t]*sizeof(*out->index));
+        passCount += blockPassCount[t];
+    }
+    out->isize = passCount;
+}
+
+}   // namespace
+
+void filterIndexByComparison(const gmx_ana_index_t *g, const real *values,
+                             RealComparison op, real limit,
+                             gmx_ana_index_t *out)
+{
+    switch (op)
+    {
+        case RealComparison::Less:
+            filterIndex(g, values, ComparisonTest<RealComparison::Less>(limit), out);
+            break;
+        case RealComparison::LessOrEqual:
+            filterIndex(g, values, ComparisonTest<RealComparison::LessOrEqual>(limit), out);
+            break;
+        case RealComparison::Greater:
+            filterIndex(g, values, ComparisonTest<RealComparison::Greater>(limit), out);
+            break;
+        case RealComparison::GreaterOrEqual:
+            filterIndex(g, values, ComparisonTest<RealComparison::GreaterOrEqual>(limit), out);
+            break;
+    }
+}
+
+void filterIndexByRange(const gmx_ana_index_t *g, const real *values,
+                        real lower, real upper, gmx_ana_index_t *out)
+{
+    filterIndex(g, values, RangeTest(lower, upper), out);
+}
+
+void computeMaskInParallel(int count, const std::function<bool(int)> &test,
+                           char *mask)
+{
+    const int threadCount =
+        (count >= c_minParallelTestCount ? gmx_omp_get_max_threads() : 1);
+#pragma omp parallel for num_threads(threadCount) schedule(dynamic, 256)
+    for (int i = 0; i < count; ++i)
+    {
+        try
+        {
+            mask[i] = (test(i) ? 1 : 0);
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+}
+
+} // namespace gmx
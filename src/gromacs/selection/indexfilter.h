@@ -0,0 +1,110 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Declares functions for filtering index groups with per-entry values.
+ *
+ * The functions process the values in SIMD-width blocks, skipping blocks
+ * where no entry passes, and split large groups between OpenMP threads.
+ * The order of the entries is always preserved.
+ *
+ * This is an implementation header: there should be no need to use it outside
+ * this directory.
+ *
+ * \ingroup module_selection
+ */
+#ifndef GMX_SELECTION_INDEXFILTER_H
+#define GMX_SELECTION_INDEXFILTER_H
+
+#include <functional>
+
+#include "gromacs/utility/real.h"
+
+struct gmx_ana_index_t;
+
+namespace gmx
+{
+
+//! Comparison operators supported by filterIndexByComparison().
+enum class RealComparison
+{
+    Less,           //!< value < limit
+    LessOrEqual,    //!< value <= limit
+    Greater,        //!< value > limit
+    GreaterOrEqual  //!< value >= limit
+};
+
+/*! \brief
+ * Keeps entries of an index group whose value passes a comparison.
+ *
+ * \param[in]  g      Index group to filter.
+ * \param[in]  values Value for each entry in \p g.
+ * \param[in]  op     Comparison to do, with the value on the left.
+ * \param[in]  limit  Value to compare against.
+ * \param[out] out    Receives the entries of \p g that pass.
+ *     Can be the same as \p g; otherwise, should have room for all of \p g.
+ */
+void filterIndexByComparison(const gmx_ana_index_t *g, const real *values,
+                             RealComparison op, real limit,
+                             gmx_ana_index_t *out);
+
+/*! \brief
+ * Keeps entries of an index group whose value is within a closed range.
+ *
+ * \param[in]  g      Index group to filter.
+ * \param[in]  values Value for each entry in \p g.
+ * \param[in]  lower  Smallest accepted value.
+ * \param[in]  upper  Largest accepted value.
+ * \param[out] out    Receives the entries of \p g that pass.
+ *     Can be the same as \p g; otherwise, should have room for all of \p g.
+ */
+void filterIndexByRange(const gmx_ana_index_t *g, const real *values,
+                        real lower, real upper, gmx_ana_index_t *out);
+
+/*! \brief
+ * Evaluates a per-item test for a range of items, in parallel if large.
+ *
+ * \param[in]  count  Number of items to test.
+ * \param[in]  test   Function that returns whether an item passes.
+ *     Called concurrently from multiple threads for large \p count.
+ * \param[out] mask   Receives `1` for items that pass, `0` for others.
+ *     Should have room for \p count items.
+ */
+void computeMaskInParallel(int count, const std::function<bool(int)> &test,
+                           char *mask);
+
+} // namespace gmx
+
+#endif
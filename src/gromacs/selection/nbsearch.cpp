@@ -61,12 +61,16 @@
 
 #include "gromacs/math/functions.h"
 #include "gromacs/math/vec.h"
+#include "gromacs/nbnxm/analysispairsearch.h"
 #include "gromacs/pbcutil/pbc.h"
 #include "gromacs/selection/position.h"
+#include "gromacs/simd/simd.h"
 #include "gromacs/topology/block.h"
+#include "gromacs/utility/alignedallocator.h"
 #include "gromacs/utility/arrayref.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/mutex.h"
 #include "gromacs/utility/stringutil.h"
 
@@ -76,6 +80,19 @@ namespace gmx
 namespace
 {
 
+//! Number of reference positions checked together in bulk grid searches.
+#if GMX_SIMD_HAVE_REAL
+const int  c_clusterSize = GMX_SIMD_REAL_WIDTH;
+#else
+const int  c_clusterSize = 1;
+#endif
+//! Coordinate for padding clusters, far enough to never be within the cutoff.
+const real c_clusterPaddingCoordinate = 1e10;
+//! Number of test positions in each task of a bulk search.
+const int  c_bulkSearchBlockSize = 256;
+//! Minimum number of reference positions for mapping them in parallel.
+const int  c_minParallelMappingCount = 10000;
+
 /*! \brief
  * Computes the bounding box for a set of positions.
  *
@@ -115,15 +132,50 @@ namespace internal
  * Implementation class declarations
  */
 
+/*! \internal \brief
+ * Pair list within the cutoff plus a buffer, kept between frames.
+ *
+ * Stores the positions for which the list was built, so that it can be
+ * checked whether the list still contains all pairs within the cutoff.
+ *
+ * \ingroup module_selection
+ */
+struct AnalysisNeighborhoodPairListBuffer
+{
+    //! Pairs within the list cutoff.
+    AnalysisNeighborhoodPairList    list;
+    //! Whether \p list has been built.
+    bool                            bValid = false;
+    //! Whether \p list contains reference position pairs.
+    bool                            bSelf = false;
+    //! Index of the first test position in \p list.
+    int                             firstTestIndex = 0;
+    //! Cutoff used for building \p list.
+    real                            listCutoff = 0;
+    //! Buffer in \p listCutoff.
+    real                            buffer = 0;
+    //! Whether \p list was built in the XY plane.
+    bool                            bXY = false;
+    //! PBC type for \p list.
+    int                             ePBC = 0;
+    //! Box for \p list.
+    matrix                          box = {{0}};
+    //! Reference positions for \p list.
+    std::vector<RVec>               refX;
+    //! Test positions for \p list (empty for self pairs).
+    std::vector<RVec>               testX;
+    //! Position indices and exclusion ids for \p list.
+    std::vector<int>                ids;
+};
+
 class AnalysisNeighborhoodSearchImpl
 {
     public:
         typedef AnalysisNeighborhoodPairSearch::ImplPointer
             PairSearchImplPointer;
         typedef std::vector<PairSearchImplPointer> PairSearchList;
-        typedef std::vector<std::vector<int> > CellList;
 
-        explicit AnalysisNeighborhoodSearchImpl(real cutoff);
+        AnalysisNeighborhoodSearchImpl(real cutoff, real pairListBuffer);
         ~AnalysisNeighborhoodSearchImpl();
 
         /*! \brief
@@ -141,11 +193,41 @@ class AnalysisNeighborhoodSearchImpl
                   const t_pbc                         *pbc,
                   const AnalysisNeighborhoodPositions &positions);
         PairSearchImplPointer getPairSearch();
+        /*! \brief
+         * Finds all pairs within the cutoff.
+         *
+         * \param[in]  positions  Test positions, or `nullptr` to search for
+         *     pairs of reference positions.
+         * \param[out] pairs      Receives the found pairs.
+         *
+         * Reuses the buffered pair list in \p pairs if a pair list buffer is
+         * set and the list is still valid.
+         */
+        void findAllPairs(const AnalysisNeighborhoodPositions *positions,
+                          AnalysisNeighborhoodPairList        *pairs) const;
 
         real cutoffSquared() const { return cutoff2_; }
         bool usesGridSearch() const { return bGrid_; }
+        bool usesClusterPairSearch() const { return bClusterPair_; }
 
     private:
+        //! Test positions for a bulk search.
+        struct BulkTestPositions
+        {
+            //! Whether the test positions are the reference positions.
+            bool        bSelf;
+            //! Index of the first test position to use.
+            int         first;
+            //! Number of test positions (including those before \p first).
+            int         count;
+            //! Test position coordinates.
+            const rvec *x;
+            //! Exclusion ids of the test positions.
+            const int  *exclusionIds;
+            //! Indices of the test positions in \p x, or `nullptr`.
+            const int  *indices;
+        };
+
         /*! \brief
          * Determines a suitable grid size and sets up the cells.
          *
@@ -196,16 +278,107 @@ class AnalysisNeighborhoodSearchImpl
          */
         int getGridCellIndex(const rvec cell) const;
         /*! \brief
-         * Adds an index into a grid cell.
+         * Maps the reference positions to the grid and sorts them into cells.
+         *
+         * \param[in]  positions Reference positions.
+         *
+         * Within each cell, the positions are in ascending order.
+         */
+        void sortIntoGridCells(const AnalysisNeighborhoodPositions &positions);
+        /*! \brief
+         * Initializes the cluster data used for bulk grid searches.
+         *
+         * Thread-safe; does nothing if already initialized for the current
+         * reference positions.
+         */
+        void initClusters() const;
+        /*! \brief
+         * Puts the reference positions on the cluster-pair search grid.
+         *
+         * Thread-safe; does nothing if already done for the current
+         * reference positions, so the grid is built once per frame.
+         */
+        void initClusterPairSearch() const;
+        /*! \brief
+         * Returns the exclusions for a test position.
+         *
+         * \param[in]  testExclusionIds  Exclusion ids of the test positions.
+         * \param[in]  index             Index of the test position in
+         *     \p testExclusionIds.
+         */
+        ArrayRef<const int> testExclusions(const int *testExclusionIds, int index) const;
+        /*! \brief
+         * Checks whether a reference position is excluded.
+         *
+         * \param[in]  i     Index of the reference position.
+         * \param[in]  excl  Excluded reference ids for the test position.
+         */
+        bool isExcludedReference(int i, ArrayRef<const int> excl) const;
+        /*! \brief
+         * Finds pairs for a single test position using the grid.
          *
-         * \param[in]  cell Fractional cell coordinates into which \p i should
-         *     be added.
-         * \param[in]  i    Index to add.
+         * \param[in]     testIndex  Index of the test position.
+         * \param[in]     x          Test position.
+         * \param[in]     excl       Excluded reference ids for the test position.
+         * \param[in]     bSelf      Whether to only find references with
+         *     index < \p testIndex.
+         * \param[in]     cutoff2    Squared cutoff for the pairs.
+         * \param[in,out] pairs      Found pairs are appended here.
+         */
+        void findGridPairs(int testIndex, const rvec x, ArrayRef<const int> excl,
+                           bool bSelf, real cutoff2,
+                           std::vector<AnalysisNeighborhoodPair> *pairs) const;
+        //! Finds pairs for a single test position without the grid.
+        void findSimplePairs(int testIndex, const rvec x, ArrayRef<const int> excl,
+                             bool bSelf, real cutoff2,
+                             std::vector<AnalysisNeighborhoodPair> *pairs) const;
+        /*! \brief
+         * Finds all pairs using the nonbonded cluster-pair search.
+         *
+         * \param[in]  firstTestIndex   Index of the first test position to use.
+         * \param[in]  testPosCount     Number of test positions.
+         * \param[in]  testPositions    Test positions, `nullptr` for self pairs.
+         * \param[in]  testExclusionIds Exclusion ids of the test positions.
+         * \param[in]  testIndices      Indices of the test positions, or `nullptr`.
+         * \param[in]  cutoff           Cutoff for the pairs.
+         * \param[out] pairs            Receives the found pairs.
+         */
+        void findClusterPairs(int firstTestIndex, int testPosCount,
+                              const rvec *testPositions, const int *testExclusionIds,
+                              const int *testIndices, real cutoff,
+                              AnalysisNeighborhoodPairList *pairs) const;
+        //! Returns the test positions for findAllPairs().
+        BulkTestPositions bulkTestPositions(const AnalysisNeighborhoodPositions *positions) const;
+        /*! \brief
+         * Finds all pairs within a given cutoff without a pair list buffer.
+         *
+         * \param[in]  test     Test positions.
+         * \param[in]  cutoff   Cutoff for the pairs (at most \p listCutoff_).
+         * \param[in]  cutoff2  Square of \p cutoff.
+         * \param[out] pairs    Receives the found pairs.
+         */
+        void findPairs(const BulkTestPositions &test, real cutoff, real cutoff2,
+                       AnalysisNeighborhoodPairList *pairs) const;
+        //! Collects the position indices and exclusion ids of a bulk search.
+        void collectPositionIds(const BulkTestPositions &test, std::vector<int> *ids) const;
+        /*! \brief
+         * Checks whether a buffered pair list still contains all pairs.
+         *
+         * The list is valid if it was built for the same positions and
+         * search parameters, and if the positions have not moved (and the
+         * box has not changed) so much that a pair outside the list could
+         * have come within the cutoff.
+         */
+        bool isBufferedListValid(const BulkTestPositions                  &test,
+                                 const AnalysisNeighborhoodPairListBuffer &buffer) const;
+        /*! \brief
+         * Finds all pairs within the cutoff through a buffered pair list.
          *
-         * \p cell should satisfy the conditions that \p mapPointToGridCell()
-         * produces.
+         * Rebuilds the list in \p pairs if necessary, and fills \p pairs with
+         * the pairs from the list that are within the cutoff.
          */
-        void addToGridCell(const rvec cell, int i);
+        void findBufferedPairs(const BulkTestPositions      &test,
+                               AnalysisNeighborhoodPairList *pairs) const;
         /*! \brief
          * Initializes a cell pair loop for a dimension.
          *
@@ -270,6 +443,12 @@ class AnalysisNeighborhoodSearchImpl
         real                    cutoff_;
         //! The cutoff squared.
         real                    cutoff2_;
+        //! Buffer for pair lists kept between frames (zero if not used).
+        real                    pairListBuffer_;
+        //! The cutoff plus \p pairListBuffer_, used for the grid setup.
+        real                    listCutoff_;
+        //! The list cutoff squared.
+        real                    listCutoff2_;
         //! Whether to do searching in XY plane only.
         bool                    bXY_;
 
@@ -317,8 +496,35 @@ class AnalysisNeighborhoodSearchImpl
         real                    cellShiftYX_;
         //! Number of cells along each dimension.
         ivec                    ncelldim_;
-        //! Data structure to hold the grid cell contents.
-        CellList                cells_;
+        //! Index of the first position of each cell in \p cellContents_ (plus the end).
+        std::vector<int>        cellStart_;
+        //! Reference position indices sorted by grid cell.
+        std::vector<int>        cellContents_;
+        //! Grid cell index of each reference position.
+        std::vector<int>        refCell_;
+
+        //! Whether the cluster-pair search is used for the current positions.
+        bool                    bClusterPair_;
+
+        //! Protects the initialization of the cluster data and cluster-pair searches.
+        mutable Mutex           clusterMutex_;
+        //! Whether the cluster data is initialized for the current positions.
+        mutable bool            bClustersInitialized_;
+        /*! \brief
+         * Start of each grid cell in the cluster arrays (plus the end).
+         *
+         * Each cell is padded to a multiple of \ref c_clusterSize.
+         */
+        mutable std::vector<int>        clusterCellStart_;
+        //! Reference position index for each cluster entry (-1 for padding).
+        mutable std::vector<int>        clusterIndex_;
+        //! Reference position coordinates in cluster order, for each dimension.
+        mutable std::vector<real, AlignedAllocator<real> > clusterX_[DIM];
+
+        //! Cluster-pair search, kept for reusing its memory between frames.
+        mutable std::unique_ptr<Nbnxm::AnalysisPairSearch>  clusterPairSearch_;
+        //! Whether the reference positions are on the cluster-pair search grid.
+        mutable bool                                        bClusterPairGridInitialized_;
 
         Mutex                   createPairSearchMutex_;
         PairSearchList          pairSearchList_;
@@ -404,6 +610,10 @@ class AnalysisNeighborhoodPairSearchImpl
         ivec                                    cellBound_;
         //! Stores the index within the current cell during pair loops.
         int                                     prevcai_;
+        //! Pairs found with the cluster-pair search.
+        AnalysisNeighborhoodPairList            clusterPairs_;
+        //! Stores the index of the previous pair in \p clusterPairs_ for the test position.
+        int                                     prevPairIndex_;
 
         GMX_DISALLOW_COPY_AND_ASSIGN(AnalysisNeighborhoodPairSearchImpl);
 };
@@ -412,10 +622,12 @@ class AnalysisNeighborhoodPairSearchImpl
  * AnalysisNeighborhoodSearchImpl
  */
 
-AnalysisNeighborhoodSearchImpl::AnalysisNeighborhoodSearchImpl(real cutoff)
+AnalysisNeighborhoodSearchImpl::AnalysisNeighborhoodSearchImpl(real cutoff,
+                                                               real pairListBuffer)
 {
     bTryGrid_       = true;
     cutoff_         = cutoff;
+    pairListBuffer_ = 0;
     if (cutoff_ <= 0)
     {
         cutoff_     = cutoff2_ = GMX_REAL_MAX;
@@ -424,7 +636,13 @@ AnalysisNeighborhoodSearchImpl::AnalysisNeighborhoodSearchImpl(real cutoff)
     else
     {
         cutoff2_        = gmx::square(cutoff_);
+        if (pairListBuffer > 0)
+        {
+            pairListBuffer_ = pairListBuffer;
+        }
     }
+    listCutoff_      = (pairListBuffer_ > 0 ? cutoff_ + pairListBuffer_ : cutoff_);
+    listCutoff2_     = (pairListBuffer_ > 0 ? gmx::square(listCutoff_) : cutoff2_);
     bXY_             = false;
     nref_            = 0;
     xref_            = nullptr;
@@ -437,6 +655,9 @@ AnalysisNeighborhoodSearchImpl::AnalysisNeighborhoodSearchImpl(real cutoff)
     bGridPBC_[XX]   = true;
     bGridPBC_[YY]   = true;
     bGridPBC_[ZZ]   = true;
+    bClusterPair_   = false;
+    bClustersInitialized_        = false;
+    bClusterPairGridInitialized_ = false;
 
     clear_rvec(gridOrigin_);
     clear_rvec(cellSize_);
@@ -543,17 +764,7 @@ bool AnalysisNeighborhoodSearchImpl::initGridCells(
     {
         return false;
     }
-    // Never decrease the size of the cell vector to avoid reallocating
-    // memory for the nested vectors.  The actual size of the vector is not
-    // used outside this function.
-    if (cells_.size() < static_cast<size_t>(totalCellCount))
-    {
-        cells_.resize(totalCellCount);
-    }
-    for (int ci = 0; ci < totalCellCount; ++ci)
-    {
-        cells_[ci].clear();
-    }
+    cellStart_.assign(totalCellCount + 1, 0);
     return true;
 }
 
@@ -638,7 +849,7 @@ bool AnalysisNeighborhoodSearchImpl::initGrid(
             // TODO: It could be better to avoid this when determining the cell
             // size, but this can still remain here as a fallback to avoid
             // incorrect results.
-            if (std::ceil(2*cutoff_*invCellSize_[dd]) >= ncelldim_[dd])
+            if (std::ceil(2*listCutoff_*invCellSize_[dd]) >= ncelldim_[dd])
             {
                 // Cutoff is too close to half the box size for grid searching
                 // (it is not possible to find a single shift for every pair of
@@ -722,10 +933,85 @@ int AnalysisNeighborhoodSearchImpl::getGridCellIndex(const rvec cell) const
     return getGridCellIndex(icell);
 }
 
-void AnalysisNeighborhoodSearchImpl::addToGridCell(const rvec cell, int i)
+void AnalysisNeighborhoodSearchImpl::sortIntoGridCells(
+        const AnalysisNeighborhoodPositions &positions)
+{
+    xrefAlloc_.resize(nref_);
+    xref_ = as_rvec_array(xrefAlloc_.data());
+    refCell_.resize(nref_);
+
+    // Mapping is independent for each position, and the most expensive part.
+    const int threadCount =
+        (nref_ >= c_minParallelMappingCount ? gmx_omp_get_max_threads() : 1);
+#pragma omp parallel for num_threads(threadCount) schedule(static)
+    for (int i = 0; i < nref_; ++i)
+    {
+        const int ii = (refIndices_ != nullptr) ? refIndices_[i] : i;
+        rvec      refcell;
+        mapPointToGridCell(positions.x_[ii], refcell, xrefAlloc_[i]);
+        refCell_[i] = getGridCellIndex(refcell);
+    }
+
+    // Counting sort, which keeps the positions in each cell in ascending
+    // order as required by the exclusion handling.
+    const int cellCount = ssize(cellStart_) - 1;
+    for (int i = 0; i < nref_; ++i)
+    {
+        ++cellStart_[refCell_[i] + 1];
+    }
+    for (int ci = 0; ci < cellCount; ++ci)
+    {
+        cellStart_[ci + 1] += cellStart_[ci];
+    }
+    cellContents_.resize(nref_);
+    for (int i = 0; i < nref_; ++i)
+    {
+        cellContents_[cellStart_[refCell_[i]]++] = i;
+    }
+    // The loop above advanced each start to the start of the next cell.
+    for (int ci = cellCount; ci > 0; --ci)
+    {
+        cellStart_[ci] = cellStart_[ci - 1];
+    }
+    cellStart_[0] = 0;
+}
+
+void AnalysisNeighborhoodSearchImpl::initClusters() const
 {
-    const int ci = getGridCellIndex(cell);
-    cells_[ci].push_back(i);
+    lock_guard<Mutex> lock(clusterMutex_);
+    if (bClustersInitialized_)
+    {
+        return;
+    }
+    const int cellCount = ssize(cellStart_) - 1;
+    clusterCellStart_.resize(cellCount + 1);
+    clusterCellStart_[0] = 0;
+    for (int ci = 0; ci < cellCount; ++ci)
+    {
+        const int cellSize = cellStart_[ci + 1] - cellStart_[ci];
+        clusterCellStart_[ci + 1] = clusterCellStart_[ci]
+            + (cellSize + c_clusterSize - 1)/c_clusterSize*c_clusterSize;
+    }
+    const int clusterEntryCount = clusterCellStart_[cellCount];
+    clusterIndex_.assign(clusterEntryCount, -1);
+    for (int d = 0; d < DIM; ++d)
+    {
+        clusterX_[d].assign(clusterEntryCount, c_clusterPaddingCoordinate);
+    }
+    for (int ci = 0; ci < cellCount; ++ci)
+    {
+        int entry = clusterCellStart_[ci];
+        for (int k = cellStart_[ci]; k < cellStart_[ci + 1]; ++k, ++entry)
+        {
+            const int i = cellContents_[k];
+            clusterIndex_[entry] = i;
+            for (int d = 0; d < DIM; ++d)
+            {
+                clusterX_[d][entry] = xref_[i][d];
+            }
+        }
+    }
+    bClustersInitialized_ = true;
 }
 
 void AnalysisNeighborhoodSearchImpl::initCellRange(
@@ -794,7 +1080,7 @@ real AnalysisNeighborhoodSearchImpl::computeCutoffExtent(
 {
     if (dim == ZZ)
     {
-        return cutoff_;
+        return listCutoff_;
     }
 
     real dist2 = 0;
@@ -811,11 +1097,11 @@ real AnalysisNeighborhoodSearchImpl::computeCutoffExtent(
         }
         dist2 += dimDist*dimDist*cellSize_[d]*cellSize_[d];
     }
-    if (dist2 >= cutoff2_)
+    if (dist2 >= listCutoff2_)
     {
         return 0;
     }
-    return std::sqrt(cutoff2_ - dist2);
+    return std::sqrt(listCutoff2_ - dist2);
 }
 
 bool AnalysisNeighborhoodSearchImpl::nextCell(
@@ -875,6 +1161,500 @@ int AnalysisNeighborhoodSearchImpl::shiftCell(const ivec cell, rvec shift) const
     return getGridCellIndex(shiftedCell);
 }
 
+ArrayRef<const int> AnalysisNeighborhoodSearchImpl::testExclusions(
+        const int *testExclusionIds, int index) const
+{
+    if (excls_ != nullptr)
+    {
+        const int exclIndex = testExclusionIds[index];
+        if (exclIndex < excls_->nr)
+        {
+            const int startIndex = excls_->index[exclIndex];
+            return constArrayRefFromArray(excls_->a + startIndex,
+                                          excls_->index[exclIndex + 1] - startIndex);
+        }
+    }
+    return {};
+}
+
+bool AnalysisNeighborhoodSearchImpl::isExcludedReference(
+        int i, ArrayRef<const int> excl) const
+{
+    if (excl.empty())
+    {
+        return false;
+    }
+    const int refId = refExclusionIds_[refIndices_ != nullptr ? refIndices_[i] : i];
+    return std::binary_search(excl.begin(), excl.end(), refId);
+}
+
+void AnalysisNeighborhoodSearchImpl::findGridPairs(
+        int testIndex, const rvec x, ArrayRef<const int> excl, bool bSelf,
+        real cutoff2, std::vector<AnalysisNeighborhoodPair> *pairs) const
+{
+    rvec testcell, xtest;
+    ivec currCell, cellBound;
+    mapPointToGridCell(x, testcell, xtest);
+    initCellRange(testcell, currCell, cellBound, ZZ);
+    initCellRange(testcell, currCell, cellBound, YY);
+    initCellRange(testcell, currCell, cellBound, XX);
+    // The cluster prefilter is only used to reject positions, so it uses a
+    // slightly larger cutoff to not lose pairs to rounding differences.
+    // The exact check below uses the same arithmetic as searchNext().
+    const real prefilterCutoff2 = cutoff2*(1 + 10*GMX_REAL_EPS);
+    do
+    {
+        rvec      shift;
+        const int ci = shiftCell(currCell, shift);
+        for (int c = clusterCellStart_[ci]; c < clusterCellStart_[ci + 1]; c += c_clusterSize)
+        {
+            int candidates[c_clusterSize];
+            int candidateCount = 0;
+#if GMX_SIMD_HAVE_REAL
+            const SimdReal dx = (load<SimdReal>(clusterX_[XX].data() + c) - SimdReal(xtest[XX])) - SimdReal(shift[XX]);
+            const SimdReal dy = (load<SimdReal>(clusterX_[YY].data() + c) - SimdReal(xtest[YY])) - SimdReal(shift[YY]);
+            SimdReal       r2 = dx*dx + dy*dy;
+            if (!bXY_)
+            {
+                const SimdReal dz = (load<SimdReal>(clusterX_[ZZ].data() + c) - SimdReal(xtest[ZZ])) - SimdReal(shift[ZZ]);
+                r2 = r2 + dz*dz;
+            }
+            const SimdBool bWithin = (r2 <= SimdReal(prefilterCutoff2));
+            if (!anyTrue(bWithin))
+            {
+                continue;
+            }
+            alignas(GMX_SIMD_ALIGNMENT) real withinMask[GMX_SIMD_REAL_WIDTH];
+            store(withinMask, selectByMask(SimdReal(1.0), bWithin));
+            for (int k = 0; k < c_clusterSize; ++k)
+            {
+                if (withinMask[k] != 0)
+                {
+                    candidates[candidateCount++] = c + k;
+                }
+            }
+#else
+            GMX_UNUSED_VALUE(prefilterCutoff2);
+            candidates[candidateCount++] = c;
+#endif
+            for (int k = 0; k < candidateCount; ++k)
+            {
+                const int i = clusterIndex_[candidates[k]];
+                if (i < 0 || (bSelf && i >= testIndex))
+                {
+                    continue;
+                }
+                rvec       dx;
+                rvec_sub(xref_[i], xtest, dx);
+                rvec_sub(dx, shift, dx);
+                const real r2
+                    = bXY_
+                        ? dx[XX]*dx[XX] + dx[YY]*dx[YY]
+                        : norm2(dx);
+                if (r2 <= cutoff2 && !isExcludedReference(i, excl))
+                {
+                    pairs->emplace_back(i, testIndex, r2, dx);
+                }
+            }
+        }
+    }
+    while (nextCell(testcell, currCell, cellBound));
+}
+
+void AnalysisNeighborhoodSearchImpl::findSimplePairs(
+        int testIndex, const rvec x, ArrayRef<const int> excl, bool bSelf,
+        real cutoff2, std::vector<AnalysisNeighborhoodPair> *pairs) const
+{
+    const int refCount = (bSelf ? testIndex : nref_);
+    for (int i = 0; i < refCount; ++i)
+    {
+        rvec dx;
+        if (pbc_.ePBC != epbcNONE)
+        {
+            pbc_dx(&pbc_, xref_[i], x, dx);
+        }
+        else
+        {
+            rvec_sub(xref_[i], x, dx);
+        }
+        const real r2
+            = bXY_
+                ? dx[XX]*dx[XX] + dx[YY]*dx[YY]
+                : norm2(dx);
+        if (r2 <= cutoff2 && !isExcludedReference(i, excl))
+        {
+            pairs->emplace_back(i, testIndex, r2, dx);
+        }
+    }
+}
+
+void AnalysisNeighborhoodSearchImpl::initClusterPairSearch() const
+{
+    lock_guard<Mutex> lock(clusterMutex_);
+    if (bClusterPairGridInitialized_)
+    {
+        return;
+    }
+    if (clusterPairSearch_ == nullptr)
+    {
+        clusterPairSearch_ = std::make_unique<Nbnxm::AnalysisPairSearch>(gmx_omp_get_max_threads());
+    }
+    // The grid is set up for the largest cutoff used in findPairs().
+    clusterPairSearch_->setReferencePositions(pbc_.ePBC, pbc_.box, listCutoff_,
+                                              constArrayRefFromArray(reinterpret_cast<const RVec *>(xref_), nref_));
+    bClusterPairGridInitialized_ = true;
+}
+
+void AnalysisNeighborhoodSearchImpl::findClusterPairs(
+        int firstTestIndex, int testPosCount,
+        const rvec *testPositions, const int *testExclusionIds,
+        const int *testIndices, real cutoff,
+        AnalysisNeighborhoodPairList *pairs) const
+{
+    const bool bSelf = (testPositions == nullptr);
+    initClusterPairSearch();
+    std::vector<Nbnxm::AnalysisPairSearch::Pair> clusterPairs;
+    if (bSelf)
+    {
+        // The pairs of reference positions are kept in the search object.
+        lock_guard<Mutex> lock(clusterMutex_);
+        clusterPairSearch_->findSelfPairs(cutoff, &clusterPairs);
+    }
+    else
+    {
+        std::vector<RVec> testX;
+        testX.reserve(testPosCount - firstTestIndex);
+        for (int t = firstTestIndex; t < testPosCount; ++t)
+        {
+            const int index = (testIndices != nullptr ? testIndices[t] : t);
+            testX.emplace_back(testPositions[index]);
+        }
+        clusterPairSearch_->findPairs(cutoff, testX, &clusterPairs);
+    }
+
+    // Sort the pairs by the test position, keeping the order otherwise.
+    std::vector<int> &testStart = pairs->testStart_;
+    testStart.assign(testPosCount + 1, 0);
+    for (Nbnxm::AnalysisPairSearch::Pair &pair : clusterPairs)
+    {
+        // The reference position is always pair.i.
+        const int testIndex = (bSelf ? pair.j : firstTestIndex + pair.j);
+        const int index     = (bSelf || testIndices == nullptr ? testIndex : testIndices[testIndex]);
+        if (isExcludedReference(pair.i, testExclusions(testExclusionIds, index)))
+        {
+            pair.j = -1;
+            continue;
+        }
+        pair.j = testIndex;
+        ++testStart[testIndex + 1];
+    }
+    for (int t = 0; t < testPosCount; ++t)
+    {
+        testStart[t + 1] += testStart[t];
+    }
+    pairs->pairs_.resize(testStart[testPosCount]);
+    for (const Nbnxm::AnalysisPairSearch::Pair &pair : clusterPairs)
+    {
+        if (pair.j >= 0)
+        {
+            pairs->pairs_[testStart[pair.j]++] =
+                AnalysisNeighborhoodPair(pair.i, pair.j, pair.r2, pair.dx);
+        }
+    }
+    // The loop above advanced each start to the start of the next position.
+    for (int t = testPosCount; t > 0; --t)
+    {
+        testStart[t] = testStart[t - 1];
+    }
+    testStart[0] = 0;
+}
+
+AnalysisNeighborhoodSearchImpl::BulkTestPositions
+AnalysisNeighborhoodSearchImpl::bulkTestPositions(
+        const AnalysisNeighborhoodPositions *positions) const
+{
+    BulkTestPositions test;
+    test.bSelf = (positions == nullptr);
+    if (test.bSelf)
+    {
+        GMX_RELEASE_ASSERT(excls_ == nullptr || refIndices_ == nullptr,
+                           "Exclusion IDs not implemented with indexed ref positions");
+        test.first        = 0;
+        test.count        = nref_;
+        test.x            = xref_;
+        test.exclusionIds = refExclusionIds_;
+        test.indices      = nullptr;
+    }
+    else
+    {
+        GMX_RELEASE_ASSERT(excls_ == nullptr || positions->exclusionIds_ != nullptr,
+                           "Exclusion IDs must be set when exclusions are enabled");
+        test.first        = std::max(positions->index_, 0);
+        test.count        = (positions->index_ < 0 ? positions->count_ : positions->index_ + 1);
+        test.x            = positions->x_;
+        test.exclusionIds = positions->exclusionIds_;
+        test.indices      = positions->indices_;
+    }
+    return test;
+}
+
+void AnalysisNeighborhoodSearchImpl::findPairs(
+        const BulkTestPositions &test, real cutoff, real cutoff2,
+        AnalysisNeighborhoodPairList *pairs) const
+{
+    if (bClusterPair_)
+    {
+        findClusterPairs(test.first, test.count,
+                         test.bSelf ? nullptr : test.x, test.exclusionIds,
+                         test.indices, cutoff, pairs);
+        return;
+    }
+    if (bGrid_)
+    {
+        initClusters();
+    }
+
+    const int firstTestIndex = test.first;
+    const int testPosCount   = test.count;
+    pairs->pairs_.clear();
+    pairs->testStart_.assign(testPosCount + 1, 0);
+    const int blockCount  = (testPosCount - firstTestIndex + c_bulkSearchBlockSize - 1)
+        / c_bulkSearchBlockSize;
+    const int threadCount = (blockCount > 1 ? gmx_omp_get_max_threads() : 1);
+    std::vector<std::vector<AnalysisNeighborhoodPair> > blockPairs(blockCount);
+#pragma omp parallel for num_threads(threadCount) schedule(dynamic)
+    for (int block = 0; block < blockCount; ++block)
+    {
+        try
+        {
+            const int begin = firstTestIndex + block*c_bulkSearchBlockSize;
+            const int end   = std::min(begin + c_bulkSearchBlockSize, testPosCount);
+            for (int t = begin; t < end; ++t)
+            {
+                const int                 index = (test.indices != nullptr ? test.indices[t] : t);
+                const ArrayRef<const int> excl  = testExclusions(test.exclusionIds, index);
+                const size_t prevCount = blockPairs[block].size();
+                if (bGrid_)
+                {
+                    findGridPairs(t, test.x[index], excl, test.bSelf, cutoff2,
+                                  &blockPairs[block]);
+                }
+                else
+                {
+                    findSimplePairs(t, test.x[index], excl, test.bSelf, cutoff2,
+                                    &blockPairs[block]);
+                }
+                pairs->testStart_[t + 1] = blockPairs[block].size() - prevCount;
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+
+    // Concatenate in block order to keep the result independent of the
+    // number of threads.
+    for (int t = 0; t < testPosCount; ++t)
+    {
+        pairs->testStart_[t + 1] += pairs->testStart_[t];
+    }
+    pairs->pairs_.reserve(pairs->testStart_[testPosCount]);
+    for (const auto &block : blockPairs)
+    {
+        pairs->pairs_.insert(pairs->pairs_.end(), block.begin(), block.end());
+    }
+}
+
+void AnalysisNeighborhoodSearchImpl::collectPositionIds(
+        const BulkTestPositions &test, std::vector<int> *ids) const
+{
+    ids->clear();
+    if (refIndices_ != nullptr)
+    {
+        ids->insert(ids->end(), refIndices_, refIndices_ + nref_);
+    }
+    if (test.indices != nullptr)
+    {
+        ids->insert(ids->end(), test.indices + test.first, test.indices + test.count);
+    }
+    if (excls_ != nullptr)
+    {
+        for (int i = 0; i < nref_; ++i)
+        {
+            ids->push_back(refExclusionIds_[refIndices_ != nullptr ? refIndices_[i] : i]);
+        }
+        for (int t = test.first; t < test.count; ++t)
+        {
+            ids->push_back(test.exclusionIds[test.indices != nullptr ? test.indices[t] : t]);
+        }
+    }
+}
+
+bool AnalysisNeighborhoodSearchImpl::isBufferedListValid(
+        const BulkTestPositions                  &test,
+        const AnalysisNeighborhoodPairListBuffer &buffer) const
+{
+    if (!buffer.bValid || buffer.bSelf != test.bSelf
+        || buffer.firstTestIndex != test.first
+        || buffer.list.testPositionCount() != test.count
+        || ssize(buffer.refX) != nref_
+        || buffer.listCutoff != listCutoff_ || buffer.buffer != pairListBuffer_
+        || buffer.bXY != bXY_ || buffer.ePBC != pbc_.ePBC)
+    {
+        return false;
+    }
+    std::vector<int> ids;
+    collectPositionIds(test, &ids);
+    if (ids != buffer.ids)
+    {
+        return false;
+    }
+    // With pairs at most one periodic shift apart in each dimension, a change
+    // in the box changes each pair distance at most by this much.
+    real boxChange = 0;
+    for (int d = 0; d < DIM; ++d)
+    {
+        rvec boxDiff;
+        rvec_sub(pbc_.box[d], buffer.box[d], boxDiff);
+        boxChange += norm(boxDiff);
+    }
+    auto displacement2 = [this](const rvec x, const rvec xprev)
+        {
+            rvec dx;
+            if (pbc_.ePBC != epbcNONE)
+            {
+                pbc_dx(&pbc_, x, xprev, dx);
+            }
+            else
+            {
+                rvec_sub(x, xprev, dx);
+            }
+            return bXY_ ? dx[XX]*dx[XX] + dx[YY]*dx[YY] : norm2(dx);
+        };
+    // The grid stores the reference positions relative to its origin.
+    const RVec origin(bGrid_ ? RVec(gridOrigin_) : RVec(0, 0, 0));
+    real       maxDisplacement2 = 0;
+    for (int i = 0; i < nref_; ++i)
+    {
+        rvec xref;
+        rvec_add(xref_[i], origin, xref);
+        maxDisplacement2 = std::max(maxDisplacement2, displacement2(xref, buffer.refX[i]));
+    }
+    if (!test.bSelf)
+    {
+        for (int t = test.first; t < test.count; ++t)
+        {
+            const int index = (test.indices != nullptr ? test.indices[t] : t);
+            maxDisplacement2 = std::max(maxDisplacement2,
+                                        displacement2(test.x[index], buffer.testX[t - test.first]));
+        }
+    }
+    // A pair can get closer by at most twice the largest displacement.
+    return 2*std::sqrt(maxDisplacement2) + boxChange <= pairListBuffer_;
+}
+
+void AnalysisNeighborhoodSearchImpl::findBufferedPairs(
+        const BulkTestPositions      &test,
+        AnalysisNeighborhoodPairList *pairs) const
+{
+    if (pairs->buffer_ == nullptr)
+    {
+        pairs->buffer_ = std::make_unique<AnalysisNeighborhoodPairListBuffer>();
+    }
+    AnalysisNeighborhoodPairListBuffer &buffer   = *pairs->buffer_;
+    const bool                          bRebuild = !isBufferedListValid(test, buffer);
+    if (bRebuild)
+    {
+        findPairs(test, listCutoff_, listCutoff2_, &buffer.list);
+        buffer.bValid         = true;
+        buffer.bSelf          = test.bSelf;
+        buffer.firstTestIndex = test.first;
+        buffer.listCutoff     = listCutoff_;
+        buffer.buffer         = pairListBuffer_;
+        buffer.bXY            = bXY_;
+        buffer.ePBC           = pbc_.ePBC;
+        copy_mat(pbc_.box, buffer.box);
+        const RVec origin(bGrid_ ? RVec(gridOrigin_) : RVec(0, 0, 0));
+        buffer.refX.resize(nref_);
+        for (int i = 0; i < nref_; ++i)
+        {
+            rvec_add(xref_[i], origin, buffer.refX[i]);
+        }
+        buffer.testX.clear();
+        if (!test.bSelf)
+        {
+            for (int t = test.first; t < test.count; ++t)
+            {
+                buffer.testX.emplace_back(test.x[test.indices != nullptr ? test.indices[t] : t]);
+            }
+        }
+        collectPositionIds(test, &buffer.ids);
+    }
+
+    // Filter the list with the actual cutoff.  For a freshly built list, the
+    // distances are already correct, otherwise they are recomputed for the
+    // current positions.
+    const RVec origin(bGrid_ ? RVec(gridOrigin_) : RVec(0, 0, 0));
+    pairs->pairs_.clear();
+    pairs->testStart_.assign(test.count + 1, 0);
+    for (int t = test.first; t < test.count; ++t)
+    {
+        rvec xtest;
+        if (test.bSelf)
+        {
+            copy_rvec(xref_[t], xtest);
+        }
+        else
+        {
+            // Put the test position into the same frame as the grid.
+            rvec_sub(test.x[test.indices != nullptr ? test.indices[t] : t], origin, xtest);
+        }
+        for (const AnalysisNeighborhoodPair &pair : buffer.list.pairsForTestPosition(t))
+        {
+            if (bRebuild)
+            {
+                if (pair.distance2() <= cutoff2_)
+                {
+                    pairs->pairs_.push_back(pair);
+                }
+                continue;
+            }
+            const int i = pair.refIndex();
+            rvec      dx;
+            if (pbc_.ePBC != epbcNONE)
+            {
+                pbc_dx(&pbc_, xref_[i], xtest, dx);
+            }
+            else
+            {
+                rvec_sub(xref_[i], xtest, dx);
+            }
+            const real r2
+                = bXY_
+                    ? dx[XX]*dx[XX] + dx[YY]*dx[YY]
+                    : norm2(dx);
+            if (r2 <= cutoff2_)
+            {
+                pairs->pairs_.emplace_back(i, t, r2, dx);
+            }
+        }
+        pairs->testStart_[t + 1] = pairs->pairs_.size();
+    }
+}
+
+void AnalysisNeighborhoodSearchImpl::findAllPairs(
+        const AnalysisNeighborhoodPositions *positions,
+        AnalysisNeighborhoodPairList        *pairs) const
+{
+    const BulkTestPositions test = bulkTestPositions(positions);
+    if (pairListBuffer_ > 0)
+    {
+        findBufferedPairs(test, pairs);
+    }
+    else
+    {
+        findPairs(test, cutoff_, cutoff2_, pairs);
+    }
+}
+
 void AnalysisNeighborhoodSearchImpl::init(
         AnalysisNeighborhood::SearchMode     mode,
         bool                                 bXY,
@@ -915,29 +1695,29 @@ void AnalysisNeighborhoodSearchImpl::init(
         pbc_.ePBC = epbcNONE;
         clear_mat(pbc_.box);
     }
-    nref_ = positions.count_;
+    nref_         = positions.count_;
+    bClusterPair_ = false;
     if (mode == AnalysisNeighborhood::eSearchMode_Simple)
     {
         bGrid_ = false;
     }
+    else if (mode == AnalysisNeighborhood::eSearchMode_ClusterPair && bTryGrid_ && !bXY_
+             && Nbnxm::AnalysisPairSearch::isSupported(pbc_.ePBC, pbc_.box, listCutoff_))
+    {
+        bGrid_        = false;
+        bClusterPair_ = true;
+    }
     else if (bTryGrid_)
     {
         bGrid_ = initGrid(pbc_, positions.count_, positions.x_,
                           mode == AnalysisNeighborhood::eSearchMode_Grid);
     }
-    refIndices_ = positions.indices_;
+    refIndices_                  = positions.indices_;
+    bClustersInitialized_        = false;
+    bClusterPairGridInitialized_ = false;
     if (bGrid_)
     {
-        xrefAlloc_.resize(nref_);
-        xref_ = as_rvec_array(xrefAlloc_.data());
-
-        for (int i = 0; i < nref_; ++i)
-        {
-            const int ii = (refIndices_ != nullptr) ? refIndices_[i] : i;
-            rvec      refcell;
-            mapPointToGridCell(positions.x_[ii], refcell, xrefAlloc_[i]);
-            addToGridCell(refcell, i);
-        }
+        sortIntoGridCells(positions);
     }
     else if (refIndices_ != nullptr)
     {
@@ -977,6 +1757,7 @@ void AnalysisNeighborhoodPairSearchImpl::reset(int testIndex)
     clear_rvec(prevdx_);
     exclind_       = 0;
     prevcai_       = -1;
+    prevPairIndex_ = -1;
     if (testIndex_ >= 0 && testIndex_ < testPosCount_)
     {
         const int index =
@@ -1057,6 +1838,11 @@ void AnalysisNeighborhoodPairSearchImpl::startSearch(
     testIndices_      = positions.indices_;
     GMX_RELEASE_ASSERT(search_.excls_ == nullptr || testExclusionIds_ != nullptr,
                        "Exclusion IDs must be set when exclusions are enabled");
+    if (search_.bClusterPair_)
+    {
+        search_.findPairs(search_.bulkTestPositions(&positions),
+                          search_.cutoff_, search_.cutoff2_, &clusterPairs_);
+    }
     if (positions.index_ < 0)
     {
         reset(0);
@@ -1079,6 +1865,11 @@ void AnalysisNeighborhoodPairSearchImpl::startSelfSearch()
     testIndices_      = search_.refIndices_;
     GMX_RELEASE_ASSERT(search_.excls_ == nullptr || testIndices_ == nullptr,
                        "Exclusion IDs not implemented with indexed ref positions");
+    if (search_.bClusterPair_)
+    {
+        search_.findPairs(search_.bulkTestPositions(nullptr),
+                          search_.cutoff_, search_.cutoff2_, &clusterPairs_);
+    }
     reset(0);
 }
 
@@ -1087,7 +1878,27 @@ bool AnalysisNeighborhoodPairSearchImpl::searchNext(Action action)
 {
     while (testIndex_ < testPosCount_)
     {
-        if (search_.bGrid_)
+        if (search_.bClusterPair_)
+        {
+            // The pairs are already filtered for cutoff and exclusions.
+            const ArrayRef<const AnalysisNeighborhoodPair> pairs
+                = clusterPairs_.pairsForTestPosition(testIndex_);
+            for (int k = prevPairIndex_ + 1; k < pairs.ssize(); ++k)
+            {
+                const AnalysisNeighborhoodPair &pair = pairs[k];
+                rvec                            dx;
+                copy_rvec(pair.dx(), dx);
+                if (action(pair.refIndex(), pair.distance2(), dx))
+                {
+                    prevPairIndex_ = k;
+                    previ_         = pair.refIndex();
+                    prevr2_        = pair.distance2();
+                    copy_rvec(dx, prevdx_);
+                    return true;
+                }
+            }
+        }
+        else if (search_.bGrid_)
         {
             int cai = prevcai_ + 1;
 
@@ -1099,10 +1910,11 @@ bool AnalysisNeighborhoodPairSearchImpl::searchNext(Action action)
                 {
                     continue;
                 }
-                const int cellSize = ssize(search_.cells_[ci]);
+                const int cellStart = search_.cellStart_[ci];
+                const int cellSize  = search_.cellStart_[ci + 1] - cellStart;
                 for (; cai < cellSize; ++cai)
                 {
-                    const int i = search_.cells_[ci][cai];
+                    const int i = search_.cellContents_[cellStart + cai];
                     if (selfSearchMode_ && ci == testCellIndex_ && i >= testIndex_)
                     {
                         continue;
@@ -1269,7 +2081,8 @@ class AnalysisNeighborhood::Impl
         typedef std::vector<SearchImplPointer> SearchList;
 
         Impl()
-            : cutoff_(0), excls_(nullptr), mode_(eSearchMode_Automatic), bXY_(false)
+            : cutoff_(0), pairListBuffer_(0), excls_(nullptr),
+              mode_(eSearchMode_Automatic), bXY_(false)
         {
         }
         ~Impl()
@@ -1287,6 +2100,7 @@ class AnalysisNeighborhood::Impl
         Mutex                   createSearchMutex_;
         SearchList              searchList_;
         real                    cutoff_;
+        real                    pairListBuffer_;
         const t_blocka         *excls_;
         SearchMode              mode_;
         bool                    bXY_;
@@ -1306,7 +2120,7 @@ AnalysisNeighborhood::Impl::getSearch()
             return *i;
         }
     }
-    SearchImplPointer search(new internal::AnalysisNeighborhoodSearchImpl(cutoff_));
+    SearchImplPointer search(new internal::AnalysisNeighborhoodSearchImpl(cutoff_, pairListBuffer_));
     searchList_.push_back(search);
     return search;
 }
@@ -1331,6 +2145,13 @@ void AnalysisNeighborhood::setCutoff(real cutoff)
     impl_->cutoff_ = cutoff;
 }
 
+void AnalysisNeighborhood::setPairListBuffer(real buffer)
+{
+    GMX_RELEASE_ASSERT(impl_->searchList_.empty(),
+                       "Changing the pair list buffer after initSearch() not currently supported");
+    impl_->pairListBuffer_ = buffer;
+}
+
 void AnalysisNeighborhood::setXYMode(bool bXY)
 {
     impl_->bXY_ = bXY;
@@ -1384,6 +2205,10 @@ void AnalysisNeighborhoodSearch::reset()
 AnalysisNeighborhood::SearchMode AnalysisNeighborhoodSearch::mode() const
 {
     GMX_RELEASE_ASSERT(impl_, "Accessing an invalid search object");
+    if (impl_->usesClusterPairSearch())
+    {
+        return AnalysisNeighborhood::eSearchMode_ClusterPair;
+    }
     return (impl_->usesGridSearch()
             ? AnalysisNeighborhood::eSearchMode_Grid
             : AnalysisNeighborhood::eSearchMode_Simple);
@@ -1446,6 +2271,40 @@ AnalysisNeighborhoodSearch::startPairSearch(
     return AnalysisNeighborhoodPairSearch(pairSearch);
 }
 
+void AnalysisNeighborhoodSearch::findAllPairs(
+        const AnalysisNeighborhoodPositions &positions,
+        AnalysisNeighborhoodPairList        *pairs) const
+{
+    GMX_RELEASE_ASSERT(impl_, "Accessing an invalid search object");
+    impl_->findAllPairs(&positions, pairs);
+}
+
+void AnalysisNeighborhoodSearch::findAllSelfPairs(
+        AnalysisNeighborhoodPairList *pairs) const
+{
+    GMX_RELEASE_ASSERT(impl_, "Accessing an invalid search object");
+    impl_->findAllPairs(nullptr, pairs);
+}
+
+/********************************************************************
+ * AnalysisNeighborhoodPairList
+ */
+
+AnalysisNeighborhoodPairList::AnalysisNeighborhoodPairList()
+    : testStart_(1, 0)
+{
+}
+
+AnalysisNeighborhoodPairList::~AnalysisNeighborhoodPairList()
+{
+}
+
+AnalysisNeighborhoodPairList::AnalysisNeighborhoodPairList(
+        AnalysisNeighborhoodPairList &&other) noexcept = default;
+
+AnalysisNeighborhoodPairList &
+AnalysisNeighborhoodPairList::operator=(AnalysisNeighborhoodPairList &&other) noexcept = default;
+
 /********************************************************************
  * AnalysisNeighborhoodPairSearch
  */
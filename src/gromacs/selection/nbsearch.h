@@ -68,10 +68,12 @@ namespace internal
 {
 class AnalysisNeighborhoodSearchImpl;
 class AnalysisNeighborhoodPairSearchImpl;
+struct AnalysisNeighborhoodPairListBuffer;
 };
 
 class AnalysisNeighborhoodSearch;
 class AnalysisNeighborhoodPairSearch;
+class AnalysisNeighborhoodPairList;
 
 /*! \brief
  * Input positions for neighborhood searching.
@@ -227,7 +229,19 @@ class AnalysisNeighborhood
             //! Use a simple loop over all pairs.
             eSearchMode_Simple,
             //! Use grid-based searching whenever possible.
-            eSearchMode_Grid
+            eSearchMode_Grid,
+            /*! \brief
+             * Use the cluster-pair search of the nonbonded setup whenever possible.
+             *
+             * The reference positions are put on a cluster grid once for
+             * each search, which all pair searches and bulk searches then
+             * use.  Pairs of reference positions are found with a
+             * cluster-pair list, which pays off for large numbers of
+             * positions.  Only used with full 3D PBC without XY mode;
+             * otherwise, falls back to the same algorithms as
+             * \ref eSearchMode_Automatic.
+             */
+            eSearchMode_ClusterPair
         };
 
         //! Creates an uninitialized neighborhood search.
@@ -246,6 +260,35 @@ class AnalysisNeighborhood
          * Does not throw.
          */
         void setCutoff(real cutoff);
+        /*! \brief
+         * Sets a buffer for reusing pair lists between frames.
+         *
+         * \param[in]  buffer Buffer added to the cutoff for the pair lists
+         *   (<=0 disables the reuse).
+         *
+         * With a buffer, AnalysisNeighborhoodSearch::findAllPairs() and
+         * AnalysisNeighborhoodSearch::findAllSelfPairs() keep a list of pairs
+         * within the cutoff plus \p buffer in the AnalysisNeighborhoodPairList
+         * they are given.  On later calls with the same list, the pairs are
+         * only filtered with the actual cutoff, as long as no position has
+         * moved more than about half the buffer since the list was built.
+         * This works like the Verlet buffer in mdrun, and can make the
+         * searching much faster for densely sampled trajectories.
+         * The returned pairs are the same as without the buffer.
+         *
+         * Each AnalysisNeighborhoodPairList must then only be used for the
+         * same set of positions (e.g., the same static selections) in each
+         * frame: the reuse only checks the number of positions and their
+         * indices, not which particles the positions correspond to.
+         * The buffer has no effect on searches that use
+         * AnalysisNeighborhoodPairSearch.
+         *
+         * Currently, can only be called before the first call to initSearch().
+         * Has no effect if no cutoff is used.
+         *
+         * Does not throw.
+         */
+        void setPairListBuffer(real buffer);
         /*! \brief
          * Sets the search to only happen in the XY plane.
          *
@@ -279,9 +322,10 @@ class AnalysisNeighborhood
          *
          * \param[in] mode  Search mode to use.
          *
-         * Note that if \p mode is \ref eSearchMode_Grid, it is still only a
-         * suggestion: grid-based searching may not be possible with the
-         * provided input, in which case a simple search is still used.
+         * Note that if \p mode is \ref eSearchMode_Grid or
+         * \ref eSearchMode_ClusterPair, it is still only a suggestion:
+         * the algorithm may not be possible with the provided input, in which
+         * case another search algorithm is still used.
          * This is mainly useful for testing purposes to force a mode.
          *
          * Does not throw.
@@ -391,6 +435,64 @@ class AnalysisNeighborhoodPair
         rvec                    dx_;
 };
 
+/*! \brief
+ * List of all pairs of positions found in a bulk neighborhood search.
+ *
+ * Filled by AnalysisNeighborhoodSearch::findAllPairs() and
+ * AnalysisNeighborhoodSearch::findAllSelfPairs().  The pairs are ordered by
+ * the test position; the order of the pairs for a single test position is
+ * not specified.  The same object can be reused for multiple searches to
+ * avoid reallocating memory.
+ *
+ * \inpublicapi
+ * \ingroup module_selection
+ */
+class AnalysisNeighborhoodPairList
+{
+    public:
+        //! Initializes an empty list.
+        AnalysisNeighborhoodPairList();
+        ~AnalysisNeighborhoodPairList();
+        //! Moves the list, including a buffered pair list.
+        AnalysisNeighborhoodPairList(AnalysisNeighborhoodPairList &&other) noexcept;
+        //! Moves the list, including a buffered pair list.
+        AnalysisNeighborhoodPairList &operator=(AnalysisNeighborhoodPairList &&other) noexcept;
+
+        //! Returns the number of test positions in the search.
+        int testPositionCount() const { return static_cast<int>(testStart_.size()) - 1; }
+        //! Returns all the pairs, ordered by the test position.
+        ArrayRef<const AnalysisNeighborhoodPair> pairs() const { return pairs_; }
+        /*! \brief
+         * Returns the pairs for a single test position.
+         *
+         * \param[in] testIndex  Index of the test position, as returned by
+         *     AnalysisNeighborhoodPair::testIndex().
+         */
+        ArrayRef<const AnalysisNeighborhoodPair>
+        pairsForTestPosition(int testIndex) const
+        {
+            GMX_ASSERT(testIndex >= 0 && testIndex < testPositionCount(),
+                       "Test position index out of range");
+            return constArrayRefFromArray(pairs_.data() + testStart_[testIndex],
+                                          testStart_[testIndex + 1] - testStart_[testIndex]);
+        }
+
+    private:
+        //! All found pairs.
+        std::vector<AnalysisNeighborhoodPair>   pairs_;
+        //! Index of the first pair for each test position (plus one end index).
+        std::vector<int>                        testStart_;
+        /*! \brief
+         * Pairs within the cutoff plus the pair list buffer, for reuse
+         * between frames.
+         *
+         * Only allocated if AnalysisNeighborhood::setPairListBuffer() is used.
+         */
+        std::unique_ptr<internal::AnalysisNeighborhoodPairListBuffer> buffer_;
+
+        friend class internal::AnalysisNeighborhoodSearchImpl;
+};
+
 /*! \brief
  * Initialized neighborhood search with a fixed set of reference positions.
  *
@@ -530,6 +632,37 @@ class AnalysisNeighborhoodSearch
         AnalysisNeighborhoodPairSearch
         startPairSearch(const AnalysisNeighborhoodPositions &positions) const;
 
+        /*! \brief
+         * Finds all reference positions within a cutoff of test positions.
+         *
+         * \param[in]  positions  Set of test positions to use.
+         * \param[out] pairs      Receives all pairs within the cutoff.
+         * \throws     std::bad_alloc if out of memory.
+         *
+         * Finds the same pairs as looping over startPairSearch() with
+         * AnalysisNeighborhoodPairSearch::findNextPair(), but processes all
+         * positions at once: with grid searching, the reference positions in
+         * each grid cell are stored as SIMD-width clusters that are checked
+         * together, and the test positions are divided between OpenMP
+         * threads.  Prefer this when all the pairs are processed anyway.
+         *
+         * If AnalysisNeighborhood::setPairListBuffer() has been used, a
+         * buffered list in \p pairs from an earlier frame may be reused
+         * instead of searching again.
+         */
+        void findAllPairs(const AnalysisNeighborhoodPositions &positions,
+                          AnalysisNeighborhoodPairList        *pairs) const;
+        /*! \brief
+         * Finds all reference position pairs within a cutoff.
+         *
+         * \param[out] pairs  Receives all pairs within the cutoff.
+         * \throws     std::bad_alloc if out of memory.
+         *
+         * Bulk version of startSelfPairSearch(), see findAllPairs().
+         * Each pair is returned once, such that refIndex() < testIndex().
+         */
+        void findAllSelfPairs(AnalysisNeighborhoodPairList *pairs) const;
+
     private:
         typedef internal::AnalysisNeighborhoodSearchImpl Impl;
 
@@ -43,6 +43,9 @@
 
 #include "selection.h"
 
+#include <cstring>
+
+#include <algorithm>
 #include <string>
 
 #include "gromacs/selection/nbsearch.h"
@@ -51,6 +54,7 @@
 #include "gromacs/topology/topology.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/stringutil.h"
 #include "gromacs/utility/textwriter.h"
 
@@ -121,11 +125,34 @@ SelectionData::SelectionData(SelectionTreeElement *elem,
 }
 
 
+SelectionData::SelectionData(SelectionTreeElement *elem,
+                             const SelectionData  &source)
+    : name_(source.name_), selectionText_(source.selectionText_),
+      flags_(source.flags_), rootElement_(*elem),
+      coveredFractionType_(source.coveredFractionType_),
+      coveredFraction_(source.coveredFraction_),
+      averageCoveredFraction_(source.averageCoveredFraction_),
+      bDynamic_(source.bDynamic_),
+      bDynamicCoveredFraction_(source.bDynamicCoveredFraction_)
+{
+    copyFrameState(source);
+}
+
+
 SelectionData::~SelectionData()
 {
 }
 
 
+// static
+std::unique_ptr<SelectionData>
+SelectionData::createFrameLocalCopy(const SelectionData &source)
+{
+    return std::unique_ptr<SelectionData>(
+            new SelectionData(&source.rootElement_, source));
+}
+
+
 bool
 SelectionData::initCoveredFraction(e_coverfrac_t type)
 {
@@ -195,6 +222,61 @@ SelectionData::hasSortedAtomIndices() const
     return gmx_ana_index_check_sorted(&g);
 }
 
+void
+SelectionData::copyFrameState(const SelectionData &source)
+{
+    const gmx_ana_pos_t &src   = source.rawPositions_;
+    gmx_ana_pos_t       &dest  = rawPositions_;
+    const int            count = src.count();
+    gmx_ana_pos_reserve(&dest, std::max(count, src.m.b.nr), src.m.b.nra);
+    if (src.v != nullptr)
+    {
+        gmx_ana_pos_reserve_velocities(&dest);
+    }
+    if (src.f != nullptr)
+    {
+        gmx_ana_pos_reserve_forces(&dest);
+    }
+    std::memcpy(dest.x, src.x, count*sizeof(*dest.x));
+    if (src.v != nullptr)
+    {
+        std::memcpy(dest.v, src.v, count*sizeof(*dest.v));
+    }
+    if (src.f != nullptr)
+    {
+        std::memcpy(dest.f, src.f, count*sizeof(*dest.f));
+    }
+
+    // gmx_ana_indexmap_copy() may leave the atom array aliased to the
+    // source, which would not survive evaluation of the next frame, so the
+    // mapping is copied explicitly here.
+    const gmx_ana_indexmap_t &srcMap  = src.m;
+    gmx_ana_indexmap_t       &destMap = dest.m;
+    destMap.type    = srcMap.type;
+    destMap.bStatic = srcMap.bStatic;
+    destMap.b.nr    = srcMap.b.nr;
+    destMap.b.nra   = srcMap.b.nra;
+    std::copy(srcMap.b.index, srcMap.b.index + srcMap.b.nr + 1, destMap.b.index);
+    std::copy(srcMap.b.a, srcMap.b.a + srcMap.b.nra, destMap.b.a);
+    std::copy(srcMap.orgid, srcMap.orgid + srcMap.b.nr, destMap.orgid);
+    destMap.mapb.nr  = srcMap.mapb.nr;
+    destMap.mapb.nra = srcMap.mapb.nra;
+    if (destMap.mapb.nalloc_a < srcMap.mapb.nra)
+    {
+        srenew(destMap.mapb.a, srcMap.mapb.nra);
+        destMap.mapb.nalloc_a = srcMap.mapb.nra;
+    }
+    std::copy(srcMap.mapb.a, srcMap.mapb.a + srcMap.mapb.nra, destMap.mapb.a);
+    std::copy(srcMap.mapb.index, srcMap.mapb.index + srcMap.mapb.nr + 1,
+              destMap.mapb.index);
+    std::copy(srcMap.refid, srcMap.refid + srcMap.mapb.nr, destMap.refid);
+    std::copy(srcMap.mapid, srcMap.mapid + srcMap.mapb.nr, destMap.mapid);
+
+    posMass_         = source.posMass_;
+    posCharge_       = source.posCharge_;
+    coveredFraction_ = source.coveredFraction_;
+}
+
 void
 SelectionData::refreshName()
 {
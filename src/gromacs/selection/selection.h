@@ -43,6 +43,7 @@
 #ifndef GMX_SELECTION_SELECTION_H
 #define GMX_SELECTION_SELECTION_H
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -95,6 +96,20 @@ class SelectionData
         SelectionData(SelectionTreeElement *elem, const char *selstr);
         ~SelectionData();
 
+        /*! \brief
+         * Creates a frame-local copy of a selection.
+         *
+         * \param[in] source  Selection to copy.
+         * \throws    std::bad_alloc if out of memory.
+         *
+         * The copy shares the evaluation tree with \p source, and can only
+         * be used for read-only access to the selected positions.
+         * copyFrameState() is used to update the copy after \p source has
+         * been evaluated for a frame.
+         */
+        static std::unique_ptr<SelectionData>
+        createFrameLocalCopy(const SelectionData &source);
+
         //! Returns the name for this selection.
         const char *name() const { return name_.c_str(); }
         //! Returns the string that was parsed to produce this selection.
@@ -186,8 +201,23 @@ class SelectionData
          * Called by SelectionEvaluator::evaluateFinal().
          */
         void restoreOriginalPositions(const gmx_mtop_t *top);
+        /*! \brief
+         * Copies the evaluated positions from another selection.
+         *
+         * \param[in] source  Selection to copy the positions from.
+         * \throws    std::bad_alloc if out of memory.
+         *
+         * Nothing is shared with \p source after the call, so the copied
+         * positions remain valid when \p source is evaluated for another
+         * frame.
+         * Used for frame-local copies created with createFrameLocalCopy().
+         */
+        void copyFrameState(const SelectionData &source);
 
     private:
+        //! Initializes a frame-local copy; see createFrameLocalCopy().
+        SelectionData(SelectionTreeElement *elem, const SelectionData &source);
+
         //! Name of the selection.
         std::string               name_;
         //! The actual selection string.
@@ -84,7 +84,8 @@ namespace gmx
  */
 
 SelectionCollection::Impl::Impl()
-    : debugLevel_(0), bExternalGroupsSet_(false), grps_(nullptr)
+    : debugLevel_(0), bExternalGroupsSet_(false), grps_(nullptr),
+      frameLocalSource_(nullptr)
 {
     sc_.nvars     = 0;
     sc_.varstrs   = nullptr;
@@ -915,6 +916,61 @@ SelectionCollection::evaluateFinal(int nframes)
 }
 
 
+void
+SelectionCollection::initFrameLocalCopy(const SelectionCollection &source)
+{
+    GMX_RELEASE_ASSERT(impl_->sc_.sel.empty() && !impl_->sc_.root,
+                       "Frame-local copy should be made into an empty collection");
+    GMX_RELEASE_ASSERT(source.impl_->frameLocalSource_ == nullptr,
+                       "Cannot make a frame-local copy of a frame-local copy");
+    impl_->sc_.sel.reserve(source.impl_->sc_.sel.size());
+    for (const auto &sel : source.impl_->sc_.sel)
+    {
+        impl_->sc_.sel.push_back(internal::SelectionData::createFrameLocalCopy(*sel));
+    }
+    impl_->sc_.top           = source.impl_->sc_.top;
+    impl_->frameLocalSource_ = &source;
+}
+
+
+void
+SelectionCollection::copyFrameState()
+{
+    const SelectionCollection *source = impl_->frameLocalSource_;
+    GMX_RELEASE_ASSERT(source != nullptr,
+                       "copyFrameState() called for a collection that is not a copy");
+    const SelectionDataList   &sourceSel = source->impl_->sc_.sel;
+    GMX_RELEASE_ASSERT(sourceSel.size() == impl_->sc_.sel.size(),
+                       "Selections added to the source after copying");
+    for (size_t i = 0; i < sourceSel.size(); ++i)
+    {
+        impl_->sc_.sel[i]->copyFrameState(*sourceSel[i]);
+    }
+}
+
+
+Selection
+SelectionCollection::frameLocalSelection(const Selection &selection) const
+{
+    const SelectionCollection *source = impl_->frameLocalSource_;
+    if (source == nullptr)
+    {
+        return selection;
+    }
+    const SelectionDataList &sourceSel = source->impl_->sc_.sel;
+    for (size_t i = 0; i < sourceSel.size(); ++i)
+    {
+        if (Selection(sourceSel[i].get()) == selection)
+        {
+            return Selection(impl_->sc_.sel[i].get());
+        }
+    }
+    // Selections that are not part of the source (e.g., ones that are
+    // constructed by the caller) are returned unchanged.
+    return selection;
+}
+
+
 void
 SelectionCollection::printTree(FILE *fp, bool bValues) const
 {
@@ -389,6 +389,45 @@ class SelectionCollection
          */
         void evaluateFinal(int nframes);
 
+        /*! \brief
+         * Initializes this collection as a frame-local copy of another one.
+         *
+         * \param[in] source  Compiled selection collection to copy.
+         * \throws    std::bad_alloc if out of memory.
+         *
+         * After this call, the collection holds a copy of each selection in
+         * \p source, accessible through frameLocalSelection().
+         * The copies are updated with copyFrameState() after \p source has
+         * been evaluated, after which they keep the positions for that frame
+         * even when \p source is evaluated for further frames.  This allows
+         * analyzing several frames concurrently while evaluation itself stays
+         * serial.
+         *
+         * The collection should be empty when this method is called, and
+         * \p source must outlive this collection.  Parsing, compiling or
+         * evaluating the copy is not supported.
+         */
+        void initFrameLocalCopy(const SelectionCollection &source);
+        /*! \brief
+         * Updates a frame-local copy with the current state of its source.
+         *
+         * \throws    std::bad_alloc if out of memory.
+         *
+         * Can only be called after initFrameLocalCopy().
+         */
+        void copyFrameState();
+        /*! \brief
+         * Returns the selection in this collection that corresponds to a
+         * selection in the source collection.
+         *
+         * \param[in] selection  Selection from the source collection.
+         * \returns   Corresponding frame-local selection, or \p selection
+         *      if this collection is not a frame-local copy.
+         *
+         * Does not throw.
+         */
+        Selection frameLocalSelection(const Selection &selection) const;
+
         /*! \brief
          * Prints a human-readable version of the internal selection element
          * tree.
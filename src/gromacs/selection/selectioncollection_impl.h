@@ -187,6 +187,12 @@ class SelectionCollection::Impl
         bool                    bExternalGroupsSet_;
         //! External index groups (can be NULL).
         gmx_ana_indexgrps_t    *grps_;
+        /*! \brief
+         * Collection that this is a frame-local copy of (NULL if none).
+         *
+         * \see SelectionCollection::initFrameLocalCopy()
+         */
+        const SelectionCollection *frameLocalSource_;
 };
 
 /*! \internal
@@ -49,6 +49,7 @@
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/smalloc.h"
 
+#include "indexfilter.h"
 #include "keywords.h"
 #include "selmethod.h"
 
@@ -572,6 +573,30 @@ evaluate_compare_real(gmx_ana_index_t *g, gmx_ana_selvalue_t *out, void *data)
     real                  a, b;
     bool                  bAccept;
 
+    // Comparisons of dynamic values against a constant (e.g., "z > 3") are
+    // done in SIMD blocks.
+    if (!(d->left.flags & CMP_SINGLEVAL) && (d->right.flags & CMP_SINGLEVAL))
+    {
+        const real limit = (d->right.flags & CMP_REALVAL) ? d->right.r[0] : d->right.i[0];
+        switch (d->cmpt)
+        {
+            case CMP_LESS:
+                gmx::filterIndexByComparison(g, d->left.r, gmx::RealComparison::Less, limit, out->u.g);
+                return;
+            case CMP_LEQ:
+                gmx::filterIndexByComparison(g, d->left.r, gmx::RealComparison::LessOrEqual, limit, out->u.g);
+                return;
+            case CMP_GTR:
+                gmx::filterIndexByComparison(g, d->left.r, gmx::RealComparison::Greater, limit, out->u.g);
+                return;
+            case CMP_GEQ:
+                gmx::filterIndexByComparison(g, d->left.r, gmx::RealComparison::GreaterOrEqual, limit, out->u.g);
+                return;
+            default:
+                break;
+        }
+    }
+
     for (i = i1 = i2 = ig = 0; i < g->isize; ++i)
     {
         a       = d->left.r[i1];
@@ -44,12 +44,15 @@
  */
 #include "gmxpre.h"
 
+#include <vector>
+
 #include "gromacs/math/vec.h"
 #include "gromacs/selection/nbsearch.h"
 #include "gromacs/selection/position.h"
 #include "gromacs/utility/arraysize.h"
 #include "gromacs/utility/exceptions.h"
 
+#include "indexfilter.h"
 #include "selmethod.h"
 #include "selmethod_impl.h"
 
@@ -75,6 +78,8 @@ struct t_methoddata_distance
     gmx::AnalysisNeighborhood        nb;
     /** Neighborhood search for an invididual frame. */
     gmx::AnalysisNeighborhoodSearch  nbsearch;
+    /** Whether each position is within the cutoff, for evaluate_within(). */
+    std::vector<char>                withinMask;
 };
 
 /*! \brief
@@ -242,6 +247,9 @@ init_common(const gmx_mtop_t * /* top */, int /* npar */, gmx_ana_selparam_t *pa
         GMX_THROW(gmx::InvalidInputError("Distance cutoff should be > 0"));
     }
     d->nb.setCutoff(d->cutoff);
+    // Large membrane and solvent selections benefit from the cluster-pair
+    // search; it falls back to the grid or simple search when not supported.
+    d->nb.setMode(gmx::AnalysisNeighborhood::eSearchMode_ClusterPair);
 }
 
 /*!
@@ -299,10 +307,16 @@ evaluate_within(const gmx::SelMethodEvalContext & /*context*/,
 {
     t_methoddata_distance *d = static_cast<t_methoddata_distance *>(data);
 
+    // The searches are independent, so they can be done in parallel; the
+    // output group is then constructed in order.
+    d->withinMask.resize(pos->count());
+    gmx::computeMaskInParallel(pos->count(),
+                               [d, pos](int b) { return d->nbsearch.isWithin(pos->x[b]); },
+                               d->withinMask.data());
     out->u.g->isize = 0;
     for (int b = 0; b < pos->count(); ++b)
     {
-        if (d->nbsearch.isWithin(pos->x[b]))
+        if (d->withinMask[b])
         {
             gmx_ana_pos_add_to_group(out->u.g, pos, b);
         }
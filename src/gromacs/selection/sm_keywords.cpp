@@ -56,6 +56,7 @@
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/stringutil.h"
 
+#include "indexfilter.h"
 #include "keywords.h"
 #include "parsetree.h"
 #include "scanner.h"
@@ -544,8 +545,14 @@ evaluate_keyword_real(const gmx::SelMethodEvalContext & /*context*/,
     int                  n, i, j, jmin, jmax;
     real                 val;
 
-    out->u.g->isize = 0;
     n               = d->n;
+    // A single range (e.g., "z 3 to 5") is checked in SIMD blocks.
+    if (n == 1)
+    {
+        gmx::filterIndexByRange(g, d->v, d->r[0], d->r[1], out->u.g);
+        return;
+    }
+    out->u.g->isize = 0;
     for (i = 0; i < g->isize; ++i)
     {
         val = d->v[i];
@@ -0,0 +1,180 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests the index group filtering functions in the selection engine.
+ *
+ * \ingroup module_selection
+ */
+#include "gmxpre.h"
+
+#include "gromacs/selection/indexfilter.h"
+
+#include <numeric>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/random/threefry.h"
+#include "gromacs/random/uniformrealdistribution.h"
+#include "gromacs/selection/indexutil.h"
+
+namespace
+{
+
+/*! \brief
+ * Test fixture with random values for index group filtering.
+ */
+class IndexFilterTest : public ::testing::Test
+{
+    public:
+        //! Creates a group with every third atom and random values for it.
+        void generateGroup(int count)
+        {
+            gmx::DefaultRandomEngine           rng(12345);
+            gmx::UniformRealDistribution<real> dist(-1.0, 1.0);
+            index_.resize(count);
+            values_.resize(count);
+            for (int i = 0; i < count; ++i)
+            {
+                index_[i]  = 3*i;
+                values_[i] = dist(rng);
+            }
+            // Include exact matches of the limits used in the tests.
+            values_[count/2] = 0.25;
+            values_[count/3] = -0.5;
+            outIndex_.resize(count);
+        }
+        //! Returns the generated group.
+        gmx_ana_index_t group()
+        {
+            gmx_ana_index_t g = { static_cast<int>(index_.size()), index_.data(), 0 };
+            return g;
+        }
+        //! Returns an output group with room for the generated group.
+        gmx_ana_index_t outGroup()
+        {
+            gmx_ana_index_t g = { 0, outIndex_.data(), 0 };
+            return g;
+        }
+        //! Returns the entries for which \p test returns `true`.
+        template <class Test>
+        std::vector<int> expectedIndex(const Test &test) const
+        {
+            std::vector<int> result;
+            for (size_t i = 0; i < index_.size(); ++i)
+            {
+                if (test(values_[i]))
+                {
+                    result.push_back(index_[i]);
+                }
+            }
+            return result;
+        }
+
+        std::vector<int>  index_;
+        std::vector<real> values_;
+        std::vector<int>  outIndex_;
+};
+
+//! Returns the entries of an index group as a vector.
+std::vector<int> groupIndex(const gmx_ana_index_t &g)
+{
+    return std::vector<int>(g.index, g.index + g.isize);
+}
+
+TEST_F(IndexFilterTest, FiltersByComparison)
+{
+    generateGroup(1003);
+    gmx_ana_index_t g                = group();
+    gmx_ana_index_t out              = outGroup();
+    const auto      isLess           = [](real v) { return v < 0.25; };
+    const auto      isLessOrEqual    = [](real v) { return v <= 0.25; };
+    const auto      isGreater        = [](real v) { return v > 0.25; };
+    const auto      isGreaterOrEqual = [](real v) { return v >= 0.25; };
+    gmx::filterIndexByComparison(&g, values_.data(), gmx::RealComparison::Less, 0.25, &out);
+    EXPECT_EQ(expectedIndex(isLess), groupIndex(out));
+    gmx::filterIndexByComparison(&g, values_.data(), gmx::RealComparison::LessOrEqual, 0.25, &out);
+    EXPECT_EQ(expectedIndex(isLessOrEqual), groupIndex(out));
+    gmx::filterIndexByComparison(&g, values_.data(), gmx::RealComparison::Greater, 0.25, &out);
+    EXPECT_EQ(expectedIndex(isGreater), groupIndex(out));
+    gmx::filterIndexByComparison(&g, values_.data(), gmx::RealComparison::GreaterOrEqual, 0.25, &out);
+    EXPECT_EQ(expectedIndex(isGreaterOrEqual), groupIndex(out));
+}
+
+TEST_F(IndexFilterTest, FiltersByRange)
+{
+    generateGroup(1003);
+    gmx_ana_index_t g         = group();
+    gmx_ana_index_t out       = outGroup();
+    const auto      isInRange = [](real v) { return -0.5 <= v && v <= 0.25; };
+    gmx::filterIndexByRange(&g, values_.data(), -0.5, 0.25, &out);
+    EXPECT_EQ(expectedIndex(isInRange), groupIndex(out));
+}
+
+TEST_F(IndexFilterTest, FiltersLargeGroupsInPlace)
+{
+    // Large enough to be split between threads.
+    generateGroup(100003);
+    const auto             isGreater = [](real v) { return v > 0.25; };
+    const std::vector<int> expected  = expectedIndex(isGreater);
+    gmx_ana_index_t        g         = group();
+    gmx::filterIndexByComparison(&g, values_.data(), gmx::RealComparison::Greater, 0.25, &g);
+    EXPECT_EQ(expected, groupIndex(g));
+}
+
+TEST_F(IndexFilterTest, HandlesEmptyGroups)
+{
+    generateGroup(1);
+    gmx_ana_index_t g   = { 0, index_.data(), 0 };
+    gmx_ana_index_t out = outGroup();
+    out.isize = 1;
+    gmx::filterIndexByRange(&g, values_.data(), -1.0, 1.0, &out);
+    EXPECT_EQ(0, out.isize);
+}
+
+TEST(IndexMaskTest, ComputesMaskInParallel)
+{
+    const int         count = 10001;
+    std::vector<char> mask(count);
+    const auto        isMultipleOfThree = [](int i) { return i % 3 == 0; };
+    gmx::computeMaskInParallel(count, isMultipleOfThree, mask.data());
+    for (int i = 0; i < count; ++i)
+    {
+        EXPECT_EQ(i % 3 == 0 ? 1 : 0, mask[i]) << "Item " << i;
+    }
+}
+
+} // namespace
@@ -413,6 +413,8 @@ void ExclusionsHelper::generateExclusions()
 class NeighborhoodSearchTest : public ::testing::Test
 {
     public:
+        NeighborhoodSearchTest() : bBulkSearch_(false) {}
+
         void testIsWithin(gmx::AnalysisNeighborhoodSearch  *search,
                           const NeighborhoodSearchTestData &data);
         void testMinimumDistance(gmx::AnalysisNeighborhoodSearch  *search,
@@ -431,8 +433,12 @@ class NeighborhoodSearchTest : public ::testing::Test
                                 const gmx::ArrayRef<const int>           &refIndices,
                                 const gmx::ArrayRef<const int>           &testIndices,
                                 bool                                      selfPairs);
+        void testBufferedPairSearch(const NeighborhoodSearchTestData &data,
+                                    bool                              selfPairs);
 
         gmx::AnalysisNeighborhood        nb_;
+        //! Whether to test findAllPairs() instead of findNextPair().
+        bool                             bBulkSearch_;
 };
 
 void NeighborhoodSearchTest::testIsWithin(
@@ -609,12 +615,45 @@ void NeighborhoodSearchTest::testPairSearchFull(
     {
         posCopy.indexed(testIndices);
     }
-    gmx::AnalysisNeighborhoodPairSearch pairSearch
-        = selfPairs
-            ? search->startSelfPairSearch()
-            : search->startPairSearch(posCopy);
-    gmx::AnalysisNeighborhoodPair       pair;
-    while (pairSearch.findNextPair(&pair))
+    std::vector<gmx::AnalysisNeighborhoodPair> foundPairs;
+    if (bBulkSearch_)
+    {
+        gmx::AnalysisNeighborhoodPairList pairList;
+        if (selfPairs)
+        {
+            search->findAllSelfPairs(&pairList);
+        }
+        else
+        {
+            search->findAllPairs(posCopy, &pairList);
+        }
+        for (int i = 0; i < pairList.testPositionCount(); ++i)
+        {
+            for (const auto &pair : pairList.pairsForTestPosition(i))
+            {
+                EXPECT_EQ(i, pair.testIndex())
+                << "Pairs are not ordered by the test position";
+                if (selfPairs)
+                {
+                    EXPECT_LT(pair.refIndex(), pair.testIndex());
+                }
+            }
+        }
+        foundPairs.assign(pairList.pairs().begin(), pairList.pairs().end());
+    }
+    else
+    {
+        gmx::AnalysisNeighborhoodPairSearch pairSearch
+            = selfPairs
+                ? search->startSelfPairSearch()
+                : search->startPairSearch(posCopy);
+        gmx::AnalysisNeighborhoodPair       pair;
+        while (pairSearch.findNextPair(&pair))
+        {
+            foundPairs.push_back(pair);
+        }
+    }
+    for (const auto &pair : foundPairs)
     {
         const int testIndex =
             (testIndices.empty() ? pair.testIndex() : testIndices[pair.testIndex()]);
@@ -689,6 +728,107 @@ void NeighborhoodSearchTest::testPairSearchFull(
     }
 }
 
+/*! \brief
+ * Returns the pairs from a pair list sorted by the test and reference index.
+ */
+std::vector<gmx::AnalysisNeighborhoodPair>
+sortedPairs(const gmx::AnalysisNeighborhoodPairList &pairList)
+{
+    std::vector<gmx::AnalysisNeighborhoodPair> pairs(pairList.pairs().begin(),
+                                                     pairList.pairs().end());
+    std::sort(pairs.begin(), pairs.end(),
+              [](const gmx::AnalysisNeighborhoodPair &a,
+                 const gmx::AnalysisNeighborhoodPair &b)
+              {
+                  return a.testIndex() < b.testIndex()
+                  || (a.testIndex() == b.testIndex() && a.refIndex() < b.refIndex());
+              });
+    return pairs;
+}
+
+void NeighborhoodSearchTest::testBufferedPairSearch(
+        const NeighborhoodSearchTestData &data,
+        bool                              selfPairs)
+{
+    gmx::AnalysisNeighborhood          unbufferedNb;
+    unbufferedNb.setCutoff(data.cutoff_);
+    unbufferedNb.setMode(nb_.mode());
+
+    gmx::DefaultRandomEngine           rng(54321);
+    gmx::UniformRealDistribution<real> dist;
+    std::vector<gmx::RVec>             refPos(data.refPos_);
+    std::vector<gmx::RVec>             testPos;
+    for (const auto &testPosition : data.testPositions_)
+    {
+        testPos.emplace_back(testPosition.x);
+    }
+    matrix                             box;
+    copy_mat(data.box_, box);
+    gmx::AnalysisNeighborhoodPairList  pairList;
+    gmx::AnalysisNeighborhoodPairList  unbufferedPairList;
+    // Move the positions a bit in each frame, such that the buffered list
+    // is reused for a few frames at a time, and change the box once.
+    for (int frame = 0; frame < 20; ++frame)
+    {
+        SCOPED_TRACE(gmx::formatString("Frame %d", frame));
+        if (frame > 0)
+        {
+            for (auto *positions : {&refPos, &testPos})
+            {
+                for (auto &x : *positions)
+                {
+                    x[XX] += 0.02 * dist(rng) - 0.01;
+                    x[YY] += 0.02 * dist(rng) - 0.01;
+                    x[ZZ] += 0.02 * dist(rng) - 0.01;
+                }
+            }
+        }
+        if (frame == 13)
+        {
+            box[XX][XX] += 0.01;
+        }
+        t_pbc pbc;
+        set_pbc(&pbc, data.pbc_.ePBC, box);
+        gmx::AnalysisNeighborhoodSearch search =
+            nb_.initSearch(&pbc, gmx::AnalysisNeighborhoodPositions(refPos));
+        gmx::AnalysisNeighborhoodSearch unbufferedSearch =
+            unbufferedNb.initSearch(&pbc, gmx::AnalysisNeighborhoodPositions(refPos));
+        if (selfPairs)
+        {
+            search.findAllSelfPairs(&pairList);
+            unbufferedSearch.findAllSelfPairs(&unbufferedPairList);
+        }
+        else
+        {
+            search.findAllPairs(testPos, &pairList);
+            unbufferedSearch.findAllPairs(testPos, &unbufferedPairList);
+        }
+        ASSERT_EQ(unbufferedPairList.testPositionCount(), pairList.testPositionCount());
+        const std::vector<gmx::AnalysisNeighborhoodPair> pairs
+            = sortedPairs(pairList);
+        const std::vector<gmx::AnalysisNeighborhoodPair> unbufferedPairs
+            = sortedPairs(unbufferedPairList);
+        ASSERT_EQ(unbufferedPairs.size(), pairs.size());
+        for (size_t i = 0; i < pairs.size(); ++i)
+        {
+            EXPECT_EQ(unbufferedPairs[i].testIndex(), pairs[i].testIndex());
+            EXPECT_EQ(unbufferedPairs[i].refIndex(), pairs[i].refIndex());
+            EXPECT_REAL_EQ_TOL(std::sqrt(unbufferedPairs[i].distance2()),
+                               std::sqrt(pairs[i].distance2()),
+                               data.relativeTolerance());
+        }
+        for (int t = 0; t < pairList.testPositionCount(); ++t)
+        {
+            for (const auto &pair : pairList.pairsForTestPosition(t))
+            {
+                EXPECT_EQ(t, pair.testIndex());
+            }
+        }
+        search.reset();
+        unbufferedSearch.reset();
+    }
+}
+
 /********************************************************************
  * Test data generation
  */
@@ -1066,6 +1206,291 @@ TEST_F(NeighborhoodSearchTest, GridSelfPairsSearch)
                        {}, {}, true);
 }
 
+TEST_F(NeighborhoodSearchTest, BulkSimpleSearch)
+{
+    const NeighborhoodSearchTestData &data = RandomBoxFullPBCData::get();
+
+    bBulkSearch_ = true;
+    nb_.setCutoff(data.cutoff_);
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_Simple);
+    gmx::AnalysisNeighborhoodSearch search =
+        nb_.initSearch(&data.pbc_, data.refPositions());
+    ASSERT_EQ(gmx::AnalysisNeighborhood::eSearchMode_Simple, search.mode());
+
+    testPairSearch(&search, data);
+
+    search.reset();
+    testPairSearchIndexed(&nb_, data, 123);
+}
+
+TEST_F(NeighborhoodSearchTest, BulkGridSearchBox)
+{
+    const NeighborhoodSearchTestData &data = RandomBoxFullPBCData::get();
+
+    bBulkSearch_ = true;
+    nb_.setCutoff(data.cutoff_);
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_Grid);
+    gmx::AnalysisNeighborhoodSearch search =
+        nb_.initSearch(&data.pbc_, data.refPositions());
+    ASSERT_EQ(gmx::AnalysisNeighborhood::eSearchMode_Grid, search.mode());
+
+    testPairSearch(&search, data);
+
+    search.reset();
+    testPairSearchIndexed(&nb_, data, 456);
+}
+
+TEST_F(NeighborhoodSearchTest, BulkGridSearchTriclinic)
+{
+    const NeighborhoodSearchTestData &data = RandomTriclinicFullPBCData::get();
+
+    bBulkSearch_ = true;
+    nb_.setCutoff(data.cutoff_);
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_Grid);
+    gmx::AnalysisNeighborhoodSearch search =
+        nb_.initSearch(&data.pbc_, data.refPositions());
+    ASSERT_EQ(gmx::AnalysisNeighborhood::eSearchMode_Grid, search.mode());
+
+    testPairSearch(&search, data);
+}
+
+TEST_F(NeighborhoodSearchTest, BulkGridSearchNoPBC)
+{
+    const NeighborhoodSearchTestData &data = RandomBoxNoPBCData::get();
+
+    bBulkSearch_ = true;
+    nb_.setCutoff(data.cutoff_);
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_Grid);
+    gmx::AnalysisNeighborhoodSearch search =
+        nb_.initSearch(&data.pbc_, data.refPositions());
+    ASSERT_EQ(gmx::AnalysisNeighborhood::eSearchMode_Grid, search.mode());
+
+    testPairSearch(&search, data);
+}
+
+TEST_F(NeighborhoodSearchTest, BulkGridSearchXYBox)
+{
+    const NeighborhoodSearchTestData &data = RandomBoxXYFullPBCData::get();
+
+    bBulkSearch_ = true;
+    nb_.setCutoff(data.cutoff_);
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_Grid);
+    nb_.setXYMode(true);
+    gmx::AnalysisNeighborhoodSearch search =
+        nb_.initSearch(&data.pbc_, data.refPositions());
+    ASSERT_EQ(gmx::AnalysisNeighborhood::eSearchMode_Grid, search.mode());
+
+    testPairSearch(&search, data);
+}
+
+TEST_F(NeighborhoodSearchTest, BulkSimpleSelfPairsSearch)
+{
+    const NeighborhoodSearchTestData &data = TrivialSelfPairsTestData::get();
+
+    bBulkSearch_ = true;
+    nb_.setCutoff(data.cutoff_);
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_Simple);
+    gmx::AnalysisNeighborhoodSearch search =
+        nb_.initSearch(&data.pbc_, data.refPositions());
+    ASSERT_EQ(gmx::AnalysisNeighborhood::eSearchMode_Simple, search.mode());
+
+    testPairSearchFull(&search, data, data.testPositions(), nullptr,
+                       {}, {}, true);
+}
+
+TEST_F(NeighborhoodSearchTest, BulkGridSelfPairsSearch)
+{
+    const NeighborhoodSearchTestData &data = RandomBoxSelfPairsData::get();
+
+    bBulkSearch_ = true;
+    nb_.setCutoff(data.cutoff_);
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_Grid);
+    gmx::AnalysisNeighborhoodSearch search =
+        nb_.initSearch(&data.pbc_, data.refPositions());
+    ASSERT_EQ(gmx::AnalysisNeighborhood::eSearchMode_Grid, search.mode());
+
+    testPairSearchFull(&search, data, data.testPositions(), nullptr,
+                       {}, {}, true);
+}
+
+TEST_F(NeighborhoodSearchTest, BulkSearchSinglePosition)
+{
+    const NeighborhoodSearchTestData &data = TrivialTestData::get();
+
+    nb_.setCutoff(data.cutoff_);
+    gmx::AnalysisNeighborhoodSearch   search =
+        nb_.initSearch(&data.pbc_, data.refPositions());
+    gmx::AnalysisNeighborhoodPairList pairList;
+    search.findAllPairs(data.testPosition(2), &pairList);
+    ASSERT_EQ(3, pairList.testPositionCount());
+    EXPECT_TRUE(pairList.pairsForTestPosition(0).empty());
+    EXPECT_TRUE(pairList.pairsForTestPosition(1).empty());
+    ASSERT_FALSE(pairList.pairsForTestPosition(2).empty())
+    << "Test data did not contain any pairs for position 2 (problem in the test).";
+    for (const auto &pair : pairList.pairs())
+    {
+        EXPECT_EQ(2, pair.testIndex());
+        NeighborhoodSearchTestData::RefPair searchPair(pair.refIndex(), std::sqrt(pair.distance2()));
+        EXPECT_TRUE(data.containsPair(2, searchPair));
+    }
+}
+
+TEST_F(NeighborhoodSearchTest, ClusterPairSearchBox)
+{
+    const NeighborhoodSearchTestData &data = RandomBoxFullPBCData::get();
+
+    nb_.setCutoff(data.cutoff_);
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_ClusterPair);
+    gmx::AnalysisNeighborhoodSearch search =
+        nb_.initSearch(&data.pbc_, data.refPositions());
+    ASSERT_EQ(gmx::AnalysisNeighborhood::eSearchMode_ClusterPair, search.mode());
+
+    testIsWithin(&search, data);
+    testMinimumDistance(&search, data);
+    testNearestPoint(&search, data);
+    testPairSearch(&search, data);
+    bBulkSearch_ = true;
+    testPairSearch(&search, data);
+
+    search.reset();
+    testPairSearchIndexed(&nb_, data, 789);
+}
+
+TEST_F(NeighborhoodSearchTest, ClusterPairSearchTriclinic)
+{
+    const NeighborhoodSearchTestData &data = RandomTriclinicFullPBCData::get();
+
+    bBulkSearch_ = true;
+    nb_.setCutoff(data.cutoff_);
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_ClusterPair);
+    gmx::AnalysisNeighborhoodSearch search =
+        nb_.initSearch(&data.pbc_, data.refPositions());
+    ASSERT_EQ(gmx::AnalysisNeighborhood::eSearchMode_ClusterPair, search.mode());
+
+    testPairSearch(&search, data);
+}
+
+TEST_F(NeighborhoodSearchTest, ClusterPairSelfPairsSearch)
+{
+    const NeighborhoodSearchTestData &data = RandomBoxSelfPairsData::get();
+
+    nb_.setCutoff(data.cutoff_);
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_ClusterPair);
+    gmx::AnalysisNeighborhoodSearch search =
+        nb_.initSearch(&data.pbc_, data.refPositions());
+    ASSERT_EQ(gmx::AnalysisNeighborhood::eSearchMode_ClusterPair, search.mode());
+
+    testPairSearchFull(&search, data, data.testPositions(), nullptr,
+                       {}, {}, true);
+    bBulkSearch_ = true;
+    testPairSearchFull(&search, data, data.testPositions(), nullptr,
+                       {}, {}, true);
+}
+
+TEST_F(NeighborhoodSearchTest, ClusterPairSearchFromConcurrentThreads)
+{
+    const NeighborhoodSearchTestData &data = RandomBoxFullPBCData::get();
+
+    nb_.setCutoff(data.cutoff_);
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_ClusterPair);
+    gmx::AnalysisNeighborhoodSearch search =
+        nb_.initSearch(&data.pbc_, data.refPositions());
+    ASSERT_EQ(gmx::AnalysisNeighborhood::eSearchMode_ClusterPair, search.mode());
+
+    // The threads race to build the grid for the frame, and then search
+    // the same grid concurrently.
+    const int         testPosCount = data.testPositions_.size();
+    std::vector<char> bWithin(testPosCount);
+    std::vector<real> minDist(testPosCount);
+#pragma omp parallel for num_threads(4) schedule(dynamic)
+    for (int t = 0; t < testPosCount; ++t)
+    {
+        bWithin[t] = search.isWithin(data.testPositions_[t].x);
+        minDist[t] = search.minimumDistance(data.testPositions_[t].x);
+    }
+    for (int t = 0; t < testPosCount; ++t)
+    {
+        const real refDist = data.testPositions_[t].refMinDist;
+        EXPECT_EQ(refDist <= data.cutoff_, bWithin[t] != 0)
+        << "Distance is " << refDist;
+        EXPECT_REAL_EQ_TOL(refDist, minDist[t], data.relativeTolerance());
+    }
+}
+
+TEST_F(NeighborhoodSearchTest, ClusterPairSearchFallsBackWithoutFullPBC)
+{
+    const NeighborhoodSearchTestData &data = RandomBox2DPBCData::get();
+
+    bBulkSearch_ = true;
+    nb_.setCutoff(data.cutoff_);
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_ClusterPair);
+    gmx::AnalysisNeighborhoodSearch search =
+        nb_.initSearch(&data.pbc_, data.refPositions());
+    ASSERT_EQ(gmx::AnalysisNeighborhood::eSearchMode_Grid, search.mode());
+
+    testPairSearch(&search, data);
+}
+
+TEST_F(NeighborhoodSearchTest, BufferedSimpleSearch)
+{
+    const NeighborhoodSearchTestData &data = RandomBoxFullPBCData::get();
+
+    nb_.setCutoff(data.cutoff_);
+    nb_.setPairListBuffer(0.1);
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_Simple);
+    testBufferedPairSearch(data, false);
+}
+
+TEST_F(NeighborhoodSearchTest, BufferedGridSearchBox)
+{
+    const NeighborhoodSearchTestData &data = RandomBoxFullPBCData::get();
+
+    nb_.setCutoff(data.cutoff_);
+    nb_.setPairListBuffer(0.1);
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_Grid);
+    testBufferedPairSearch(data, false);
+}
+
+TEST_F(NeighborhoodSearchTest, BufferedGridSearchTriclinic)
+{
+    const NeighborhoodSearchTestData &data = RandomTriclinicFullPBCData::get();
+
+    nb_.setCutoff(data.cutoff_);
+    nb_.setPairListBuffer(0.1);
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_Grid);
+    testBufferedPairSearch(data, false);
+}
+
+TEST_F(NeighborhoodSearchTest, BufferedGridSearchNoPBC)
+{
+    const NeighborhoodSearchTestData &data = RandomBoxNoPBCData::get();
+
+    nb_.setCutoff(data.cutoff_);
+    nb_.setPairListBuffer(0.1);
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_Grid);
+    testBufferedPairSearch(data, false);
+}
+
+TEST_F(NeighborhoodSearchTest, BufferedGridSelfPairsSearch)
+{
+    const NeighborhoodSearchTestData &data = RandomBoxSelfPairsData::get();
+
+    nb_.setCutoff(data.cutoff_);
+    nb_.setPairListBuffer(0.1);
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_Grid);
+    testBufferedPairSearch(data, true);
+}
+
+TEST_F(NeighborhoodSearchTest, BufferedClusterPairSearch)
+{
+    const NeighborhoodSearchTestData &data = RandomBoxFullPBCData::get();
+
+    nb_.setCutoff(data.cutoff_);
+    nb_.setPairListBuffer(0.1);
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_ClusterPair);
+    testBufferedPairSearch(data, false);
+}
+
 TEST_F(NeighborhoodSearchTest, HandlesConcurrentSearches)
 {
     const NeighborhoodSearchTestData &data = TrivialTestData::get();
@@ -1184,6 +1609,58 @@ TEST_F(NeighborhoodSearchTest, SimpleSearchExclusions)
                        {}, false);
 }
 
+TEST_F(NeighborhoodSearchTest, BulkSearchExclusions)
+{
+    const NeighborhoodSearchTestData &data = RandomBoxFullPBCData::get();
+
+    ExclusionsHelper                  helper(data.refPosCount_, data.testPositions_.size());
+    helper.generateExclusions();
+
+    bBulkSearch_ = true;
+    nb_.setCutoff(data.cutoff_);
+    nb_.setTopologyExclusions(helper.exclusions());
+    for (auto mode : {gmx::AnalysisNeighborhood::eSearchMode_Simple,
+                      gmx::AnalysisNeighborhood::eSearchMode_Grid})
+    {
+        nb_.setMode(mode);
+        gmx::AnalysisNeighborhoodSearch search =
+            nb_.initSearch(&data.pbc_,
+                           data.refPositions().exclusionIds(helper.refPosIds()));
+        ASSERT_EQ(mode, search.mode());
+
+        testPairSearchFull(&search, data,
+                           data.testPositions().exclusionIds(helper.testPosIds()),
+                           helper.exclusions(), {},
+                           {}, false);
+    }
+}
+
+TEST_F(NeighborhoodSearchTest, ClusterPairSearchExclusions)
+{
+    const NeighborhoodSearchTestData &data = RandomBoxFullPBCData::get();
+
+    ExclusionsHelper                  helper(data.refPosCount_, data.testPositions_.size());
+    helper.generateExclusions();
+
+    nb_.setCutoff(data.cutoff_);
+    nb_.setTopologyExclusions(helper.exclusions());
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_ClusterPair);
+    gmx::AnalysisNeighborhoodSearch search =
+        nb_.initSearch(&data.pbc_,
+                       data.refPositions().exclusionIds(helper.refPosIds()));
+    ASSERT_EQ(gmx::AnalysisNeighborhood::eSearchMode_ClusterPair, search.mode());
+
+    testPairSearchFull(&search, data,
+                       data.testPositions().exclusionIds(helper.testPosIds()),
+                       helper.exclusions(), {},
+                       {}, false);
+    bBulkSearch_ = true;
+    testPairSearchFull(&search, data,
+                       data.testPositions().exclusionIds(helper.testPosIds()),
+                       helper.exclusions(), {},
+                       {}, false);
+}
+
 TEST_F(NeighborhoodSearchTest, GridSearchExclusions)
 {
     const NeighborhoodSearchTestData &data = RandomBoxFullPBCData::get();
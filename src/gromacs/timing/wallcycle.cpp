@@ -134,6 +134,8 @@ static const char *wcsn[ewcsNR] =
     "NB X buffer ops.",
     "NB F buffer ops.",
     "Clear force buffer",
+    "Comm. coord. dim 1", "Comm. coord. dim 2", "Comm. coord. dim 3",
+    "Comm. force dim 1", "Comm. force dim 2", "Comm. force dim 3",
     "Test subcounter",
 };
 
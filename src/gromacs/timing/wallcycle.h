@@ -80,6 +80,8 @@ enum {
     ewcsNB_X_BUF_OPS,
     ewcsNB_F_BUF_OPS,
     ewcsCLEAR_FORCE_BUFFER,
+    ewcsMOVEX_DIM0, ewcsMOVEX_DIM1, ewcsMOVEX_DIM2,
+    ewcsMOVEF_DIM0, ewcsMOVEF_DIM1, ewcsMOVEF_DIM2,
     ewcsTEST,
     ewcsNR
 };
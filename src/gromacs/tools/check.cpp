@@ -46,12 +46,14 @@
 #include "gromacs/fileio/confio.h"
 #include "gromacs/fileio/enxio.h"
 #include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/trajectoryframeindex.h"
 #include "gromacs/fileio/tpxio.h"
 #include "gromacs/fileio/trxio.h"
 #include "gromacs/fileio/xtcio.h"
 #include "gromacs/math/functions.h"
 #include "gromacs/math/units.h"
 #include "gromacs/math/vec.h"
+#include "gromacs/math/vectypes.h"
 #include "gromacs/mdrun/mdmodules.h"
 #include "gromacs/mdtypes/inputrec.h"
 #include "gromacs/mdtypes/md_enums.h"
@@ -65,6 +67,7 @@
 #include "gromacs/topology/topology.h"
 #include "gromacs/trajectory/energyframe.h"
 #include "gromacs/trajectory/trajectoryframe.h"
+#include "gromacs/utility/arrayref.h"
 #include "gromacs/utility/arraysize.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
@@ -175,7 +178,7 @@ static void comp_trx(const gmx_output_env_t *oenv, const char *fn1, const char *
     }
 }
 
-static void chk_coords(int frame, int natoms, rvec *x, matrix box, real fac, real tol)
+static void chk_coords(int frame, int natoms, const rvec *x, matrix box, real fac, real tol)
 {
     int  i, j;
     int  nNul = 0;
@@ -205,7 +208,7 @@ static void chk_coords(int frame, int natoms, rvec *x, matrix box, real fac, rea
     }
 }
 
-static void chk_vels(int frame, int natoms, rvec *v)
+static void chk_vels(int frame, int natoms, const rvec *v)
 {
     int i, j;
 
@@ -222,7 +225,7 @@ static void chk_vels(int frame, int natoms, rvec *v)
     }
 }
 
-static void chk_forces(int frame, int natoms, rvec *f)
+static void chk_forces(int frame, int natoms, const rvec *f)
 {
     int i, j;
 
@@ -239,7 +242,7 @@ static void chk_forces(int frame, int natoms, rvec *f)
     }
 }
 
-static void chk_bonds(t_idef *idef, int ePBC, rvec *x, matrix box, real tol)
+static void chk_bonds(t_idef *idef, int ePBC, const rvec *x, matrix box, real tol)
 {
     int   ftype, k, ai, aj, type;
     real  b0, blen, deviation;
@@ -344,10 +347,18 @@ static void chk_trj(const gmx_output_env_t *oenv, const char *fn, const char *tp
     last.bF      = 0;
     last.bBox    = 0;
 
-    read_first_frame(oenv, &status, fn, &fr, TRX_READ_X | TRX_READ_V | TRX_READ_F);
+    /* Check trr frames in place in the memory-mapped file, without copying */
+    read_first_frame(oenv, &status, fn, &fr, TRX_READ_X | TRX_READ_V | TRX_READ_F | TRX_MAPPED_VIEWS);
 
     do
     {
+        gmx::ArrayRef<const gmx::RVec> x, v, f;
+        if (!trx_get_mapped_frame_views(status, &x, &v, &f))
+        {
+            x = gmx::arrayRefFromArray(reinterpret_cast<const gmx::RVec *>(fr.x), fr.bX ? fr.natoms : 0);
+            v = gmx::arrayRefFromArray(reinterpret_cast<const gmx::RVec *>(fr.v), fr.bV ? fr.natoms : 0);
+            f = gmx::arrayRefFromArray(reinterpret_cast<const gmx::RVec *>(fr.f), fr.bF ? fr.natoms : 0);
+        }
         if (j == 0)
         {
             fprintf(stderr, "\n# Atoms  %d\n", fr.natoms);
@@ -376,19 +387,19 @@ static void chk_trj(const gmx_output_env_t *oenv, const char *fn, const char *tp
         natoms = new_natoms;
         if (tpr)
         {
-            chk_bonds(&top.idef, ir.ePBC, fr.x, fr.box, tol);
+            chk_bonds(&top.idef, ir.ePBC, as_rvec_array(x.data()), fr.box, tol);
         }
         if (fr.bX)
         {
-            chk_coords(j, natoms, fr.x, fr.box, 1e5, tol);
+            chk_coords(j, natoms, as_rvec_array(x.data()), fr.box, 1e5, tol);
         }
         if (fr.bV)
         {
-            chk_vels(j, natoms, fr.v);
+            chk_vels(j, natoms, as_rvec_array(v.data()));
         }
         if (fr.bF)
         {
-            chk_forces(j, natoms, fr.f);
+            chk_forces(j, natoms, as_rvec_array(f.data()));
         }
 
         old_t2 = old_t1;
@@ -721,6 +732,21 @@ static void chk_enx(const char *fn)
     sfree(fr);
 }
 
+static void write_frame_index(const char *fn)
+{
+    if (!gmx::TrajectoryFrameIndex::isSupportedFormat(fn))
+    {
+        gmx_fatal(FARGS, "A frame index can only be written for xtc and trr files");
+    }
+    gmx::TrajectoryFrameIndex index(fn);
+    index.readSidecar();
+    index.update();
+    index.writeSidecar();
+    fprintf(stderr, "Wrote index of %" PRId64 " frames to %s\n",
+            index.frameCount(),
+            gmx::TrajectoryFrameIndex::sidecarFileName(fn).c_str());
+}
+
 int gmx_check(int argc, char *argv[])
 {
     const char       *desc[] = {
@@ -751,7 +777,15 @@ int gmx_check(int argc, char *argv[])
         "Similarly a pair of trajectory files can be compared (using the [TT]-f2[tt]",
         "option), or a pair of energy files (using the [TT]-e2[tt] option).[PAR]",
         "For free energy simulations the A and B state topology from one",
-        "run input file can be compared with options [TT]-s1[tt] and [TT]-ab[tt].[PAR]"
+        "run input file can be compared with options [TT]-s1[tt] and [TT]-ab[tt].[PAR]",
+        "Option [TT]-frameindex[tt] writes an index of the frames in an",
+        "[REF].xtc[ref] or [REF].trr[ref] file given with [TT]-f[tt] to a file with",
+        "the extension [TT].gmxidx[tt] appended. Tools reading the trajectory",
+        "use this index to start at the time given with [TT]-b[tt] without",
+        "reading the preceding frames. An existing index is extended with",
+        "frames appended to the trajectory after it was written.",
+        "[TT]gmx mdrun[tt] writes and extends this index for its own",
+        "[REF].xtc[ref] and [REF].trr[ref] output at every checkpoint."
     };
     t_filenm          fnm[] = {
         { efTRX, "-f",  nullptr, ffOPTRD },
@@ -768,15 +802,16 @@ int gmx_check(int argc, char *argv[])
     const char       *fn1 = nullptr, *fn2 = nullptr, *tex = nullptr;
 
     gmx_output_env_t *oenv;
-    static real       vdw_fac  = 0.8;
-    static real       bon_lo   = 0.4;
-    static real       bon_hi   = 0.7;
-    static gmx_bool   bRMSD    = FALSE;
-    static real       ftol     = 0.001;
-    static real       abstol   = 0.001;
-    static gmx_bool   bCompAB  = FALSE;
-    static char      *lastener = nullptr;
-    static t_pargs    pa[]     = {
+    static real       vdw_fac     = 0.8;
+    static real       bon_lo      = 0.4;
+    static real       bon_hi      = 0.7;
+    static gmx_bool   bRMSD       = FALSE;
+    static real       ftol        = 0.001;
+    static real       abstol      = 0.001;
+    static gmx_bool   bCompAB     = FALSE;
+    static char      *lastener    = nullptr;
+    static gmx_bool   bFrameIndex = FALSE;
+    static t_pargs    pa[]        = {
         { "-vdwfac", FALSE, etREAL, {&vdw_fac},
           "Fraction of sum of VdW radii used as warning cutoff" },
         { "-bonlo",  FALSE, etREAL, {&bon_lo},
@@ -792,7 +827,9 @@ int gmx_check(int argc, char *argv[])
         { "-ab",     FALSE, etBOOL, {&bCompAB},
           "Compare the A and B topology from one file" },
         { "-lastener", FALSE, etSTR,  {&lastener},
-          "Last energy term to compare (if not given all are tested). It makes sense to go up until the Pressure." }
+          "Last energy term to compare (if not given all are tested). It makes sense to go up until the Pressure." },
+        { "-frameindex", FALSE, etBOOL, {&bFrameIndex},
+          "Write a frame index for the xtc or trr trajectory" }
     };
 
     if (!parse_common_args(&argc, argv, 0, NFILE, fnm, asize(pa), pa,
@@ -814,6 +851,10 @@ int gmx_check(int argc, char *argv[])
     {
         comp_trx(oenv, fn1, fn2, bRMSD, ftol, abstol);
     }
+    else if (fn1 && bFrameIndex)
+    {
+        write_frame_index(fn1);
+    }
     else if (fn1)
     {
         chk_trj(oenv, fn1, opt2fn_null("-s1", NFILE, fnm), ftol);
@@ -126,6 +126,18 @@ class TrajectoryAnalysisSettings
              * \see setRmPBC()
              */
             efNoUserRmPBC    = 1<<5,
+            /*! \brief
+             * Allows analyzing multiple frames concurrently.
+             *
+             * If this flag is specified, the module declares that its
+             * TrajectoryAnalysisModule::analyzeFrame() only accesses
+             * frame-local data through the TrajectoryAnalysisModuleData
+             * object (data handles, selections from parallelSelection(), and
+             * data in derived classes created in startFrames()), and is
+             * otherwise thread-safe.  The user can then request frame-parallel
+             * analysis with the `-nt` option.
+             */
+            efFrameParallel  = 1<<6,
         };
 
         //! Initializes default settings.
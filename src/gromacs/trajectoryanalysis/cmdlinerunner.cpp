@@ -43,9 +43,14 @@
 
 #include "cmdlinerunner.h"
 
+#include <exception>
+#include <memory>
+#include <vector>
+
 #include "gromacs/analysisdata/paralleloptions.h"
 #include "gromacs/commandline/cmdlinemodulemanager.h"
 #include "gromacs/commandline/cmdlineoptionsmodule.h"
+#include "gromacs/math/vectypes.h"
 #include "gromacs/options/ioptionscontainer.h"
 #include "gromacs/options/timeunitmanager.h"
 #include "gromacs/pbcutil/pbc.h"
@@ -67,6 +72,59 @@ namespace gmx
 namespace
 {
 
+/********************************************************************
+ * FrameBuffer
+ */
+
+/*! \brief
+ * Keeps a private copy of a trajectory frame for frame-parallel analysis.
+ *
+ * The coordinate buffers are reused for subsequent frames, so that no memory
+ * is allocated per frame after the first batch.
+ */
+class FrameBuffer
+{
+    public:
+        FrameBuffer() : frame_(), pbc_() {}
+
+        /*! \brief
+         * Copies \p source into the buffer.
+         *
+         * Atom index information (\p source.index) is not copied, as it
+         * stays constant over the trajectory.
+         */
+        void copyFrom(const t_trxframe &source)
+        {
+            frame_ = source;
+            frame_.x = copyVectors(source.bX ? source.x : nullptr, source.natoms, &x_);
+            frame_.v = copyVectors(source.bV ? source.v : nullptr, source.natoms, &v_);
+            frame_.f = copyVectors(source.bF ? source.f : nullptr, source.natoms, &f_);
+        }
+
+        //! Returns the copied frame.
+        t_trxframe &frame() { return frame_; }
+        //! Returns the PBC structure for the copied frame.
+        t_pbc *pbc() { return &pbc_; }
+
+    private:
+        //! Copies \p n vectors from \p source into \p buffer, if non-NULL.
+        static rvec *copyVectors(const rvec *source, int n, std::vector<RVec> *buffer)
+        {
+            if (source == nullptr)
+            {
+                return nullptr;
+            }
+            buffer->assign(source, source + n);
+            return as_rvec_array(buffer->data());
+        }
+
+        t_trxframe         frame_;
+        t_pbc              pbc_;
+        std::vector<RVec>  x_;
+        std::vector<RVec>  v_;
+        std::vector<RVec>  f_;
+};
+
 /********************************************************************
  * RunnerModule
  */
@@ -85,6 +143,26 @@ class RunnerModule : public ICommandLineOptionsModule
         void optionsFinished() override;
         int run() override;
 
+        /*! \brief
+         * Analyzes all frames in serial.
+         *
+         * \returns Number of frames analyzed.
+         */
+        int analyzeFramesSerial();
+        /*! \brief
+         * Analyzes all frames in batches of frames processed concurrently.
+         *
+         * \param[in] threadCount  Number of threads to use.
+         * \returns Number of frames analyzed.
+         *
+         * The frames are read and the selections evaluated in serial; a
+         * frame-local copy of the frame and the selections is then made for
+         * each frame in the batch, and analyzeFrame() is called for the
+         * frames in parallel.  The data objects are notified in frame order
+         * after each batch through finishFrameSerial().
+         */
+        int analyzeFramesParallel(int threadCount);
+
         TrajectoryAnalysisModulePointer module_;
         TrajectoryAnalysisSettings      settings_;
         TrajectoryAnalysisRunnerCommon  common_;
@@ -117,19 +195,11 @@ void RunnerModule::optionsFinished()
     module_->optionsFinished(&settings_);
 }
 
-int RunnerModule::run()
+int RunnerModule::analyzeFramesSerial()
 {
-    common_.initTopology();
     const TopologyInformation &topology = common_.topologyInformation();
-    module_->initAnalysis(settings_, topology);
-
-    // Load first frame.
-    common_.initFirstFrame();
-    common_.initFrameIndexGroup();
-    module_->initAfterFirstFrame(settings_, common_.frame());
-
-    t_pbc  pbc;
-    t_pbc *ppbc = settings_.hasPBC() ? &pbc : nullptr;
+    t_pbc                      pbc;
+    t_pbc                     *ppbc = settings_.hasPBC() ? &pbc : nullptr;
 
     int    nframes = 0;
     AnalysisDataParallelOptions         dataOptions;
@@ -157,6 +227,104 @@ int RunnerModule::run()
         pdata->finish();
     }
     pdata.reset();
+    return nframes;
+}
+
+int RunnerModule::analyzeFramesParallel(int threadCount)
+{
+    const TopologyInformation &topology  = common_.topologyInformation();
+    const bool                 bPBC      = settings_.hasPBC();
+    const int                  batchSize = threadCount;
+
+    AnalysisDataParallelOptions                       dataOptions(batchSize);
+    std::vector<FrameBuffer>                          frames(batchSize);
+    std::vector<std::unique_ptr<SelectionCollection>> frameSelections;
+    std::vector<TrajectoryAnalysisModuleDataPointer>  pdata;
+    std::vector<std::exception_ptr>                   exceptions(batchSize);
+    for (int i = 0; i < batchSize; ++i)
+    {
+        frameSelections.push_back(std::make_unique<SelectionCollection>());
+        frameSelections.back()->initFrameLocalCopy(selections_);
+        pdata.push_back(module_->startFrames(dataOptions, *frameSelections.back()));
+    }
+
+    int  nframes = 0;
+    bool bMore   = true;
+    while (bMore)
+    {
+        int count = 0;
+        while (bMore && count < batchSize)
+        {
+            common_.initFrame();
+            t_trxframe  &frame = common_.frame();
+            FrameBuffer &local = frames[count];
+            t_pbc       *ppbc  = bPBC ? local.pbc() : nullptr;
+            if (ppbc != nullptr)
+            {
+                set_pbc(ppbc, topology.ePBC(), frame.box);
+            }
+            selections_.evaluate(&frame, ppbc);
+            frameSelections[count]->copyFrameState();
+            local.copyFrom(frame);
+            ++count;
+            bMore = common_.readNextFrame();
+        }
+
+#pragma omp parallel for num_threads(threadCount) schedule(dynamic, 1)
+        for (int i = 0; i < count; ++i)
+        {
+            try
+            {
+                FrameBuffer &local = frames[i];
+                module_->analyzeFrame(nframes + i, local.frame(),
+                                      bPBC ? local.pbc() : nullptr,
+                                      pdata[i].get());
+            }
+            catch (...)
+            {
+                exceptions[i] = std::current_exception();
+            }
+        }
+        for (int i = 0; i < count; ++i)
+        {
+            if (exceptions[i])
+            {
+                std::rethrow_exception(exceptions[i]);
+            }
+        }
+        for (int i = 0; i < count; ++i)
+        {
+            module_->finishFrameSerial(nframes + i);
+        }
+        nframes += count;
+    }
+    for (auto &data : pdata)
+    {
+        module_->finishFrames(data.get());
+        if (data != nullptr)
+        {
+            data->finish();
+        }
+        data.reset();
+    }
+    return nframes;
+}
+
+int RunnerModule::run()
+{
+    common_.initTopology();
+    const TopologyInformation &topology = common_.topologyInformation();
+    module_->initAnalysis(settings_, topology);
+
+    // Load first frame.
+    common_.initFirstFrame();
+    common_.initFrameIndexGroup();
+    module_->initAfterFirstFrame(settings_, common_.frame());
+
+    const int threadCount = common_.threadCount();
+    const int nframes     = (threadCount > 1
+                             ? analyzeFramesParallel(threadCount)
+                             : analyzeFramesSerial());
 
     if (common_.hasTrajectory())
     {
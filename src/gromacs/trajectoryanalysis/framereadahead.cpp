@@ -0,0 +1,263 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements gmx::TrajectoryFrameReadAhead.
+ *
+ * \ingroup module_trajectoryanalysis
+ */
+#include "gmxpre.h"
+
+#include "framereadahead.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gromacs/fileio/trxio.h"
+#include "gromacs/trajectory/trajectoryframe.h"
+#include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/smalloc.h"
+
+namespace gmx
+{
+
+/********************************************************************
+ * TrajectoryFrameReadAhead::Impl
+ */
+
+/*! \internal \brief
+ * Private implementation class for TrajectoryFrameReadAhead.
+ *
+ * \ingroup module_trajectoryanalysis
+ */
+class TrajectoryFrameReadAhead::Impl
+{
+    public:
+        //! \copydoc TrajectoryFrameReadAhead::TrajectoryFrameReadAhead()
+        Impl(const gmx_output_env_t *oenv, t_trxstatus *status,
+             const t_trxframe &frame, int depth, FrameProcessor processor);
+        ~Impl();
+
+        //! Main loop of the reader thread.
+        void readFrames();
+        //! \copydoc TrajectoryFrameReadAhead::nextFrame()
+        t_trxframe *nextFrame();
+
+        //! Output environment for read_next_frame().
+        const gmx_output_env_t     *oenv_;
+        //! Trajectory being read; only accessed from the reader thread.
+        t_trxstatus                *status_;
+        //! Callback to call in the reader thread for each frame.
+        FrameProcessor              processor_;
+        /*! \brief
+         * Frame buffers.
+         *
+         * Not resized after construction, so pointers to the elements stay
+         * valid.
+         */
+        std::vector<t_trxframe>     frames_;
+        //! Buffers that the reader thread can read into.
+        std::deque<t_trxframe *>    freeFrames_;
+        //! Frames that have been read, but not yet returned from nextFrame().
+        std::deque<t_trxframe *>    readyFrames_;
+        //! Frame last returned from nextFrame(), or `nullptr`.
+        t_trxframe                 *currentFrame_;
+        //! Whether the reader thread has stopped reading.
+        bool                        bFinished_;
+        //! Whether the reader thread has been asked to stop.
+        bool                        bStop_;
+        //! Exception thrown in the reader thread, if any.
+        std::exception_ptr          exception_;
+        //! Protects the queues and the flags above.
+        std::mutex                  mutex_;
+        //! Signals changes in the queues and the flags.
+        std::condition_variable     cond_;
+        //! The reader thread.
+        std::thread                 thread_;
+};
+
+TrajectoryFrameReadAhead::Impl::Impl(
+        const gmx_output_env_t *oenv, t_trxstatus *status,
+        const t_trxframe &frame, int depth, FrameProcessor processor)
+    : oenv_(oenv), status_(status), processor_(std::move(processor)),
+      currentFrame_(nullptr), bFinished_(false), bStop_(false)
+{
+    GMX_RELEASE_ASSERT(depth >= 1, "Read-ahead depth must be positive");
+    // One buffer more than the depth, as the caller holds on to one.
+    frames_.resize(depth + 1, frame);
+    for (t_trxframe &buffer : frames_)
+    {
+        buffer.x = nullptr;
+        buffer.v = nullptr;
+        buffer.f = nullptr;
+        if (frame.x != nullptr)
+        {
+            snew(buffer.x, frame.natoms);
+        }
+        if (frame.v != nullptr)
+        {
+            snew(buffer.v, frame.natoms);
+        }
+        if (frame.f != nullptr)
+        {
+            snew(buffer.f, frame.natoms);
+        }
+        freeFrames_.push_back(&buffer);
+    }
+    thread_ = std::thread([this] { readFrames(); });
+}
+
+TrajectoryFrameReadAhead::Impl::~Impl()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        bStop_ = true;
+    }
+    cond_.notify_all();
+    thread_.join();
+    for (t_trxframe &buffer : frames_)
+    {
+        sfree(buffer.x);
+        sfree(buffer.v);
+        sfree(buffer.f);
+    }
+}
+
+void TrajectoryFrameReadAhead::Impl::readFrames()
+{
+    try
+    {
+        while (true)
+        {
+            t_trxframe *frame;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cond_.wait(lock, [this] { return bStop_ || !freeFrames_.empty(); });
+                if (bStop_)
+                {
+                    return;
+                }
+                frame = freeFrames_.front();
+                freeFrames_.pop_front();
+            }
+            const bool bRead = read_next_frame(oenv_, status_, frame);
+            if (bRead && processor_)
+            {
+                processor_(frame);
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (bRead)
+                {
+                    readyFrames_.push_back(frame);
+                }
+                else
+                {
+                    freeFrames_.push_back(frame);
+                    bFinished_ = true;
+                }
+            }
+            cond_.notify_all();
+            if (!bRead)
+            {
+                return;
+            }
+        }
+    }
+    catch (...)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            exception_ = std::current_exception();
+            bFinished_ = true;
+        }
+        cond_.notify_all();
+    }
+}
+
+t_trxframe *TrajectoryFrameReadAhead::Impl::nextFrame()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this] { return bFinished_ || !readyFrames_.empty(); });
+    if (readyFrames_.empty())
+    {
+        if (exception_)
+        {
+            std::exception_ptr exception = exception_;
+            exception_ = nullptr;
+            std::rethrow_exception(exception);
+        }
+        return nullptr;
+    }
+    if (currentFrame_ != nullptr)
+    {
+        freeFrames_.push_back(currentFrame_);
+    }
+    currentFrame_ = readyFrames_.front();
+    readyFrames_.pop_front();
+    lock.unlock();
+    cond_.notify_all();
+    return currentFrame_;
+}
+
+/********************************************************************
+ * TrajectoryFrameReadAhead
+ */
+
+TrajectoryFrameReadAhead::TrajectoryFrameReadAhead(
+        const gmx_output_env_t *oenv,
+        t_trxstatus            *status,
+        const t_trxframe       &frame,
+        int                     depth,
+        FrameProcessor          processor)
+    : impl_(new Impl(oenv, status, frame, depth, std::move(processor)))
+{
+}
+
+TrajectoryFrameReadAhead::~TrajectoryFrameReadAhead()
+{
+}
+
+t_trxframe *TrajectoryFrameReadAhead::nextFrame()
+{
+    return impl_->nextFrame();
+}
+
+} // namespace gmx
@@ -0,0 +1,135 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Declares gmx::TrajectoryFrameReadAhead.
+ *
+ * \ingroup module_trajectoryanalysis
+ */
+#ifndef GMX_TRAJECTORYANALYSIS_FRAMEREADAHEAD_H
+#define GMX_TRAJECTORYANALYSIS_FRAMEREADAHEAD_H
+
+#include <functional>
+
+#include "gromacs/utility/classhelpers.h"
+
+struct gmx_output_env_t;
+struct t_trxframe;
+struct t_trxstatus;
+
+namespace gmx
+{
+
+/*! \internal
+ * \brief
+ * Reads trajectory frames in a background thread.
+ *
+ * Decoding a compressed trajectory frame can take a significant fraction of
+ * the time for lightweight analyses.  This class moves the calls to
+ * read_next_frame() into a separate thread, so that the next few frames are
+ * decoded while the current one is being analyzed.
+ *
+ * A fixed pool of frame buffers is allocated at construction, all with the
+ * same layout as the frame passed to the constructor.  The reader thread
+ * fills free buffers and queues them; nextFrame() hands out the queued frames
+ * in order and recycles the previously returned one.  At most \p depth frames
+ * are read ahead of the frame that the caller is processing.
+ *
+ * After construction, the trajectory status object is accessed only from the
+ * reader thread, and the caller must not access it until this object has been
+ * destroyed.
+ *
+ * \ingroup module_trajectoryanalysis
+ */
+class TrajectoryFrameReadAhead
+{
+    public:
+        /*! \brief
+         * Callback for processing a frame in the reader thread.
+         *
+         * Is called for each frame after it has been read, before it is
+         * made available to the caller.  Calls are made in frame order.
+         */
+        typedef std::function<void(t_trxframe *)> FrameProcessor;
+
+        /*! \brief
+         * Allocates the frame buffers and starts the reader thread.
+         *
+         * \param[in] oenv      Output environment for read_next_frame().
+         * \param[in] status    Trajectory to read from; must already be open.
+         * \param[in] frame     Frame that determines the layout of the
+         *     buffers (number of atoms, presence of v and f, and the index).
+         * \param[in] depth     Maximum number of frames to read ahead (>= 1).
+         * \param[in] processor Callback for processing each frame in the
+         *     reader thread (can be empty).
+         *
+         * The index array of \p frame is shared with the buffers, and must
+         * remain valid for the lifetime of this object.
+         */
+        TrajectoryFrameReadAhead(const gmx_output_env_t *oenv,
+                                 t_trxstatus            *status,
+                                 const t_trxframe       &frame,
+                                 int                     depth,
+                                 FrameProcessor          processor);
+        /*! \brief
+         * Stops the reader thread and frees the frame buffers.
+         *
+         * If the reader thread is in the middle of reading a frame, waits
+         * until that completes.
+         */
+        ~TrajectoryFrameReadAhead();
+
+        /*! \brief
+         * Returns the next frame from the trajectory.
+         *
+         * \returns The next frame, or `nullptr` if there are no more frames.
+         * \throws  unspecified Any exception thrown in the reader thread
+         *     is rethrown here.
+         *
+         * Blocks until the next frame has been read.  The frame returned by
+         * the previous call is recycled, and must no longer be accessed.
+         * When the trajectory ends, the last returned frame stays valid.
+         */
+        t_trxframe *nextFrame();
+
+    private:
+        class Impl;
+
+        PrivateImplPointer<Impl> impl_;
+};
+
+} // namespace gmx
+
+#endif
@@ -192,6 +192,7 @@ class Rdf : public TrajectoryAnalysisModule
         double                                    binwidth_;
         double                                    cutoff_;
         double                                    rmax_;
+        double                                    pairListBuffer_;
         Normalization                             normalization_;
         bool                                      bNormalizationSet_;
         bool                                      bXY_;
@@ -210,7 +211,7 @@ Rdf::Rdf()
       pairCounts_(new AnalysisDataSimpleHistogramModule()),
       normAve_(new AnalysisDataAverageModule()),
       localTop_(nullptr),
-      binwidth_(0.002), cutoff_(0.0), rmax_(0.0),
+      binwidth_(0.002), cutoff_(0.0), rmax_(0.0), pairListBuffer_(0.0),
       normalization_(Normalization_Rdf), bNormalizationSet_(false), bXY_(false),
       bExclusions_(false),
       cut2_(0.0), rmax2_(0.0), surfaceGroupCount_(0)
@@ -244,6 +245,13 @@ Rdf::initOptions(IOptionsContainer *options, TrajectoryAnalysisSettings *setting
         "up to the default (half of the box size with PBC, three times the",
         "box size without PBC).",
         "",
+        "For trajectories with closely spaced frames, [TT]-nbbuf[tt] can",
+        "make the neighbor searching faster: the pairs within [TT]-rmax[tt]",
+        "plus the buffer are kept, and only searched again when some position",
+        "has moved more than half the buffer. The buffer is only used when",
+        "all selections are static, and not with [TT]-surf[tt]. It does not",
+        "change the results.",
+        "",
         "To use exclusions from the topology ([TT]-s[tt]), set [TT]-excl[tt]",
         "and ensure that both [TT]-ref[tt] and [TT]-sel[tt] only select atoms.",
         "A rougher alternative to exclude intra-molecular peaks is to set",
@@ -279,6 +287,7 @@ Rdf::initOptions(IOptionsContainer *options, TrajectoryAnalysisSettings *setting
     };
 
     settings->setHelpText(desc);
+    settings->setFlag(TrajectoryAnalysisSettings::efFrameParallel);
 
     options->addOption(FileNameOption("o").filetype(eftPlot).outputFile().required()
                            .store(&fnRdf_).defaultBasename("rdf")
@@ -301,6 +310,8 @@ Rdf::initOptions(IOptionsContainer *options, TrajectoryAnalysisSettings *setting
                            .description("Shortest distance (nm) to be considered"));
     options->addOption(DoubleOption("rmax").store(&rmax_)
                            .description("Largest distance (nm) to calculate"));
+    options->addOption(DoubleOption("nbbuf").store(&pairListBuffer_)
+                           .description("Buffer (nm) for reusing neighbor lists between frames"));
 
     options->addOption(EnumOption<SurfaceType>("surf").enumValue(c_SurfaceEnum)
                            .store(&surface_)
@@ -351,6 +362,9 @@ Rdf::initAnalysis(const TrajectoryAnalysisSettings &settings,
     }
     plotSettings_ = settings.plotSettings();
     nb_.setXYMode(bXY_);
+    // Solvated systems benefit from the cluster-pair search; it falls back
+    // to the grid or simple search for XY mode or a too long -rmax.
+    nb_.setMode(AnalysisNeighborhood::eSearchMode_ClusterPair);
 
     normFactors_.setColumnCount(0, sel_.size() + 1);
 
@@ -385,6 +399,17 @@ Rdf::initAnalysis(const TrajectoryAnalysisSettings &settings,
         }
         nb_.setTopologyExclusions(&localTop_->excls);
     }
+
+    // The buffered pair lists assume the same positions in every frame.
+    bool bStatic = !refSel_.isDynamic();
+    for (const Selection &sel : sel_)
+    {
+        bStatic = bStatic && !sel.isDynamic();
+    }
+    if (pairListBuffer_ > 0 && !bSurface && bStatic)
+    {
+        nb_.setPairListBuffer(pairListBuffer_);
+    }
 }
 
 void
@@ -435,10 +460,12 @@ class RdfModuleData : public TrajectoryAnalysisModuleData
         RdfModuleData(TrajectoryAnalysisModule          *module,
                       const AnalysisDataParallelOptions &opt,
                       const SelectionCollection         &selections,
-                      int                                surfaceGroupCount)
+                      int                                surfaceGroupCount,
+                      int                                selectionCount)
             : TrajectoryAnalysisModuleData(module, opt, selections)
         {
             surfaceDist2_.resize(surfaceGroupCount);
+            pairs_.resize(selectionCount);
         }
 
         void finish() override { finishDataHandles(); }
@@ -454,7 +481,14 @@ class RdfModuleData : public TrajectoryAnalysisModuleData
          * to find the minimum distance to each surface group, and then compute
          * the RDF from these numbers.
          */
-        std::vector<real> surfaceDist2_;
+        std::vector<real>            surfaceDist2_;
+        /*! \brief
+         * Pairs found in the neighborhood search for each selection.
+         *
+         * Kept between frames to reuse the memory and, with -nbbuf, the
+         * buffered pair lists.
+         */
+        std::vector<AnalysisNeighborhoodPairList> pairs_;
 };
 
 TrajectoryAnalysisModuleDataPointer Rdf::startFrames(
@@ -462,7 +496,8 @@ TrajectoryAnalysisModuleDataPointer Rdf::startFrames(
         const SelectionCollection         &selections)
 {
     return TrajectoryAnalysisModuleDataPointer(
-            new RdfModuleData(this, opt, selections, surfaceGroupCount_));
+            new RdfModuleData(this, opt, selections, surfaceGroupCount_,
+                              sel_.size()));
 }
 
 void
@@ -565,9 +600,10 @@ Rdf::analyzeFrame(int frnr, const t_trxframe &fr, t_pbc *pbc,
         {
             // Standard neighborhood search over all pairs within the cutoff
             // for the -surf no case.
-            AnalysisNeighborhoodPairSearch pairSearch = nbsearch.startPairSearch(sel[g]);
-            AnalysisNeighborhoodPair       pair;
-            while (pairSearch.findNextPair(&pair))
+            // The histogram does not depend on the order of the pairs, so
+            // all of them can be found in one bulk search.
+            nbsearch.findAllPairs(sel[g], &frameData.pairs_[g]);
+            for (const AnalysisNeighborhoodPair &pair : frameData.pairs_[g].pairs())
             {
                 const real r2 = pair.distance2();
                 if (r2 > cut2_)
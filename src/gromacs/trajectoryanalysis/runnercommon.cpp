@@ -43,11 +43,15 @@
 
 #include "runnercommon.h"
 
+#include "config.h"
+
 #include <cstring>
 
 #include <algorithm>
+#include <memory>
 #include <string>
 
+#include "gromacs/fileio/filetypes.h"
 #include "gromacs/fileio/oenv.h"
 #include "gromacs/fileio/timecontrol.h"
 #include "gromacs/fileio/trxio.h"
@@ -67,11 +71,13 @@
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/programcontext.h"
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/stringutil.h"
 
 #include "analysissettings_impl.h"
+#include "framereadahead.h"
 
 namespace gmx
 {
@@ -87,8 +93,15 @@ class TrajectoryAnalysisRunnerCommon::Impl : public ITopologyProvider
         void initTopology(bool required);
         void initFirstFrame();
         void initFrameIndexGroup();
+        bool readNextFrame();
         void finishTrajectory();
 
+        //! Returns the frame that is currently being processed.
+        t_trxframe *currentFrame() const
+        {
+            return readAheadFrame_ != nullptr ? readAheadFrame_ : fr;
+        }
+
         // From ITopologyProvider
         gmx_mtop_t *getTopology(bool required) override
         {
@@ -125,6 +138,10 @@ class TrajectoryAnalysisRunnerCommon::Impl : public ITopologyProvider
         bool                        bStartTimeSet_;
         bool                        bEndTimeSet_;
         bool                        bDeltaTimeSet_;
+        //! Number of threads for frame-parallel analysis (0 = automatic).
+        int                         threadCount_;
+        //! Number of frames to read ahead in a background thread.
+        int                         readAheadDepth_;
 
         bool                        bTrajOpen_;
         //! The current frame, or \p NULL if no frame loaded yet.
@@ -133,6 +150,15 @@ class TrajectoryAnalysisRunnerCommon::Impl : public ITopologyProvider
         //! Used to store the status variable from read_first_frame().
         t_trxstatus                *status_;
         gmx_output_env_t           *oenv_;
+        //! Background reader, if used and started.
+        std::unique_ptr<TrajectoryFrameReadAhead> readAhead_;
+        /*! \brief
+         * The current frame, if it comes from \p readAhead_.
+         *
+         * PBC removal for such frames has already been done in the reader
+         * thread.
+         */
+        t_trxframe                 *readAheadFrame_;
 };
 
 
@@ -140,7 +166,8 @@ TrajectoryAnalysisRunnerCommon::Impl::Impl(TrajectoryAnalysisSettings *settings)
     : settings_(*settings),
       startTime_(0.0), endTime_(0.0), deltaTime_(0.0),
       bStartTimeSet_(false), bEndTimeSet_(false), bDeltaTimeSet_(false),
-      bTrajOpen_(false), fr(nullptr), gpbc_(nullptr), status_(nullptr), oenv_(nullptr)
+      threadCount_(1), readAheadDepth_(0), bTrajOpen_(false), fr(nullptr), gpbc_(nullptr),
+      status_(nullptr), oenv_(nullptr), readAheadFrame_(nullptr)
 {
 }
 
@@ -289,9 +316,64 @@ TrajectoryAnalysisRunnerCommon::Impl::initFrameIndexGroup()
               fr->index);
 }
 
+bool
+TrajectoryAnalysisRunnerCommon::Impl::readNextFrame()
+{
+    // Only the binary formats benefit from decoding in the background;
+    // the other readers may also touch state that is shared between
+    // frames (e.g., t_trxframe::atoms).
+    const int  ftp          = fn2ftp(trjfile_.c_str());
+    const bool bUseReadAhead
+        = readAheadDepth_ > 0 && (ftp == efXTC || ftp == efTRR);
+    if (!bUseReadAhead)
+    {
+        return read_next_frame(oenv_, status_, fr);
+    }
+    if (!readAhead_)
+    {
+        // The first frame has already been processed in initFrame(), so
+        // the removal of PBC can move to the reader thread from here on.
+        TrajectoryFrameReadAhead::FrameProcessor processor;
+        if (gpbc_ != nullptr)
+        {
+            gmx_rmpbc_t gpbc = gpbc_;
+            processor = [gpbc](t_trxframe *frame)
+                {
+                    gmx_rmpbc_trxfr(gpbc, frame);
+                };
+        }
+        readAhead_ = std::make_unique<TrajectoryFrameReadAhead>(
+                    oenv_, status_, *fr, readAheadDepth_, processor);
+    }
+    t_trxframe *frame = readAhead_->nextFrame();
+    if (frame == nullptr)
+    {
+        return false;
+    }
+    readAheadFrame_ = frame;
+    return true;
+}
+
 void
 TrajectoryAnalysisRunnerCommon::Impl::finishTrajectory()
 {
+    if (readAhead_)
+    {
+        // Keep the last frame accessible after the buffers are freed by
+        // swapping its contents into the frame owned by this object.
+        if (readAheadFrame_ != nullptr)
+        {
+            t_trxframe lastFrame = *readAheadFrame_;
+            readAheadFrame_->x = fr->x;
+            readAheadFrame_->v = fr->v;
+            readAheadFrame_->f = fr->f;
+            *fr                = lastFrame;
+            readAheadFrame_    = nullptr;
+        }
+        // This also stops the reader thread, which must happen before the
+        // trajectory is closed.
+        readAhead_.reset();
+    }
     if (bTrajOpen_)
     {
         close_trx(status_);
@@ -384,6 +466,13 @@ TrajectoryAnalysisRunnerCommon::initOptions(IOptionsContainer *options,
         options->addOption(BooleanOption("pbc").store(&settings.impl_->bPBC)
                                .description("Use periodic boundary conditions for distance calculation"));
     }
+    if (settings.hasFlag(TrajectoryAnalysisSettings::efFrameParallel))
+    {
+        options->addOption(IntegerOption("nt").store(&impl_->threadCount_)
+                               .description("Number of threads for analyzing frames in parallel (0 is guess)"));
+    }
+    options->addOption(IntegerOption("readahead").store(&impl_->readAheadDepth_)
+                           .description("Number of frames to decode ahead in a background thread (xtc and trr only, 0 to disable)"));
 }
 
 
@@ -400,6 +489,23 @@ TrajectoryAnalysisRunnerCommon::optionsFinished()
         GMX_THROW(InconsistentInputError("-fgroup only makes sense together with a trajectory (-f)"));
     }
 
+    if (impl_->readAheadDepth_ < 0)
+    {
+        GMX_THROW(InvalidInputError("-readahead should not be negative"));
+    }
+    if (impl_->threadCount_ < 0)
+    {
+        GMX_THROW(InvalidInputError("-nt should not be negative"));
+    }
+    if (impl_->threadCount_ == 0)
+    {
+        impl_->threadCount_ = gmx_omp_get_max_threads();
+    }
+    if (!GMX_OPENMP && impl_->threadCount_ > 1)
+    {
+        GMX_THROW(InvalidInputError("Frame-parallel analysis (-nt > 1) requires a build with OpenMP support"));
+    }
+
     impl_->settings_.impl_->plotSettings.setTimeUnit(impl_->settings_.timeUnit());
 
     if (impl_->bStartTimeSet_)
@@ -446,7 +552,7 @@ TrajectoryAnalysisRunnerCommon::readNextFrame()
     bool bContinue = false;
     if (hasTrajectory())
     {
-        bContinue = read_next_frame(impl_->oenv_, impl_->status_, impl_->fr);
+        bContinue = impl_->readNextFrame();
     }
     if (!bContinue)
     {
@@ -459,7 +565,7 @@ TrajectoryAnalysisRunnerCommon::readNextFrame()
 void
 TrajectoryAnalysisRunnerCommon::initFrame()
 {
-    if (impl_->gpbc_ != nullptr)
+    if (impl_->gpbc_ != nullptr && impl_->readAheadFrame_ == nullptr)
     {
         gmx_rmpbc_trxfr(impl_->gpbc_, impl_->fr);
     }
@@ -473,6 +579,17 @@ TrajectoryAnalysisRunnerCommon::hasTrajectory() const
 }
 
 
+int
+TrajectoryAnalysisRunnerCommon::threadCount() const
+{
+    if (!impl_->settings_.hasFlag(TrajectoryAnalysisSettings::efFrameParallel))
+    {
+        return 1;
+    }
+    return std::max(impl_->threadCount_, 1);
+}
+
+
 const TopologyInformation &
 TrajectoryAnalysisRunnerCommon::topologyInformation() const
 {
@@ -484,7 +601,7 @@ t_trxframe &
 TrajectoryAnalysisRunnerCommon::frame() const
 {
     GMX_RELEASE_ASSERT(impl_->fr != nullptr, "Frame not available when accessed");
-    return *impl_->fr;
+    return *impl_->currentFrame();
 }
 
 } // namespace gmx
@@ -120,6 +120,13 @@ class TrajectoryAnalysisRunnerCommon
 
         //! Returns true if input data comes from a trajectory.
         bool hasTrajectory() const;
+        /*! \brief
+         * Returns the number of threads to use for analyzing frames.
+         *
+         * Always returns one unless the module has set
+         * TrajectoryAnalysisSettings::efFrameParallel.
+         */
+        int threadCount() const;
         //! Returns the topology information object.
         const TopologyInformation &topologyInformation() const;
         //! Returns the currently loaded frame.
@@ -87,6 +87,39 @@ TEST_F(RdfModuleTest, BasicTest)
     runTest(CommandLine(cmdline));
 }
 
+TEST_F(RdfModuleTest, CalculatesOverTrajectory)
+{
+    const char *const cmdline[] = {
+        "rdf",
+        "-bin", "0.05", "-rmax", "0.8",
+        "-ref", "name OW",
+        "-sel", "name OW", "not name OW"
+    };
+    setTopology("spc216.gro");
+    setTrajectory("spc216-traj.xtc");
+    setOutputFile("-o", ".xvg", NoTextMatch());
+    excludeDataset("pairdist");
+    runTest(CommandLine(cmdline));
+}
+
+// Reusing the pair list should not change the result, so the reference
+// data is identical to that of CalculatesOverTrajectory. The trajectory
+// has frames where the list is reused and frames where it is rebuilt.
+TEST_F(RdfModuleTest, CalculatesWithPairListBuffer)
+{
+    const char *const cmdline[] = {
+        "rdf",
+        "-bin", "0.05", "-rmax", "0.8", "-nbbuf", "0.1",
+        "-ref", "name OW",
+        "-sel", "name OW", "not name OW"
+    };
+    setTopology("spc216.gro");
+    setTrajectory("spc216-traj.xtc");
+    setOutputFile("-o", ".xvg", NoTextMatch());
+    excludeDataset("pairdist");
+    runTest(CommandLine(cmdline));
+}
+
 TEST_F(RdfModuleTest, SelectionsSolelyFromIndexFileWork)
 {
     const char *const cmdline[] = {
@@ -122,4 +122,32 @@ TEST_F(TrajectoryModuleTest, HandlesNoForces)
     runTest(CommandLine(cmdline));
 }
 
+TEST_F(TrajectoryModuleTest, ReadsXtcWithReadAhead)
+{
+    const char *const cmdline[] = {
+        "trajectory",
+        "-select", "resnr 1", "resnr 2",
+        "-readahead", "1"
+    };
+    setTopology("spc2.gro");
+    setTrajectory("spc2-traj.xtc");
+    setOutputFile("-ox", "coord.xvg", NoTextMatch());
+    includeDataset("x");
+    runTest(CommandLine(cmdline));
+}
+
+TEST_F(TrajectoryModuleTest, ReadsXtcWithoutReadAhead)
+{
+    const char *const cmdline[] = {
+        "trajectory",
+        "-select", "resnr 1", "resnr 2",
+        "-readahead", "0"
+    };
+    setTopology("spc2.gro");
+    setTrajectory("spc2-traj.xtc");
+    setOutputFile("-ox", "coord.xvg", NoTextMatch());
+    includeDataset("x");
+    runTest(CommandLine(cmdline));
+}
+
 } // namespace
@@ -0,0 +1,174 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for multiple time stepping of the long-range nonbonded forces
+ *
+ * Checks that MTS with factor 1 reproduces a normal run and that with
+ * factor 2 the energies include the long-range contribution, also at
+ * the last step when that is not a multiple of the MTS factor.
+ *
+ * \ingroup module_mdrun_integration_tests
+ */
+#include "gmxpre.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/trajectory/energyframe.h"
+#include "gromacs/utility/stringutil.h"
+
+#include "testutils/testasserts.h"
+
+#include "energycomparison.h"
+#include "energyreader.h"
+#include "mdruncomparison.h"
+#include "moduletest.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Test fixture for multiple time stepping
+class MtsTest : public MdrunTestFixture
+{
+    public:
+        /*! \brief Runs grompp and mdrun with \p mtsMdpLines added to the mdp settings
+         *
+         * Returns the name of the energy file.
+         */
+        std::string runSimulation(const std::string &name, const std::string &mtsMdpLines, int nsteps);
+        //! Compares the energies in \p edrFileName with those in \p referenceEdrFileName
+        void compareEnergies(const std::string &referenceEdrFileName, const std::string &edrFileName,
+                             const EnergyTolerances &energiesToMatch);
+};
+
+std::string MtsTest::runSimulation(const std::string &name, const std::string &mtsMdpLines, int nsteps)
+{
+    const std::string inputFile = "spc-and-methanol";
+    const std::string mdpFile   = formatString("coulombtype   = PME\n"
+                                               "nstcalcenergy = 2\n"
+                                               "nstenergy     = 2\n"
+                                               "nsteps        = %d\n"
+                                               "%s",
+                                               nsteps, mtsMdpLines.c_str());
+    runner_.useStringAsMdpFile(mdpFile);
+    runner_.useTopGroAndNdxFromDatabase(inputFile);
+    runner_.tprFileName_ = fileManager_.getTemporaryFilePath(name + ".tpr");
+    EXPECT_EQ(0, runner_.callGrompp());
+
+    runner_.edrFileName_ = fileManager_.getTemporaryFilePath(name + ".edr");
+    CommandLine commandLine;
+    commandLine.append("-notunepme"); // for reciprocal energy reproducibility
+    EXPECT_EQ(0, runner_.callMdrun(commandLine));
+
+    return runner_.edrFileName_;
+}
+
+void MtsTest::compareEnergies(const std::string &referenceEdrFileName, const std::string &edrFileName,
+                              const EnergyTolerances &energiesToMatch)
+{
+    auto namesOfEnergiesToMatch = getKeys(energiesToMatch);
+    FramePairManager<EnergyFrameReader, EnergyFrame>
+         energyManager(openEnergyFileToReadFields(referenceEdrFileName, namesOfEnergiesToMatch),
+                  openEnergyFileToReadFields(edrFileName, namesOfEnergiesToMatch));
+    energyManager.compareAllFramePairs([&energiesToMatch](const EnergyFrame &reference, const EnergyFrame &test)
+                                       {
+                                           compareEnergyFrames(reference, test, energiesToMatch);
+                                       });
+}
+
+TEST_F(MtsTest, Factor1MatchesNoMts)
+{
+    const int         nsteps    = 6;
+    const std::string reference = runSimulation("nomts", "", nsteps);
+    const std::string mts       = runSimulation("mts1",
+                                                "mts               = yes\n"
+                                                "mts-level2-forces = longrange-nonbonded\n"
+                                                "mts-level2-factor = 1\n",
+                                                nsteps);
+
+    /* Only the order of force summation differs */
+    EnergyTolerances energiesToMatch {
+        {
+            "Coul. recip.", relativeToleranceAsFloatingPoint(10, 1e-5)
+        },
+        {
+            "Potential", relativeToleranceAsFloatingPoint(10, 1e-5)
+        },
+        {
+            "Kinetic En.", relativeToleranceAsFloatingPoint(10, 1e-5)
+        },
+        {
+            "Pressure", relativeToleranceAsFloatingPoint(100, 1e-5)
+        }
+    };
+    compareEnergies(reference, mts, energiesToMatch);
+}
+
+TEST_F(MtsTest, Factor2EnergiesIncludeLongRange)
+{
+    /* An odd number of steps, so energies are also computed at the last
+     * step, which is not a multiple of the MTS factor.
+     */
+    const int         nsteps    = 5;
+    const std::string reference = runSimulation("nomts", "", nsteps);
+    const std::string mts       = runSimulation("mts2",
+                                                "mts               = yes\n"
+                                                "mts-level2-forces = longrange-nonbonded\n"
+                                                "mts-level2-factor = 2\n",
+                                                nsteps);
+
+    /* The trajectories differ slightly because of MTS. The pressure
+     * is not compared, since its kinetic part depends on the MTS impulse.
+     */
+    EnergyTolerances energiesToMatch {
+        {
+            "Coul. recip.", relativeToleranceAsFloatingPoint(10, 1e-3)
+        },
+        {
+            "Potential", relativeToleranceAsFloatingPoint(10, 5e-3)
+        }
+    };
+    compareEnergies(reference, mts, energiesToMatch);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace gmx
@@ -0,0 +1,101 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests that mdrun writes frame indices for its xtc and trr output
+ *
+ * \ingroup module_mdrun_integration_tests
+ */
+#include "gmxpre.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/trajectoryframeindex.h"
+
+#include "moduletest.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Test fixture for the frame indices written by mdrun
+using TrajectoryFrameIndexTest = MdrunTestFixture;
+
+//! Checks that the sidecar index of \p trajectoryFile matches a freshly built index
+void checkSidecarIndex(const std::string &trajectoryFile, int expectedFrameCount)
+{
+    SCOPED_TRACE("Checking the frame index of " + trajectoryFile);
+    TrajectoryFrameIndex sidecarIndex(trajectoryFile);
+    ASSERT_TRUE(sidecarIndex.readSidecar());
+    EXPECT_FALSE(sidecarIndex.isOutOfDate());
+
+    TrajectoryFrameIndex referenceIndex(trajectoryFile);
+    referenceIndex.update();
+    ASSERT_EQ(expectedFrameCount, referenceIndex.frameCount());
+    ASSERT_EQ(referenceIndex.frameCount(), sidecarIndex.frameCount());
+    for (int64_t frame = 0; frame < referenceIndex.frameCount(); frame++)
+    {
+        EXPECT_EQ(referenceIndex.frame(frame).offset, sidecarIndex.frame(frame).offset);
+        EXPECT_EQ(referenceIndex.frame(frame).step, sidecarIndex.frame(frame).step);
+        EXPECT_EQ(referenceIndex.frame(frame).natoms, sidecarIndex.frame(frame).natoms);
+    }
+}
+
+TEST_F(TrajectoryFrameIndexTest, MdrunWritesIndicesOfXtcAndTrr)
+{
+    runner_.useStringAsMdpFile("integrator         = md\n"
+                               "nsteps             = 6\n"
+                               "nstxout            = 2\n"
+                               "nstvout            = 3\n"
+                               "nstxout-compressed = 2\n");
+    runner_.useTopGroAndNdxFromDatabase("spc-and-methanol");
+    ASSERT_EQ(0, runner_.callGrompp());
+    runner_.reducedPrecisionTrajectoryFileName_ = fileManager_.getTemporaryFilePath(".xtc");
+    ASSERT_EQ(0, runner_.callMdrun());
+
+    // The xtc file has frames at steps 0, 2, 4 and 6, the trr file
+    // also at step 3 for the velocities.
+    checkSidecarIndex(runner_.reducedPrecisionTrajectoryFileName_, 4);
+    checkSidecarIndex(runner_.fullPrecisionTrajectoryFileName_, 5);
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
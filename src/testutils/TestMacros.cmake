@@ -173,6 +173,16 @@ function (gmx_add_unit_test NAME EXENAME)
     gmx_register_gtest_test(${NAME} ${EXENAME})
 endfunction()
 
+# Builds a gtest executable that is built with the tests target, but is
+# not registered with CTest. Used for microbenchmarks, which report
+# timings rather than check results and are run manually.
+function (gmx_add_gtest_benchmark EXENAME)
+    gmx_add_gtest_executable(${EXENAME} ${ARGN})
+    if (GMX_BUILD_UNITTESTS AND BUILD_TESTING)
+        add_dependencies(tests ${EXENAME})
+    endif()
+endfunction()
+
 function (gmx_add_mpi_unit_test NAME EXENAME RANKS)
     if (GMX_MPI OR (GMX_THREAD_MPI AND GTEST_IS_THREADSAFE))
         gmx_add_gtest_executable(${EXENAME} MPI ${ARGN})